@@ -2012,8 +2012,8 @@ void CApplication::Render()
 
   // reset our info cache - we do this at the end of Render so that it is
   // fresh for the next process(), or after a windowclose animation (where process()
-  // isn't called)
-  g_infoManager.ResetCache();
+  // isn't called). Only bools depending on something which changed are reset.
+  g_infoManager.ResetCache(INFO::INFO_SOURCE_FRAME);
 
 
   unsigned int now = XbmcThreads::SystemClockMillis();
@@ -143,6 +143,11 @@ CGUIInfoManager::CGUIInfoManager(void) :
   m_playerShowCodec = false;
   m_playerShowInfo = false;
   m_fps = 0.0f;
+  memset(&m_boolStats, 0, sizeof(m_boolStats));
+  m_changedSources = 0;
+  m_playerState = 0;
+  m_playerSpeed = 0;
+  m_boolsMinute = 0;
   ResetLibraryBools();
 }
 
@@ -6096,14 +6101,162 @@ bool CGUIInfoManager::GetItemBool(const CGUIListItem *item, int condition) const
   return false;
 }
 
-void CGUIInfoManager::ResetCache()
+void CGUIInfoManager::ResetCache(unsigned int sources /* = INFO_SOURCE_ALL */)
 {
   // reset any animation triggers as well
   m_containerMoves.clear();
+
+  sources |= GetChangedSources();
+
+  // the player and the clock are checked once here rather than by every
+  // condition depending on them
+  int playerState = 0;
+  int playerSpeed = 0;
+  if (g_application.m_pPlayer->IsPlaying())
+  {
+    playerState = 1;
+    if (g_application.m_pPlayer->IsPlayingAudio())
+      playerState |= 2;
+    if (g_application.m_pPlayer->IsPlayingVideo())
+      playerState |= 4;
+    if (g_application.m_pPlayer->IsPausedPlayback())
+      playerState |= 8;
+    playerSpeed = g_application.m_pPlayer->GetPlaySpeed();
+  }
+  if (playerState != m_playerState || playerSpeed != m_playerSpeed)
+  {
+    m_playerState = playerState;
+    m_playerSpeed = playerSpeed;
+    sources |= INFO_SOURCE_PLAYER;
+  }
+
+  time_t minute = time(NULL) / 60;
+  if (minute != m_boolsMinute)
+  {
+    m_boolsMinute = minute;
+    sources |= INFO_SOURCE_TIME;
+  }
+
   // mark our infobools as dirty
   CSingleLock lock(m_critInfo);
+  m_boolStats.bools = m_bools.size();
+  m_boolStats.evaluations = 0;
+  m_boolStats.invalidated = 0;
   for (std::vector<InfoPtr>::iterator i = m_bools.begin(); i != m_bools.end(); ++i)
-    (*i)->SetDirty();
+  {
+    m_boolStats.evaluations += (*i)->TakeEvaluations();
+    if (sources == INFO_SOURCE_ALL || ((*i)->GetSources() & sources))
+    {
+      (*i)->SetDirty();
+      m_boolStats.invalidated++;
+    }
+  }
+}
+
+void CGUIInfoManager::InvalidateBools(unsigned int sources)
+{
+  CSingleLock lock(m_critSources);
+  m_changedSources |= sources;
+}
+
+unsigned int CGUIInfoManager::GetChangedSources()
+{
+  CSingleLock lock(m_critSources);
+  unsigned int sources = m_changedSources;
+  m_changedSources = 0;
+  return sources;
+}
+
+void CGUIInfoManager::OnSettingChanged(const CSetting *setting)
+{
+  InvalidateBools(INFO_SOURCE_SETTINGS);
+}
+
+void CGUIInfoManager::WatchSetting(const std::string &setting)
+{
+  if (m_watchedSettings.insert(setting).second)
+  {
+    std::set<std::string> settings;
+    settings.insert(setting);
+    CSettings::GetInstance().RegisterCallback(this, settings);
+  }
+}
+
+unsigned int CGUIInfoManager::GetBoolSources(int condition)
+{
+  CSingleLock lock(m_critInfo);
+  switch (abs(condition))
+  {
+    case SYSTEM_ALWAYS_TRUE:
+    case SYSTEM_ALWAYS_FALSE:
+    case SYSTEM_ETHERNET_LINK_ACTIVE:
+    case SYSTEM_PLATFORM_LINUX:
+    case SYSTEM_PLATFORM_DARWIN:
+    case SYSTEM_PLATFORM_DARWIN_OSX:
+    case SYSTEM_PLATFORM_DARWIN_IOS:
+    case SYSTEM_PLATFORM_DARWIN_TVOS:
+    case SYSTEM_PLATFORM_ANDROID:
+    case SYSTEM_PLATFORM_LINUX_RASPBERRY_PI:
+    case SYSTEM_IS_TOUCH:
+    case SYSTEM_HAS_PVR:
+    case SYSTEM_HAS_ADSP:
+      return INFO_SOURCE_NONE;
+    case LIBRARY_HAS_MUSIC...LIBRARY_HAS_COMPILATIONS:
+      return INFO_SOURCE_LIBRARY;
+    case SYSTEM_HAS_SHUTDOWN:
+      WatchSetting(CSettings::SETTING_POWERMANAGEMENT_SHUTDOWNTIME);
+      return INFO_SOURCE_SETTINGS;
+#if defined(TARGET_DARWIN_TVOS)
+    case SYSTEM_HAS_APPLETV_SLIDER:
+      WatchSetting(CSettings::SETTING_INPUT_APPLESIRIEXPERTMODE);
+      return INFO_SOURCE_SETTINGS;
+#endif
+    case PLAYER_HAS_MEDIA:
+    case PLAYER_HAS_AUDIO:
+    case PLAYER_HAS_VIDEO:
+    case PLAYER_PLAYING:
+    case PLAYER_PAUSED:
+    case PLAYER_REWINDING:
+    case PLAYER_FORWARDING:
+    case PLAYER_REWINDING_2x:
+    case PLAYER_REWINDING_4x:
+    case PLAYER_REWINDING_8x:
+    case PLAYER_REWINDING_16x:
+    case PLAYER_REWINDING_32x:
+    case PLAYER_FORWARDING_2x:
+    case PLAYER_FORWARDING_4x:
+    case PLAYER_FORWARDING_8x:
+    case PLAYER_FORWARDING_16x:
+    case PLAYER_FORWARDING_32x:
+      return INFO_SOURCE_PLAYER;
+    case MULTI_INFO_START...MULTI_INFO_END:
+    {
+      const GUIInfo &info = m_multiInfo[abs(condition) - MULTI_INFO_START];
+      switch (abs(info.m_info))
+      {
+        case SKIN_BOOL:
+        case SKIN_STRING:
+          return INFO_SOURCE_SKIN_SETTINGS;
+        case SKIN_HAS_THEME:
+          WatchSetting(CSettings::SETTING_LOOKANDFEEL_SKINTHEME);
+          return INFO_SOURCE_SETTINGS;
+        case SYSTEM_GET_BOOL:
+          WatchSetting(m_stringParameters[info.GetData1()]);
+          return INFO_SOURCE_SETTINGS;
+        case SYSTEM_HAS_CORE_ID:
+          return INFO_SOURCE_NONE;
+        case SYSTEM_DATE:
+        case SYSTEM_TIME:
+          return INFO_SOURCE_TIME;
+        default:
+          break;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return INFO_SOURCE_FRAME;
 }
 
 std::string CGUIInfoManager::GetPictureLabel(int info)
@@ -6271,8 +6424,9 @@ void CGUIInfoManager::SetLibraryBool(int condition, bool value)
       m_libraryHasCompilations = value ? 1 : 0;
       break;
     default:
-      break;
+      return;
   }
+  InvalidateBools(INFO_SOURCE_LIBRARY);
 }
 
 void CGUIInfoManager::ResetLibraryBools()
@@ -6284,6 +6438,7 @@ void CGUIInfoManager::ResetLibraryBools()
   m_libraryHasMovieSets = -1;
   m_libraryHasSingles = -1;
   m_libraryHasCompilations = -1;
+  InvalidateBools(INFO_SOURCE_LIBRARY);
 }
 
 bool CGUIInfoManager::GetLibraryBool(int condition)
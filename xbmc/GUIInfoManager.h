@@ -36,9 +36,11 @@
 #include "interfaces/info/InfoBool.h"
 #include "interfaces/info/SkinVariable.h"
 #include "cores/IPlayer.h"
+#include "settings/lib/ISettingCallback.h"
 
 #include <list>
 #include <map>
+#include <set>
 
 namespace MUSIC_INFO
 {
@@ -100,9 +102,16 @@ private:
  \brief
  */
 class CGUIInfoManager : public IMsgTargetCallback, public Observable,
-                        public KODI::MESSAGING::IMessageTarget
+                        public KODI::MESSAGING::IMessageTarget, public ISettingCallback
 {
 public:
+  struct InfoBoolStats
+  {
+    unsigned int bools;        ///< registered conditions
+    unsigned int evaluations;  ///< conditions evaluated during the last frame
+    unsigned int invalidated;  ///< conditions marked for evaluation in the next frame
+  };
+
   CGUIInfoManager(void);
   virtual ~CGUIInfoManager(void);
 
@@ -111,6 +120,7 @@ public:
 
   virtual int GetMessageMask() override;
   virtual void OnApplicationMessage(KODI::MESSAGING::ThreadMessage* pMsg) override;
+  virtual void OnSettingChanged(const CSetting *setting) override;
 
   /*! \brief Register a boolean condition/expression
    This routine allows controls or other clients of the info manager to register
@@ -205,7 +215,25 @@ public:
   void SetNextWindow(int windowID) { m_nextWindowID = windowID; };
   void SetPreviousWindow(int windowID) { m_prevWindowID = windowID; };
 
-  void ResetCache();
+  /*! \brief Mark info bools for re-evaluation
+   Besides the given sources, any sources announced by InvalidateBools() since
+   the last call are reset. Called with INFO_SOURCE_FRAME after each frame.
+   \param sources the INFO::InfoSource flags to reset, all bools by default
+   */
+  void ResetCache(unsigned int sources = INFO::INFO_SOURCE_ALL);
+
+  /*! \brief Announce a change of info sources
+   The info bools depending on them are re-evaluated in the next frame.
+   May be called from any thread.
+   \param sources the INFO::InfoSource flags which changed
+   */
+  void InvalidateBools(unsigned int sources);
+
+  /*! \brief Get the INFO::InfoSource flags a condition depends on
+   */
+  unsigned int GetBoolSources(int condition);
+  const InfoBoolStats& GetBoolStats() const { return m_boolStats; }
+
   bool GetItemInt(int &value, const CGUIListItem *item, int info) const;
   std::string GetItemLabel(const CFileItem *item, int info, std::string *fallback = NULL);
   std::string GetItemImage(const CFileItem *item, int info, std::string *fallback = NULL);
@@ -284,6 +312,8 @@ protected:
   int ConditionalStringParameter(const std::string &strParameter, bool caseSensitive = false);
   int AddMultiInfo(const GUIInfo &info);
   int AddListItemProp(const std::string &str, int offset=0);
+  void WatchSetting(const std::string &setting);
+  unsigned int GetChangedSources();
 
   /*!
    * @brief Get the EPG tag that is currently active
@@ -328,6 +358,13 @@ protected:
   int m_prevWindowID;
 
   std::vector<INFO::InfoPtr> m_bools;
+  InfoBoolStats m_boolStats;
+  std::set<std::string> m_watchedSettings;  // settings conditions depend on
+  unsigned int m_changedSources;            // announced by InvalidateBools()
+  int m_playerState;                        // playing state when bools were last reset
+  int m_playerSpeed;
+  time_t m_boolsMinute;                     // minute when bools were last reset
+  CCriticalSection m_critSources;
   std::vector<INFO::CSkinVariableString> m_skinVariableStrings;
 
   int m_libraryHasMusic;
@@ -26,7 +26,10 @@
 #include "utils/TimeUtils.h"
 #include "utils/JobManager.h"
 #include "guilib/GraphicContext.h"
+#include "filesystem/File.h"
+#include "settings/AdvancedSettings.h"
 #include "utils/log.h"
+#include "utils/URIUtils.h"
 #include "TextureCache.h"
 
 #include <cassert>
@@ -64,7 +67,16 @@ bool CImageLoader::DoWork()
   {
     // direct route - load the image
     unsigned int start = XbmcThreads::SystemClockMillis();
-    m_texture = CBaseTexture::LoadFromFile(loadPath, g_graphicsContext.GetWidth(), g_graphicsContext.GetHeight());
+
+    // cached images may have a copy which is ready for upload
+    if (m_use_cache && loadPath != texturePath && g_advancedSettings.m_imageDDSRes)
+    {
+      std::string ddsPath = URIUtils::ReplaceExtension(loadPath, ".dds");
+      if (XFILE::CFile::Exists(ddsPath))
+        m_texture = CBaseTexture::LoadFromFile(ddsPath);
+    }
+    if (!m_texture)
+      m_texture = CBaseTexture::LoadFromFile(loadPath, g_graphicsContext.GetWidth(), g_graphicsContext.GetHeight());
 
     if (XbmcThreads::SystemClockMillis() - start > 100)
       CLog::Log(LOGDEBUG, "%s - took %u ms to load %s", __FUNCTION__, XbmcThreads::SystemClockMillis() - start, loadPath.c_str());
@@ -310,6 +310,7 @@ bool CTextureCleanupJob::DoWork()
       std::string cachedurl = url.second;
       URIUtils::Split(cachedurl, path, fn);
       std::string cmpurl = "special://thumbnails/" + cachedurl;
+      std::string ddsurl = URIUtils::ReplaceExtension(cmpurl, ".dds");
       if (path != prevPath)
       {
         while (fileIdx < files.Size())
@@ -321,7 +322,13 @@ bool CTextureCleanupJob::DoWork()
         fileIdx = 0;
       }
       while (fileIdx < files.Size() && files.Get(fileIdx)->GetPath() < cmpurl)
-        deleteFile();
+      {
+        // keep the copy ready for upload, it sorts before its .jpg/.png
+        if (files.Get(fileIdx)->GetPath() == ddsurl)
+          fileIdx++;
+        else
+          deleteFile();
+      }
       if (fileIdx < files.Size() && files.Get(fileIdx)->GetPath() == cmpurl)
         fileIdx++;
       else
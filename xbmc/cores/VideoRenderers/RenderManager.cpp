@@ -43,6 +43,7 @@
   #include "LinuxRendererGL.h"
 #elif HAS_GLES >= 2
   #include "LinuxRendererGLES.h"
+  #include "windowing/WindowingFactory.h"
 #elif defined(HAS_SDL)
   #include "LinuxRenderer.h"
 #endif
@@ -801,6 +802,11 @@ void CXBMCRenderManager::Render(bool clear, uint32_t flags, uint32_t alpha, bool
 {
   CSharedLock lock(m_sharedSection);
 
+#if HAS_GLES >= 2
+  // the GUI drawn so far has to be below the video
+  g_Windowing.GUIQuadBatch().Flush();
+#endif
+
   if (!gui && m_pRenderer->IsGuiLayer())
     return;
 
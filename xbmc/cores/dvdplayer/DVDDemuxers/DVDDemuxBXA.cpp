@@ -139,7 +139,8 @@ DemuxPacket* CDVDDemuxBXA::Read()
 
   if(pPacket->iSize < 1)
   {
-    SAFE_DELETE(pPacket);
+    CDVDDemuxUtils::FreeDemuxPacket(pPacket);
+    pPacket = NULL;
   }
   else
   {
@@ -29,14 +29,171 @@ extern "C" {
 #include "libavcodec/avcodec.h"
 }
 
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
+
+#include <vector>
+
+// payload size classes are powers of two from 2^MIN to 2^MAX bytes,
+// bigger packets are allocated and freed directly
+#define DEMUX_POOL_MIN_CLASS   8
+#define DEMUX_POOL_MAX_CLASS   20
+#define DEMUX_POOL_CLASSES     (DEMUX_POOL_MAX_CLASS - DEMUX_POOL_MIN_CLASS + 1)
+// upper limit of memory kept in the pool and of cached headers
+#define DEMUX_POOL_MAX_BYTES   (16 * 1024 * 1024)
+#define DEMUX_POOL_MAX_HEADERS 1024
+
+namespace
+{
+
+// the pool needs the capacity of the payload, DemuxPacket itself is shared
+// with addons and can't be extended, so it is wrapped
+struct PooledPacket
+{
+  DemuxPacket packet;
+  int sizeClass; // -1 for no or an unpooled payload
+};
+
+class CDemuxPacketPool
+{
+public:
+  CDemuxPacketPool()
+  {
+    ResetStats();
+  }
+
+  ~CDemuxPacketPool()
+  {
+    Trim();
+  }
+
+  // sizeClass -1 if no pooled payload is needed, NULL results have to be allocated
+  PooledPacket* Get(int sizeClass, bool payload, uint8_t* &buffer)
+  {
+    CSingleLock lock(m_section);
+    m_stats.allocations++;
+    m_stats.outstanding++;
+    if (m_stats.outstanding > m_stats.highWater)
+      m_stats.highWater = m_stats.outstanding;
+
+    buffer = NULL;
+    if (sizeClass >= 0)
+    {
+      std::vector<uint8_t*> &buffers = m_buffers[sizeClass - DEMUX_POOL_MIN_CLASS];
+      if (!buffers.empty())
+      {
+        buffer = buffers.back();
+        buffers.pop_back();
+        m_stats.pooledBytes -= (size_t)1 << sizeClass;
+      }
+    }
+
+    PooledPacket* pooled = NULL;
+    if (!m_headers.empty())
+    {
+      pooled = m_headers.back();
+      m_headers.pop_back();
+    }
+
+    if (pooled && (buffer || !payload))
+      m_stats.hits++;
+    return pooled;
+  }
+
+  void Put(PooledPacket* pooled)
+  {
+    CSingleLock lock(m_section);
+    m_stats.outstanding--;
+
+    uint8_t* buffer = pooled->packet.pData;
+    int sizeClass = pooled->sizeClass;
+    if (buffer && sizeClass >= 0)
+    {
+      size_t size = (size_t)1 << sizeClass;
+      if (m_stats.pooledBytes + size <= DEMUX_POOL_MAX_BYTES)
+      {
+        m_buffers[sizeClass - DEMUX_POOL_MIN_CLASS].push_back(buffer);
+        m_stats.pooledBytes += size;
+        buffer = NULL;
+      }
+    }
+
+    bool keep = m_headers.size() < DEMUX_POOL_MAX_HEADERS;
+    if (keep)
+      m_headers.push_back(pooled);
+    lock.Leave();
+
+    if (buffer)
+      _aligned_free(buffer);
+    if (!keep)
+      delete pooled;
+  }
+
+  void Trim()
+  {
+    std::vector<uint8_t*> buffers;
+    std::vector<PooledPacket*> headers;
+    {
+      CSingleLock lock(m_section);
+      for (int i = 0; i < DEMUX_POOL_CLASSES; i++)
+      {
+        buffers.insert(buffers.end(), m_buffers[i].begin(), m_buffers[i].end());
+        m_buffers[i].clear();
+      }
+      headers.swap(m_headers);
+      m_stats.pooledBytes = 0;
+    }
+
+    for (auto buffer : buffers)
+      _aligned_free(buffer);
+    for (auto header : headers)
+      delete header;
+  }
+
+  void GetStats(DemuxPacketPoolStats &stats)
+  {
+    CSingleLock lock(m_section);
+    stats = m_stats;
+  }
+
+  void ResetStats()
+  {
+    CSingleLock lock(m_section);
+    m_stats.allocations = 0;
+    m_stats.hits = 0;
+    m_stats.highWater = m_stats.outstanding;
+  }
+
+  static int SizeClass(int size)
+  {
+    int sizeClass = DEMUX_POOL_MIN_CLASS;
+    while (sizeClass <= DEMUX_POOL_MAX_CLASS && ((size_t)1 << sizeClass) < (size_t)size)
+      sizeClass++;
+    return sizeClass <= DEMUX_POOL_MAX_CLASS ? sizeClass : -1;
+  }
+
+private:
+  CCriticalSection m_section;
+  std::vector<uint8_t*> m_buffers[DEMUX_POOL_CLASSES];
+  std::vector<PooledPacket*> m_headers;
+  DemuxPacketPoolStats m_stats = {};
+};
+
+CDemuxPacketPool& GetPool()
+{
+  static CDemuxPacketPool pool;
+  return pool;
+}
+
+}
+
 void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 {
   if (pPacket)
   {
     try {
-      if (pPacket->pData)
-        _aligned_free(pPacket->pData);
-      SAFE_DELETE(pPacket);
+      // every packet is allocated as PooledPacket, see AllocateDemuxPacket
+      GetPool().Put((PooledPacket*)pPacket);
     }
     catch(...) {
       CLog::Log(LOGERROR, "%s - Exception thrown while freeing packet", __FUNCTION__);
@@ -46,13 +203,22 @@ void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 
 DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
 {
-  DemuxPacket* pPacket = new DemuxPacket;
-  if (!pPacket)
+  // need to allocate a few bytes more, see below
+  int size = iDataSize + FF_INPUT_BUFFER_PADDING_SIZE;
+  int sizeClass = iDataSize > 0 ? CDemuxPacketPool::SizeClass(size) : -1;
+
+  uint8_t* buffer;
+  PooledPacket* pooled = GetPool().Get(sizeClass, iDataSize > 0, buffer);
+  if (!pooled)
+    pooled = new PooledPacket;
+  if (!pooled)
     return NULL;
 
+  DemuxPacket* pPacket = &pooled->packet;
   try
   {
     memset(pPacket, 0, sizeof(DemuxPacket));
+    pooled->sizeClass = -1;
 
     if (iDataSize > 0)
     {
@@ -65,7 +231,17 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
         * Note, if the first 23 bits of the additional bytes are not 0 then damaged
         * MPEG bitstreams could cause overread and segfault
         */
-      pPacket->pData =(uint8_t*)_aligned_malloc(iDataSize + FF_INPUT_BUFFER_PADDING_SIZE, 16);
+      if (sizeClass >= 0)
+      {
+        pPacket->pData = buffer;
+        if (!pPacket->pData)
+          pPacket->pData = (uint8_t*)_aligned_malloc((size_t)1 << sizeClass, 16);
+        if (pPacket->pData)
+          pooled->sizeClass = sizeClass;
+      }
+      else
+        pPacket->pData = (uint8_t*)_aligned_malloc(size, 16);
+
       if (!pPacket->pData)
       {
         FreeDemuxPacket(pPacket);
@@ -89,3 +265,18 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
   }
   return pPacket;
 }
+
+void CDVDDemuxUtils::GetPoolStats(DemuxPacketPoolStats &stats)
+{
+  GetPool().GetStats(stats);
+}
+
+void CDVDDemuxUtils::ResetPoolStats()
+{
+  GetPool().ResetStats();
+}
+
+void CDVDDemuxUtils::TrimPool()
+{
+  GetPool().Trim();
+}
@@ -21,11 +21,30 @@
  */
 
 #include "DVDDemuxPacket.h"
+#include <stdint.h>
+#include <stddef.h>
+
+struct DemuxPacketPoolStats
+{
+  uint64_t allocations;  // packets handed out
+  uint64_t hits;         // of which were served from the pool
+  int      outstanding;  // packets currently in use
+  int      highWater;    // maximum of outstanding packets
+  size_t   pooledBytes;  // payload memory kept for reuse
+};
 
 class CDVDDemuxUtils
 {
 public:
   static void FreeDemuxPacket(DemuxPacket* pPacket);
   static DemuxPacket* AllocateDemuxPacket(int iDataSize = 0);
+
+  /*!
+   \brief Packets and their payload buffers are recycled in power of two size classes.
+   Statistics are collected from the last ResetPoolStats, TrimPool releases all unused memory.
+   */
+  static void GetPoolStats(DemuxPacketPoolStats &stats);
+  static void ResetPoolStats();
+  static void TrimPool();
 };
 
@@ -25,11 +25,83 @@
 #include "DVDClock.h"
 #include "utils/MathUtils.h"
 
-CDVDMessageQueue::CDVDMessageQueue(const std::string &owner) : m_hEvent(true), m_owner(owner)
+// power of two, packets beyond this spill into the locked overflow list
+#define MSGQ_RING_SIZE 2048
+
+CDVDMessageRing::CDVDMessageRing(size_t capacity)
+  : m_cells(new Cell[capacity])
+  , m_mask(capacity - 1)
+  , m_enqueuePos(0)
+  , m_dequeuePos(0)
+{
+  for (size_t i = 0; i < capacity; i++)
+  {
+    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    m_cells[i].message = NULL;
+  }
+}
+
+CDVDMessageRing::~CDVDMessageRing()
+{
+  while (CDVDMsg* msg = Pop())
+    msg->Release();
+}
+
+bool CDVDMessageRing::Push(CDVDMsg* msg)
+{
+  Cell *cell;
+  size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    cell = &m_cells[pos & m_mask];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0)
+    {
+      if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+      return false; // full
+    else
+      pos = m_enqueuePos.load(std::memory_order_relaxed);
+  }
+
+  cell->message = msg;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+CDVDMsg* CDVDMessageRing::Pop()
+{
+  size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+  Cell &cell = m_cells[pos & m_mask];
+  if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+    return NULL;
+
+  CDVDMsg* msg = cell.message;
+  cell.message = NULL;
+  m_dequeuePos.store(pos + 1, std::memory_order_relaxed);
+  cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+  return msg;
+}
+
+bool CDVDMessageRing::Empty() const
+{
+  size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+  return m_cells[pos & m_mask].sequence.load(std::memory_order_acquire) != pos + 1;
+}
+
+CDVDMessageQueue::CDVDMessageQueue(const std::string &owner)
+  : m_hEvent(true)
+  , m_owner(owner)
+  , m_ring(MSGQ_RING_SIZE)
 {
   m_iDataSize     = 0;
   m_bAbortRequest = false;
   m_bInitialized = false;
+  m_waiting = false;
+  m_overflow = false;
 
   m_TimeBack = DVD_NOPTS_VALUE;
   m_TimeFront = DVD_NOPTS_VALUE;
@@ -56,17 +128,33 @@ void CDVDMessageQueue::Flush(CDVDMsg::Message type)
 {
   CSingleLock lock(m_section);
 
-  m_messages.remove_if([type](const DVDMessageListItem &item){
-    return type == CDVDMsg::NONE || item.message->IsType(type);
-  });
+  auto remove = [this, type](const DVDMessageListItem &item){
+    if (type != CDVDMsg::NONE && !item.message->IsType(type))
+      return false;
+    if (item.priority == 0)
+      RemovePacket(item.message, true);
+    return true;
+  };
 
-  m_prioMessages.remove_if([type](const DVDMessageListItem &item){
-    return type == CDVDMsg::NONE || item.message->IsType(type);
-  });
+  m_messages.remove_if(remove);
+  m_prioMessages.remove_if(remove);
+
+  // messages kept from the ring are older than anything put from now on
+  while (CDVDMsg* msg = m_ring.Pop())
+  {
+    if (type == CDVDMsg::NONE || msg->IsType(type))
+      RemovePacket(msg, true);
+    else
+      m_messages.emplace_back(msg, 0);
+    msg->Release();
+  }
+
+  m_overflowMessages.remove_if(remove);
+  if (m_overflowMessages.empty())
+    m_overflow = false;
 
   if (type == CDVDMsg::DEMUXER_PACKET ||  type == CDVDMsg::NONE)
   {
-    m_iDataSize = 0;
     m_TimeBack = DVD_NOPTS_VALUE;
     m_TimeFront = DVD_NOPTS_VALUE;
   }
@@ -93,10 +181,64 @@ void CDVDMessageQueue::End()
   m_bAbortRequest = false;
 }
 
-MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front)
+void CDVDMessageQueue::AddPacket(CDVDMsg* pMsg)
 {
-  CSingleLock lock(m_section);
+  if (!pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
+    return;
+
+  DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
+  if (packet)
+  {
+    m_iDataSize.fetch_add(packet->iSize, std::memory_order_relaxed);
+
+    double time = DVD_NOPTS_VALUE;
+    if (packet->dts != DVD_NOPTS_VALUE)
+      time = packet->dts;
+    else if (packet->pts != DVD_NOPTS_VALUE)
+      time = packet->pts;
+
+    if (time != DVD_NOPTS_VALUE)
+    {
+      m_TimeFront.store(time, std::memory_order_relaxed);
+
+      double back = DVD_NOPTS_VALUE;
+      m_TimeBack.compare_exchange_strong(back, time, std::memory_order_relaxed);
+    }
+  }
+}
+
+void CDVDMessageQueue::RemovePacket(CDVDMsg* pMsg, bool flush)
+{
+  if (!pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
+    return;
 
+  DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
+  if (packet)
+  {
+    m_iDataSize.fetch_sub(packet->iSize, std::memory_order_relaxed);
+    if (flush)
+      return;
+
+    if (packet->dts != DVD_NOPTS_VALUE)
+      m_TimeBack.store(packet->dts, std::memory_order_relaxed);
+    else if (packet->pts != DVD_NOPTS_VALUE)
+      m_TimeBack.store(packet->pts, std::memory_order_relaxed);
+  }
+}
+
+void CDVDMessageQueue::Signal()
+{
+  // the reader announces itself before it waits, so the event is only
+  // touched when somebody is actually blocked on an empty queue. The fence
+  // keeps the load of m_waiting behind the release store publishing the
+  // message, pairing with the fence in Get.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_waiting.load())
+    m_hEvent.Set();
+}
+
+MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front)
+{
   if (!m_bInitialized)
   {
     CLog::Log(LOGWARNING, "CDVDMessageQueue(%s)::Put MSGQ_NOT_INITIALIZED", m_owner.c_str());
@@ -111,6 +253,8 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
 
   if (priority > 0)
   {
+    CSingleLock lock(m_section);
+
     int prio = priority;
     if (!front)
       prio++;
@@ -120,46 +264,86 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
                              return prio <= item.priority;
                            });
     m_prioMessages.emplace(it, pMsg, priority);
+    pMsg->Release();
   }
   else
   {
-    if (m_messages.empty())
+    AddPacket(pMsg);
+
+    // the common case, the ring takes over our reference
+    if (!front || m_overflow.load() || !m_ring.Push(pMsg))
     {
-      m_iDataSize = 0;
-      m_TimeBack = DVD_NOPTS_VALUE;
-      m_TimeFront = DVD_NOPTS_VALUE;
-    }
+      CSingleLock lock(m_section);
 
-    if (front)
-      m_messages.emplace_front(pMsg, priority);
-    else
-      m_messages.emplace_back(pMsg, priority);
-  }
+      if (!front)
+        m_messages.emplace_front(pMsg, priority);
+      else if (m_overflowMessages.empty() && m_ring.Push(pMsg))
+        pMsg = NULL;
+      else
+      {
+        // keep order, everything goes to the overflow list until the reader drained it
+        m_overflow = true;
+        m_overflowMessages.emplace_back(pMsg, priority);
+      }
 
-  if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
-  {
-    DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
-    if (packet)
-    {
-      m_iDataSize += packet->iSize;
-      if (packet->dts != DVD_NOPTS_VALUE)
-        m_TimeFront = packet->dts;
-      else if (packet->pts != DVD_NOPTS_VALUE)
-        m_TimeFront = packet->pts;
-
-      if (m_TimeBack == DVD_NOPTS_VALUE)
-        m_TimeBack = m_TimeFront;
+      if (pMsg)
+        pMsg->Release();
     }
   }
 
-  pMsg->Release();
-
   // inform waiter for new packet
-  m_hEvent.Set();
+  Signal();
 
   return MSGQ_OK;
 }
 
+bool CDVDMessageQueue::HasMessage(int priority) const
+{
+  if (!m_prioMessages.empty() && m_prioMessages.back().priority >= priority)
+    return true;
+  if (priority > 0)
+    return false;
+
+  return !m_messages.empty() || !m_ring.Empty() || !m_overflowMessages.empty();
+}
+
+CDVDMsg* CDVDMessageQueue::PopMessage(int &priority)
+{
+  if (priority > 0 || !m_prioMessages.empty())
+  {
+    if (m_prioMessages.empty() || m_prioMessages.back().priority < priority)
+      return NULL;
+
+    DVDMessageListItem& item(m_prioMessages.back());
+    CDVDMsg* msg = item.message->Acquire();
+    priority = item.priority;
+    m_prioMessages.pop_back();
+    return msg;
+  }
+
+  CDVDMsg* msg = NULL;
+  if (!m_messages.empty())
+  {
+    msg = m_messages.front().message->Acquire();
+    m_messages.pop_front();
+  }
+  else if ((msg = m_ring.Pop()) == NULL && !m_overflowMessages.empty())
+  {
+    msg = m_overflowMessages.front().message->Acquire();
+    m_overflowMessages.pop_front();
+  }
+
+  if (m_overflowMessages.empty())
+    m_overflow = false;
+
+  if (msg)
+  {
+    priority = 0;
+    RemovePacket(msg, false);
+  }
+  return msg;
+}
+
 MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutInMilliSeconds, int &priority)
 {
   CSingleLock lock(m_section);
@@ -176,29 +360,8 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
 
   while (!m_bAbortRequest)
   {
-    std::list<DVDMessageListItem> &msgs = (priority > 0 || !m_prioMessages.empty()) ? m_prioMessages : m_messages;
-
-    if (!msgs.empty() && msgs.back().priority >= priority)
+    if ((*pMsg = PopMessage(priority)) != NULL)
     {
-      DVDMessageListItem& item(msgs.back());
-      priority = item.priority;
-
-      if (item.message->IsType(CDVDMsg::DEMUXER_PACKET) && item.priority == 0)
-      {
-        DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)item.message)->GetPacket();
-        if (packet)
-        {
-          m_iDataSize -= packet->iSize;
-          if (packet->dts != DVD_NOPTS_VALUE)
-            m_TimeBack = packet->dts;
-          else if (packet->pts != DVD_NOPTS_VALUE)
-            m_TimeBack = packet->pts;
-        }
-      }
-
-      *pMsg = item.message->Acquire();
-      msgs.pop_back();
-
       ret = MSGQ_OK;
       break;
     }
@@ -210,10 +373,22 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
     else
     {
       m_hEvent.Reset();
+      m_waiting = true;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      // a writer may have put a message before it could see us waiting
+      if (HasMessage(priority))
+      {
+        m_waiting = false;
+        continue;
+      }
+
       lock.Leave();
 
       // wait for a new message
-      if (!m_hEvent.WaitMSec(iTimeoutInMilliSeconds))
+      bool signaled = m_hEvent.WaitMSec(iTimeoutInMilliSeconds);
+      m_waiting = false;
+      if (!signaled)
         return MSGQ_TIMEOUT;
 
       lock.Enter();
@@ -244,6 +419,15 @@ unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
     if(item.message->IsType(type))
       count++;
   }
+  m_ring.ForEach([type, &count](CDVDMsg* msg){
+    if(msg->IsType(type))
+      count++;
+  });
+  for (const auto &item : m_overflowMessages)
+  {
+    if(item.message->IsType(type))
+      count++;
+  }
 
   return count;
 }
@@ -259,22 +443,23 @@ void CDVDMessageQueue::WaitUntilEmpty()
 
 int CDVDMessageQueue::GetLevel() const
 {
-  CSingleLock lock(m_section);
-
-  if (m_iDataSize > m_iMaxDataSize)
+  int dataSize = m_iDataSize.load(std::memory_order_relaxed);
+  if (dataSize > m_iMaxDataSize)
     return 100;
-  if (m_iDataSize == 0)
+  if (dataSize <= 0)
     return 0;
 
-  if (IsDataBased())
+  double front = m_TimeFront.load(std::memory_order_relaxed);
+  double back = m_TimeBack.load(std::memory_order_relaxed);
+  if (back == DVD_NOPTS_VALUE || front == DVD_NOPTS_VALUE || front <= back)
   {
-    return std::min(100, 100 * m_iDataSize / m_iMaxDataSize);
+    return std::min(100, 100 * dataSize / m_iMaxDataSize);
   }
 
-  int level = std::min(100, MathUtils::round_int(100.0 * m_TimeSize * (m_TimeFront - m_TimeBack) / DVD_TIME_BASE ));
+  int level = std::min(100, MathUtils::round_int(100.0 * m_TimeSize * (front - back) / DVD_TIME_BASE ));
 
   // if we added lots of packets with NOPTS, make sure that the queue is not signalled empty
-  if (level == 0 && m_iDataSize != 0)
+  if (level == 0 && dataSize != 0)
   {
     //CLog::Log(LOGNOTICE, "CDVDMessageQueue::GetLevel() - can't determine level");
     return 1;
@@ -285,17 +470,19 @@ int CDVDMessageQueue::GetLevel() const
 
 int CDVDMessageQueue::GetTimeSize() const
 {
-  CSingleLock lock(m_section);
-
-  if (IsDataBased())
+  double front = m_TimeFront.load(std::memory_order_relaxed);
+  double back = m_TimeBack.load(std::memory_order_relaxed);
+  if (back == DVD_NOPTS_VALUE || front == DVD_NOPTS_VALUE || front <= back)
     return 0;
   else
-    return (int)((m_TimeFront - m_TimeBack) / DVD_TIME_BASE);
+    return (int)((front - back) / DVD_TIME_BASE);
 }
 
 bool CDVDMessageQueue::IsDataBased() const
 {
-  return (m_TimeBack == DVD_NOPTS_VALUE  ||
-          m_TimeFront == DVD_NOPTS_VALUE ||
-          m_TimeFront <= m_TimeBack);
+  double front = m_TimeFront.load(std::memory_order_relaxed);
+  double back = m_TimeBack.load(std::memory_order_relaxed);
+  return (back == DVD_NOPTS_VALUE  ||
+          front == DVD_NOPTS_VALUE ||
+          front <= back);
 }
@@ -24,6 +24,8 @@
 #include <string>
 #include <list>
 #include <algorithm>
+#include <atomic>
+#include <memory>
 #include "threads/CriticalSection.h"
 #include "threads/Event.h"
 
@@ -52,6 +54,54 @@ struct DVDMessageListItem
   int priority;
 };
 
+/*!
+ \brief Bounded multi producer, single consumer ring of messages.
+
+ Every cell carries a sequence number which tells producers and the consumer
+ whether it is free or filled, so Push and Pop never take a lock. Push fails
+ when the ring is full. Pop, Empty and ForEach must only be called by one
+ consumer at a time, the caller is responsible for serialising them.
+ The ring takes over the reference of pushed messages.
+ */
+class CDVDMessageRing
+{
+public:
+  explicit CDVDMessageRing(size_t capacity);
+  ~CDVDMessageRing();
+
+  bool Push(CDVDMsg* msg);
+  CDVDMsg* Pop();
+  bool Empty() const;
+
+  template<typename F>
+  void ForEach(F func) const
+  {
+    size_t end = m_enqueuePos.load(std::memory_order_acquire);
+    for (size_t pos = m_dequeuePos.load(std::memory_order_relaxed); pos != end; ++pos)
+    {
+      const Cell &cell = m_cells[pos & m_mask];
+      if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+        break;
+      func(cell.message);
+    }
+  }
+
+private:
+  CDVDMessageRing(const CDVDMessageRing&) = delete;
+  CDVDMessageRing& operator=(const CDVDMessageRing&) = delete;
+
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    CDVDMsg* message;
+  };
+
+  std::unique_ptr<Cell[]> m_cells;
+  size_t m_mask;
+  std::atomic<size_t> m_enqueuePos;
+  std::atomic<size_t> m_dequeuePos;
+};
+
 enum MsgQueueReturnCode
 {
   MSGQ_OK = 1,
@@ -89,7 +139,7 @@ public:
     return Get(pMsg, iTimeoutInMilliSeconds, priority);
   }
 
-  int GetDataSize() const { return m_iDataSize; }
+  int GetDataSize() const { return m_iDataSize.load(std::memory_order_relaxed); }
   int GetTimeSize() const;
   unsigned GetPacketCount(CDVDMsg::Message type);
   bool ReceivedAbortRequest() { return m_bAbortRequest; }
@@ -107,21 +157,34 @@ public:
   bool IsDataBased() const;
 
 private:
+  void AddPacket(CDVDMsg* pMsg);
+  void RemovePacket(CDVDMsg* pMsg, bool flush);
+  bool HasMessage(int priority) const;
+  CDVDMsg* PopMessage(int &priority);
+  void Signal();
 
   CEvent m_hEvent;
+  // serialises readers and the rarely used paths (priority, front = false,
+  // ring overflow), normal packets are put without taking it
   mutable CCriticalSection m_section;
 
   bool m_bAbortRequest;
-  bool m_bInitialized;
+  std::atomic<bool> m_bInitialized;
+  std::atomic<bool> m_waiting;
+  std::atomic<bool> m_overflow;
 
-  int m_iDataSize;
-  double m_TimeFront;
-  double m_TimeBack;
+  std::atomic<int> m_iDataSize;
+  std::atomic<double> m_TimeFront;
+  std::atomic<double> m_TimeBack;
   double m_TimeSize;
 
   int m_iMaxDataSize;
   std::string m_owner;
 
+  // normal messages in arrival order, read before ring and overflow are:
+  // messages put with front = false and the ones kept by Flush
   std::list<DVDMessageListItem> m_messages;
   std::list<DVDMessageListItem> m_prioMessages;
+  std::list<DVDMessageListItem> m_overflowMessages;
+  CDVDMessageRing m_ring;
 };
@@ -722,6 +722,8 @@ void CDVDPlayer::OnStartup()
 
   m_messenger.Init();
 
+  CDVDDemuxUtils::ResetPoolStats();
+
   CUtil::ClearTempFonts();
 }
 
@@ -2344,6 +2346,11 @@ void CDVDPlayer::OnExit()
 
     m_messenger.End();
 
+    DemuxPacketPoolStats stats;
+    CDVDDemuxUtils::GetPoolStats(stats);
+    CLog::Log(LOGDEBUG, "DVDPlayer: demux packet pool, %" PRIu64 " packets, %.1f%% from pool, high-water %d packets",
+              stats.allocations, stats.allocations ? 100.0 * stats.hits / stats.allocations : 0.0, stats.highWater);
+    CDVDDemuxUtils::TrimPool();
 
   m_bStop = true;
   // if we didn't stop playing, advance to the next item in xbmc's playlist
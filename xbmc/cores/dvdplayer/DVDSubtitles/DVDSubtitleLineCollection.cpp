@@ -20,14 +20,18 @@
 
 #include "DVDSubtitleLineCollection.h"
 
+#include <algorithm>
 
-CDVDSubtitleLineCollection::CDVDSubtitleLineCollection()
+static bool CompareStartTime(const CDVDOverlay* lhs, const CDVDOverlay* rhs)
 {
-  m_pHead = NULL;
-  m_pCurrent = NULL;
-  m_pTail = NULL;
+  return lhs->iPTSStartTime < rhs->iPTSStartTime;
+}
 
-  m_iSize = 0;
+CDVDSubtitleLineCollection::CDVDSubtitleLineCollection()
+{
+  m_iCurrent = 0;
+  m_bSorted  = true;
+  m_bIndexed = true;
 }
 
 CDVDSubtitleLineCollection::~CDVDSubtitleLineCollection()
@@ -37,85 +41,78 @@ CDVDSubtitleLineCollection::~CDVDSubtitleLineCollection()
 
 void CDVDSubtitleLineCollection::Add(CDVDOverlay* pOverlay)
 {
-  ListElement* pElement = new ListElement;
-  pElement->pOverlay = pOverlay;
-  pElement->pNext = NULL;
+  if (!m_lines.empty() && pOverlay->iPTSStartTime < m_lines.back()->iPTSStartTime)
+    m_bSorted = false;
 
-  if (!m_pHead)
-  {
-    m_pHead = m_pTail = pElement;
-    m_pCurrent = m_pHead;
-  }
-  else
-  {
-    m_pTail->pNext = pElement;
-    m_pTail = pElement;
-  }
-
-  m_iSize++;
+  m_lines.push_back(pOverlay);
+  m_bIndexed = false;
 }
 
 void CDVDSubtitleLineCollection::Sort()
 {
-  if (!m_pHead || !m_pHead->pNext)
+  // most files are in order already
+  if (m_bSorted)
     return;
-  
-  for (ListElement* p1 = m_pHead; p1->pNext != NULL; p1 = p1->pNext)
+
+  std::stable_sort(m_lines.begin(), m_lines.end(), CompareStartTime);
+  m_bSorted  = true;
+  m_bIndexed = false;
+}
+
+void CDVDSubtitleLineCollection::BuildIndex()
+{
+  m_maxStopTime.resize(m_lines.size());
+
+  double maxStopTime = 0.0;
+  for (size_t i = 0; i < m_lines.size(); i++)
   {
-    for (ListElement* p2 = p1->pNext; p2 != NULL; p2 = p2->pNext)
-    {
-      if (p1->pOverlay->iPTSStartTime > p2->pOverlay->iPTSStartTime)
-      {
-        CDVDOverlay* temp = p1->pOverlay;
-        p1->pOverlay = p2->pOverlay;
-        p2->pOverlay = temp;
-      }
-    }
+    maxStopTime = std::max(maxStopTime, m_lines[i]->iPTSStopTime);
+    m_maxStopTime[i] = maxStopTime;
   }
+  m_bIndexed = true;
 }
 
 CDVDOverlay* CDVDSubtitleLineCollection::Get(double iPts)
 {
-  CDVDOverlay* pOverlay = NULL;
+  Sort();
+  if (!m_bIndexed)
+    BuildIndex();
 
-  if (m_pCurrent)
+  if (m_iCurrent >= m_lines.size())
+    return NULL;
+
+  // skip the lines that stopped before iPts. when all lines before the current
+  // one stopped too, the first one left is where the latest stop time reaches iPts.
+  if (m_iCurrent == 0 || m_maxStopTime[m_iCurrent - 1] < iPts)
   {
-    while (m_pCurrent && m_pCurrent->pOverlay->iPTSStopTime < iPts)
-    {
-      m_pCurrent = m_pCurrent->pNext;
-    }
-
-    if (m_pCurrent)
-    {
-      pOverlay = m_pCurrent->pOverlay;
-
-      // advance to the next overlay
-      m_pCurrent = m_pCurrent->pNext;
-    }
+    m_iCurrent = std::lower_bound(m_maxStopTime.begin() + m_iCurrent, m_maxStopTime.end(), iPts) - m_maxStopTime.begin();
   }
-  return pOverlay;
+  else
+  {
+    while (m_iCurrent < m_lines.size() && m_lines[m_iCurrent]->iPTSStopTime < iPts)
+      m_iCurrent++;
+  }
+
+  if (m_iCurrent >= m_lines.size())
+    return NULL;
+
+  // advance to the next overlay
+  return m_lines[m_iCurrent++];
 }
 
 void CDVDSubtitleLineCollection::Reset()
 {
-  m_pCurrent = m_pHead;
+  m_iCurrent = 0;
 }
 
 void CDVDSubtitleLineCollection::Clear()
 {
-  ListElement* pElement = NULL;
-
-  while (m_pHead)
-  {
-    pElement = m_pHead;
-    m_pHead = pElement->pNext;
-
-    pElement->pOverlay->Release();
-    delete pElement;
-  }
-
-  m_pTail    = NULL;
-  m_pHead    = NULL;
-  m_pCurrent = NULL;
-  m_iSize    = 0;
+  for (std::vector<CDVDOverlay*>::iterator it = m_lines.begin(); it != m_lines.end(); ++it)
+    (*it)->Release();
+
+  m_lines.clear();
+  m_maxStopTime.clear();
+  m_iCurrent = 0;
+  m_bSorted  = true;
+  m_bIndexed = true;
 }
@@ -20,24 +20,22 @@
  *
  */
 
-#include "../DVDCodecs/Overlay/DVDOverlay.h"
-
-typedef struct stListElement
-{
-  CDVDOverlay* pOverlay;
-  struct stListElement* pNext;
+#include <vector>
 
-} ListElement;
+#include "../DVDCodecs/Overlay/DVDOverlay.h"
 
+/*
+ * The lines of a subtitle file, ordered by start time. Lines may overlap, so
+ * next to them we keep the latest stop time of all lines up to each position.
+ * That one only grows, which lets Get() find the first line still showing at
+ * a pts with a binary search instead of walking the list after a seek.
+ */
 class CDVDSubtitleLineCollection
 {
 public:
   CDVDSubtitleLineCollection();
   virtual ~CDVDSubtitleLineCollection();
 
-  //void Lock()   { EnterCriticalSection(&m_critSection); }
-  //void Unlock() { LeaveCriticalSection(&m_critSection); }
-
   void Add(CDVDOverlay* pSubtitle);
   void Sort();
 
@@ -45,16 +43,15 @@ public:
 
   void Reset();
 
-  void Remove();
   void Clear();
-  int GetSize() { return m_iSize; }
+  int GetSize() { return (int)m_lines.size(); }
 
 private:
-  ListElement* m_pHead;
-  ListElement* m_pCurrent;
-  ListElement* m_pTail;
+  void BuildIndex();
 
-  int m_iSize;
-  //CRITICAL_SECTION m_critSection;
+  std::vector<CDVDOverlay*> m_lines;
+  std::vector<double>       m_maxStopTime; // latest stop time of the lines up to each position
+  size_t m_iCurrent;
+  bool   m_bSorted;
+  bool   m_bIndexed;
 };
-
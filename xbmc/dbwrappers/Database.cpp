@@ -581,10 +581,11 @@ void CDatabase::Close()
 
   if (NULL == m_pDB.get() ) return ;
   if (NULL != m_pDS.get()) m_pDS->close();
-  m_pDB->disconnect();
-  m_pDB.reset();
+  // datasets may hold prepared statements of the connection, drop them first
   m_pDS.reset();
   m_pDS2.reset();
+  m_pDB->disconnect();
+  m_pDB.reset();
 }
 
 bool CDatabase::Compress(bool bForce /* =true */)
@@ -671,10 +672,57 @@ void CDatabase::RollbackTransaction()
 
 bool CDatabase::InTransaction()
 {
-  if (NULL != m_pDB.get()) return false;
+  if (NULL == m_pDB.get()) return false;
   return m_pDB->in_transaction();
 }
 
+void CDatabase::BeginBatch()
+{
+  try
+  {
+    if (NULL != m_pDB.get())
+      m_pDB->start_batch();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "database:beginbatch failed");
+  }
+}
+
+bool CDatabase::CommitBatch()
+{
+  try
+  {
+    if (NULL != m_pDB.get())
+      m_pDB->commit_batch();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "database:commitbatch failed");
+    return false;
+  }
+  return true;
+}
+
+void CDatabase::RollbackBatch()
+{
+  try
+  {
+    if (NULL != m_pDB.get())
+      m_pDB->rollback_batch();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "database:rollbackbatch failed");
+  }
+}
+
+bool CDatabase::InBatch()
+{
+  if (NULL == m_pDB.get()) return false;
+  return m_pDB->in_batch();
+}
+
 bool CDatabase::CreateDatabase()
 {
   BeginTransaction();
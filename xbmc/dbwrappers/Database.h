@@ -71,6 +71,29 @@ public:
   void RollbackTransaction();
   bool InTransaction();
 
+  /*!
+   * @brief Start a batch of writes, e.g. for a library scan.
+   *        The batch is a single transaction. Transactions started while it
+   *        is open become savepoints, they can still be rolled back on their
+   *        own but only CommitBatch() writes them to disk.
+   * @sa CommitBatch, RollbackBatch
+   */
+  void BeginBatch();
+
+  /*!
+   * @brief Commit all writes done since BeginBatch().
+   * @return True if the batch was committed, false otherwise.
+   * @sa BeginBatch
+   */
+  virtual bool CommitBatch();
+
+  /*!
+   * @brief Discard all writes done since BeginBatch().
+   * @sa BeginBatch
+   */
+  void RollbackBatch();
+  bool InBatch();
+
   std::string PrepareSQL(std::string strStmt, ...) const;
 
   /*!
@@ -49,12 +49,39 @@ Database::Database():
 {
   active = false;	// No connection yet
   compression = false;
+  batch = false;
+  savepoints = 0;
 }
 
 Database::~Database() {
   disconnect();		// Disconnect if connected to database
 }
 
+void Database::start_batch() {
+  if (batch || in_transaction())
+    return;
+  start_transaction();
+  batch = in_transaction();
+  savepoints = 0;
+}
+
+void Database::commit_batch() {
+  if (!batch)
+    return;
+  // savepoints left open are committed along with the batch
+  batch = false;
+  savepoints = 0;
+  commit_transaction();
+}
+
+void Database::rollback_batch() {
+  if (!batch)
+    return;
+  batch = false;
+  savepoints = 0;
+  rollback_transaction();
+}
+
 int Database::connectFull(const char *newHost, const char *newPort, const char *newDb, const char *newLogin,
                           const char *newPasswd, const char *newKey, const char *newCert, const char *newCA,
                           const char *newCApath, const char *newCiphers, bool newCompression) {
@@ -417,6 +444,29 @@ const sql_record* const Dataset::get_sql_record()
   return result.records[frecno];
 }
 
+bool Dataset::column_isNull(int index) {
+  return get_field_value(index).get_isNull();
+}
+
+int Dataset::column_asInt(int index) {
+  return get_field_value(index).get_asInt();
+}
+
+int64_t Dataset::column_asInt64(int index) {
+  return get_field_value(index).get_asInt64();
+}
+
+double Dataset::column_asDouble(int index) {
+  return get_field_value(index).get_asDouble();
+}
+
+const char *Dataset::column_asText(int index, size_t *length) {
+  if (ds_state != dsSelect || index < 0 || index >= field_count())
+    throw DbErrors("Field index not found: %d",index);
+
+  return (*fields_object)[index].val.get_asCString(length);
+}
+
 const field_value Dataset::f_old(const char *f_name) {
   if (ds_state != dsInactive)
     for (int unsigned i=0; i < fields_object->size(); i++) 
@@ -66,6 +66,8 @@ class Database  {
 protected:
   bool active;
   bool compression;
+  bool batch;               // transactions nest as savepoints while a batch is open
+  unsigned int savepoints;  // open savepoints inside the batch
   std::string error, // Error description
     host, port, db, login, passwd, //Login info
     sequence_table, //Sequence table for nextid
@@ -148,6 +150,15 @@ public:
   virtual void commit_transaction() {};
   virtual void rollback_transaction() {};
 
+/* methods for batches: a transaction where transactions started inside it
+   become savepoints, so they can be rolled back on their own and
+   committing them doesn't end the batch */
+
+  void start_batch();
+  void commit_batch();
+  void rollback_batch();
+  bool in_batch() const { return batch; }
+
 /* virtual methods for formatting */
 
   /*! \brief Prepare a SQL statement for execution or querying using C printf nomenclature.
@@ -403,7 +414,23 @@ public:
 
 /* --------------- for fast access ---------------- */
   const result_set& get_result_set() { return result; }
-  const sql_record* const get_sql_record();
+  virtual const sql_record* const get_sql_record();
+
+/* ---------- forward-only cursor mode ------------ */
+/* Opens a select query as a forward-only cursor. Rows are fetched one at a
+   time by next() instead of being buffered in the result set, so num_rows()
+   only counts the rows visited so far and prev(), last() and seek() are not
+   supported. The default implementation falls back to query(). */
+  virtual bool query_cursor(const std::string &sql) { return query(sql); }
+/* returns true if the dataset was opened with query_cursor() */
+  virtual bool is_cursor() { return false; }
+/* typed access to the columns of the current row */
+  virtual bool column_isNull(int index);
+  virtual int column_asInt(int index);
+  virtual int64_t column_asInt64(int index);
+  virtual double column_asDouble(int index);
+/* returns the column text of the current row, valid until the row changes */
+  virtual const char *column_asText(int index, size_t *length = NULL);
 
  private:
 
@@ -261,6 +261,9 @@ void MysqlDatabase::disconnect(void) {
   }
 
   active = false;
+  _in_transaction = false;
+  batch = false;
+  savepoints = 0;
 }
 
 int MysqlDatabase::create() {
@@ -503,6 +506,11 @@ long MysqlDatabase::nextid(const char* sname) {
 void MysqlDatabase::start_transaction() {
   if (active)
   {
+    if (batch)
+    {
+      mysql_query(conn, StringUtils::Format("SAVEPOINT sp%u", ++savepoints).c_str());
+      return;
+    }
     mysql_autocommit(conn, false);
     CLog::Log(LOGDEBUG,"Mysql Start transaction");
     _in_transaction = true;
@@ -512,6 +520,12 @@ void MysqlDatabase::start_transaction() {
 void MysqlDatabase::commit_transaction() {
   if (active)
   {
+    if (batch)
+    {
+      if (savepoints > 0)
+        mysql_query(conn, StringUtils::Format("RELEASE SAVEPOINT sp%u", savepoints--).c_str());
+      return;
+    }
     mysql_commit(conn);
     mysql_autocommit(conn, true);
     CLog::Log(LOGDEBUG,"Mysql commit transaction");
@@ -522,6 +536,15 @@ void MysqlDatabase::commit_transaction() {
 void MysqlDatabase::rollback_transaction() {
   if (active)
   {
+    if (batch)
+    {
+      if (savepoints > 0)
+      {
+        mysql_query(conn, StringUtils::Format("ROLLBACK TO SAVEPOINT sp%u", savepoints).c_str());
+        mysql_query(conn, StringUtils::Format("RELEASE SAVEPOINT sp%u", savepoints--).c_str());
+      }
+      return;
+    }
     mysql_rollback(conn);
     mysql_autocommit(conn, true);
     CLog::Log(LOGDEBUG,"Mysql rollback transaction");
@@ -224,6 +224,15 @@ std::string field_value::get_asString() const {
   }
 
 
+const char *field_value::get_asCString(size_t *length) {
+  if (field_type != ft_String)
+    str_value = get_asString();
+  if (length)
+    *length = str_value.size();
+  return str_value.c_str();
+}
+
+
 
 bool field_value::get_asBool() const {
     switch (field_type) {
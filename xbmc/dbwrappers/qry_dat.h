@@ -102,6 +102,9 @@ public:
   float get_asFloat() const;
   double get_asDouble() const;
   int64_t get_asInt64() const;
+/* returns the value as C string, non string types are formatted into the
+   internal buffer. The pointer is valid until the value is modified */
+  const char *get_asCString(size_t *length = NULL);
 
   field_value& operator= (const char *s)
     {set_asString(s); return *this;}
@@ -175,7 +178,7 @@ public:
   }
   }
 
-  void set_isNull(){is_null=true;}
+  void set_isNull(bool null = true){is_null=null;}
   void set_asString(const char *s);
   void set_asString(const std::string & s);
   void set_asBool(const bool b);
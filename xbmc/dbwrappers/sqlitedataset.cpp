@@ -81,6 +81,34 @@ static int busy_callback(void*, int busyCount)
   return 1;
 }
 
+static void load_column(sqlite3_stmt *stmt, int i, field_value &v)
+{
+  switch (sqlite3_column_type(stmt, i))
+  {
+  case SQLITE_INTEGER:
+    v.set_asInt64(sqlite3_column_int64(stmt, i));
+    v.set_isNull(false);
+    break;
+  case SQLITE_FLOAT:
+    v.set_asDouble(sqlite3_column_double(stmt, i));
+    v.set_isNull(false);
+    break;
+  case SQLITE_TEXT:
+  case SQLITE_BLOB:
+    v.set_asString((const char *)sqlite3_column_text(stmt, i));
+    v.set_isNull(false);
+    break;
+  case SQLITE_NULL:
+  default:
+    v.set_asString("");
+    v.set_isNull();
+    break;
+  }
+}
+
+// number of prepared statements kept per connection
+static const size_t STATEMENT_CACHE_SIZE = 32;
+
 //************* SqliteDatabase implementation ***************
 
 SqliteDatabase::SqliteDatabase() {
@@ -261,8 +289,14 @@ bool SqliteDatabase::exists(void)
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
-  sqlite3_close(conn);
+  clear_statements();
+  // close_v2 defers the close until any statement still held by a dataset is finalized
+  sqlite3_close_v2(conn);
+  conn = nullptr;
   active = false;
+  _in_transaction = false;
+  batch = false;
+  savepoints = 0;
 }
 
 int SqliteDatabase::create() {
@@ -396,6 +430,12 @@ long SqliteDatabase::nextid(const char* sname) {
 // ---------------------------------------------
 void SqliteDatabase::start_transaction() {
   if (active) {
+    if (batch) {
+      char sqlcmd[32];
+      sprintf(sqlcmd, "savepoint sp%u", ++savepoints);
+      sqlite3_exec(conn,sqlcmd,NULL,NULL,NULL);
+      return;
+    }
     sqlite3_exec(conn,"begin IMMEDIATE",NULL,NULL,NULL);
     _in_transaction = true;
   }
@@ -403,6 +443,14 @@ void SqliteDatabase::start_transaction() {
 
 void SqliteDatabase::commit_transaction() {
   if (active) {
+    if (batch) {
+      if (savepoints > 0) {
+        char sqlcmd[32];
+        sprintf(sqlcmd, "release sp%u", savepoints--);
+        sqlite3_exec(conn,sqlcmd,NULL,NULL,NULL);
+      }
+      return;
+    }
     sqlite3_exec(conn,"commit",NULL,NULL,NULL);
     _in_transaction = false;
   }
@@ -410,12 +458,69 @@ void SqliteDatabase::commit_transaction() {
 
 void SqliteDatabase::rollback_transaction() {
   if (active) {
+    if (batch) {
+      if (savepoints > 0) {
+        char sqlcmd[64];
+        sprintf(sqlcmd, "rollback to sp%u; release sp%u", savepoints, savepoints);
+        savepoints--;
+        sqlite3_exec(conn,sqlcmd,NULL,NULL,NULL);
+      }
+      return;
+    }
     sqlite3_exec(conn,"rollback",NULL,NULL,NULL);
     _in_transaction = false;
   }  
 }
 
 
+// methods for the prepared statement cache
+// ---------------------------------------------
+int SqliteDatabase::acquire_statement(const std::string &sql, sqlite3_stmt **stmt) {
+  std::map<std::string, StatementList::iterator>::iterator it = stmt_index.find(sql);
+  if (it != stmt_index.end())
+  {
+    // hand out the cached statement, a second user of the same sql gets its own
+    *stmt = it->second->second;
+    stmt_cache.erase(it->second);
+    stmt_index.erase(it);
+    return SQLITE_OK;
+  }
+
+  *stmt = NULL;
+  return sqlite3_prepare_v2(conn, sql.c_str(), -1, stmt, NULL);
+}
+
+void SqliteDatabase::release_statement(const std::string &sql, sqlite3_stmt *stmt) {
+  if (stmt == NULL)
+    return;
+
+  if (!active || stmt_index.find(sql) != stmt_index.end())
+  {
+    sqlite3_finalize(stmt);
+    return;
+  }
+
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+  stmt_cache.push_front(std::make_pair(sql, stmt));
+  stmt_index[sql] = stmt_cache.begin();
+
+  if (stmt_cache.size() > STATEMENT_CACHE_SIZE)
+  {
+    stmt_index.erase(stmt_cache.back().first);
+    sqlite3_finalize(stmt_cache.back().second);
+    stmt_cache.pop_back();
+  }
+}
+
+void SqliteDatabase::clear_statements() {
+  for (StatementList::iterator it = stmt_cache.begin(); it != stmt_cache.end(); ++it)
+    sqlite3_finalize(it->second);
+  stmt_cache.clear();
+  stmt_index.clear();
+}
+
+
 // methods for formatting
 // ---------------------------------------------
 std::string SqliteDatabase::vprepare(const char *format, va_list args)
@@ -455,6 +560,10 @@ SqliteDataset::SqliteDataset():Dataset() {
   db = NULL;
   errmsg = NULL;
   autorefresh = false;
+  cursor_stmt = NULL;
+  cursor_fields_loaded = false;
+  cursor_record_loaded = false;
+  cursor_rows = 0;
 }
 
 
@@ -463,9 +572,14 @@ SqliteDataset::SqliteDataset(SqliteDatabase *newDb):Dataset(newDb) {
   db = newDb;
   errmsg = NULL;
   autorefresh = false;
+  cursor_stmt = NULL;
+  cursor_fields_loaded = false;
+  cursor_record_loaded = false;
+  cursor_rows = 0;
 }
 
  SqliteDataset::~SqliteDataset(){
+   close_cursor();
    if (errmsg) sqlite3_free(errmsg);
  }
 
@@ -650,8 +764,9 @@ bool SqliteDataset::query(const std::string &query) {
 
   close();
 
+  SqliteDatabase *sqlite = static_cast<SqliteDatabase*>(db);
   sqlite3_stmt *stmt = NULL;
-  if (db->setErr(sqlite3_prepare_v2(handle(),query.c_str(),-1,&stmt, NULL),query.c_str()) != SQLITE_OK)
+  if (db->setErr(sqlite->acquire_statement(query, &stmt),query.c_str()) != SQLITE_OK)
     throw DbErrors(db->getErrorMsg());
 
   // column headers
@@ -661,37 +776,17 @@ bool SqliteDataset::query(const std::string &query) {
     result.record_header[i].name = sqlite3_column_name(stmt, i);
 
   // returned rows
-  while (sqlite3_step(stmt) == SQLITE_ROW)
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
   { // have a row of data
     sql_record *res = new sql_record;
     res->resize(numColumns);
     for (unsigned int i = 0; i < numColumns; i++)
-    {
-      field_value &v = res->at(i);
-      switch (sqlite3_column_type(stmt, i))
-      {
-      case SQLITE_INTEGER:
-        v.set_asInt64(sqlite3_column_int64(stmt, i));
-        break;
-      case SQLITE_FLOAT:
-        v.set_asDouble(sqlite3_column_double(stmt, i));
-        break;
-      case SQLITE_TEXT:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_BLOB:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_NULL:
-      default:
-        v.set_asString("");
-        v.set_isNull();
-        break;
-      }
-    }
+      load_column(stmt, i, res->at(i));
     result.records.push_back(res);
   }
-  if (db->setErr(sqlite3_finalize(stmt),query.c_str()) == SQLITE_OK)
+  sqlite->release_statement(query, stmt);
+  if (db->setErr(rc == SQLITE_DONE ? SQLITE_OK : rc,query.c_str()) == SQLITE_OK)
   {
     active = true;
     ds_state = dsSelect;
@@ -704,6 +799,101 @@ bool SqliteDataset::query(const std::string &query) {
   }  
 }
 
+bool SqliteDataset::query_cursor(const std::string &query) {
+  if(!handle()) throw DbErrors("No Database Connection");
+  if (query.find("select") == std::string::npos && query.find("SELECT") == std::string::npos)
+    throw DbErrors("MUST be select SQL!");
+
+  close();
+
+  sqlite3_stmt *stmt = NULL;
+  if (db->setErr(static_cast<SqliteDatabase*>(db)->acquire_statement(query, &stmt),query.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+
+  cursor_stmt = stmt;
+  cursor_sql = query;
+  cursor_rows = 0;
+
+  // column headers
+  const unsigned int numColumns = sqlite3_column_count(stmt);
+  result.record_header.resize(numColumns);
+  fields_object->resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    result.record_header[i].name = sqlite3_column_name(stmt, i);
+    (*fields_object)[i].props = result.record_header[i];
+  }
+
+  active = true;
+  ds_state = dsSelect;
+  cursor_step();
+  fbof = feof;
+  return true;
+}
+
+void SqliteDataset::cursor_step() {
+  cursor_fields_loaded = false;
+  cursor_record_loaded = false;
+
+  int rc = sqlite3_step(cursor_stmt);
+  if (rc == SQLITE_ROW)
+  {
+    frecno = cursor_rows++;
+    feof = false;
+    return;
+  }
+
+  feof = true;
+  if (rc != SQLITE_DONE)
+  {
+    db->setErr(rc, cursor_sql.c_str());
+    close();
+    throw DbErrors(db->getErrorMsg());
+  }
+}
+
+void SqliteDataset::cursor_load_fields() {
+  if (cursor_fields_loaded || feof)
+    return;
+
+  const unsigned int ncols = fields_object->size();
+  for (unsigned int i = 0; i < ncols; i++)
+    load_column(cursor_stmt, i, (*fields_object)[i].val);
+  cursor_fields_loaded = true;
+}
+
+void SqliteDataset::cursor_load_record() {
+  if (cursor_record_loaded || feof)
+    return;
+
+  const unsigned int ncols = result.record_header.size();
+  cursor_record.resize(ncols);
+  for (unsigned int i = 0; i < ncols; i++)
+    load_column(cursor_stmt, i, cursor_record[i]);
+  cursor_record_loaded = true;
+}
+
+void SqliteDataset::cursor_check_column(int index) {
+  if (feof || index < 0 || index >= (int)result.record_header.size())
+    throw DbErrors("Field index not found: %d",index);
+}
+
+void SqliteDataset::close_cursor() {
+  if (cursor_stmt == NULL)
+    return;
+
+  if (db != NULL)
+    static_cast<SqliteDatabase*>(db)->release_statement(cursor_sql, cursor_stmt);
+  else
+    sqlite3_finalize(cursor_stmt);
+  cursor_stmt = NULL;
+  cursor_sql.clear();
+  cursor_record.clear();
+  cursor_fields_loaded = false;
+  cursor_record_loaded = false;
+  cursor_rows = 0;
+}
+
 void SqliteDataset::open(const std::string &sql) {
   set_select_sql(sql);
   open();
@@ -720,6 +910,7 @@ void SqliteDataset::open() {
 
 
 void SqliteDataset::close() {
+  close_cursor();
   Dataset::close();
   result.clear();
   edit_object->clear();
@@ -740,6 +931,8 @@ void SqliteDataset::cancel() {
 
 
 int SqliteDataset::num_rows() {
+  if (cursor_stmt)
+    return cursor_rows;
   return result.records.size();
 }
 
@@ -755,21 +948,40 @@ bool SqliteDataset::bof() {
 
 
 void SqliteDataset::first() {
+  if (cursor_stmt)
+  {
+    if (cursor_rows > 1)
+      throw DbErrors("Can't rewind a forward-only cursor");
+    return;
+  }
   Dataset::first();
   this->fill_fields();
 }
 
 void SqliteDataset::last() {
+  if (cursor_stmt)
+    throw DbErrors("Can't seek in a forward-only cursor");
   Dataset::last();
   fill_fields();
 }
 
 void SqliteDataset::prev(void) {
+  if (cursor_stmt)
+    throw DbErrors("Can't seek in a forward-only cursor");
   Dataset::prev();
   fill_fields();
 }
 
 void SqliteDataset::next(void) {
+  if (cursor_stmt)
+  {
+    if (ds_state == dsSelect && !feof)
+    {
+      fbof = false;
+      cursor_step();
+    }
+    return;
+  }
   Dataset::next();
   if (!eof()) 
       fill_fields();
@@ -789,6 +1001,8 @@ void SqliteDataset::free_row(void)
 }
 
 bool SqliteDataset::seek(int pos) {
+  if (cursor_stmt)
+    throw DbErrors("Can't seek in a forward-only cursor");
   if (ds_state == dsSelect) {
     Dataset::seek(pos);
     fill_fields();
@@ -797,6 +1011,67 @@ bool SqliteDataset::seek(int pos) {
   return false;
 }
 
+const field_value SqliteDataset::get_field_value(const char *f_name) {
+  if (cursor_stmt)
+    cursor_load_fields();
+  return Dataset::get_field_value(f_name);
+}
+
+const field_value SqliteDataset::get_field_value(int index) {
+  if (cursor_stmt)
+    cursor_load_fields();
+  return Dataset::get_field_value(index);
+}
+
+const sql_record* const SqliteDataset::get_sql_record() {
+  if (cursor_stmt)
+  {
+    if (feof)
+      return NULL;
+    cursor_load_record();
+    return &cursor_record;
+  }
+  return Dataset::get_sql_record();
+}
+
+bool SqliteDataset::column_isNull(int index) {
+  if (!cursor_stmt)
+    return Dataset::column_isNull(index);
+  cursor_check_column(index);
+  return sqlite3_column_type(cursor_stmt, index) == SQLITE_NULL;
+}
+
+int SqliteDataset::column_asInt(int index) {
+  if (!cursor_stmt)
+    return Dataset::column_asInt(index);
+  cursor_check_column(index);
+  return sqlite3_column_int(cursor_stmt, index);
+}
+
+int64_t SqliteDataset::column_asInt64(int index) {
+  if (!cursor_stmt)
+    return Dataset::column_asInt64(index);
+  cursor_check_column(index);
+  return sqlite3_column_int64(cursor_stmt, index);
+}
+
+double SqliteDataset::column_asDouble(int index) {
+  if (!cursor_stmt)
+    return Dataset::column_asDouble(index);
+  cursor_check_column(index);
+  return sqlite3_column_double(cursor_stmt, index);
+}
+
+const char *SqliteDataset::column_asText(int index, size_t *length) {
+  if (!cursor_stmt)
+    return Dataset::column_asText(index, length);
+  cursor_check_column(index);
+  const char *text = (const char *)sqlite3_column_text(cursor_stmt, index);
+  if (length)
+    *length = text ? sqlite3_column_bytes(cursor_stmt, index) : 0;
+  return text ? text : "";
+}
+
 int64_t SqliteDataset::lastinsertid()
 {
   if(!handle()) throw DbErrors("No Database Connection");
@@ -30,6 +30,8 @@
 #define _SQLITEDATASET_H
 
 #include <stdio.h>
+#include <list>
+#include <map>
 #include "dataset.h"
 #include <sqlite3.h>
 
@@ -46,6 +48,12 @@ protected:
   bool _in_transaction;
   int last_err;
 
+/* prepared statement cache, most recently used first */
+  typedef std::list< std::pair<std::string, sqlite3_stmt*> > StatementList;
+  StatementList stmt_cache;
+  std::map<std::string, StatementList::iterator> stmt_index;
+  void clear_statements();
+
 public:
 /* default constructor */
   SqliteDatabase();
@@ -97,6 +105,12 @@ public:
 
   bool in_transaction() {return _in_transaction;}; 	
 
+/* takes a prepared statement for sql out of the cache or prepares a new one,
+   returns the sqlite error code */
+  int acquire_statement(const std::string &sql, sqlite3_stmt **stmt);
+/* resets a statement obtained by acquire_statement() and returns it to the cache */
+  void release_statement(const std::string &sql, sqlite3_stmt *stmt);
+
 };
 
 
@@ -128,6 +142,21 @@ protected:
 /* Changing field values during dataset navigation */
   virtual void free_row();  // free the memory allocated for the current row
 
+/* forward-only cursor state */
+  sqlite3_stmt *cursor_stmt;
+  std::string cursor_sql;
+  sql_record cursor_record;
+  bool cursor_fields_loaded;
+  bool cursor_record_loaded;
+  int cursor_rows;
+/* steps the cursor statement to the next row */
+  void cursor_step();
+/* copies the current cursor row into fields_object / cursor_record on demand */
+  void cursor_load_fields();
+  void cursor_load_record();
+  void cursor_check_column(int index);
+  void close_cursor();
+
 public:
 /* constructor */
   SqliteDataset();
@@ -149,6 +178,9 @@ or insert() operations default = false) */
   virtual const void* getExecRes();
 /* as open, but with our query exept Sql */
   virtual bool query(const std::string &query);
+/* as query, but rows are stepped on demand instead of buffered */
+  virtual bool query_cursor(const std::string &query);
+  virtual bool is_cursor() { return cursor_stmt != NULL; }
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
@@ -172,6 +204,16 @@ or insert() operations default = false) */
   virtual bool seek(int pos=0);
 
   virtual bool dropIndex(const char *table, const char *index);
+
+  virtual const field_value get_field_value(const char *f_name);
+  virtual const field_value get_field_value(int index);
+  virtual const sql_record* const get_sql_record();
+
+  virtual bool column_isNull(int index);
+  virtual int column_asInt(int index);
+  virtual int64_t column_asInt64(int index);
+  virtual double column_asDouble(int index);
+  virtual const char *column_asText(int index, size_t *length = NULL);
 };
 } //namespace
 #endif
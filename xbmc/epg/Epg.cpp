@@ -21,6 +21,7 @@
 #include "Epg.h"
 
 #include <utility>
+#include <vector>
 
 #include "addons/include/xbmc_epg_types.h"
 #include "EpgContainer.h"
@@ -328,30 +329,41 @@ bool CEpg::UpdateEntry(const CEpgInfoTag &tag, bool bUpdateDatabase /* = false *
     bNewTag = true;
   }
 
+  /* only write new tags and tags with new data, a refresh mostly returns what we have */
+  bool bChanged(bNewTag || infoTag->HasChangedData(tag));
+
   infoTag->Update(tag, bNewTag);
   infoTag->SetEpg(this);
   infoTag->SetPVRChannel(m_pvrChannel);
 
-  if (bUpdateDatabase)
-    m_changedTags.insert(make_pair(infoTag->UniqueBroadcastID(), infoTag));
+  if (bUpdateDatabase && bChanged)
+    m_changedTags[infoTag->StartAsUTC()] = infoTag;
 
   return true;
 }
 
 bool CEpg::Load(void)
 {
-  bool bReturn(false);
   CEpgDatabase *database = g_EpgContainer.GetDatabase();
 
   if (!database || !database->IsOpen())
   {
     CLog::Log(LOGERROR, "EPG - %s - could not open the database", __FUNCTION__);
-    return bReturn;
+    return false;
   }
 
   CSingleLock lock(m_critSection);
-  int iEntriesLoaded = database->Get(*this);
-  if (iEntriesLoaded <= 0)
+  database->Get(*this);
+
+  return Loaded();
+}
+
+bool CEpg::Loaded(void)
+{
+  bool bReturn(false);
+
+  CSingleLock lock(m_critSection);
+  if (m_tags.empty())
   {
     CLog::Log(LOGDEBUG, "EPG - %s - no database entries found for table '%s'.", __FUNCTION__, m_strName.c_str());
   }
@@ -501,16 +513,31 @@ int CEpg::Get(CFileItemList &results, const EpgSearchFilter &filter) const
 
   CSingleLock lock(m_critSection);
 
-  for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+  /* all tags of this table share its channel */
+  if (m_tags.empty() || !filter.FilterChannel(*m_tags.begin()->second))
+    return 0;
+
+  /* the tags are sorted by start time, only look at those that can match the
+     filter's time range. the range is in local time, allow for a day of offset. */
+  std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin();
+  std::map<CDateTime, CEpgInfoTagPtr>::const_iterator end = m_tags.end();
+  if (filter.m_startDateTime.IsValid())
+    it = m_tags.lower_bound(filter.m_startDateTime.GetAsUTCDateTime() - CDateTimeSpan(1, 0, 0, 0));
+  if (filter.m_endDateTime.IsValid())
+    end = m_tags.upper_bound(filter.m_endDateTime.GetAsUTCDateTime() + CDateTimeSpan(1, 0, 0, 0));
+  if (it != m_tags.end() && end != m_tags.end() && end->first < it->first)
+    return 0;
+
+  for (; it != end && it != m_tags.end(); ++it)
   {
-    if (filter.FilterEntry(*it->second))
+    if (filter.FilterTag(*it->second))
       results.Add(CFileItemPtr(new CFileItem(it->second)));
   }
 
   return results.Size() - iInitialSize;
 }
 
-bool CEpg::Persist(void)
+bool CEpg::Persist(bool bCommit /* = true */)
 {
   if (CSettings::GetInstance().GetBool(CSettings::SETTING_EPG_IGNOREDBFORCLIENT) || !NeedsSave())
     return true;
@@ -535,10 +562,21 @@ bool CEpg::Persist(void)
         m_iEpgID = iId;
     }
 
-    for (std::map<int, CEpgInfoTagPtr>::iterator it = m_deletedTags.begin(); it != m_deletedTags.end(); ++it)
-      database->Delete(*it->second);
+    /* deletes are queued ahead of the writes, an entry may be replaced by one with the same start time */
+    if (!m_deletedTags.empty())
+    {
+      std::vector<time_t> startTimes;
+      startTimes.reserve(m_deletedTags.size());
+      for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_deletedTags.begin(); it != m_deletedTags.end(); ++it)
+      {
+        time_t iStartTime;
+        it->first.GetAsTime(iStartTime);
+        startTimes.push_back(iStartTime);
+      }
+      database->Delete(*this, startTimes, true);
+    }
 
-    for (std::map<int, CEpgInfoTagPtr>::iterator it = m_changedTags.begin(); it != m_changedTags.end(); ++it)
+    for (std::map<CDateTime, CEpgInfoTagPtr>::iterator it = m_changedTags.begin(); it != m_changedTags.end(); ++it)
       it->second->Persist(false);
 
     if (m_bUpdateLastScanTime)
@@ -551,7 +589,7 @@ bool CEpg::Persist(void)
     m_bUpdateLastScanTime = false;
   }
 
-  return database->CommitInsertQueries();
+  return bCommit ? database->CommitInsertQueries() : true;
 }
 
 CDateTime CEpg::GetFirstDate(void) const
@@ -599,7 +637,10 @@ bool CEpg::FixOverlappingEvents(bool bUpdateDb /* = false */)
     {
       // delete the current tag. it's completely overlapped
       if (bUpdateDb)
-        m_deletedTags.insert(make_pair(currentTag->UniqueBroadcastID(), currentTag));
+      {
+        m_deletedTags[it->first] = currentTag;
+        m_changedTags.erase(it->first);
+      }
 
       if (m_nowActiveStart == it->first)
         m_nowActiveStart.SetValid(false);
@@ -611,7 +652,7 @@ bool CEpg::FixOverlappingEvents(bool bUpdateDb /* = false */)
     {
       previousTag->SetEndFromUTC(currentTag->StartAsUTC());
       if (bUpdateDb)
-        m_changedTags.insert(make_pair(previousTag->UniqueBroadcastID(), previousTag));
+        m_changedTags[previousTag->StartAsUTC()] = previousTag;
 
       previousTag = it->second;
     }
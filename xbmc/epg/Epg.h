@@ -75,6 +75,12 @@ namespace EPG
      */
     bool Load(void);
 
+    /*!
+     * @brief Mark this table as loaded, once its entries were added by CEpgDatabase::Get().
+     * @return True if any entries were loaded, false otherwise.
+     */
+    bool Loaded(void);
+
     /*!
      * @brief The channel this EPG belongs to.
      * @return The channel this EPG belongs to
@@ -240,10 +246,11 @@ namespace EPG
     int Get(CFileItemList &results, const EpgSearchFilter &filter) const;
 
     /*!
-     * @brief Persist this table in the database.
+     * @brief Persist the new, changed and removed entries of this table in the database.
+     * @param bCommit False to leave the queued writes for the caller to commit, together with those of other tables.
      * @return True if the table was persisted, false otherwise.
      */
-    bool Persist(void);
+    bool Persist(bool bCommit = true);
 
     /*!
      * @brief Get the start time of the first entry in this table.
@@ -350,8 +357,8 @@ namespace EPG
     bool IsRemovableTag(const EPG::CEpgInfoTag &tag) const;
 
     std::map<CDateTime, CEpgInfoTagPtr> m_tags;
-    std::map<int, CEpgInfoTagPtr>       m_changedTags;
-    std::map<int, CEpgInfoTagPtr>       m_deletedTags;
+    std::map<CDateTime, CEpgInfoTagPtr> m_changedTags;     /*!< new or changed tags to write, by start time */
+    std::map<CDateTime, CEpgInfoTagPtr> m_deletedTags;     /*!< tags to remove from the database, by start time */
     bool                                m_bChanged;        /*!< true if anything changed that needs to be persisted, false otherwise */
     bool                                m_bTagsChanged;    /*!< true when any tags are changed and not persisted, false otherwise */
     bool                                m_bLoaded;         /*!< true when the initial entries have been loaded */
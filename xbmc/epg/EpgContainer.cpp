@@ -260,13 +260,19 @@ void CEpgContainer::LoadFromDB(void)
     m_database.DeleteOldEpgEntries();
     m_database.Get(*this);
 
+    /* read the entries of all tables in one go instead of a query per table */
+    auto copy = m_epgs;
+    lock.Leave();
+    m_database.Get(copy);
+    lock.Enter();
+
     for (const auto &epgEntry : m_epgs)
     {
       if (m_bStop)
         break;
       UpdateProgressDialog(++iCounter, m_epgs.size(), epgEntry.second->Name());
       lock.Leave();
-      epgEntry.second->Load();
+      epgEntry.second->Loaded();
       lock.Enter();
     }
 
@@ -299,15 +305,19 @@ bool CEpgContainer::PersistAll(void)
   auto copy = m_epgs;
   m_critSection.unlock();
 
+  /* the changes of all tables are written in a single transaction */
   for (EPGMAP::const_iterator it = copy.begin(); it != copy.end() && !m_bStop; ++it)
   {
     CEpgPtr epg = it->second;
     if (epg && epg->NeedsSave())
     {
-      bReturn &= epg->Persist();
+      bReturn &= epg->Persist(false);
     }
   }
 
+  if (m_database.IsOpen())
+    bReturn &= m_database.CommitInsertQueries();
+
   return bReturn;
 }
 
@@ -18,6 +18,7 @@
  *
  */
 
+#include <algorithm>
 #include <cstdlib>
 
 #include "system.h"
@@ -174,6 +175,39 @@ bool CEpgDatabase::Delete(const CEpgInfoTag &tag)
   return DeleteValues("epgtags", filter);
 }
 
+bool CEpgDatabase::Delete(const CEpg &table, const std::vector<time_t> &startTimes, bool bQueueWrite /* = false */)
+{
+  if (table.EpgID() <= 0)
+  {
+    CLog::Log(LOGERROR, "EpgDB - %s - invalid channel id: %d", __FUNCTION__, table.EpgID());
+    return false;
+  }
+
+  /* start times are unique within a table, so entries that were never read back
+     from the database can be removed too. keep the statements reasonably short. */
+  static const size_t iMaxTimesPerQuery = 500;
+
+  bool bReturn(true);
+  for (size_t iFirst = 0; iFirst < startTimes.size(); iFirst += iMaxTimesPerQuery)
+  {
+    size_t iLast = std::min(startTimes.size(), iFirst + iMaxTimesPerQuery);
+
+    std::string strTimes;
+    for (size_t i = iFirst; i < iLast; ++i)
+    {
+      if (!strTimes.empty())
+        strTimes += ",";
+      strTimes += StringUtils::Format("%u", (unsigned int)startTimes[i]);
+    }
+
+    std::string strQuery = PrepareSQL("DELETE FROM epgtags WHERE idEpg = %u AND iStartTime IN (%s);",
+        table.EpgID(), strTimes.c_str());
+    bReturn &= bQueueWrite ? QueueInsertQuery(strQuery) : ExecuteQuery(strQuery);
+  }
+
+  return bReturn;
+}
+
 int CEpgDatabase::Get(CEpgContainer &container)
 {
   int iReturn(-1);
@@ -219,46 +253,7 @@ int CEpgDatabase::Get(CEpg &epg)
       while (!m_pDS->eof())
       {
         CEpgInfoTagPtr newTag(new CEpgInfoTag());
-
-        time_t iStartTime, iEndTime, iFirstAired;
-        iStartTime = (time_t) m_pDS->fv("iStartTime").get_asInt();
-        CDateTime startTime(iStartTime);
-        newTag->m_startTime = startTime;
-
-        iEndTime = (time_t) m_pDS->fv("iEndTime").get_asInt();
-        CDateTime endTime(iEndTime);
-        newTag->m_endTime = endTime;
-
-        iFirstAired = (time_t) m_pDS->fv("iFirstAired").get_asInt();
-        CDateTime firstAired(iFirstAired);
-        newTag->m_firstAired = firstAired;
-
-        int iBroadcastUID = m_pDS->fv("iBroadcastUid").get_asInt();
-        // Compat: null value for broadcast uid changed from numerical -1 to 0 with PVR Addon API v4.0.0
-        newTag->m_iUniqueBroadcastID = iBroadcastUID == -1 ? PVR_TIMER_NO_EPG_UID : iBroadcastUID;
-
-        newTag->m_iBroadcastId       = m_pDS->fv("idBroadcast").get_asInt();
-        newTag->m_strTitle           = m_pDS->fv("sTitle").get_asString().c_str();
-        newTag->m_strPlotOutline     = m_pDS->fv("sPlotOutline").get_asString().c_str();
-        newTag->m_strPlot            = m_pDS->fv("sPlot").get_asString().c_str();
-        newTag->m_strOriginalTitle   = m_pDS->fv("sOriginalTitle").get_asString().c_str();
-        newTag->m_strCast            = m_pDS->fv("sCast").get_asString().c_str();
-        newTag->m_strDirector        = m_pDS->fv("sDirector").get_asString().c_str();
-        newTag->m_strWriter          = m_pDS->fv("sWriter").get_asString().c_str();
-        newTag->m_iYear              = m_pDS->fv("iYear").get_asInt();
-        newTag->m_strIMDBNumber      = m_pDS->fv("sIMDBNumber").get_asString().c_str();
-        newTag->m_iGenreType         = m_pDS->fv("iGenreType").get_asInt();
-        newTag->m_iGenreSubType      = m_pDS->fv("iGenreSubType").get_asInt();
-        newTag->m_genre              = StringUtils::Split(m_pDS->fv("sGenre").get_asString().c_str(), g_advancedSettings.m_videoItemSeparator);
-        newTag->m_iParentalRating    = m_pDS->fv("iParentalRating").get_asInt();
-        newTag->m_iStarRating        = m_pDS->fv("iStarRating").get_asInt();
-        newTag->m_bNotify            = m_pDS->fv("bNotify").get_asBool();
-        newTag->m_iEpisodeNumber     = m_pDS->fv("iEpisodeId").get_asInt();
-        newTag->m_iEpisodePart       = m_pDS->fv("iEpisodePart").get_asInt();
-        newTag->m_strEpisodeName     = m_pDS->fv("sEpisodeName").get_asString().c_str();
-        newTag->m_iSeriesNumber      = m_pDS->fv("iSeriesId").get_asInt();
-        newTag->m_strIconPath        = m_pDS->fv("sIconPath").get_asString().c_str();
-        newTag->m_iFlags             = m_pDS->fv("iFlags").get_asInt();
+        GetTag(*newTag);
 
         epg.AddEntry(*newTag);
         ++iReturn;
@@ -275,6 +270,93 @@ int CEpgDatabase::Get(CEpg &epg)
   return iReturn;
 }
 
+int CEpgDatabase::Get(const EPGMAP &epgs)
+{
+  int iReturn(-1);
+
+  /* rows come grouped by table, so the table only has to be looked up when it changes */
+  std::string strQuery = PrepareSQL("SELECT * FROM epgtags ORDER BY idEpg, iStartTime;");
+  if (ResultQuery(strQuery))
+  {
+    iReturn = 0;
+    try
+    {
+      int iEpgID(-1);
+      CEpgPtr epg;
+      while (!m_pDS->eof())
+      {
+        int iRowEpgID = m_pDS->fv("idEpg").get_asInt();
+        if (iRowEpgID != iEpgID)
+        {
+          iEpgID = iRowEpgID;
+          EPGMAP::const_iterator it = epgs.find((unsigned int)iEpgID);
+          epg = (it != epgs.end()) ? it->second : CEpgPtr();
+        }
+
+        if (epg)
+        {
+          CEpgInfoTagPtr newTag(new CEpgInfoTag());
+          GetTag(*newTag);
+
+          epg->AddEntry(*newTag);
+          ++iReturn;
+        }
+
+        m_pDS->next();
+      }
+      m_pDS->close();
+    }
+    catch (...)
+    {
+      CLog::Log(LOGERROR, "%s - couldn't load EPG data from the database", __FUNCTION__);
+    }
+  }
+  return iReturn;
+}
+
+void CEpgDatabase::GetTag(CEpgInfoTag &tag)
+{
+  time_t iStartTime, iEndTime, iFirstAired;
+  iStartTime = (time_t) m_pDS->fv("iStartTime").get_asInt();
+  CDateTime startTime(iStartTime);
+  tag.m_startTime = startTime;
+
+  iEndTime = (time_t) m_pDS->fv("iEndTime").get_asInt();
+  CDateTime endTime(iEndTime);
+  tag.m_endTime = endTime;
+
+  iFirstAired = (time_t) m_pDS->fv("iFirstAired").get_asInt();
+  CDateTime firstAired(iFirstAired);
+  tag.m_firstAired = firstAired;
+
+  int iBroadcastUID = m_pDS->fv("iBroadcastUid").get_asInt();
+  // Compat: null value for broadcast uid changed from numerical -1 to 0 with PVR Addon API v4.0.0
+  tag.m_iUniqueBroadcastID = iBroadcastUID == -1 ? PVR_TIMER_NO_EPG_UID : iBroadcastUID;
+
+  tag.m_iBroadcastId       = m_pDS->fv("idBroadcast").get_asInt();
+  tag.m_strTitle           = m_pDS->fv("sTitle").get_asString().c_str();
+  tag.m_strPlotOutline     = m_pDS->fv("sPlotOutline").get_asString().c_str();
+  tag.m_strPlot            = m_pDS->fv("sPlot").get_asString().c_str();
+  tag.m_strOriginalTitle   = m_pDS->fv("sOriginalTitle").get_asString().c_str();
+  tag.m_strCast            = m_pDS->fv("sCast").get_asString().c_str();
+  tag.m_strDirector        = m_pDS->fv("sDirector").get_asString().c_str();
+  tag.m_strWriter          = m_pDS->fv("sWriter").get_asString().c_str();
+  tag.m_iYear              = m_pDS->fv("iYear").get_asInt();
+  tag.m_strIMDBNumber      = m_pDS->fv("sIMDBNumber").get_asString().c_str();
+  tag.m_iGenreType         = m_pDS->fv("iGenreType").get_asInt();
+  tag.m_iGenreSubType      = m_pDS->fv("iGenreSubType").get_asInt();
+  tag.m_genre              = StringUtils::Split(m_pDS->fv("sGenre").get_asString().c_str(), g_advancedSettings.m_videoItemSeparator);
+  tag.m_iParentalRating    = m_pDS->fv("iParentalRating").get_asInt();
+  tag.m_iStarRating        = m_pDS->fv("iStarRating").get_asInt();
+  tag.m_bNotify            = m_pDS->fv("bNotify").get_asBool();
+  tag.m_iEpisodeNumber     = m_pDS->fv("iEpisodeId").get_asInt();
+  tag.m_iEpisodePart       = m_pDS->fv("iEpisodePart").get_asInt();
+  tag.m_strEpisodeName     = m_pDS->fv("sEpisodeName").get_asString().c_str();
+  tag.m_iSeriesNumber      = m_pDS->fv("iSeriesId").get_asInt();
+  tag.m_strIconPath        = m_pDS->fv("sIconPath").get_asString().c_str();
+  tag.m_iFlags             = m_pDS->fv("iFlags").get_asInt();
+}
+
 bool CEpgDatabase::GetLastEpgScanTime(int iEpgId, CDateTime *lastScan)
 {
   bool bReturn = false;
@@ -21,6 +21,7 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "XBDateTime.h"
 #include "dbwrappers/Database.h"
@@ -96,6 +97,15 @@ namespace EPG
      */
     virtual bool Delete(const CEpgInfoTag &tag);
 
+    /*!
+     * @brief Remove the entries of a table that start at the given times.
+     * @param table The table to remove the entries from.
+     * @param startTimes The start times of the entries to remove.
+     * @param bQueueWrite Don't execute the queries immediately but queue them if true.
+     * @return True if the entries were removed or the queries were queued, false otherwise.
+     */
+    virtual bool Delete(const CEpg &table, const std::vector<time_t> &startTimes, bool bQueueWrite = false);
+
     /*!
      * @brief Get all EPG tables from the database. Does not get the EPG tables' entries.
      * @param container The container to fill.
@@ -110,6 +120,13 @@ namespace EPG
      */
     virtual int Get(CEpg &epg);
 
+    /*!
+     * @brief Get the EPG entries of all given tables with a single query.
+     * @param epgs The tables to get the entries for.
+     * @return The amount of entries that was added.
+     */
+    virtual int Get(const EPGMAP &epgs);
+
     /*!
      * @brief Get the last stored EPG scan time.
      * @param iEpgId The table to update the time for. Use 0 for a global value.
@@ -168,5 +185,12 @@ namespace EPG
      */
     virtual void UpdateTables(int version);
     virtual int GetMinSchemaVersion() const { return 4; }
+
+  private:
+    /*!
+     * @brief Read the entry at the current row of the dataset.
+     * @param tag The tag to fill.
+     */
+    void GetTag(CEpgInfoTag &tag);
   };
 }
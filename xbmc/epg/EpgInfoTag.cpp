@@ -576,6 +576,36 @@ const PVR::CPVRChannelPtr CEpgInfoTag::ChannelTag(void) const
   return m_pvrChannel;
 }
 
+bool CEpgInfoTag::HasChangedData(const CEpgInfoTag &tag) const
+{
+  return (m_strTitle           != tag.m_strTitle ||
+          m_strPlotOutline     != tag.m_strPlotOutline ||
+          m_strPlot            != tag.m_strPlot ||
+          m_strOriginalTitle   != tag.m_strOriginalTitle ||
+          m_strCast            != tag.m_strCast ||
+          m_strDirector        != tag.m_strDirector ||
+          m_strWriter          != tag.m_strWriter ||
+          m_iYear              != tag.m_iYear ||
+          m_strIMDBNumber      != tag.m_strIMDBNumber ||
+          m_startTime          != tag.m_startTime ||
+          m_endTime            != tag.m_endTime ||
+          m_iGenreType         != tag.m_iGenreType ||
+          m_iGenreSubType      != tag.m_iGenreSubType ||
+          m_firstAired         != tag.m_firstAired ||
+          m_iParentalRating    != tag.m_iParentalRating ||
+          m_iStarRating        != tag.m_iStarRating ||
+          m_bNotify            != tag.m_bNotify ||
+          m_iEpisodeNumber     != tag.m_iEpisodeNumber ||
+          m_iEpisodePart       != tag.m_iEpisodePart ||
+          m_iSeriesNumber      != tag.m_iSeriesNumber ||
+          m_strEpisodeName     != tag.m_strEpisodeName ||
+          m_iUniqueBroadcastID != tag.m_iUniqueBroadcastID ||
+          /* the description of known genres is derived from type and subtype */
+          (m_iGenreType == EPG_GENRE_USE_STRING && m_genre != tag.m_genre) ||
+          m_strIconPath        != tag.m_strIconPath ||
+          m_iFlags             != tag.m_iFlags);
+}
+
 bool CEpgInfoTag::Update(const CEpgInfoTag &tag, bool bUpdateBroadcastId /* = true */)
 {
   bool bChanged(false);
@@ -585,34 +615,7 @@ bool CEpgInfoTag::Update(const CEpgInfoTag &tag, bool bUpdateBroadcastId /* = tr
   }
 
   {
-    bChanged |= (
-        m_strTitle           != tag.m_strTitle ||
-        m_strPlotOutline     != tag.m_strPlotOutline ||
-        m_strPlot            != tag.m_strPlot ||
-        m_strOriginalTitle   != tag.m_strOriginalTitle ||
-        m_strCast            != tag.m_strCast ||
-        m_strDirector        != tag.m_strDirector ||
-        m_strWriter          != tag.m_strWriter ||
-        m_iYear              != tag.m_iYear ||
-        m_strIMDBNumber      != tag.m_strIMDBNumber ||
-        m_startTime          != tag.m_startTime ||
-        m_endTime            != tag.m_endTime ||
-        m_iGenreType         != tag.m_iGenreType ||
-        m_iGenreSubType      != tag.m_iGenreSubType ||
-        m_firstAired         != tag.m_firstAired ||
-        m_iParentalRating    != tag.m_iParentalRating ||
-        m_iStarRating        != tag.m_iStarRating ||
-        m_bNotify            != tag.m_bNotify ||
-        m_iEpisodeNumber     != tag.m_iEpisodeNumber ||
-        m_iEpisodePart       != tag.m_iEpisodePart ||
-        m_iSeriesNumber      != tag.m_iSeriesNumber ||
-        m_strEpisodeName     != tag.m_strEpisodeName ||
-        m_iUniqueBroadcastID != tag.m_iUniqueBroadcastID ||
-        EpgID()              != tag.EpgID() ||
-        m_genre              != tag.m_genre ||
-        m_strIconPath        != tag.m_strIconPath ||
-        m_iFlags             != tag.m_iFlags
-    );
+    bChanged |= (EpgID() != tag.EpgID() || HasChangedData(tag));
     if (bUpdateBroadcastId)
       bChanged |= (m_iBroadcastId != tag.m_iBroadcastId);
 
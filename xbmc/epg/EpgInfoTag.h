@@ -410,6 +410,14 @@ namespace EPG
 
   private:
 
+    /*!
+     * @brief Check whether the given tag carries other data than this one. The
+     *        table, channel and database ID of the tags are not compared.
+     * @param tag The tag to compare with.
+     * @return True if the tags differ in something that is stored in the database.
+     */
+    bool HasChangedData(const CEpgInfoTag &tag) const;
+
     /*!
      * @brief Change the genre of this event.
      * @param iGenreType The genre type ID.
@@ -94,9 +94,14 @@ bool EpgSearchFilter::MatchSearchTerm(const CEpgInfoTag &tag) const
 
   if (!m_strSearchTerm.empty())
   {
-    CTextSearch search(m_strSearchTerm, m_bIsCaseSensitive, SEARCH_DEFAULT_OR);
-    bReturn = search.Search(tag.Title()) ||
-        search.Search(tag.PlotOutline());
+    if (!m_textSearch || m_strTextSearchTerm != m_strSearchTerm || m_bTextSearchCaseSensitive != m_bIsCaseSensitive)
+    {
+      m_textSearch.reset(new CTextSearch(m_strSearchTerm, m_bIsCaseSensitive, SEARCH_DEFAULT_OR));
+      m_strTextSearchTerm = m_strSearchTerm;
+      m_bTextSearchCaseSensitive = m_bIsCaseSensitive;
+    }
+    bReturn = m_textSearch->Search(tag.Title()) ||
+        m_textSearch->Search(tag.PlotOutline());
   }
 
   return bReturn;
@@ -112,18 +117,27 @@ bool EpgSearchFilter::MatchBroadcastId(const CEpgInfoTag &tag) const
 
 bool EpgSearchFilter::FilterEntry(const CEpgInfoTag &tag) const
 {
-  return (MatchGenre(tag) &&
-      MatchBroadcastId(tag) &&
-      MatchDuration(tag) &&
-      MatchStartAndEndTimes(tag) &&
-      MatchSearchTerm(tag)) &&
-      (!tag.HasPVRChannel() ||
+  return FilterTag(tag) && FilterChannel(tag);
+}
+
+bool EpgSearchFilter::FilterChannel(const CEpgInfoTag &tag) const
+{
+  return (!tag.HasPVRChannel() ||
        (MatchChannelType(tag) &&
         MatchChannelNumber(tag) &&
         MatchChannelGroup(tag) &&
         (!m_bFTAOnly || !tag.ChannelTag()->IsEncrypted())));
 }
 
+bool EpgSearchFilter::FilterTag(const CEpgInfoTag &tag) const
+{
+  return (MatchGenre(tag) &&
+      MatchBroadcastId(tag) &&
+      MatchDuration(tag) &&
+      MatchStartAndEndTimes(tag) &&
+      MatchSearchTerm(tag));
+}
+
 int EpgSearchFilter::RemoveDuplicates(CFileItemList &results)
 {
   unsigned int iSize = results.Size();
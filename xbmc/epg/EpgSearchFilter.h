@@ -19,9 +19,13 @@
  *
  */
 
+#include <memory>
+#include <string>
+
 #include "XBDateTime.h"
 
 class CFileItemList;
+class CTextSearch;
 
 namespace EPG
 {
@@ -48,6 +52,21 @@ namespace EPG
      */
     virtual bool FilterEntry(const CEpgInfoTag &tag) const;
 
+    /*!
+     * @brief Check the part of the filter that only depends on the channel of a tag,
+     *        which is the same for all tags of a table.
+     * @param tag The tag to check.
+     * @return True if the channel of this tag matches the filter, false if not.
+     */
+    virtual bool FilterChannel(const CEpgInfoTag &tag) const;
+
+    /*!
+     * @brief Check the part of the filter that depends on the tag itself.
+     * @param tag The tag to check.
+     * @return True if this tag matches the filter, false if not.
+     */
+    virtual bool FilterTag(const CEpgInfoTag &tag) const;
+
     virtual bool MatchGenre(const CEpgInfoTag &tag) const;
     virtual bool MatchDuration(const CEpgInfoTag &tag) const;
     virtual bool MatchStartAndEndTimes(const CEpgInfoTag &tag) const;
@@ -79,5 +98,10 @@ namespace EPG
     bool          m_bIgnorePresentTimers;     /*!< True to ignore currently present timers (future recordings), false if not */
     bool          m_bIgnorePresentRecordings; /*!< True to ignore currently active recordings, false if not */
     unsigned int  m_iUniqueBroadcastId;       /*!< The broadcastid to search for */
+
+  private:
+    mutable std::shared_ptr<CTextSearch> m_textSearch; /*!< m_strSearchTerm, parsed once per search */
+    mutable std::string m_strTextSearchTerm;
+    mutable bool        m_bTextSearchCaseSensitive;
   };
 }
@@ -18,6 +18,7 @@
  *
  */
 
+#include <algorithm>
 #include <assert.h>
 #include <tinyxml.h>
 
@@ -150,6 +151,7 @@ CGUIEPGGridContainer::CGUIEPGGridContainer(const CGUIEPGGridContainer &other)
   m_gridStart               = other.m_gridStart;
   m_gridEnd                 = other.m_gridEnd;
   m_gridIndex               = other.m_gridIndex;
+  m_emptyGridItem           = other.m_emptyGridItem;
   m_item                    = other.m_item;
   m_lastItem                = other.m_lastItem;
   m_lastChannel             = other.m_lastChannel;
@@ -429,26 +431,20 @@ void CGUIEPGGridContainer::ProcessProgrammeGrid(unsigned int currentTime, CDirty
     int block = blockOffset;
     float posA2 = posA;
 
-    CGUIListItemPtr item = m_gridIndex[channel][block].item;
-    if (blockOffset > 0 && item == m_gridIndex[channel][blockOffset-1].item)
-    {
-      /* first program starts before current view */
-      int startBlock = blockOffset - 1;
-      while (startBlock >= 0 && m_gridIndex[channel][startBlock].item == item)
-        startBlock--;
-
-      block = startBlock + 1;
-      int missingSection = blockOffset - block;
-      posA2 -= missingSection * m_blockSize;
-    }
+    /* first program may start before current view */
+    block = GetGridItemStart(channel, blockOffset);
+    posA2 -= (blockOffset - block) * m_blockSize;
+
+    CGUIListItemPtr item;
 
     while (posA2 < endA && !m_programmeItems.empty())   // FOR EACH ITEM ///////////////
     {
-      item = m_gridIndex[channel][block].item;
+      GridItemsPtr *gridItem = GetGridItem(channel, block);
+      item = gridItem->item;
       if (!item || !item.get()->IsFileItem())
         break;
 
-      bool focused = (channel == m_channelOffset + m_channelCursor) && (item == m_gridIndex[m_channelOffset + m_channelCursor][m_blockOffset + m_blockCursor].item);
+      bool focused = (channel == m_channelOffset + m_channelCursor) && (item == GetGridItem(m_channelOffset + m_channelCursor, m_blockOffset + m_blockCursor)->item);
 
       // calculate the size to truncate if item is out of grid view
       float truncateSize = 0;
@@ -461,14 +457,14 @@ void CGUIEPGGridContainer::ProcessProgrammeGrid(unsigned int currentTime, CDirty
       {
         CSingleLock lock(m_critSection);
         // truncate item's width
-        m_gridIndex[channel][block].width = m_gridIndex[channel][block].originWidth - truncateSize;
+        gridItem->width = gridItem->originWidth - truncateSize;
       }
 
-      ProcessItem(posA2, posB, item.get(), m_lastChannel, focused, m_programmeLayout, m_focusedProgrammeLayout, currentTime, dirtyregions, m_gridIndex[channel][block].width);
+      ProcessItem(posA2, posB, item.get(), m_lastChannel, focused, m_programmeLayout, m_focusedProgrammeLayout, currentTime, dirtyregions, gridItem->width);
 
       // increment our X position
-      posA2 += m_gridIndex[channel][block].width; // assumes focused & unfocused layouts have equal length
-      block += MathUtils::round_int(m_gridIndex[channel][block].originWidth / m_blockSize);
+      posA2 += gridItem->width; // assumes focused & unfocused layouts have equal length
+      block += MathUtils::round_int(gridItem->originWidth / m_blockSize);
     }
 
     // increment our Y position
@@ -515,26 +511,20 @@ void CGUIEPGGridContainer::RenderProgrammeGrid()
     int block = blockOffset;
     float posA2 = posA;
 
-    CGUIListItemPtr item = m_gridIndex[channel][block].item;
-    if (blockOffset > 0 && item == m_gridIndex[channel][blockOffset-1].item)
-    {
-      /* first program starts before current view */
-      int startBlock = blockOffset - 1;
-      while (startBlock >= 0 && m_gridIndex[channel][startBlock].item == item)
-        startBlock--;
-
-      block = startBlock + 1;
-      int missingSection = blockOffset - block;
-      posA2 -= missingSection * m_blockSize;
-    }
+    /* first program may start before current view */
+    block = GetGridItemStart(channel, blockOffset);
+    posA2 -= (blockOffset - block) * m_blockSize;
+
+    CGUIListItemPtr item;
 
     while (posA2 < endA && !m_programmeItems.empty())   // FOR EACH ITEM ///////////////
     {
-      item = m_gridIndex[channel][block].item;
+      GridItemsPtr *gridItem = GetGridItem(channel, block);
+      item = gridItem->item;
       if (!item || !item.get()->IsFileItem())
         break;
 
-      bool focused = (channel == m_channelOffset + m_channelCursor) && (item == m_gridIndex[m_channelOffset + m_channelCursor][m_blockOffset + m_blockCursor].item);
+      bool focused = (channel == m_channelOffset + m_channelCursor) && (item == GetGridItem(m_channelOffset + m_channelCursor, m_blockOffset + m_blockCursor)->item);
 
       // reset to grid start position if first item is out of grid view
       if (posA2 < posA)
@@ -553,8 +543,8 @@ void CGUIEPGGridContainer::RenderProgrammeGrid()
       }
 
       // increment our X position
-      posA2 += m_gridIndex[channel][block].width; // assumes focused & unfocused layouts have equal length
-      block += MathUtils::round_int(m_gridIndex[channel][block].originWidth / m_blockSize);
+      posA2 += gridItem->width; // assumes focused & unfocused layouts have equal length
+      block += MathUtils::round_int(gridItem->originWidth / m_blockSize);
     }
 
     // increment our Y position
@@ -840,6 +830,7 @@ void CGUIEPGGridContainer::UpdateItems(CFileItemList *items)
     return;
 
   CSingleLock lock(m_critSection);
+  long tick(XbmcThreads::SystemClockMillis());
 
   /* Safe currently selected epg tag. Selection shall be restored after update. */
   const CEpgInfoTagPtr prevSelectedEpgTag(GetSelectedEpgInfoTag());
@@ -888,12 +879,8 @@ void CGUIEPGGridContainer::UpdateItems(CFileItemList *items)
     m_epgItemsPtr.push_back(itemsPointer);
   }
 
-  m_gridIndex.reserve(m_channelItems.size());
-  for (unsigned int i = 0; i < m_channelItems.size(); i++)
-  {
-    std::vector<GridItemsPtr> blocks(MAXBLOCKS);
-    m_gridIndex.push_back(blocks);
-  }
+  // rows are filled in once looked at
+  m_gridIndex.assign(m_channelItems.size(), GridRow());
 
   FreeItemsMemory();
   UpdateLayout();
@@ -926,93 +913,6 @@ void CGUIEPGGridContainer::UpdateItems(CFileItemList *items)
   if (m_blocks >= MAXBLOCKS)
     m_blocks = MAXBLOCKS;
 
-  CDateTimeSpan blockDuration;
-  blockDuration.SetDateTimeSpan(0, 0, MINSPERBLOCK, 0);
-
-  long tick(XbmcThreads::SystemClockMillis());
-
-  for (unsigned int row = 0; row < m_epgItemsPtr.size(); ++row)
-  {
-    CDateTime gridCursor      = m_gridStart; //reset cursor for new channel
-    unsigned long progIdx     = m_epgItemsPtr[row].start;
-    unsigned long lastIdx     = m_epgItemsPtr[row].stop;
-    const CEpgInfoTagPtr info = m_programmeItems[progIdx]->GetEPGInfoTag();
-    int iEpgId                = info ? info->EpgID() : -1;
-
-    /** FOR EACH BLOCK **********************************************************************/
-
-    for (int block = 0; block < m_blocks; block++)
-    {
-      while (progIdx <= lastIdx)
-      {
-        CFileItemPtr item = m_programmeItems[progIdx];
-        const CEpgInfoTagPtr tag(item->GetEPGInfoTag());
-        if (!tag)
-        {
-          progIdx++;
-          continue;
-        }
-
-        if (tag->EpgID() != iEpgId || gridCursor < tag->StartAsUTC() || m_gridEnd <= tag->StartAsUTC())
-          break;
-
-        if (gridCursor < tag->EndAsUTC())
-        {
-          m_gridIndex[row][block].item = item;
-          break;
-        }
-        
-        progIdx++;
-      }
-
-      gridCursor += blockDuration;
-    }
-
-    /** FOR EACH BLOCK **********************************************************************/
-    int itemSize = 1; // size of the programme in blocks
-    int savedBlock = 0;
-
-    for (int block = 0; block < m_blocks; block++)
-    {
-      CFileItemPtr item = m_gridIndex[row][block].item;
-
-      if ((item != m_gridIndex[row][block+1].item) || (!item && block == m_blocks - 1))
-      {
-        if (!item)
-        {
-          CEpgInfoTagPtr gapTag(CEpgInfoTag::CreateDefaultTag());
-          gapTag->SetPVRChannel(m_channelItems[row]->GetPVRChannelInfoTag());
-          CFileItemPtr gapItem(new CFileItem(gapTag));
-          for (int i = block ; i > block - itemSize; i--)
-          {
-            m_gridIndex[row][i].item = gapItem;
-          }
-        }
-        else
-        {
-          const CEpgInfoTagPtr tag(item->GetEPGInfoTag());
-          if (tag)
-            m_gridIndex[row][savedBlock].item->SetProperty("GenreType", tag->GenreType());
-        }
-
-        m_gridIndex[row][savedBlock].originWidth = itemSize*m_blockSize;
-        m_gridIndex[row][savedBlock].originHeight = m_channelHeight;
-
-        m_gridIndex[row][savedBlock].width = m_gridIndex[row][savedBlock].originWidth;
-        m_gridIndex[row][savedBlock].height = m_gridIndex[row][savedBlock].originHeight;
-
-        itemSize = 1;
-        savedBlock = block+1;
-      }
-      else
-      {
-        itemSize++;
-      }
-    }
-  }
-
-  /******************************************* END ******************************************/
-
   CLog::Log(LOGDEBUG, "CGUIEPGGridContainer - %s completed successfully in %u ms", __FUNCTION__, (unsigned int)(XbmcThreads::SystemClockMillis()-tick));
 
   m_channels = m_epgItemsPtr.size();
@@ -1153,7 +1053,7 @@ void CGUIEPGGridContainer::OnLeft()
   if (!m_gridIndex.empty() && m_item)
   {
     if (m_channelCursor + m_channelOffset >= 0 && m_blockOffset >= 0 &&
-        m_item->item != m_gridIndex[m_channelCursor + m_channelOffset][m_blockOffset].item)
+        m_item->item != GetGridItem(m_channelCursor + m_channelOffset, m_blockOffset)->item)
     {
       // this is not first item on page
       m_item = GetPrevItem(m_channelCursor);
@@ -1178,7 +1078,7 @@ void CGUIEPGGridContainer::OnRight()
 {
   if (!m_gridIndex.empty() && m_item)
   {
-    if (m_item->item != m_gridIndex[m_channelCursor + m_channelOffset][m_blocksPerPage + m_blockOffset - 1].item)
+    if (m_item->item != GetGridItem(m_channelCursor + m_channelOffset, m_blocksPerPage + m_blockOffset - 1)->item)
     {
       // this is not last item on page
       m_item = GetNextItem(m_channelCursor);
@@ -1301,7 +1201,7 @@ bool CGUIEPGGridContainer::SelectItemFromPoint(const CPoint &point, bool justGri
   if (channelIndex >= m_channels || blockIndex >= m_blocks)
     return false;
   // bail if block isn't occupied
-  if (!m_gridIndex[channelIndex][blockIndex].item)
+  if (!GetGridItem(channelIndex, blockIndex)->item)
     return false;
 
   SetChannel(channel);
@@ -1489,7 +1389,7 @@ int CGUIEPGGridContainer::GetSelectedItem() const
       m_blockCursor + m_blockOffset >= m_blocks)
     return -1;
 
-  CGUIListItemPtr currentItem = m_gridIndex[m_channelCursor + m_channelOffset][m_blockCursor + m_blockOffset].item;
+  CGUIListItemPtr currentItem = GetGridItem(m_channelCursor + m_channelOffset, m_blockCursor + m_blockOffset)->item;
   if (!currentItem)
     return -1;
 
@@ -1514,7 +1414,7 @@ CFileItemPtr CGUIEPGGridContainer::GetSelectedChannelItem() const
       !m_epgItemsPtr.empty() &&
       m_channelCursor + m_channelOffset < m_channels &&
       m_blockCursor + m_blockOffset < m_blocks)
-    item = m_gridIndex[m_channelCursor + m_channelOffset][m_blockCursor + m_blockOffset].item;
+    item = GetGridItem(m_channelCursor + m_channelOffset, m_blockCursor + m_blockOffset)->item;
 
   return item;
 }
@@ -1528,7 +1428,7 @@ CEpgInfoTagPtr CGUIEPGGridContainer::GetSelectedEpgInfoTag() const
       m_channelCursor + m_channelOffset < m_channels &&
       m_blockCursor + m_blockOffset < m_blocks)
   {
-    CFileItemPtr currentItem(m_gridIndex[m_channelCursor + m_channelOffset][m_blockCursor + m_blockOffset].item);
+    CFileItemPtr currentItem(GetGridItem(m_channelCursor + m_channelOffset, m_blockCursor + m_blockOffset)->item);
     if (currentItem)
       tag = currentItem->GetEPGInfoTag();
   }
@@ -1538,14 +1438,18 @@ CEpgInfoTagPtr CGUIEPGGridContainer::GetSelectedEpgInfoTag() const
 
 int CGUIEPGGridContainer::GetBlock(const CEpgInfoTagPtr &tag, int channel) const
 {
-  for (int block = 0; block < m_blocks; ++block)
+  const GridRow &row = GetGridRow(channel + m_channelOffset);
+  for (size_t i = 0; i < row.items.size(); ++i)
   {
-    CFileItemPtr item = m_gridIndex[channel + m_channelOffset][block].item;
+    CFileItemPtr item = row.items[i].item;
     if (item)
     {
       CEpgInfoTagPtr currentTag(item->GetEPGInfoTag());
       if (currentTag == tag)
+      {
+        int block = row.starts[i];
         return (block - m_blockOffset >= 0) ? block - m_blockOffset : 0;
+      }
     }
   }
 
@@ -1557,23 +1461,11 @@ int CGUIEPGGridContainer::GetChannel(const CEpgInfoTagPtr &tag) const
   if (tag->HasPVRChannel())
   {
     int channelId = tag->ChannelTag()->ChannelID();
-    for (int row = 0; row < m_channels; ++row)
+    for (int row = 0; row < m_channels && row < (int)m_channelItems.size(); ++row)
     {
-      for (int block = 0; block < m_blocks; ++block)
-      {
-        CFileItemPtr item = m_gridIndex[row][block].item;
-        if (item)
-        {
-          CEpgInfoTagPtr currentTag(item->GetEPGInfoTag());
-          if (currentTag->HasPVRChannel()) // Take care. Gap tags have no channel.
-          {
-            if (currentTag->ChannelTag()->ChannelID() == channelId)
-              return (row - m_channelOffset >= 0) ? row - m_channelOffset : 0;
-            else
-              break;
-          }
-        }
-      }
+      const CPVRChannelPtr channel(m_channelItems[row]->GetPVRChannelInfoTag());
+      if (channel && channel->ChannelID() == channelId)
+        return (row - m_channelOffset >= 0) ? row - m_channelOffset : 0;
     }
   }
 
@@ -1655,9 +1547,9 @@ GridItemsPtr *CGUIEPGGridContainer::GetClosestItem(const int &channel)
   }
 
   if (right <= SHORTGAP && right <= left && m_blockCursor + right < m_blocksPerPage)
-    return &m_gridIndex[channel + m_channelOffset][m_blockCursor + right + m_blockOffset];
+    return GetGridItem(channel + m_channelOffset, m_blockCursor + right + m_blockOffset);
 
-  return &m_gridIndex[channel + m_channelOffset][m_blockCursor - left  + m_blockOffset];
+  return GetGridItem(channel + m_channelOffset, m_blockCursor - left  + m_blockOffset);
 }
 
 int CGUIEPGGridContainer::GetItemSize(GridItemsPtr *item)
@@ -1678,13 +1570,14 @@ int CGUIEPGGridContainer::GetBlock(const CGUIListItemPtr &item, const int &chann
 
 int CGUIEPGGridContainer::GetRealBlock(const CGUIListItemPtr &item, const int &channel)
 {
-  int channelIndex = channel + m_channelOffset;
-  int block = 0;
-
-  while (m_gridIndex[channelIndex][block].item != item && block < m_blocks)
-    block++;
+  const GridRow &row = GetGridRow(channel + m_channelOffset);
+  for (size_t i = 0; i < row.items.size(); ++i)
+  {
+    if (row.items[i].item == item)
+      return row.starts[i];
+  }
 
-  return block;
+  return m_blocks;
 }
 
 GridItemsPtr *CGUIEPGGridContainer::GetNextItem(const int &channel)
@@ -1694,12 +1587,10 @@ GridItemsPtr *CGUIEPGGridContainer::GetNextItem(const int &channel)
   if (channelIndex >= m_channels || blockIndex >= m_blocks)
     return NULL;
 
-  int i = m_blockCursor;
-
-  while (i < m_blocksPerPage && m_gridIndex[channelIndex][i + m_blockOffset].item == m_gridIndex[channelIndex][blockIndex].item)
-    i++;
+  // first block of the next programme, if it is on this page
+  int i = std::max(m_blockCursor, std::min(GetGridItemEnd(channelIndex, blockIndex) - m_blockOffset, m_blocksPerPage));
 
-  return &m_gridIndex[channelIndex][i + m_blockOffset];
+  return GetGridItem(channelIndex, i + m_blockOffset);
 }
 
 GridItemsPtr *CGUIEPGGridContainer::GetPrevItem(const int &channel)
@@ -1709,12 +1600,10 @@ GridItemsPtr *CGUIEPGGridContainer::GetPrevItem(const int &channel)
   if (channelIndex >= m_channels || blockIndex >= m_blocks)
     return NULL;
 
-  int i = m_blockCursor;
+  // last block of the previous programme, if it is on this page
+  int i = std::min(m_blockCursor, std::max(GetGridItemStart(channelIndex, blockIndex) - m_blockOffset - 1, 0));
 
-  while (i > 0 && m_gridIndex[channelIndex][i + m_blockOffset].item == m_gridIndex[channelIndex][blockIndex].item)
-    i--;
-
-  return &m_gridIndex[channelIndex][i + m_blockOffset];
+  return GetGridItem(channelIndex, i + m_blockOffset);
 }
 
 GridItemsPtr *CGUIEPGGridContainer::GetItem(const int &channel)
@@ -1724,7 +1613,135 @@ GridItemsPtr *CGUIEPGGridContainer::GetItem(const int &channel)
   if (channelIndex >= m_channels || blockIndex >= m_blocks)
     return NULL;
 
-  return &m_gridIndex[channelIndex][blockIndex];
+  return GetGridItem(channelIndex, blockIndex);
+}
+
+const CGUIEPGGridContainer::GridRow &CGUIEPGGridContainer::GetGridRow(int channel) const
+{
+  static const GridRow emptyRow;
+  // rows are built from the const accessors, which not every caller calls with the lock held
+  CSingleLock lock(m_critSection);
+  if (channel < 0 || channel >= (int)m_gridIndex.size())
+    return emptyRow;
+
+  if (!m_gridIndex[channel].built)
+    BuildGridRow(channel);
+
+  return m_gridIndex[channel];
+}
+
+void CGUIEPGGridContainer::BuildGridRow(int channel) const
+{
+  GridRow &row = m_gridIndex[channel];
+  row.built = true;
+
+  int block = 0; // first block not taken yet
+  if (channel < (int)m_epgItemsPtr.size())
+  {
+    unsigned long progIdx     = m_epgItemsPtr[channel].start;
+    unsigned long lastIdx     = m_epgItemsPtr[channel].stop;
+    const CEpgInfoTagPtr info = m_programmeItems[progIdx]->GetEPGInfoTag();
+    int iEpgId                = info ? info->EpgID() : -1;
+
+    for (; progIdx <= lastIdx && block < m_blocks; progIdx++)
+    {
+      const CFileItemPtr &item = m_programmeItems[progIdx];
+      const CEpgInfoTagPtr tag(item->GetEPGInfoTag());
+      if (!tag)
+        continue;
+
+      if (tag->EpgID() != iEpgId)
+        break;
+
+      // a programme takes the blocks starting while it runs, unless an earlier one has them
+      int start = std::max(block, GetBlockAt(tag->StartAsUTC()));
+      int end = std::min(m_blocks, GetBlockAt(tag->EndAsUTC()));
+      if (start >= end)
+        continue;
+
+      if (start > block)
+        AddGridRun(row, block, start, CFileItemPtr());
+
+      item->SetProperty("GenreType", tag->GenreType());
+      AddGridRun(row, start, end, item);
+      block = end;
+    }
+  }
+
+  if (block < m_blocks)
+    AddGridRun(row, block, m_blocks, CFileItemPtr());
+}
+
+void CGUIEPGGridContainer::AddGridRun(GridRow &row, int start, int end, const CFileItemPtr &item) const
+{
+  GridItemsPtr gridItem;
+  gridItem.item = item;
+  gridItem.originWidth = (end - start) * m_blockSize;
+  gridItem.originHeight = m_channelHeight;
+  gridItem.width = gridItem.originWidth;
+  gridItem.height = gridItem.originHeight;
+
+  row.starts.push_back(start);
+  row.items.push_back(gridItem);
+}
+
+int CGUIEPGGridContainer::GetBlockAt(const CDateTime &time) const
+{
+  // first block starting at or after the given time
+  int seconds = (time - m_gridStart).GetSecondsTotal();
+  int blockSeconds = MINSPERBLOCK * 60;
+  return seconds > 0 ? (seconds + blockSeconds - 1) / blockSeconds : -(-seconds / blockSeconds);
+}
+
+int CGUIEPGGridContainer::GetGridRun(int channel, int block) const
+{
+  if (block < 0 || block >= m_blocks)
+    return -1;
+
+  const GridRow &row = GetGridRow(channel);
+  std::vector<int>::const_iterator it = std::upper_bound(row.starts.begin(), row.starts.end(), block);
+  if (it == row.starts.begin())
+    return -1;
+
+  return it - row.starts.begin() - 1;
+}
+
+int CGUIEPGGridContainer::GetGridItemStart(int channel, int block) const
+{
+  int run = GetGridRun(channel, block);
+  if (run < 0)
+    return block;
+
+  return m_gridIndex[channel].starts[run];
+}
+
+int CGUIEPGGridContainer::GetGridItemEnd(int channel, int block) const
+{
+  int run = GetGridRun(channel, block);
+  if (run < 0)
+    return block + 1;
+
+  const GridRow &row = m_gridIndex[channel];
+  return run + 1 < (int)row.starts.size() ? row.starts[run + 1] : m_blocks;
+}
+
+GridItemsPtr *CGUIEPGGridContainer::GetGridItem(int channel, int block) const
+{
+  int run = GetGridRun(channel, block);
+  if (run < 0)
+    return &m_emptyGridItem;
+
+  CSingleLock lock(m_critSection);
+  GridItemsPtr &gridItem = m_gridIndex[channel].items[run];
+  if (!gridItem.item)
+  {
+    // gaps get their item once someone looks at them
+    CEpgInfoTagPtr gapTag(CEpgInfoTag::CreateDefaultTag());
+    gapTag->SetPVRChannel(m_channelItems[channel]->GetPVRChannelInfoTag());
+    gridItem.item.reset(new CFileItem(gapTag));
+  }
+
+  return &gridItem;
 }
 
 void CGUIEPGGridContainer::SetFocus(bool focus)
@@ -1890,12 +1907,12 @@ void CGUIEPGGridContainer::ClearGridIndex(void)
 {
   for (unsigned int i = 0; i < m_gridIndex.size(); i++)
   {
-    for (int block = 0; block < m_blocks; block++)
+    std::vector<GridItemsPtr> &items = m_gridIndex[i].items;
+    for (unsigned int run = 0; run < items.size(); run++)
     {
-      if (m_gridIndex[i][block].item)
-        m_gridIndex[i][block].item.get()->ClearProperties();
+      if (items[run].item)
+        items[run].item.get()->ClearProperties();
     }
-    m_gridIndex[i].clear();
   }
   m_gridIndex.clear();
 }
@@ -1927,13 +1944,11 @@ void CGUIEPGGridContainer::GoToEnd()
   int blocksEnd = 0;   // the end block of the last epg element for the selected channel
   int blocksStart = 0; // the start block of the last epg element for the selected channel
   int blockOffset = 0; // the block offset to scroll to
-  for (int blockIndex = m_blocks; blockIndex >= 0 && (!blocksEnd || !blocksStart); blockIndex--)
+  const GridRow &row = GetGridRow(m_channelCursor + m_channelOffset);
+  if (!row.starts.empty())
   {
-    if (!blocksEnd && m_gridIndex[m_channelCursor + m_channelOffset][blockIndex].item != NULL)
-      blocksEnd = blockIndex;
-    if (blocksEnd && m_gridIndex[m_channelCursor + m_channelOffset][blocksEnd].item != 
-                     m_gridIndex[m_channelCursor + m_channelOffset][blockIndex].item)
-      blocksStart = blockIndex + 1;
+    blocksEnd = m_blocks - 1;
+    blocksStart = row.starts.back();
   }
   if (blocksEnd - blocksStart > m_blocksPerPage)
     blockOffset = blocksStart;
@@ -1964,7 +1979,7 @@ void CGUIEPGGridContainer::GoToNow()
       if (offset + blockIndex >= m_blocks)
         break;
 
-      const CFileItemPtr item = m_gridIndex[m_channelCursor + m_channelOffset][offset + blockIndex].item;
+      const CFileItemPtr item = GetGridItem(m_channelCursor + m_channelOffset, offset + blockIndex)->item;
       if (item)
       {
         const CEpgInfoTagPtr tag = item->GetEPGInfoTag();
@@ -2147,42 +2162,21 @@ void CGUIEPGGridContainer::FreeProgrammeMemory(int channel, int keepStart, int k
 {
   if (keepStart < keepEnd)
   { // remove before keepStart and after keepEnd
-    if (keepStart > 0 && keepStart < m_blocks)
-    {
-      // if item exist and block is not part of visible item
-      CGUIListItemPtr last = m_gridIndex[channel][keepStart].item;
-      for (int i = keepStart - 1 ; i > 0 ; i--)
-      {
-        if (m_gridIndex[channel][i].item && m_gridIndex[channel][i].item != last)
-        {
-          CSingleLock lock(m_critSection);
+    const GridRow &row = GetGridRow(channel);
+    int first = keepStart > 0 && keepStart < m_blocks ? GetGridRun(channel, keepStart) : 0;
+    int last = keepEnd > 0 && keepEnd < m_blocks ? GetGridRun(channel, keepEnd) : (int)row.items.size() - 1;
 
-          m_gridIndex[channel][i].item->FreeMemory();
-          // FreeMemory() is smart enough to not cause any problems when called multiple times on same item
-          // but we can make use of condition needed to not call FreeMemory() on item that is partially visible
-          // to avoid calling FreeMemory() multiple times on item that ocupy few blocks in a row
-          last = m_gridIndex[channel][i].item;
-        }
-      }
+    // items partially visible are kept, FreeMemory() is harmless on items already freed
+    CSingleLock lock(m_critSection);
+    for (int i = 0; i < first; i++)
+    {
+      if (row.items[i].item)
+        row.items[i].item->FreeMemory();
     }
-
-    if (keepEnd > 0 && keepEnd < m_blocks)
+    for (int i = last + 1; i < (int)row.items.size(); i++)
     {
-      CGUIListItemPtr last = m_gridIndex[channel][keepEnd].item;
-      for (int i = keepEnd + 1 ; i < m_blocks ; i++)
-      {
-        // if item exist and block is not part of visible item
-        if (m_gridIndex[channel][i].item && m_gridIndex[channel][i].item != last)
-        {
-          CSingleLock lock(m_critSection);
-
-          m_gridIndex[channel][i].item->FreeMemory();
-          // FreeMemory() is smart enough to not cause any problems when called multiple times on same item
-          // but we can make use of condition needed to not call FreeMemory() on item that is partially visible
-          // to avoid calling FreeMemory() multiple times on item that ocupy few blocks in a row
-          last = m_gridIndex[channel][i].item;
-        }
-      }
+      if (row.items[i].item)
+        row.items[i].item->FreeMemory();
     }
   }
 }
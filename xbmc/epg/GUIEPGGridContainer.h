@@ -176,6 +176,29 @@ namespace EPG
   private:
     void UpdateItems(CFileItemList *items);
 
+    /*!
+     \brief The programmes of a channel as runs of blocks, each programme or
+     gap between them is one run. Rows are built when a channel is first
+     looked at and gaps get their item when first shown, so only what the
+     user scrolls through is ever created.
+     */
+    struct GridRow
+    {
+      GridRow() : built(false) {}
+      bool built;
+      std::vector<int> starts;          //! first block of each run, ascending
+      std::vector<GridItemsPtr> items;  //! the programme or gap of each run
+    };
+
+    const GridRow &GetGridRow(int channel) const;
+    void BuildGridRow(int channel) const;
+    void AddGridRun(GridRow &row, int start, int end, const CFileItemPtr &item) const;
+    int GetBlockAt(const CDateTime &time) const;
+    int GetGridRun(int channel, int block) const;
+    int GetGridItemStart(int channel, int block) const;
+    int GetGridItemEnd(int channel, int block) const;
+    GridItemsPtr *GetGridItem(int channel, int block) const;
+
     EPG::CEpgInfoTagPtr GetSelectedEpgInfoTag() const;
     int GetBlock(const EPG::CEpgInfoTagPtr &tag, int channel) const;
     int GetChannel(const EPG::CEpgInfoTagPtr &tag) const;
@@ -214,7 +237,8 @@ namespace EPG
 
     CGUITexture m_guiProgressIndicatorTexture;
 
-    std::vector<std::vector<GridItemsPtr> > m_gridIndex;
+    mutable std::vector<GridRow> m_gridIndex;
+    mutable GridItemsPtr m_emptyGridItem;  //! stands for blocks outside the grid
     GridItemsPtr *m_item;
     CGUIListItem *m_lastItem;
     CGUIListItem *m_lastChannel;
@@ -28,66 +28,96 @@
 #include "climits"
 
 #include <algorithm>
+#include <functional>
 
-// Maximum number of directories to keep in our cache
-#define MAX_CACHED_DIRS 50
+// Maximum (estimated) size of the directories we keep in our cache, per shard.
+// Directories that are always cached don't count.
+#define MAX_CACHED_SIZE (4 * 1024 * 1024)
 
 using namespace XFILE;
 
-CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType)
+namespace
 {
-  m_cacheType = cacheType;
-  m_lastAccess = 0;
-  m_Items = new CFileItemList;
-  m_Items->SetFastLookup(false);
+
+size_t EstimateSize(const CFileItemList &items)
+{
+  size_t size = sizeof(CFileItemList);
+  for (int i = 0; i < items.Size(); i++)
+  {
+    const CFileItemPtr item = items[i];
+    size += sizeof(CFileItem) + item->GetPath().size() + item->GetLabel().size();
+  }
+  return size;
 }
 
-CDirectoryCache::CDir::~CDir()
+std::string GetStoredPath(const std::string &strPath)
 {
-  delete m_Items;
+  // Get rid of any URL options, else the compare may be wrong
+  std::string storedPath = CURL(strPath).GetWithoutOptions();
+  URIUtils::RemoveSlashAtEnd(storedPath);
+  return storedPath;
+}
+
 }
 
-void CDirectoryCache::CDir::SetLastAccess(unsigned int &accessCounter)
+CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType, const std::shared_ptr<const CFileItemList> &items, bool fastLookup)
+  : m_Items(items)
+  , m_cacheType(cacheType)
+  , m_fastLookup(fastLookup)
+  , m_size(EstimateSize(*items))
 {
-  m_lastAccess = accessCounter++;
 }
 
 CDirectoryCache::CDirectoryCache(void)
+  : m_cacheHits(0)
+  , m_cacheMisses(0)
 {
-  m_accessCounter = 0;
-#ifdef _DEBUG
-  m_cacheHits = 0;
-  m_cacheMisses = 0;
-#endif
 }
 
 CDirectoryCache::~CDirectoryCache(void)
 {
 }
 
-bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll)
+CDirectoryCache::Shard& CDirectoryCache::GetShard(const std::string &storedPath)
 {
-  CSingleLock lock (m_cs);
+  return m_shards[std::hash<std::string>()(storedPath) % NUM_SHARDS];
+}
 
-  // Get rid of any URL options, else the compare may be wrong
-  std::string storedPath = CURL(strPath).GetWithoutOptions();
-  URIUtils::RemoveSlashAtEnd(storedPath);
+std::shared_ptr<CDirectoryCache::CDir> CDirectoryCache::Find(const std::string &storedPath, bool touch)
+{
+  Shard &shard = GetShard(storedPath);
+  CSingleLock lock(shard.cs);
+
+  auto i = shard.cache.find(storedPath);
+  if (i == shard.cache.end())
+    return std::shared_ptr<CDir>();
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  if (touch && i->second.lru != shard.lru.end())
+    shard.lru.splice(shard.lru.begin(), shard.lru, i->second.lru);
+  return i->second.dir;
+}
+
+bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll)
+{
+  std::shared_ptr<CDir> dir = Find(GetStoredPath(strPath), true);
+  if (dir)
   {
-    CDir* dir = i->second;
     if (dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
        (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
     {
-      items.Copy(*dir->m_Items);
-      dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-      m_cacheHits+=items.Size();
-#endif
+      // the cached list is never modified, so it can be copied without holding any lock.
+      // the items are copied too, callers alter them (stacking, archives) just like
+      // the lists handed to SetDirectory, see there
+      const CFileItemList &cached = *dir->m_Items;
+      items.Copy(cached, false);
+      items.SetFastLookup(dir->m_fastLookup);
+      for (int i = 0; i < cached.Size(); i++)
+        items.Add(CFileItemPtr(new CFileItem(*cached[i])));
+      m_cacheHits++;
       return true;
     }
   }
+  m_cacheMisses++;
   return false;
 }
 
@@ -107,20 +137,21 @@ void CDirectoryCache::SetDirectory(const std::string& strPath, const CFileItemLi
   // IDEALLY, any further processing on the item would actually create a new item
   // instead of altering it, but we can't really enforce that in an easy way, so
   // this is the best solution for now.
-  CSingleLock lock (m_cs);
+  std::shared_ptr<CFileItemList> cached(new CFileItemList);
+  cached->Copy(items);
+  cached->SetFastLookup(true);
+  std::shared_ptr<CDir> dir(new CDir(cacheType, cached, items.GetFastLookup()));
 
-  // Get rid of any URL options, else the compare may be wrong
-  std::string storedPath = CURL(strPath).GetWithoutOptions();
-  URIUtils::RemoveSlashAtEnd(storedPath);
-
-  ClearDirectory(storedPath);
+  std::string storedPath = GetStoredPath(strPath);
+  Shard &shard = GetShard(storedPath);
+  CSingleLock lock(shard.cs);
 
-  CheckIfFull();
+  auto i = shard.cache.find(storedPath);
+  if (i != shard.cache.end())
+    Delete(shard, i);
 
-  CDir* dir = new CDir(cacheType);
-  dir->m_Items->Copy(items);
-  dir->SetLastAccess(m_accessCounter);
-  m_cache.insert(std::pair<std::string, CDir*>(storedPath, dir));
+  Insert(shard, storedPath, dir);
+  CheckIfFull(shard);
 }
 
 void CDirectoryCache::ClearFile(const std::string& strFile)
@@ -133,56 +164,65 @@ void CDirectoryCache::ClearFile(const std::string& strFile)
 
 void CDirectoryCache::ClearDirectory(const std::string& strPath)
 {
-  CSingleLock lock (m_cs);
-
-  // Get rid of any URL options, else the compare may be wrong
-  std::string storedPath = CURL(strPath).GetWithoutOptions();
-  URIUtils::RemoveSlashAtEnd(storedPath);
+  std::string storedPath = GetStoredPath(strPath);
+  Shard &shard = GetShard(storedPath);
+  CSingleLock lock(shard.cs);
 
-  iCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
-    Delete(i);
+  auto i = shard.cache.find(storedPath);
+  if (i != shard.cache.end())
+    Delete(shard, i);
 }
 
 void CDirectoryCache::ClearSubPaths(const std::string& strPath)
 {
-  CSingleLock lock (m_cs);
+  std::string storedPath = GetStoredPath(strPath);
 
-  // Get rid of any URL options, else the compare may be wrong
-  std::string storedPath = CURL(strPath).GetWithoutOptions();
-  URIUtils::RemoveSlashAtEnd(storedPath);
-
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
   {
-    if (StringUtils::StartsWith(i->first, storedPath))
-      Delete(i++);
-    else
-      i++;
+    Shard &shard = m_shards[s];
+    CSingleLock lock(shard.cs);
+
+    auto i = shard.cache.begin();
+    while (i != shard.cache.end())
+    {
+      if (StringUtils::StartsWith(i->first, storedPath))
+        Delete(shard, i++);
+      else
+        i++;
+    }
   }
 }
 
 void CDirectoryCache::AddFile(const std::string& strFile)
 {
-  CSingleLock lock (m_cs);
-
   // Get rid of any URL options, else the compare may be wrong
   std::string strPath = URIUtils::GetDirectory(CURL(strFile).GetWithoutOptions());
   URIUtils::RemoveSlashAtEnd(strPath);
 
-  ciCache i = m_cache.find(strPath);
-  if (i != m_cache.end())
+  Shard &shard = GetShard(strPath);
+  CSingleLock lock(shard.cs);
+
+  auto i = shard.cache.find(strPath);
+  if (i != shard.cache.end())
   {
-    CDir *dir = i->second;
+    // readers may hold the current list, so replace it by an extended one.
+    // the items themselves are shared, they don't change either
+    std::shared_ptr<CDir> dir = i->second.dir;
+    std::shared_ptr<CFileItemList> items(new CFileItemList);
+    items->Copy(*dir->m_Items, false);
+    items->Append(*dir->m_Items);
     CFileItemPtr item(new CFileItem(strFile, false));
-    dir->m_Items->Add(item);
-    dir->SetLastAccess(m_accessCounter);
+    items->Add(item);
+
+    DIR_CACHE_TYPE cacheType = dir->m_cacheType;
+    Delete(shard, i);
+    Insert(shard, strPath, std::shared_ptr<CDir>(new CDir(cacheType, items, dir->m_fastLookup)));
+    CheckIfFull(shard);
   }
 }
 
 bool CDirectoryCache::FileExists(const std::string& strFile, bool& bInCache)
 {
-  CSingleLock lock (m_cs);
   bInCache = false;
 
   // Get rid of any URL options, else the compare may be wrong
@@ -191,31 +231,31 @@ bool CDirectoryCache::FileExists(const std::string& strFile, bool& bInCache)
   std::string storedPath = URIUtils::GetDirectory(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  std::shared_ptr<CDir> dir = Find(storedPath, true);
+  if (dir)
   {
-    bInCache = true;
-    CDir *dir = i->second;
-    dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
     m_cacheHits++;
-#endif
-    return (URIUtils::PathEquals(strPath, storedPath) || dir->m_Items->Contains(strFile, true));
+    bInCache = true;
+    // the hashed lookup matches paths exactly, try the path without its options too
+    return (URIUtils::PathEquals(strPath, storedPath) || dir->m_Items->Contains(strFile, true) ||
+            (strPath != strFile && dir->m_Items->Contains(strPath, true)));
   }
-#ifdef _DEBUG
   m_cacheMisses++;
-#endif
   return false;
 }
 
 void CDirectoryCache::Clear()
 {
   // this routine clears everything
-  CSingleLock lock (m_cs);
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
+  {
+    Shard &shard = m_shards[s];
+    CSingleLock lock(shard.cs);
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end() )
-    Delete(i++);
+    shard.cache.clear();
+    shard.lru.clear();
+    shard.size = 0;
+  }
 }
 
 void CDirectoryCache::InitCache(std::set<std::string>& dirs)
@@ -232,61 +272,80 @@ void CDirectoryCache::InitCache(std::set<std::string>& dirs)
 
 void CDirectoryCache::ClearCache(std::set<std::string>& dirs)
 {
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
+  for (std::set<std::string>::const_iterator it = dirs.begin(); it != dirs.end(); ++it)
+    ClearDirectory(*it);
+}
+
+void CDirectoryCache::Insert(Shard &shard, const std::string &storedPath, const std::shared_ptr<CDir> &dir)
+{
+  Entry entry;
+  entry.dir = dir;
+  entry.lru = shard.lru.end();
+
+  // ensure dirs that are always cached aren't cleared
+  if (dir->m_cacheType != DIR_CACHE_ALWAYS)
   {
-    if (dirs.find(i->first) != dirs.end())
-      Delete(i++);
-    else
-      i++;
+    entry.lru = shard.lru.insert(shard.lru.begin(), storedPath);
+    shard.size += dir->m_size;
   }
+  shard.cache.insert(std::make_pair(storedPath, entry));
 }
 
-void CDirectoryCache::CheckIfFull()
+void CDirectoryCache::CheckIfFull(Shard &shard)
 {
-  CSingleLock lock (m_cs);
-
-  // find the last accessed folder, and remove if the number of cached folders is too many
-  iCache lastAccessed = m_cache.end();
-  unsigned int numCached = 0;
-  for (iCache i = m_cache.begin(); i != m_cache.end(); i++)
+  // drop the least recently used folders until we fit, but always keep the newest one
+  while (shard.size > MAX_CACHED_SIZE && shard.lru.size() > 1)
   {
-    // ensure dirs that are always cached aren't cleared
-    if (i->second->m_cacheType != DIR_CACHE_ALWAYS)
+    auto i = shard.cache.find(shard.lru.back());
+    if (i == shard.cache.end())
     {
-      if (lastAccessed == m_cache.end() || i->second->GetLastAccess() < lastAccessed->second->GetLastAccess())
-        lastAccessed = i;
-      numCached++;
+      shard.lru.pop_back();
+      continue;
     }
+    Delete(shard, i);
   }
-  if (lastAccessed != m_cache.end() && numCached >= MAX_CACHED_DIRS)
-    Delete(lastAccessed);
 }
 
-void CDirectoryCache::Delete(iCache it)
+void CDirectoryCache::Delete(Shard &shard, std::unordered_map<std::string, Entry>::iterator it)
 {
-  CDir* dir = it->second;
-  delete dir;
-  m_cache.erase(it);
+  if (it->second.lru != shard.lru.end())
+  {
+    shard.lru.erase(it->second.lru);
+    shard.size -= it->second.dir->m_size;
+  }
+  shard.cache.erase(it);
 }
 
-#ifdef _DEBUG
-void CDirectoryCache::PrintStats() const
+void CDirectoryCache::GetStats(Stats &stats) const
 {
-  CSingleLock lock (m_cs);
-  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, and %u cache misses", __FUNCTION__, m_cacheHits, m_cacheMisses);
-  // run through and find the oldest and the number of items cached
-  unsigned int oldest = UINT_MAX;
-  unsigned int numItems = 0;
-  unsigned int numDirs = 0;
-  for (ciCache i = m_cache.begin(); i != m_cache.end(); i++)
+  stats.hits = m_cacheHits;
+  stats.misses = m_cacheMisses;
+  stats.directories = 0;
+  stats.items = 0;
+  stats.size = 0;
+
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
   {
-    CLog::Log(LOGDEBUG, "%s - name %s", __FUNCTION__, i->first.c_str());
-    CDir *dir = i->second;
-    oldest = std::min(oldest, dir->GetLastAccess());
-    numItems += dir->m_Items->Size();
-    numDirs++;
+    const Shard &shard = m_shards[s];
+    CSingleLock lock(shard.cs);
+
+    for (auto i = shard.cache.begin(); i != shard.cache.end(); ++i)
+    {
+      stats.directories++;
+      stats.items += i->second.dir->m_Items->Size();
+      stats.size += i->second.dir->m_size;
+    }
   }
-  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total.  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, oldest, m_accessCounter);
+}
+
+#ifdef _DEBUG
+void CDirectoryCache::PrintStats() const
+{
+  Stats stats;
+  GetStats(stats);
+  CLog::Log(LOGDEBUG, "%s - total of %llu cache hits, and %llu cache misses", __FUNCTION__,
+            (unsigned long long)stats.hits, (unsigned long long)stats.misses);
+  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total, about %lu bytes", __FUNCTION__,
+            stats.directories, stats.items, (unsigned long)stats.size);
 }
 #endif
@@ -23,29 +23,55 @@
 #include "Directory.h"
 #include "threads/CriticalSection.h"
 
-#include <map>
+#include <atomic>
+#include <stdint.h>
+#include <list>
+#include <memory>
 #include <set>
+#include <unordered_map>
 
 class CFileItem;
+class CFileItemList;
 
 namespace XFILE
 {
   class CDirectoryCache
   {
+    /*!
+     \brief A cached directory. Its item list is never changed once cached,
+     so it is shared with readers and replaced as a whole when it changes.
+     */
     class CDir
     {
     public:
-      CDir(DIR_CACHE_TYPE cacheType);
-      virtual ~CDir();
+      CDir(DIR_CACHE_TYPE cacheType, const std::shared_ptr<const CFileItemList> &items, bool fastLookup);
 
-      void SetLastAccess(unsigned int &accessCounter);
-      unsigned int GetLastAccess() const { return m_lastAccess; };
-
-      CFileItemList* m_Items;
+      std::shared_ptr<const CFileItemList> m_Items;  ///< always has fast lookup, for FileExists()
       DIR_CACHE_TYPE m_cacheType;
-    private:
-      unsigned int m_lastAccess;
+      bool m_fastLookup;  ///< lookup mode of the list that was cached, restored on copies handed out
+      size_t m_size;
+    };
+
+    typedef std::list<std::string> LRUList;
+    struct Entry
+    {
+      std::shared_ptr<CDir> dir;
+      LRUList::iterator lru; // end() for directories that are always cached
+    };
+
+    /*!
+     \brief Part of the cache, paths are spread over the shards by their hash
+     so lookups of different directories don't wait for each other.
+     */
+    struct Shard
+    {
+      Shard() : size(0) {}
+      mutable CCriticalSection cs;
+      std::unordered_map<std::string, Entry> cache;
+      LRUList lru;  // most recently used first
+      size_t size;  // estimated bytes of the evictable directories
     };
+
   public:
     CDirectoryCache(void);
     virtual ~CDirectoryCache(void);
@@ -57,27 +83,35 @@ namespace XFILE
     void Clear();
     void AddFile(const std::string& strFile);
     bool FileExists(const std::string& strPath, bool& bInCache);
+
+    struct Stats
+    {
+      uint64_t hits;
+      uint64_t misses;
+      unsigned int directories;
+      unsigned int items;
+      size_t size;
+    };
+    void GetStats(Stats &stats) const;
 #ifdef _DEBUG
     void PrintStats() const;
 #endif
   protected:
     void InitCache(std::set<std::string>& dirs);
     void ClearCache(std::set<std::string>& dirs);
-    void CheckIfFull();
 
-    std::map<std::string, CDir*> m_cache;
-    typedef std::map<std::string, CDir*>::iterator iCache;
-    typedef std::map<std::string, CDir*>::const_iterator ciCache;
-    void Delete(iCache i);
+    static const unsigned int NUM_SHARDS = 8;
 
-    CCriticalSection m_cs;
+    Shard& GetShard(const std::string &storedPath);
+    std::shared_ptr<CDir> Find(const std::string &storedPath, bool touch);
+    void Insert(Shard &shard, const std::string &storedPath, const std::shared_ptr<CDir> &dir);
+    void Delete(Shard &shard, std::unordered_map<std::string, Entry>::iterator it);
+    void CheckIfFull(Shard &shard);
 
-    unsigned int m_accessCounter;
+    Shard m_shards[NUM_SHARDS];
 
-#ifdef _DEBUG
-    unsigned int m_cacheHits;
-    unsigned int m_cacheMisses;
-#endif
+    std::atomic<uint64_t> m_cacheHits;
+    std::atomic<uint64_t> m_cacheMisses;
   };
 }
 extern XFILE::CDirectoryCache g_directoryCache;
@@ -985,6 +985,24 @@ bool CFile::Touch(const std::string& fileName)
   return newfile.OpenForWrite(fileName);
 }
 
+bool CFile::WriteAtomically(const std::string& fileName, const void* data, size_t size)
+{
+  std::string tempFile = fileName + ".tmp";
+  CFile output;
+  if (!output.OpenForWrite(tempFile, true))
+    return false;
+
+  bool written = output.Write(data, size) == (ssize_t)size;
+  output.Close();
+
+  if (!written || !Rename(tempFile, fileName))
+  {
+    Delete(tempFile);
+    return false;
+  }
+  return true;
+}
+
 //*********************************************************************************************
 //*************** Stream IO for CFile objects *************************************************
 //*********************************************************************************************
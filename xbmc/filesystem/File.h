@@ -187,6 +187,11 @@ public:
   static bool Copy(const std::string& strFileName, const std::string& strDest, XFILE::IFileCallback* pCallback = NULL, void* pContext = NULL);
   static bool SetHidden(const std::string& fileName, bool hidden);
   static bool Touch(const std::string& fileName);
+  /*!
+   \brief Write a whole file aside and rename it into place, so it is never read half written
+   \return false if it couldn't be written, an earlier version of the file is then left as it was
+   */
+  static bool WriteAtomically(const std::string& fileName, const void* data, size_t size);
 
 private:
   unsigned int m_flags;
@@ -25,6 +25,7 @@
 #include "URL.h"
 
 #include "CircularCache.h"
+#include "MappedFileCache.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "settings/Settings.h"
@@ -172,7 +173,14 @@ bool CFileCache::Open(const CURL& url)
   if (!m_pCache)
   {
     unsigned int cacheMemBufferSize = (unsigned int)CSettings::GetInstance().GetInt(CSettings::SETTING_NETWORK_CACHEMEMBUFFERSIZE) * 1024 * 1024;
-    if (cacheMemBufferSize == 0)
+    if (cacheMemBufferSize == 0 && m_seekPossible > 0)
+    {
+      // Use cache on disk, keeping earlier ranges around for seeking back.
+      // It holds multiple ranges itself, so no double buffering is needed
+      m_pCache = new CMappedFileCache(m_fileSize);
+      m_forwardCacheSize = 0;
+    }
+    else if (cacheMemBufferSize == 0)
     {
       // Use cache on disk
       m_pCache = new CSimpleFileCache();
@@ -204,7 +212,7 @@ bool CFileCache::Open(const CURL& url)
       m_forwardCacheSize = front;
     }
 
-    if (m_flags & READ_MULTI_STREAM)
+    if ((m_flags & READ_MULTI_STREAM) && !dynamic_cast<CMappedFileCache*>(m_pCache))
     {
       // If READ_MULTI_STREAM flag is set: Double buffering is required
       m_pCache = new CDoubleCache(m_pCache);
@@ -212,7 +220,18 @@ bool CFileCache::Open(const CURL& url)
   }
 
   // open cache strategy
-  if (!m_pCache || m_pCache->Open() != CACHE_RC_OK)
+  int rc = m_pCache ? m_pCache->Open() : CACHE_RC_ERROR;
+  if (rc != CACHE_RC_OK && dynamic_cast<CMappedFileCache*>(m_pCache))
+  {
+    // mapping can fail for lack of address space, fall back to plain disk cache
+    CLog::Log(LOGWARNING, "CFileCache::Open - failed to open mapped cache, using simple file cache");
+    SetCacheStrategy(new CSimpleFileCache());
+    if (m_flags & READ_MULTI_STREAM)
+      m_pCache = new CDoubleCache(m_pCache);
+    rc = m_pCache->Open();
+  }
+
+  if (rc != CACHE_RC_OK)
   {
     CLog::Log(LOGERROR,"CFileCache::Open - failed to open cache");
     Close();
@@ -0,0 +1,386 @@
+/*
+ *      Copyright (C) 2017 Team MrMC
+ *      https://github.com/MrMC
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MrMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "threads/SystemClock.h"
+#include "system.h"
+#include "threads/SingleLock.h"
+#include "MappedFileCache.h"
+#include "SpecialProtocol.h"
+#include "linux/PlatformDefs.h" //for PRIdS, PRId64
+#include "Util.h"
+#include "utils/log.h"
+
+using namespace XFILE;
+
+#define MAPPED_CACHE_BLOCK_SIZE (1024 * 1024)
+#define MAPPED_CACHE_MAX_SIZE   (512 * 1024 * 1024)
+
+CMappedFileCache::CMappedFileCache(int64_t fileSize)
+ : CCacheStrategy()
+ , m_fileSize(fileSize)
+ , m_end(0)
+ , m_cur(0)
+ , m_fd(-1)
+ , m_map(NULL)
+ , m_mapSize(0)
+ , m_stamp(0)
+{
+}
+
+CMappedFileCache::~CMappedFileCache()
+{
+  Close();
+}
+
+int CMappedFileCache::Open()
+{
+  Close();
+
+  // no need for more slots than the source has blocks
+  size_t slots = MAPPED_CACHE_MAX_SIZE / MAPPED_CACHE_BLOCK_SIZE;
+  if (m_fileSize > 0)
+    slots = std::min(slots, (size_t)((m_fileSize + MAPPED_CACHE_BLOCK_SIZE - 1) / MAPPED_CACHE_BLOCK_SIZE));
+  slots = std::max(slots, (size_t)2);
+
+  std::string filename = CSpecialProtocol::TranslatePath(CUtil::GetNextFilename("special://temp/filecache%03d.cache", 999));
+  if (filename.empty())
+  {
+    CLog::Log(LOGERROR, "%s - Unable to generate a new filename", __FUNCTION__);
+    return CACHE_RC_ERROR;
+  }
+
+  m_fd = open(filename.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (m_fd < 0)
+  {
+    CLog::LogF(LOGERROR, "failed to create file \"%s\"", filename.c_str());
+    return CACHE_RC_ERROR;
+  }
+  // the file lives as long as it is open, nothing is left behind after a crash
+  unlink(filename.c_str());
+
+  // the file stays sparse, only blocks actually written use disk space
+  m_mapSize = slots * MAPPED_CACHE_BLOCK_SIZE;
+  if (ftruncate(m_fd, m_mapSize) != 0)
+  {
+    CLog::LogF(LOGERROR, "failed to resize file \"%s\" to %" PRIdS" bytes", filename.c_str(), m_mapSize);
+    Close();
+    return CACHE_RC_ERROR;
+  }
+
+  void *map = mmap(NULL, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (map == MAP_FAILED)
+  {
+    CLog::LogF(LOGERROR, "failed to map %" PRIdS" bytes of \"%s\"", m_mapSize, filename.c_str());
+    Close();
+    return CACHE_RC_ERROR;
+  }
+  m_map = (uint8_t*)map;
+
+  Slot slot = { -1, 0, 0, 0 };
+  m_slots.assign(slots, slot);
+  m_blocks.clear();
+  m_stamp = 0;
+  m_end = 0;
+  m_cur = 0;
+  return CACHE_RC_OK;
+}
+
+void CMappedFileCache::Close()
+{
+  if (m_map)
+    munmap(m_map, m_mapSize);
+  m_map = NULL;
+  m_mapSize = 0;
+
+  if (m_fd >= 0)
+    close(m_fd);
+  m_fd = -1;
+
+  m_slots.clear();
+  m_blocks.clear();
+}
+
+CMappedFileCache::Slot* CMappedFileCache::FindSlot(int64_t block)
+{
+  std::map<int64_t, size_t>::iterator it = m_blocks.find(block);
+  if (it == m_blocks.end())
+    return NULL;
+  return &m_slots[it->second];
+}
+
+/*!
+ \brief Find or make room for a block, returns NULL when all slots hold unread data
+ */
+CMappedFileCache::Slot* CMappedFileCache::GetSlot(int64_t block)
+{
+  Slot *slot = FindSlot(block);
+  if (slot)
+    return slot;
+
+  // blocks between read and write position haven't been read yet
+  int64_t first = m_cur / MAPPED_CACHE_BLOCK_SIZE;
+  int64_t last  = m_end / MAPPED_CACHE_BLOCK_SIZE;
+
+  Slot *oldest = NULL;
+  for (size_t i = 0; i < m_slots.size(); i++)
+  {
+    Slot &candidate = m_slots[i];
+    if (candidate.block < 0)
+    {
+      oldest = &candidate;
+      break;
+    }
+    if (candidate.block >= first && candidate.block <= last)
+      continue;
+    if (!oldest || candidate.stamp < oldest->stamp)
+      oldest = &candidate;
+  }
+
+  if (!oldest)
+    return NULL;
+
+  if (oldest->block >= 0)
+    m_blocks.erase(oldest->block);
+  oldest->block = block;
+  oldest->begin = 0;
+  oldest->end = 0;
+  oldest->stamp = ++m_stamp;
+  m_blocks[block] = oldest - &m_slots[0];
+  return oldest;
+}
+
+/*!
+ \brief Returns the first position at or after pos which isn't cached
+ */
+int64_t CMappedFileCache::RunEnd(int64_t pos)
+{
+  for (;;)
+  {
+    Slot *slot = FindSlot(pos / MAPPED_CACHE_BLOCK_SIZE);
+    size_t offset = (size_t)(pos % MAPPED_CACHE_BLOCK_SIZE);
+    if (!slot || offset < slot->begin || offset >= slot->end)
+      return pos;
+
+    pos += slot->end - offset;
+    if (slot->end < MAPPED_CACHE_BLOCK_SIZE)
+      return pos;
+  }
+}
+
+size_t CMappedFileCache::GetMaxWriteSize(const size_t& iRequestSize)
+{
+  CSingleLock lock(m_sync);
+
+  if (!m_map)
+    return 0;
+
+  int64_t block = m_end / MAPPED_CACHE_BLOCK_SIZE;
+  if (!FindSlot(block))
+  {
+    // a slot is available if any of them is free or holds no unread data
+    int64_t first = m_cur / MAPPED_CACHE_BLOCK_SIZE;
+    bool available = false;
+    for (size_t i = 0; i < m_slots.size() && !available; i++)
+      available = m_slots[i].block < first || m_slots[i].block > block;
+    if (!available)
+      return 0;
+  }
+
+  size_t limit = MAPPED_CACHE_BLOCK_SIZE - (size_t)(m_end % MAPPED_CACHE_BLOCK_SIZE);
+  return std::min(iRequestSize, limit);
+}
+
+/**
+ * Writes at m_end, block by block. Writing stops early when no slot
+ * can be recycled, so multiple calls may be needed.
+ */
+int CMappedFileCache::WriteToCache(const char *buf, size_t len)
+{
+  CSingleLock lock(m_sync);
+
+  if (!m_map)
+    return CACHE_RC_ERROR;
+
+  size_t written = 0;
+  while (written < len)
+  {
+    Slot *slot = GetSlot(m_end / MAPPED_CACHE_BLOCK_SIZE);
+    if (!slot)
+      break;
+
+    size_t offset = (size_t)(m_end % MAPPED_CACHE_BLOCK_SIZE);
+    size_t size = std::min(len - written, (size_t)MAPPED_CACHE_BLOCK_SIZE - offset);
+    memcpy(m_map + (slot - &m_slots[0]) * MAPPED_CACHE_BLOCK_SIZE + offset, buf + written, size);
+
+    // merge with the valid part of the block if we touch it, else start over
+    if (offset <= slot->end && offset + size >= slot->begin && slot->end > 0)
+    {
+      slot->begin = std::min(slot->begin, offset);
+      slot->end = std::max(slot->end, offset + size);
+    }
+    else
+    {
+      slot->begin = offset;
+      slot->end = offset + size;
+    }
+    slot->stamp = ++m_stamp;
+
+    m_end += size;
+    written += size;
+  }
+
+  if (written > 0)
+    m_written.Set();
+
+  return written;
+}
+
+int CMappedFileCache::ReadFromCache(char *buf, size_t len)
+{
+  CSingleLock lock(m_sync);
+
+  if (m_cur >= m_end)
+  {
+    if(IsEndOfInput())
+      return 0;
+    else
+      return CACHE_RC_WOULD_BLOCK;
+  }
+
+  size_t read = 0;
+  while (read < len && m_cur < m_end)
+  {
+    Slot *slot = FindSlot(m_cur / MAPPED_CACHE_BLOCK_SIZE);
+    size_t offset = (size_t)(m_cur % MAPPED_CACHE_BLOCK_SIZE);
+    if (!slot || offset < slot->begin || offset >= slot->end)
+    {
+      CLog::LogF(LOGERROR, "position %" PRId64" is missing from cache", m_cur);
+      return read > 0 ? (int)read : CACHE_RC_ERROR;
+    }
+
+    size_t size = std::min(len - read, slot->end - offset);
+    size = (size_t)std::min((int64_t)size, m_end - m_cur);
+    memcpy(buf + read, m_map + (slot - &m_slots[0]) * MAPPED_CACHE_BLOCK_SIZE + offset, size);
+    slot->stamp = ++m_stamp;
+
+    m_cur += size;
+    read += size;
+  }
+
+  m_space.Set();
+
+  return read;
+}
+
+int64_t CMappedFileCache::WaitForData(unsigned int minimum, unsigned int millis)
+{
+  CSingleLock lock(m_sync);
+  int64_t avail = m_end - m_cur;
+
+  if(millis == 0 || IsEndOfInput())
+    return avail;
+
+  if(minimum > m_mapSize - MAPPED_CACHE_BLOCK_SIZE)
+    minimum = m_mapSize - MAPPED_CACHE_BLOCK_SIZE;
+
+  XbmcThreads::EndTime endtime(millis);
+  while (!IsEndOfInput() && avail < minimum && !endtime.IsTimePast() )
+  {
+    lock.Leave();
+    m_written.WaitMSec(50); // may miss the deadline. shouldn't be a problem.
+    lock.Enter();
+    avail = m_end - m_cur;
+  }
+
+  return avail;
+}
+
+int64_t CMappedFileCache::Seek(int64_t pos)
+{
+  CSingleLock lock(m_sync);
+
+  // if seek is a bit over what we have, try to wait a few seconds for the data to be available.
+  // we try to avoid a (heavy) seek on the source
+  if (pos >= m_end && pos < m_end + 100000)
+  {
+    m_cur = m_end;
+    lock.Leave();
+    WaitForData((size_t)(pos - m_cur), 5000);
+    lock.Enter();
+  }
+
+  // only positions connected to the write position can be read from here,
+  // for other cached ranges the source has to be moved by a cache reset
+  if (pos <= m_end && RunEnd(pos) >= m_end)
+  {
+    m_cur = pos;
+    m_space.Set();
+    return pos;
+  }
+
+  return CACHE_RC_ERROR;
+}
+
+bool CMappedFileCache::Reset(int64_t pos, bool clearAnyway)
+{
+  CSingleLock lock(m_sync);
+
+  if (clearAnyway)
+  {
+    Slot slot = { -1, 0, 0, 0 };
+    std::fill(m_slots.begin(), m_slots.end(), slot);
+    m_blocks.clear();
+  }
+
+  bool cached = IsCachedPosition(pos);
+  m_cur = pos;
+  m_end = RunEnd(pos);
+  m_space.Set();
+
+  return !cached;
+}
+
+int64_t CMappedFileCache::CachedDataEndPosIfSeekTo(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+  return RunEnd(iFilePosition);
+}
+
+int64_t CMappedFileCache::CachedDataEndPos()
+{
+  return m_end;
+}
+
+bool CMappedFileCache::IsCachedPosition(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+  return iFilePosition == m_end || RunEnd(iFilePosition) > iFilePosition;
+}
+
+CCacheStrategy *CMappedFileCache::CreateNew()
+{
+  return new CMappedFileCache(m_fileSize);
+}
@@ -0,0 +1,93 @@
+/*
+ *      Copyright (C) 2017 Team MrMC
+ *      https://github.com/MrMC
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MrMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CACHEMAPPEDFILE_H
+#define CACHEMAPPEDFILE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "CacheStrategy.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+
+namespace XFILE {
+
+/*!
+ \brief Disk cache keeping several cached ranges of the source.
+
+ The source is split in fixed size blocks which are stored in the slots of a
+ memory mapped temporary file. Each slot remembers which part of its block
+ is valid, so data from earlier positions survives seeks and is served again
+ when reading returns there. When all slots are in use, the least recently
+ used block outside the unread range [m_cur, m_end) is recycled.
+ */
+class CMappedFileCache : public CCacheStrategy
+{
+public:
+  CMappedFileCache(int64_t fileSize);
+  virtual ~CMappedFileCache();
+
+  virtual int Open();
+  virtual void Close();
+
+  virtual size_t GetMaxWriteSize(const size_t& iRequestSize);
+  virtual int WriteToCache(const char *buf, size_t len);
+  virtual int ReadFromCache(char *buf, size_t len);
+  virtual int64_t WaitForData(unsigned int minimum, unsigned int iMillis);
+
+  virtual int64_t Seek(int64_t pos);
+  virtual bool Reset(int64_t pos, bool clearAnyway=true);
+
+  virtual int64_t CachedDataEndPosIfSeekTo(int64_t iFilePosition);
+  virtual int64_t CachedDataEndPos();
+  virtual bool IsCachedPosition(int64_t iFilePosition);
+
+  virtual CCacheStrategy *CreateNew();
+
+protected:
+  struct Slot
+  {
+    int64_t  block;  /**< block of the source stored in this slot, -1 if free */
+    size_t   begin;  /**< offset of the first valid byte in the block */
+    size_t   end;    /**< offset past the last valid byte in the block */
+    uint64_t stamp;  /**< last access, for recycling */
+  };
+
+  int64_t RunEnd(int64_t pos);
+  Slot* FindSlot(int64_t block);
+  Slot* GetSlot(int64_t block);
+
+  int64_t           m_fileSize;
+  int64_t           m_end;       /**< index in file of end of data the source is written to */
+  int64_t           m_cur;       /**< current reading index in file */
+  int               m_fd;
+  uint8_t          *m_map;       /**< mapping of the whole cache file */
+  size_t            m_mapSize;
+  uint64_t          m_stamp;
+  std::vector<Slot> m_slots;
+  std::map<int64_t, size_t> m_blocks; /**< source block -> slot index */
+  CCriticalSection  m_sync;
+  CEvent            m_written;
+};
+
+} // namespace XFILE
+#endif
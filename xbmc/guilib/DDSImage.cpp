@@ -19,6 +19,7 @@
  */
 
 #include <algorithm>
+#include <vector>
 #include "DDSImage.h"
 #include "XBTF.h"
 #include "utils/log.h"
@@ -26,26 +27,55 @@
 
 #ifndef NO_XBMC_FILESYSTEM
 #include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "URL.h"
 using namespace XFILE;
 #else
 #include "SimpleFS.h"
 #endif
 
+#if defined(TARGET_POSIX) && !defined(NO_XBMC_FILESYSTEM)
+#define HAS_DDS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 CDDSImage::CDDSImage()
 {
   m_data = NULL;
+  m_map = NULL;
+  m_mapSize = 0;
   memset(&m_desc, 0, sizeof(m_desc));
 }
 
 CDDSImage::CDDSImage(unsigned int width, unsigned int height, unsigned int format)
 {
   m_data = NULL;
+  m_map = NULL;
+  m_mapSize = 0;
   Allocate(width, height, format);
 }
 
 CDDSImage::~CDDSImage()
 {
+  Free();
+}
+
+void CDDSImage::Free()
+{
+#ifdef HAS_DDS_MMAP
+  if (m_map)
+  {
+    munmap(m_map, m_mapSize);
+    m_data = NULL;
+  }
+#endif
+  m_map = NULL;
+  m_mapSize = 0;
   delete[] m_data;
+  m_data = NULL;
 }
 
 unsigned int CDDSImage::GetWidth() const
@@ -86,8 +116,63 @@ unsigned char *CDDSImage::GetData() const
   return m_data;
 }
 
+bool CDDSImage::HasAlpha() const
+{
+  // compressed formats don't flag their alpha
+  if (GetFormat() != XB_FMT_A8R8G8B8)
+    return true;
+  return (m_desc.pixelFormat.flags & DDPF_ALPHAPIXELS) != 0;
+}
+
+bool CDDSImage::MapFile(const std::string &inputFile)
+{
+#ifdef HAS_DDS_MMAP
+  std::string path = CSpecialProtocol::TranslatePath(inputFile);
+  if (!CURL(path).GetProtocol().empty())
+    return false;
+
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < (off_t)(4 + sizeof(m_desc)))
+  {
+    close(fd);
+    return false;
+  }
+
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return false;
+
+  m_map = (unsigned char *)map;
+  m_mapSize = st.st_size;
+  memcpy(&m_desc, m_map + 4, sizeof(m_desc));
+  if (memcmp(m_map, "DDS ", 4) != 0 || !GetFormat() ||
+      m_mapSize - 4 - sizeof(m_desc) < m_desc.linearSize)
+  {
+    CLog::Log(LOGERROR, "%s - invalid DDS file %s", __FUNCTION__, inputFile.c_str());
+    Free();
+    memset(&m_desc, 0, sizeof(m_desc));
+    return false;
+  }
+  m_data = m_map + 4 + sizeof(m_desc);
+  return true;
+#else
+  return false;
+#endif
+}
+
 bool CDDSImage::ReadFile(const std::string &inputFile)
 {
+  Free();
+
+  // local files are uploaded straight from the page cache
+  if (MapFile(inputFile))
+    return true;
+
   // open the file
   CFile file;
   if (!file.Open(inputFile))
@@ -115,6 +200,28 @@ bool CDDSImage::ReadFile(const std::string &inputFile)
   return true;
 }
 
+bool CDDSImage::Create(const std::string &outputFile, unsigned int width, unsigned int height, unsigned int pitch, const unsigned char *pixels, bool hasAlpha)
+{
+  if (!pixels || !width || !height)
+    return false;
+
+  InitDesc(width, height, XB_FMT_A8R8G8B8);
+  if (hasAlpha)
+    m_desc.pixelFormat.flags |= ddpf_alphapixels;
+
+  // the whole file is put together in one buffer, the rows go there directly
+  std::vector<unsigned char> data(4 + sizeof(m_desc) + m_desc.linearSize);
+  memcpy(&data[0], "DDS ", 4);
+  memcpy(&data[4], &m_desc, sizeof(m_desc));
+  unsigned char *rows = &data[4 + sizeof(m_desc)];
+  unsigned int rowSize = width * 4;
+  for (unsigned int y = 0; y < height; y++)
+    memcpy(rows + y * rowSize, pixels + y * pitch, rowSize);
+
+  // a partially written file must never be picked up in place of the original
+  return CFile::WriteAtomically(outputFile, data.data(), data.size());
+}
+
 unsigned int CDDSImage::GetStorageRequirements(unsigned int width, unsigned int height, unsigned int format)
 {
   switch (format)
@@ -131,6 +238,13 @@ unsigned int CDDSImage::GetStorageRequirements(unsigned int width, unsigned int
 }
 
 void CDDSImage::Allocate(unsigned int width, unsigned int height, unsigned int format)
+{
+  InitDesc(width, height, format);
+  Free();
+  m_data = new unsigned char[m_desc.linearSize];
+}
+
+void CDDSImage::InitDesc(unsigned int width, unsigned int height, unsigned int format)
 {
   memset(&m_desc, 0, sizeof(m_desc));
   m_desc.size = sizeof(m_desc);
@@ -142,8 +256,6 @@ void CDDSImage::Allocate(unsigned int width, unsigned int height, unsigned int f
   m_desc.pixelFormat.flags = ddpf_fourcc;
   memcpy(&m_desc.pixelFormat.fourcc, GetFourCC(format), 4);
   m_desc.caps.flags1 = ddscaps_texture;
-  delete[] m_data;
-  m_data = new unsigned char[m_desc.linearSize];
 }
 
 const char *CDDSImage::GetFourCC(unsigned int format)
@@ -35,11 +35,24 @@ public:
   unsigned int GetFormat() const;
   unsigned int GetSize() const;
   unsigned char *GetData() const;
+  bool HasAlpha() const;
 
+  /*!
+   \brief Reads a DDS file, local files are memory mapped rather than copied
+   */
   bool ReadFile(const std::string &file);
 
+  /*!
+   \brief Writes uncompressed A8R8G8B8 pixels to a DDS file which can be
+   uploaded as is by ReadFile and CBaseTexture
+   */
+  bool Create(const std::string &file, unsigned int width, unsigned int height, unsigned int pitch, const unsigned char *pixels, bool hasAlpha);
+
 private:
   void Allocate(unsigned int width, unsigned int height, unsigned int format);
+  void InitDesc(unsigned int width, unsigned int height, unsigned int format);
+  void Free();
+  bool MapFile(const std::string &file);
   static const char *GetFourCC(unsigned int format);
 
   static unsigned int GetStorageRequirements(unsigned int width, unsigned int height, unsigned int format);
@@ -111,4 +124,6 @@ private:
 
   ddsurfacedesc2 m_desc;
   unsigned char *m_data;
+  unsigned char *m_map;     ///< mapping of the whole file m_data points into, if any
+  size_t         m_mapSize;
 };
@@ -164,6 +164,14 @@ void CGUIFontTTFGL::LastEnd()
   glDisable(GL_TEXTURE_2D);
 #else
   // GLES 2.0 version.
+  // textures queued so far go first, they change what FirstBegin() set up
+  if (g_Windowing.GUIQuadBatch().Flush())
+  {
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE_MINUS_DST_ALPHA, GL_ONE);
+    glEnable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_2D, m_nTexture);
+  }
+
   g_Windowing.EnableGUIShader(SM_FONTS);
 
   CreateStaticVertexBuffers();
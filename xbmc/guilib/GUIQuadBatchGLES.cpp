@@ -0,0 +1,303 @@
+/*
+ *      Copyright (C) 2017 Team MrMC
+ *      https://github.com/MrMC
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MrMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#if defined(HAS_GLES)
+
+#include <algorithm>
+#include <cstddef>
+#include <string.h>
+
+#include "GUIQuadBatchGLES.h"
+#include "Texture.h"
+#include "windowing/WindowingFactory.h"
+
+// indices are GLushort, so a single draw call can't address more vertices
+#define QUAD_BATCH_MAX_QUADS (65536 / 4)
+// how many runs a quad may skip to join one with the same state
+#define QUAD_BATCH_LOOKBACK  8
+
+bool CGUIQuadBatchGLES::State::operator==(const State &rhs) const
+{
+  return texture == rhs.texture &&
+         diffuse == rhs.diffuse &&
+         shader  == rhs.shader  &&
+         blend   == rhs.blend   &&
+         memcmp(color, rhs.color, sizeof(color)) == 0;
+}
+
+CGUIQuadBatchGLES::CGUIQuadBatchGLES()
+ : m_runCount(0)
+ , m_vertexBuffer(0)
+ , m_vertexBufferSize(0)
+ , m_indexBuffer(0)
+ , m_flushing(false)
+{
+  memset(&m_frame, 0, sizeof(m_frame));
+  memset(&m_lastFrame, 0, sizeof(m_lastFrame));
+}
+
+CGUIQuadBatchGLES::~CGUIQuadBatchGLES()
+{
+}
+
+void CGUIQuadBatchGLES::AddQuads(const State &state, const PackedVertex *vertices, size_t count)
+{
+  if (count < 4)
+    return;
+
+  // the whole batch is drawn with one set of matrices
+  if (m_runCount > 0 &&
+     (memcmp(m_modview.m_pMatrix, glMatrixModview.Get().m_pMatrix, sizeof(m_modview.m_pMatrix)) != 0 ||
+      memcmp(m_project.m_pMatrix, glMatrixProject.Get().m_pMatrix, sizeof(m_project.m_pMatrix)) != 0))
+    Flush();
+
+  if (m_runCount == 0)
+  {
+    m_modview = glMatrixModview.Get();
+    m_project = glMatrixProject.Get();
+  }
+
+  CRect bounds(vertices[0].x, vertices[0].y, vertices[0].x, vertices[0].y);
+  bool flat = true;
+  for (size_t i = 0; i < count; i++)
+  {
+    bounds.x1 = std::min(bounds.x1, vertices[i].x);
+    bounds.y1 = std::min(bounds.y1, vertices[i].y);
+    bounds.x2 = std::max(bounds.x2, vertices[i].x);
+    bounds.y2 = std::max(bounds.y2, vertices[i].y);
+    flat &= vertices[i].z == 0.0f;
+  }
+
+  // join the latest run with the same state, unless that means drawing
+  // the quads before something queued later which they overlap
+  Run *target = NULL;
+  size_t last = m_runCount > QUAD_BATCH_LOOKBACK ? m_runCount - QUAD_BATCH_LOOKBACK : 0;
+  for (size_t i = m_runCount; i > last; i--)
+  {
+    Run &run = m_runs[i - 1];
+    if (run.state == state)
+    {
+      target = &run;
+      break;
+    }
+    if (!flat || !run.flat ||
+        (bounds.x1 < run.bounds.x2 && run.bounds.x1 < bounds.x2 &&
+         bounds.y1 < run.bounds.y2 && run.bounds.y1 < bounds.y2))
+      break;
+  }
+
+  if (target)
+  {
+    target->bounds.Union(bounds);
+    target->flat &= flat;
+  }
+  else
+  {
+    if (m_runCount == m_runs.size())
+      m_runs.push_back(Run());
+    target = &m_runs[m_runCount++];
+    target->state = state;
+    target->bounds = bounds;
+    target->flat = flat;
+    target->vertices.clear();
+  }
+
+  target->vertices.insert(target->vertices.end(), vertices, vertices + count);
+  m_frame.quads += count / 4;
+}
+
+void CGUIQuadBatchGLES::CreateBuffers()
+{
+  // the same index pattern serves every draw call
+  std::vector<GLushort> index(QUAD_BATCH_MAX_QUADS * 6);
+  for (size_t i = 0; i < QUAD_BATCH_MAX_QUADS; i++)
+  {
+    index[i * 6 + 0] = 4 * i + 0;
+    index[i * 6 + 1] = 4 * i + 1;
+    index[i * 6 + 2] = 4 * i + 2;
+    index[i * 6 + 3] = 4 * i + 2;
+    index[i * 6 + 4] = 4 * i + 3;
+    index[i * 6 + 5] = 4 * i + 0;
+  }
+
+  glGenBuffers(1, &m_indexBuffer);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, index.size() * sizeof(GLushort), &index[0], GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  glGenBuffers(1, &m_vertexBuffer);
+  m_vertexBufferSize = 0;
+}
+
+bool CGUIQuadBatchGLES::Flush()
+{
+  // enabling the shaders below would get us here again
+  if (m_flushing || m_runCount == 0)
+    return false;
+  m_flushing = true;
+
+  if (!m_indexBuffer)
+    CreateBuffers();
+
+  m_upload.clear();
+  for (size_t i = 0; i < m_runCount; i++)
+    m_upload.insert(m_upload.end(), m_runs[i].vertices.begin(), m_runs[i].vertices.end());
+
+  // orphan the previous storage, the driver may still be reading it
+  size_t size = m_upload.size() * sizeof(PackedVertex);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+  if (size > m_vertexBufferSize)
+  {
+    glBufferData(GL_ARRAY_BUFFER, size, &m_upload[0], GL_STREAM_DRAW);
+    m_vertexBufferSize = size;
+  }
+  else
+  {
+    glBufferData(GL_ARRAY_BUFFER, m_vertexBufferSize, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, &m_upload[0]);
+  }
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+
+  // the shaders pick up the matrices which were current when queueing
+  CMatrixGL modview = glMatrixModview.Get();
+  CMatrixGL project = glMatrixProject.Get();
+  glMatrixModview.Get() = m_modview;
+  glMatrixProject.Get() = m_project;
+
+  const State *current = NULL;
+  GLint posLoc = -1, tex0Loc = -1, tex1Loc = -1, uniColLoc = -1;
+  bool blendFunc = false;
+  size_t first = 0;
+
+  for (size_t i = 0; i < m_runCount; i++)
+  {
+    const Run &run = m_runs[i];
+    const State &state = run.state;
+
+    if (!current || current->shader != state.shader)
+    {
+      if (current)
+      {
+        glDisableVertexAttribArray(posLoc);
+        glDisableVertexAttribArray(tex0Loc);
+        if (tex1Loc >= 0)
+          glDisableVertexAttribArray(tex1Loc);
+        g_Windowing.DisableGUIShader();
+      }
+
+      g_Windowing.EnableGUIShader((ESHADERMETHOD)state.shader);
+      posLoc    = g_Windowing.GUIShaderGetPos();
+      tex0Loc   = g_Windowing.GUIShaderGetCoord0();
+      tex1Loc   = state.diffuse ? g_Windowing.GUIShaderGetCoord1() : -1;
+      uniColLoc = g_Windowing.GUIShaderGetUniCol();
+
+      glEnableVertexAttribArray(posLoc);
+      glEnableVertexAttribArray(tex0Loc);
+      if (tex1Loc >= 0)
+        glEnableVertexAttribArray(tex1Loc);
+    }
+
+    if (!current || current->texture != state.texture || current->diffuse != state.diffuse)
+    {
+      state.texture->BindToUnit(0);
+      if (state.diffuse)
+        state.diffuse->BindToUnit(1);
+    }
+
+    if (!current || current->blend != state.blend)
+    {
+      if (state.blend)
+      {
+        if (!blendFunc)
+          glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE_MINUS_DST_ALPHA, GL_ONE);
+        blendFunc = true;
+        glEnable(GL_BLEND);
+      }
+      else
+        glDisable(GL_BLEND);
+    }
+
+    if (uniColLoc >= 0)
+      glUniform4f(uniColLoc, (state.color[0] / 255.0f), (state.color[1] / 255.0f), (state.color[2] / 255.0f), (state.color[3] / 255.0f));
+
+    current = &state;
+
+    size_t quads = run.vertices.size() / 4;
+    for (size_t quad = 0; quad < quads; quad += QUAD_BATCH_MAX_QUADS)
+    {
+      size_t count = std::min<size_t>(quads - quad, QUAD_BATCH_MAX_QUADS);
+      size_t offset = (first + quad * 4) * sizeof(PackedVertex);
+
+      // offsets into the buffer bound to GL_ARRAY_BUFFER
+      glVertexAttribPointer(posLoc, 3, GL_FLOAT, 0, sizeof(PackedVertex), (GLvoid *) (offset + offsetof(PackedVertex, x)));
+      glVertexAttribPointer(tex0Loc, 2, GL_FLOAT, 0, sizeof(PackedVertex), (GLvoid *) (offset + offsetof(PackedVertex, u1)));
+      if (tex1Loc >= 0)
+        glVertexAttribPointer(tex1Loc, 2, GL_FLOAT, 0, sizeof(PackedVertex), (GLvoid *) (offset + offsetof(PackedVertex, u2)));
+
+      glDrawElements(GL_TRIANGLES, count * 6, GL_UNSIGNED_SHORT, 0);
+      m_frame.drawCalls++;
+    }
+    first += run.vertices.size();
+  }
+
+  glDisableVertexAttribArray(posLoc);
+  glDisableVertexAttribArray(tex0Loc);
+  if (tex1Loc >= 0)
+    glDisableVertexAttribArray(tex1Loc);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  glActiveTexture(GL_TEXTURE0);
+  glEnable(GL_BLEND);
+  g_Windowing.DisableGUIShader();
+
+  glMatrixModview.Get() = modview;
+  glMatrixProject.Get() = project;
+
+  m_frame.flushes++;
+  m_runCount = 0;
+  m_flushing = false;
+  return true;
+}
+
+void CGUIQuadBatchGLES::EndFrame()
+{
+  m_lastFrame = m_frame;
+  memset(&m_frame, 0, sizeof(m_frame));
+}
+
+void CGUIQuadBatchGLES::Destroy()
+{
+  m_runCount = 0;
+  m_runs.clear();
+  m_upload.clear();
+
+  if (m_vertexBuffer)
+    glDeleteBuffers(1, &m_vertexBuffer);
+  if (m_indexBuffer)
+    glDeleteBuffers(1, &m_indexBuffer);
+  m_vertexBuffer = 0;
+  m_vertexBufferSize = 0;
+  m_indexBuffer = 0;
+}
+
+#endif
@@ -0,0 +1,120 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2017 Team MrMC
+ *      https://github.com/MrMC
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MrMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stddef.h>
+#include <vector>
+
+#include "system_gl.h"
+#include "guilib/Geometry.h"
+#include "guilib/MatrixGLES.h"
+
+class CBaseTexture;
+
+struct PackedVertex
+{
+  float x, y, z;
+  float u1, v1;
+  float u2, v2;
+};
+typedef std::vector<PackedVertex> PackedVertices;
+
+/*!
+ \brief Collects the quads of GUI textures and draws them with as few draw
+ calls as possible.
+
+ Quads are grouped in runs sharing textures, shader, blending and color.
+ New quads join an earlier run with the same state if they don't overlap
+ anything queued after it, so the result looks as if every texture was
+ drawn on its own. The vertices of all runs are uploaded to a streaming
+ vertex buffer once per flush. The render system flushes the batch before
+ anything else touches the GL state (other shaders, scissors, viewport,
+ matrices, video) and at the end of the frame.
+ */
+class CGUIQuadBatchGLES
+{
+public:
+  struct State
+  {
+    CBaseTexture *texture;
+    CBaseTexture *diffuse;
+    int           shader;    /**< ESHADERMETHOD */
+    bool          blend;
+    GLubyte       color[4];
+
+    bool operator==(const State &rhs) const;
+  };
+
+  struct Stats
+  {
+    unsigned int drawCalls;
+    unsigned int quads;
+    unsigned int flushes;
+  };
+
+  CGUIQuadBatchGLES();
+  ~CGUIQuadBatchGLES();
+
+  /*!
+   \brief Queues quads, count is the number of vertices (4 per quad)
+   */
+  void AddQuads(const State &state, const PackedVertex *vertices, size_t count);
+
+  /*!
+   \brief Draws everything queued, leaves GL_TEXTURE0 active and blending on
+   \return true if anything was drawn, i.e. texture bindings changed
+   */
+  bool Flush();
+
+  /*!
+   \brief Makes the counters of the frame just drawn available
+   */
+  void EndFrame();
+  const Stats& GetFrameStats() const { return m_lastFrame; }
+
+  /*!
+   \brief Drops queued quads and releases the GL buffers
+   */
+  void Destroy();
+
+private:
+  struct Run
+  {
+    State          state;
+    CRect          bounds;
+    bool           flat;     /**< all z are 0, so bounds can be compared */
+    PackedVertices vertices;
+  };
+
+  void CreateBuffers();
+
+  std::vector<Run> m_runs;
+  size_t           m_runCount;
+  PackedVertices   m_upload;
+  CMatrixGL        m_modview;
+  CMatrixGL        m_project;
+  GLuint           m_vertexBuffer;
+  size_t           m_vertexBufferSize;
+  GLuint           m_indexBuffer;
+  bool             m_flushing;
+  Stats            m_frame;
+  Stats            m_lastFrame;
+};
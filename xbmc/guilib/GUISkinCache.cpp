@@ -0,0 +1,612 @@
+/*
+ *      Copyright (C) 2017 Team MrMC
+ *      https://github.com/MrMC
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MrMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "GUISkinCache.h"
+
+#include <string.h>
+
+#include "GUIInfoManager.h"
+#include "addons/Skin.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "threads/SingleLock.h"
+#include "utils/Crc32.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+#include "utils/XBMCTinyXML.h"
+
+#if defined(TARGET_POSIX)
+#define HAS_SKIN_CACHE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace XFILE;
+
+#define SKIN_CACHE_PATH     "special://temp/skincache/"
+#define SKIN_CACHE_MAGIC    "MSKC"
+// bump when the layout below changes
+#define SKIN_CACHE_FORMAT   1
+// condition value combinations kept per window
+#define SKIN_CACHE_VARIANTS 4
+// deeper trees are taken as a damaged file
+#define SKIN_CACHE_MAX_DEPTH 256
+
+/*
+ File layout, all numbers in host byte order:
+   magic, format, skin id, skin version, window file
+   source count, (path, time, size) of every file the window was made from
+   variant count, per variant
+     condition count, (expression, value) per include condition
+     tree size, tree: string count, strings, then the nodes in document
+     order as type, value string, [attribute count, (name, value) strings],
+     child count for elements
+ Strings are a 32 bit length followed by the characters.
+ */
+enum SkinCacheNode
+{
+  SKIN_CACHE_ELEMENT = 1,
+  SKIN_CACHE_TEXT,
+  SKIN_CACHE_CDATA,
+  SKIN_CACHE_COMMENT,
+  SKIN_CACHE_UNKNOWN
+};
+
+namespace
+{
+
+class CCacheWriter
+{
+public:
+  CCacheWriter(std::string &data) : m_data(data) {}
+
+  void U8(uint8_t value)   { m_data.push_back((char)value); }
+  void U32(uint32_t value) { m_data.append((const char *)&value, sizeof(value)); }
+  void I64(int64_t value)  { m_data.append((const char *)&value, sizeof(value)); }
+  void String(const std::string &value)
+  {
+    U32(value.size());
+    m_data.append(value);
+  }
+
+private:
+  std::string &m_data;
+};
+
+class CCacheReader
+{
+public:
+  CCacheReader(const uint8_t *data, size_t size) : m_pos(data), m_end(data + size), m_ok(true) {}
+
+  bool Ok() const { return m_ok; }
+  void Fail() { m_ok = false; }
+
+  const uint8_t* Bytes(size_t size)
+  {
+    if (!m_ok || (size_t)(m_end - m_pos) < size)
+    {
+      m_ok = false;
+      return NULL;
+    }
+    const uint8_t *bytes = m_pos;
+    m_pos += size;
+    return bytes;
+  }
+  uint8_t U8()
+  {
+    const uint8_t *bytes = Bytes(1);
+    return bytes ? *bytes : 0;
+  }
+  uint32_t U32()
+  {
+    uint32_t value = 0;
+    const uint8_t *bytes = Bytes(sizeof(value));
+    if (bytes)
+      memcpy(&value, bytes, sizeof(value));
+    return value;
+  }
+  int64_t I64()
+  {
+    int64_t value = 0;
+    const uint8_t *bytes = Bytes(sizeof(value));
+    if (bytes)
+      memcpy(&value, bytes, sizeof(value));
+    return value;
+  }
+  std::string String()
+  {
+    uint32_t size = U32();
+    const uint8_t *bytes = Bytes(size);
+    return bytes ? std::string((const char *)bytes, size) : std::string();
+  }
+
+private:
+  const uint8_t *m_pos;
+  const uint8_t *m_end;
+  bool m_ok;
+};
+
+class CTreeWriter
+{
+public:
+  std::string Write(const TiXmlElement *root)
+  {
+    std::string nodes;
+    CCacheWriter writer(nodes);
+    WriteNode(writer, root);
+
+    std::string data;
+    CCacheWriter table(data);
+    table.U32(m_strings.size());
+    for (std::vector<const std::string*>::const_iterator it = m_strings.begin(); it != m_strings.end(); ++it)
+      table.String(**it);
+    data.append(nodes);
+    return data;
+  }
+
+private:
+  static bool IsStored(const TiXmlNode *node)
+  {
+    int type = node->Type();
+    return type == TiXmlNode::TINYXML_ELEMENT || type == TiXmlNode::TINYXML_TEXT ||
+           type == TiXmlNode::TINYXML_COMMENT || type == TiXmlNode::TINYXML_UNKNOWN;
+  }
+
+  uint32_t Index(const std::string &value)
+  {
+    std::map<std::string, uint32_t>::iterator it = m_index.find(value);
+    if (it != m_index.end())
+      return it->second;
+    it = m_index.insert(std::make_pair(value, (uint32_t)m_strings.size())).first;
+    m_strings.push_back(&it->first);
+    return it->second;
+  }
+
+  void WriteNode(CCacheWriter &writer, const TiXmlNode *node)
+  {
+    switch (node->Type())
+    {
+    case TiXmlNode::TINYXML_ELEMENT:
+      {
+        const TiXmlElement *element = node->ToElement();
+        writer.U8(SKIN_CACHE_ELEMENT);
+        writer.U32(Index(element->ValueStr()));
+
+        uint32_t attributes = 0;
+        for (const TiXmlAttribute *attribute = element->FirstAttribute(); attribute; attribute = attribute->Next())
+          attributes++;
+        writer.U32(attributes);
+        for (const TiXmlAttribute *attribute = element->FirstAttribute(); attribute; attribute = attribute->Next())
+        {
+          writer.U32(Index(attribute->Name()));
+          writer.U32(Index(attribute->Value()));
+        }
+
+        uint32_t children = 0;
+        for (const TiXmlNode *child = element->FirstChild(); child; child = child->NextSibling())
+          children += IsStored(child) ? 1 : 0;
+        writer.U32(children);
+        for (const TiXmlNode *child = element->FirstChild(); child; child = child->NextSibling())
+        {
+          if (IsStored(child))
+            WriteNode(writer, child);
+        }
+      }
+      break;
+    case TiXmlNode::TINYXML_TEXT:
+      writer.U8(node->ToText()->CDATA() ? SKIN_CACHE_CDATA : SKIN_CACHE_TEXT);
+      writer.U32(Index(node->ValueStr()));
+      break;
+    case TiXmlNode::TINYXML_COMMENT:
+      writer.U8(SKIN_CACHE_COMMENT);
+      writer.U32(Index(node->ValueStr()));
+      break;
+    default:
+      writer.U8(SKIN_CACHE_UNKNOWN);
+      writer.U32(Index(node->ValueStr()));
+      break;
+    }
+  }
+
+  std::map<std::string, uint32_t> m_index;
+  std::vector<const std::string*> m_strings;
+};
+
+class CTreeReader
+{
+public:
+  CTreeReader(const uint8_t *data, size_t size) : m_reader(data, size) {}
+
+  TiXmlElement* Read()
+  {
+    uint32_t count = m_reader.U32();
+    for (uint32_t i = 0; i < count && m_reader.Ok(); i++)
+      m_strings.push_back(m_reader.String());
+    if (!m_reader.Ok())
+      return NULL;
+
+    TiXmlNode *root = ReadNode(0);
+    if (root && !root->ToElement())
+    {
+      delete root;
+      return NULL;
+    }
+    return (TiXmlElement *)root;
+  }
+
+private:
+  const std::string* String()
+  {
+    uint32_t index = m_reader.U32();
+    return m_reader.Ok() && index < m_strings.size() ? &m_strings[index] : NULL;
+  }
+
+  TiXmlNode* ReadNode(unsigned int depth)
+  {
+    uint8_t type = m_reader.U8();
+    const std::string *value = String();
+    if (!value || depth > SKIN_CACHE_MAX_DEPTH)
+      return NULL;
+
+    switch (type)
+    {
+    case SKIN_CACHE_ELEMENT:
+      {
+        TiXmlElement *element = new TiXmlElement(*value);
+        uint32_t attributes = m_reader.U32();
+        for (uint32_t i = 0; i < attributes && m_reader.Ok(); i++)
+        {
+          const std::string *name = String();
+          const std::string *attribute = String();
+          if (name && attribute)
+            element->SetAttribute(*name, *attribute);
+          else
+            m_reader.Fail();
+        }
+        uint32_t children = m_reader.U32();
+        for (uint32_t i = 0; i < children && m_reader.Ok(); i++)
+        {
+          TiXmlNode *child = ReadNode(depth + 1);
+          if (!child)
+          {
+            delete element;
+            return NULL;
+          }
+          element->LinkEndChild(child);
+        }
+        if (!m_reader.Ok())
+        {
+          delete element;
+          return NULL;
+        }
+        return element;
+      }
+    case SKIN_CACHE_TEXT:
+    case SKIN_CACHE_CDATA:
+      {
+        TiXmlText *text = new TiXmlText(*value);
+        text->SetCDATA(type == SKIN_CACHE_CDATA);
+        return text;
+      }
+    case SKIN_CACHE_COMMENT:
+      return new TiXmlComment(value->c_str());
+    case SKIN_CACHE_UNKNOWN:
+      {
+        TiXmlUnknown *unknown = new TiXmlUnknown();
+        unknown->SetValue(*value);
+        return unknown;
+      }
+    default:
+      return NULL;
+    }
+  }
+
+  CCacheReader m_reader;
+  std::vector<std::string> m_strings;
+};
+
+}
+
+bool CGUISkinCache::Source::operator==(const Source &rhs) const
+{
+  return path == rhs.path && time == rhs.time && size == rhs.size;
+}
+
+CGUISkinCache::Entry::Entry()
+ : map(NULL)
+ , mapSize(0)
+{
+}
+
+CGUISkinCache::Entry::~Entry()
+{
+#ifdef HAS_SKIN_CACHE_MMAP
+  if (map)
+    munmap(map, mapSize);
+#endif
+}
+
+CGUISkinCache::CGUISkinCache()
+{
+}
+
+CGUISkinCache::~CGUISkinCache()
+{
+}
+
+CGUISkinCache& CGUISkinCache::GetInstance()
+{
+  static CGUISkinCache sSkinCache;
+  return sSkinCache;
+}
+
+void CGUISkinCache::Clear()
+{
+  CSingleLock lock(m_section);
+  m_entries.clear();
+  m_sources.clear();
+}
+
+TiXmlElement* CGUISkinCache::Get(const std::string &path, std::map<INFO::InfoPtr, bool> &conditions)
+{
+  CSingleLock lock(m_section);
+  if (!g_SkinInfo)
+    return NULL;
+
+  std::unique_ptr<Entry> &entry = m_entries[path];
+  if (!entry)
+  {
+    // remember a missing or outdated file too, so we only look once
+    entry.reset(new Entry);
+    if (!Open(path, *entry))
+      entry.reset(new Entry);
+  }
+
+  for (std::vector<Variant>::const_iterator variant = entry->variants.begin(); variant != entry->variants.end(); ++variant)
+  {
+    bool match = true;
+    for (std::vector<std::pair<INFO::InfoPtr, bool> >::const_iterator it = variant->conditions.begin(); match && it != variant->conditions.end(); ++it)
+      match = it->first->Get() == it->second;
+    if (!match)
+      continue;
+
+    TiXmlElement *root = CTreeReader(variant->Data(), variant->size).Read();
+    if (!root)
+    {
+      CLog::Log(LOGERROR, "%s - damaged skin cache for %s", __FUNCTION__, path.c_str());
+      entry.reset(new Entry);
+      CFile::Delete(GetCacheFile(path));
+      return NULL;
+    }
+
+    conditions.clear();
+    conditions.insert(variant->conditions.begin(), variant->conditions.end());
+    return root;
+  }
+  return NULL;
+}
+
+void CGUISkinCache::Store(const std::string &path, const TiXmlElement *root, const std::map<INFO::InfoPtr, bool> &conditions)
+{
+  CSingleLock lock(m_section);
+  if (!g_SkinInfo || !root)
+    return;
+
+  std::vector<Source> sources;
+  if (!GetSources(path, sources))
+    return;
+
+  std::unique_ptr<Entry> &entry = m_entries[path];
+  if (!entry || entry->sources != sources)
+  {
+    entry.reset(new Entry);
+    entry->sources = sources;
+  }
+
+  Variant variant;
+  variant.conditions.assign(conditions.begin(), conditions.end());
+  variant.data = NULL;
+  variant.owned = CTreeWriter().Write(root);
+  variant.size = variant.owned.size();
+
+  // replace a variant for the same conditions, else the oldest one
+  std::vector<Variant> &variants = entry->variants;
+  for (std::vector<Variant>::iterator it = variants.begin(); it != variants.end(); )
+  {
+    if (it->conditions == variant.conditions)
+      it = variants.erase(it);
+    else
+      ++it;
+  }
+  if (variants.size() >= SKIN_CACHE_VARIANTS)
+    variants.erase(variants.begin());
+  variants.push_back(variant);
+
+  Write(path, *entry);
+}
+
+bool CGUISkinCache::GetSource(const std::string &path, Source &source)
+{
+  std::map<std::string, Source>::const_iterator it = m_sources.find(path);
+  if (it != m_sources.end())
+  {
+    source = it->second;
+    return true;
+  }
+
+  struct __stat64 st;
+  if (CFile::Stat(path, &st) != 0)
+    return false;
+
+  source.path = path;
+  source.time = st.st_mtime;
+  source.size = st.st_size;
+  m_sources[path] = source;
+  return true;
+}
+
+bool CGUISkinCache::GetSources(const std::string &path, std::vector<Source> &sources)
+{
+  // the window can use anything in the include files loaded so far
+  std::vector<std::string> files(1, path);
+  const std::vector<std::string> &includes = g_SkinInfo->GetIncludeFiles();
+  files.insert(files.end(), includes.begin(), includes.end());
+
+  sources.resize(files.size());
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    if (!GetSource(files[i], sources[i]))
+      return false;
+  }
+  return true;
+}
+
+bool CGUISkinCache::Open(const std::string &path, Entry &entry)
+{
+  std::string file = GetCacheFile(path);
+#ifdef HAS_SKIN_CACHE_MMAP
+  std::string localFile = CSpecialProtocol::TranslatePath(file);
+  int fd = open(localFile.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return false;
+
+  entry.map = (uint8_t *)map;
+  entry.mapSize = st.st_size;
+  return Parse(path, entry, entry.map, entry.mapSize);
+#else
+  if (!CFile::Exists(file))
+    return false;
+
+  auto_buffer buffer;
+  if (CFile().LoadFile(file, buffer) <= 0)
+    return false;
+
+  entry.buffer.assign(buffer.get(), buffer.size());
+  return Parse(path, entry, (const uint8_t *)entry.buffer.data(), entry.buffer.size());
+#endif
+}
+
+bool CGUISkinCache::Parse(const std::string &path, Entry &entry, const uint8_t *data, size_t size)
+{
+  CCacheReader reader(data, size);
+  const uint8_t *magic = reader.Bytes(4);
+  if (!magic || memcmp(magic, SKIN_CACHE_MAGIC, 4) != 0 || reader.U32() != SKIN_CACHE_FORMAT ||
+      reader.String() != g_SkinInfo->ID() ||
+      reader.String() != g_SkinInfo->Version().asString() ||
+      reader.String() != path)
+    return false;
+
+  uint32_t count = reader.U32();
+  for (uint32_t i = 0; i < count && reader.Ok(); i++)
+  {
+    Source source;
+    source.path = reader.String();
+    source.time = reader.I64();
+    source.size = reader.I64();
+
+    Source current;
+    if (!reader.Ok() || !GetSource(source.path, current) || !(current == source))
+    {
+      CLog::Log(LOGDEBUG, "%s - %s changed, skin cache for %s is outdated", __FUNCTION__, source.path.c_str(), path.c_str());
+      return false;
+    }
+    entry.sources.push_back(source);
+  }
+
+  count = reader.U32();
+  for (uint32_t i = 0; i < count && reader.Ok(); i++)
+  {
+    Variant variant;
+    uint32_t conditions = reader.U32();
+    for (uint32_t j = 0; j < conditions && reader.Ok(); j++)
+    {
+      std::string expression = reader.String();
+      bool value = reader.U8() != 0;
+      INFO::InfoPtr condition = g_infoManager.Register(expression);
+      if (!condition)
+        return false;
+      variant.conditions.push_back(std::make_pair(condition, value));
+    }
+    variant.size = reader.U32();
+    variant.data = reader.Bytes(variant.size);
+    if (!variant.data)
+      return false;
+    entry.variants.push_back(variant);
+  }
+  return reader.Ok();
+}
+
+void CGUISkinCache::Write(const std::string &path, const Entry &entry)
+{
+  std::string data;
+  CCacheWriter writer(data);
+  data.append(SKIN_CACHE_MAGIC, 4);
+  writer.U32(SKIN_CACHE_FORMAT);
+  writer.String(g_SkinInfo->ID());
+  writer.String(g_SkinInfo->Version().asString());
+  writer.String(path);
+
+  writer.U32(entry.sources.size());
+  for (std::vector<Source>::const_iterator it = entry.sources.begin(); it != entry.sources.end(); ++it)
+  {
+    writer.String(it->path);
+    writer.I64(it->time);
+    writer.I64(it->size);
+  }
+
+  writer.U32(entry.variants.size());
+  for (std::vector<Variant>::const_iterator it = entry.variants.begin(); it != entry.variants.end(); ++it)
+  {
+    writer.U32(it->conditions.size());
+    for (std::vector<std::pair<INFO::InfoPtr, bool> >::const_iterator condition = it->conditions.begin(); condition != it->conditions.end(); ++condition)
+    {
+      writer.String(condition->first->GetExpression());
+      writer.U8(condition->second ? 1 : 0);
+    }
+    writer.U32(it->size);
+    data.append((const char *)it->Data(), it->size);
+  }
+
+  // written aside and renamed, a mapping of the old file stays intact
+  CDirectory::Create(SKIN_CACHE_PATH);
+  if (!CFile::WriteAtomically(GetCacheFile(path), data.data(), data.size()))
+    CLog::Log(LOGERROR, "%s - unable to write skin cache for %s", __FUNCTION__, path.c_str());
+}
+
+std::string CGUISkinCache::GetCacheFile(const std::string &path)
+{
+  return StringUtils::Format(SKIN_CACHE_PATH "%08x.bin", (uint32_t)Crc32::Compute(path));
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2017 Team MrMC
+ *      https://github.com/MrMC
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MrMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "interfaces/info/InfoBool.h"
+#include "threads/CriticalSection.h"
+
+class TiXmlElement;
+class TiXmlNode;
+
+/*!
+ \brief Compiled copies of skin windows with their includes resolved.
+
+ Resolving includes, constants and parameters of a window only depends on
+ the skin's XML files and on the values of the include conditions met on
+ the way. The resolved tree is kept in a compact binary form, together
+ with those conditions, in special://temp/skincache/. The files are mapped
+ and checked against the skin version and the size and date of every XML
+ file they were made from, after which a window can be rebuilt from them
+ without parsing its file or resolving anything again. A window keeps a
+ few variants for different condition values.
+ */
+class CGUISkinCache
+{
+public:
+  static CGUISkinCache& GetInstance();
+
+  /*!
+   \brief Forget everything loaded for the previous skin, called when a skin is (re)loaded
+   */
+  void Clear();
+
+  /*!
+   \brief Get the resolved window in the given file, if we have a copy made
+   under the current include condition values.
+   \param path skin XML file of the window
+   \param conditions [out] the include conditions the copy depends on
+   \return the root element, owned by the caller, NULL if there is no valid copy
+   */
+  TiXmlElement* Get(const std::string &path, std::map<INFO::InfoPtr, bool> &conditions);
+
+  /*!
+   \brief Keep a copy of a window just resolved from the given file
+   \param path skin XML file of the window
+   \param root the resolved root element
+   \param conditions the include conditions met while resolving it
+   */
+  void Store(const std::string &path, const TiXmlElement *root, const std::map<INFO::InfoPtr, bool> &conditions);
+
+private:
+  CGUISkinCache();
+  ~CGUISkinCache();
+  CGUISkinCache(const CGUISkinCache&);
+  CGUISkinCache& operator=(const CGUISkinCache&);
+
+  struct Source
+  {
+    std::string path;
+    int64_t     time;
+    int64_t     size;
+    bool operator==(const Source &rhs) const;
+  };
+
+  struct Variant
+  {
+    std::vector<std::pair<INFO::InfoPtr, bool> > conditions;
+    const uint8_t *data;   ///< serialized tree inside the entry's file mapping, or
+    std::string    owned;  ///< the serialized tree of a variant added since
+    size_t         size;
+    const uint8_t* Data() const { return data ? data : (const uint8_t *)owned.data(); }
+  };
+
+  struct Entry
+  {
+    Entry();
+    ~Entry();
+    std::vector<Source>  sources;
+    std::vector<Variant> variants;
+    uint8_t             *map;
+    size_t               mapSize;
+    std::string          buffer;   ///< file contents, where it can't be mapped
+  };
+
+  bool GetSource(const std::string &path, Source &source);
+  bool GetSources(const std::string &path, std::vector<Source> &sources);
+  bool Open(const std::string &path, Entry &entry);
+  bool Parse(const std::string &path, Entry &entry, const uint8_t *data, size_t size);
+  void Write(const std::string &path, const Entry &entry);
+  static std::string GetCacheFile(const std::string &path);
+
+  CCriticalSection m_section;
+  std::map<std::string, std::unique_ptr<Entry> > m_entries;
+  std::map<std::string, Source> m_sources;   ///< stat results, skin files don't change while in use
+};
@@ -29,18 +29,11 @@
  */
 
 #include "GUITexture.h"
+#include "GUIQuadBatchGLES.h"
 
 #include "system_gl.h"
 #include <vector>
 
-struct PackedVertex
-{
-  float x, y, z;
-  float u1, v1;
-  float u2, v2;
-};
-typedef std::vector<PackedVertex> PackedVertices;
-
 class CGUITextureGLES : public CGUITextureBase
 {
 public:
@@ -53,8 +46,8 @@ protected:
 
   GLubyte m_col[4];
 
+  CGUIQuadBatchGLES::State m_state;
   PackedVertices m_packedVertices;
-  std::vector<GLushort> m_idx;
 };
 
 #endif
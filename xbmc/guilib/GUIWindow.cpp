@@ -25,6 +25,7 @@
 #include "GUIControlFactory.h"
 #include "GUIControlGroup.h"
 #include "GUIControlProfiler.h"
+#include "GUISkinCache.h"
 
 #include "addons/Skin.h"
 #include "GUIInfoManager.h"
@@ -127,6 +128,14 @@ bool CGUIWindow::Load(const std::string& strFileName, bool bContainsPath)
 
 bool CGUIWindow::LoadXML(const std::string &strPath, const std::string &strLowerPath)
 {
+  // a compiled copy of the resolved window saves parsing the file and resolving its includes
+  TiXmlElement *pRootElement = CGUISkinCache::GetInstance().Get(strPath, m_xmlIncludeConditions);
+  if (pRootElement)
+  {
+    CLog::Log(LOGDEBUG, "Using compiled skin cache for %s", strPath.c_str());
+    return LoadResolved(pRootElement);
+  }
+
   // load window xml if we don't have it stored yet
   if (!m_windowXMLRootElement)
   {
@@ -144,30 +153,49 @@ bool CGUIWindow::LoadXML(const std::string &strPath, const std::string &strLower
   else
     CLog::Log(LOGDEBUG, "Using already stored xml root node for %s", strPath.c_str());
 
-  return Load(m_windowXMLRootElement);
+  pRootElement = ResolveXML(m_windowXMLRootElement);
+  if (!pRootElement)
+    return false;
+
+  CGUISkinCache::GetInstance().Store(strPath, pRootElement, m_xmlIncludeConditions);
+  return LoadResolved(pRootElement);
 }
 
 bool CGUIWindow::Load(TiXmlElement* pRootElement)
 {
+  pRootElement = ResolveXML(pRootElement);
   if (!pRootElement)
     return false;
+
+  return LoadResolved(pRootElement);
+}
+
+TiXmlElement* CGUIWindow::ResolveXML(const TiXmlElement* pRootElement)
+{
+  if (!pRootElement)
+    return NULL;
   
   if (strcmpi(pRootElement->Value(), "window"))
   {
     CLog::Log(LOGERROR, "file : XML file doesnt contain <window>");
-    return false;
+    return NULL;
   }
 
   // we must create copy of root element as we will manipulate it when resolving includes
   // and we don't want original root element to change
-  pRootElement = (TiXmlElement*)pRootElement->Clone();
+  TiXmlElement *pResolved = (TiXmlElement*)pRootElement->Clone();
+
+  // Resolve any includes that may be present and save conditions used to do it
+  g_SkinInfo->ResolveIncludes(pResolved, &m_xmlIncludeConditions);
+  return pResolved;
+}
 
+bool CGUIWindow::LoadResolved(TiXmlElement* pRootElement)
+{
   // set the scaling resolution so that any control creation or initialisation can
   // be done with respect to the correct aspect ratio
   g_graphicsContext.SetScalingResolution(m_coordsRes, m_needsScaling);
 
-  // Resolve any includes that may be present and save conditions used to do it
-  g_SkinInfo->ResolveIncludes(pRootElement, &m_xmlIncludeConditions);
   // now load in the skin file
   SetDefaults();
 
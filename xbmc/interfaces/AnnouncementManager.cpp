@@ -19,8 +19,15 @@
  */
 
 #include "AnnouncementManager.h"
+#include "threads/Event.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+#include <deque>
+#include <memory>
 #include <stdio.h>
+#include <string.h>
+#include "linux/PlatformDefs.h" //for PRIu64
 #include "utils/log.h"
 #include "utils/Variant.h"
 #include "utils/StringUtils.h"
@@ -32,9 +39,170 @@
 #include "PlayListPlayer.h"
 
 #define LOOKUP_PROPERTY "database-lookup"
+// announcements a queued listener may fall behind before the oldest are dropped
+#define ANNOUNCEMENT_QUEUE_SIZE 256
+// a listener taking longer than this to catch up is reported in the log
+#define ANNOUNCEMENT_LAG_WARNING 1000
 
 using namespace ANNOUNCEMENT;
 
+namespace ANNOUNCEMENT
+{
+  /*!
+   \brief An announcement as handed to queued listeners, one copy is shared by all of them
+   */
+  struct CAnnouncement
+  {
+    AnnouncementFlag flag;
+    std::string      sender;
+    std::string      message;
+    CVariant         data;
+  };
+  typedef std::shared_ptr<const CAnnouncement> AnnouncementPtr;
+
+  /*!
+   \brief Delivers announcements to a single listener from a thread of its own
+   */
+  class CAnnouncementQueue : public CThread
+  {
+  public:
+    CAnnouncementQueue(IAnnouncer *announcer);
+    virtual ~CAnnouncementQueue();
+
+    IAnnouncer* GetAnnouncer() const { return m_announcer; }
+    void Push(const AnnouncementPtr &announcement);
+    void GetStats(AnnouncerStats &stats);
+
+  protected:
+    virtual void Process();
+
+  private:
+    struct Entry
+    {
+      AnnouncementPtr announcement;
+      unsigned int    time;  /**< when the first of the announcements coalesced into this one was queued */
+    };
+
+    static bool IsCoalescable(const CAnnouncement &announcement);
+
+    IAnnouncer       *m_announcer;
+    CCriticalSection  m_critSection;
+    CEvent            m_queued;
+    std::deque<Entry> m_entries;
+    AnnouncerStats    m_stats;
+    bool              m_lagging;
+  };
+}
+
+CAnnouncementQueue::CAnnouncementQueue(IAnnouncer *announcer)
+ : CThread("AnnouncementQueue")
+ , m_announcer(announcer)
+ , m_lagging(false)
+{
+  memset(&m_stats, 0, sizeof(m_stats));
+  m_stats.announcer = announcer;
+}
+
+CAnnouncementQueue::~CAnnouncementQueue()
+{
+  StopThread();
+}
+
+bool CAnnouncementQueue::IsCoalescable(const CAnnouncement &announcement)
+{
+  // only announcements carrying the complete new state, an older one adds nothing
+  static const struct { AnnouncementFlag flag; const char *message; } coalescable[] = {
+    { Player,      "OnSeek" },
+    { Player,      "OnSpeedChanged" },
+    { Application, "OnVolumeChanged" },
+  };
+
+  for (size_t i = 0; i < sizeof(coalescable) / sizeof(coalescable[0]); i++)
+  {
+    if (announcement.flag == coalescable[i].flag && announcement.message == coalescable[i].message)
+      return true;
+  }
+  return false;
+}
+
+void CAnnouncementQueue::Push(const AnnouncementPtr &announcement)
+{
+  CSingleLock lock(m_critSection);
+
+  Entry entry = { announcement, XbmcThreads::SystemClockMillis() };
+
+  // drop the pending one and queue the newer at the end, so it still
+  // follows whatever was announced in between
+  if (IsCoalescable(*announcement))
+  {
+    for (std::deque<Entry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+      const CAnnouncement &pending = *it->announcement;
+      if (pending.flag == announcement->flag && pending.message == announcement->message &&
+          pending.sender == announcement->sender)
+      {
+        entry.time = it->time;
+        m_entries.erase(it);
+        m_stats.coalesced++;
+        break;
+      }
+    }
+  }
+
+  if (m_entries.size() >= ANNOUNCEMENT_QUEUE_SIZE)
+  {
+    if (m_stats.dropped++ == 0)
+      CLog::Log(LOGWARNING, "CAnnouncementQueue: listener %p doesn't keep up, dropping announcements", (void*)m_announcer);
+    m_entries.pop_front();
+  }
+
+  m_entries.push_back(entry);
+  m_stats.queued = m_entries.size();
+  m_queued.Set();
+}
+
+void CAnnouncementQueue::GetStats(AnnouncerStats &stats)
+{
+  CSingleLock lock(m_critSection);
+  stats = m_stats;
+}
+
+void CAnnouncementQueue::Process()
+{
+  while (!m_bStop)
+  {
+    Entry entry;
+    {
+      CSingleLock lock(m_critSection);
+      if (m_entries.empty())
+      {
+        lock.Leave();
+        AbortableWait(m_queued);
+        continue;
+      }
+      entry = m_entries.front();
+      m_entries.pop_front();
+    }
+
+    const CAnnouncement &announcement = *entry.announcement;
+    m_announcer->Announce(announcement.flag, announcement.sender.c_str(), announcement.message.c_str(), announcement.data);
+
+    unsigned int lag = XbmcThreads::SystemClockMillis() - entry.time;
+
+    CSingleLock lock(m_critSection);
+    m_stats.queued = m_entries.size();
+    m_stats.delivered++;
+    m_stats.lastLag = lag;
+    if (lag > m_stats.maxLag)
+      m_stats.maxLag = lag;
+
+    if (lag > ANNOUNCEMENT_LAG_WARNING && !m_lagging)
+      CLog::Log(LOGWARNING, "CAnnouncementQueue: listener %p is %u ms behind (%s.%s)", (void*)m_announcer, lag,
+                AnnouncementFlagToString(announcement.flag), announcement.message.c_str());
+    m_lagging = lag > ANNOUNCEMENT_LAG_WARNING;
+  }
+}
+
 CAnnouncementManager::CAnnouncementManager()
 { }
 
@@ -49,19 +217,72 @@ CAnnouncementManager& CAnnouncementManager::GetInstance()
   return s_instance;
 }
 
+/*!
+ \brief Stops and deletes queues, the lock must not be held as their listeners may announce
+ */
+static void DeleteQueues(std::vector<CAnnouncementQueue *> &queues, std::vector<CAnnouncementQueue *> &retired)
+{
+  for (std::vector<CAnnouncementQueue *>::iterator it = queues.begin(); it != queues.end(); ++it)
+  {
+    // a listener removing itself can't wait for its own thread
+    if ((*it)->IsCurrentThread())
+    {
+      (*it)->StopThread(false);
+      retired.push_back(*it);
+      continue;
+    }
+    delete *it;
+  }
+}
+
+void CAnnouncementManager::ReapQueues()
+{
+  std::vector<CAnnouncementQueue *> queues, retired;
+  {
+    CSingleLock lock (m_critSection);
+    queues.swap(m_retired);
+  }
+  DeleteQueues(queues, retired);
+
+  if (!retired.empty())
+  {
+    CSingleLock lock (m_critSection);
+    m_retired.insert(m_retired.end(), retired.begin(), retired.end());
+  }
+}
+
 void CAnnouncementManager::Deinitialize()
 {
+  std::vector<CAnnouncementQueue *> queues, retired;
+  {
+    CSingleLock lock (m_critSection);
+    m_announcers.clear();
+    queues.swap(m_queues);
+    queues.insert(queues.end(), m_retired.begin(), m_retired.end());
+    m_retired.clear();
+  }
+  DeleteQueues(queues, retired);
+
   CSingleLock lock (m_critSection);
-  m_announcers.clear();
+  m_retired.insert(m_retired.end(), retired.begin(), retired.end());
 }
 
-void CAnnouncementManager::AddAnnouncer(IAnnouncer *listener)
+void CAnnouncementManager::AddAnnouncer(IAnnouncer *listener, bool queued /* = false */)
 {
   if (!listener)
     return;
 
+  ReapQueues();
+
   CSingleLock lock (m_critSection);
-  m_announcers.push_back(listener);
+  if (queued)
+  {
+    CAnnouncementQueue *queue = new CAnnouncementQueue(listener);
+    queue->Create();
+    m_queues.push_back(queue);
+  }
+  else
+    m_announcers.push_back(listener);
 }
 
 void CAnnouncementManager::RemoveAnnouncer(IAnnouncer *listener)
@@ -69,15 +290,52 @@ void CAnnouncementManager::RemoveAnnouncer(IAnnouncer *listener)
   if (!listener)
     return;
 
-  CSingleLock lock (m_critSection);
-  for (unsigned int i = 0; i < m_announcers.size(); i++)
+  std::vector<CAnnouncementQueue *> queues, retired;
   {
-    if (m_announcers[i] == listener)
+    CSingleLock lock (m_critSection);
+    for (unsigned int i = 0; i < m_announcers.size(); i++)
+    {
+      if (m_announcers[i] == listener)
+      {
+        m_announcers.erase(m_announcers.begin() + i);
+        return;
+      }
+    }
+
+    for (unsigned int i = 0; i < m_queues.size(); i++)
     {
-      m_announcers.erase(m_announcers.begin() + i);
-      return;
+      if (m_queues[i]->GetAnnouncer() == listener)
+      {
+        queues.push_back(m_queues[i]);
+        m_queues.erase(m_queues.begin() + i);
+        break;
+      }
     }
   }
+
+  for (unsigned int i = 0; i < queues.size(); i++)
+  {
+    AnnouncerStats stats;
+    queues[i]->GetStats(stats);
+    CLog::Log(LOGDEBUG, "%s - listener %p: %" PRIu64" delivered, %" PRIu64" coalesced, %" PRIu64" dropped, max lag %u ms",
+              __FUNCTION__, (void*)listener, stats.delivered, stats.coalesced, stats.dropped, stats.maxLag);
+  }
+
+  // waits for an announcement being delivered right now
+  DeleteQueues(queues, retired);
+  if (!retired.empty())
+  {
+    CSingleLock lock (m_critSection);
+    m_retired.insert(m_retired.end(), retired.begin(), retired.end());
+  }
+}
+
+void CAnnouncementManager::GetStats(std::vector<AnnouncerStats> &stats)
+{
+  CSingleLock lock (m_critSection);
+  stats.resize(m_queues.size());
+  for (unsigned int i = 0; i < m_queues.size(); i++)
+    m_queues[i]->GetStats(stats[i]);
 }
 
 void CAnnouncementManager::Announce(AnnouncementFlag flag, const char *sender, const char *message)
@@ -90,6 +348,18 @@ void CAnnouncementManager::Announce(AnnouncementFlag flag, const char *sender, c
 {
   CSingleLock lock (m_critSection);
 
+  // queued listeners share a single copy of the data
+  if (!m_queues.empty())
+  {
+    std::shared_ptr<CAnnouncement> announcement(new CAnnouncement);
+    announcement->flag = flag;
+    announcement->sender = sender ? sender : "";
+    announcement->message = message ? message : "";
+    announcement->data = data;
+    for (unsigned int i = 0; i < m_queues.size(); i++)
+      m_queues[i]->Push(announcement);
+  }
+
   // Make a copy of announers. They may be removed or even remove themselves during execution of IAnnouncer::Announce()!
   std::vector<IAnnouncer *> announcers(m_announcers); 
   for (unsigned int i = 0; i < announcers.size(); i++)
@@ -18,6 +18,7 @@
  *  <http://www.gnu.org/licenses/>.
  *
  */
+#include <stdint.h>
 #include <vector>
 
 #include "IAnnouncer.h"
@@ -29,6 +30,19 @@ class CVariant;
 
 namespace ANNOUNCEMENT
 {
+  class CAnnouncementQueue;
+
+  struct AnnouncerStats
+  {
+    IAnnouncer   *announcer;
+    unsigned int  queued;     /**< announcements waiting for delivery */
+    uint64_t      delivered;
+    uint64_t      coalesced;  /**< replaced by a newer one before delivery */
+    uint64_t      dropped;    /**< discarded because the queue was full */
+    unsigned int  lastLag;    /**< ms from Announce() until the listener returned */
+    unsigned int  maxLag;
+  };
+
   class CAnnouncementManager
   {
   public:
@@ -38,9 +52,24 @@ namespace ANNOUNCEMENT
 
     void Deinitialize();
 
-    void AddAnnouncer(IAnnouncer *listener);
+    /*!
+     \brief Registers a listener
+     \param queued If true, announcements are handed to the listener by a thread
+     of its own, so a slow listener delays neither the announcing thread nor
+     the other listeners. Bursts of seek, speed and volume changes are
+     coalesced for queued listeners, only the latest one is delivered.
+     */
+    void AddAnnouncer(IAnnouncer *listener, bool queued = false);
+    /*!
+     \brief Unregisters a listener, no announcement is delivered to it after this returns
+     */
     void RemoveAnnouncer(IAnnouncer *listener);
 
+    /*!
+     \brief Fills stats with the delivery counters of all queued listeners
+     */
+    void GetStats(std::vector<AnnouncerStats> &stats);
+
     void Announce(AnnouncementFlag flag, const char *sender, const char *message);
     void Announce(AnnouncementFlag flag, const char *sender, const char *message, CVariant &data);
     void Announce(AnnouncementFlag flag, const char *sender, const char *message, CFileItemPtr item);
@@ -50,7 +79,11 @@ namespace ANNOUNCEMENT
     CAnnouncementManager(const CAnnouncementManager&);
     CAnnouncementManager const& operator=(CAnnouncementManager const&);
 
+    void ReapQueues();
+
     CCriticalSection m_critSection;
     std::vector<IAnnouncer *> m_announcers;
+    std::vector<CAnnouncementQueue *> m_queues;
+    std::vector<CAnnouncementQueue *> m_retired; /**< removed from their own thread, deleted later */
   };
 }
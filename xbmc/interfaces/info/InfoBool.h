@@ -27,6 +27,24 @@ class CGUIListItem;
 
 namespace INFO
 {
+/*!
+ \ingroup info
+ \brief Sources of information a condition is computed from.
+ A bool is only re-evaluated when one of its sources announced a change,
+ see CGUIInfoManager::InvalidateBools().
+ */
+enum InfoSource
+{
+  INFO_SOURCE_NONE          = 0,        ///< constant, evaluated once
+  INFO_SOURCE_FRAME         = 1 << 0,   ///< anything without change notifications, evaluated every frame
+  INFO_SOURCE_PLAYER        = 1 << 1,   ///< playing state and speed of the player
+  INFO_SOURCE_SETTINGS      = 1 << 2,   ///< CSettings
+  INFO_SOURCE_SKIN_SETTINGS = 1 << 3,   ///< skin bools and strings
+  INFO_SOURCE_LIBRARY       = 1 << 4,   ///< content of the libraries
+  INFO_SOURCE_TIME          = 1 << 5,   ///< date and time, in minutes
+  INFO_SOURCE_ALL           = 0xffffffff
+};
+
 /*!
  \ingroup info
  \brief Base class, wrapping boolean conditions and expressions
@@ -51,11 +69,15 @@ public:
   inline bool Get(const CGUIListItem *item = NULL)
   {
     if (item && m_listItemDependent)
+    {
       Update(item);
+      m_evaluations++;
+    }
     else if (m_dirty)
     {
       Update(NULL);
       m_dirty = false;
+      m_evaluations++;
     }
     return m_value;
   }
@@ -73,15 +95,31 @@ public:
 
   const std::string &GetExpression() const { return m_expression; }
   bool ListItemDependent() const { return m_listItemDependent; }
+
+  /*! \brief Get the sources this info bool depends on
+   \return a combination of InfoSource flags
+   */
+  unsigned int GetSources() const { return m_sources; }
+
+  /*! \brief Get the number of evaluations since the last call, for profiling
+   */
+  unsigned int TakeEvaluations()
+  {
+    unsigned int evaluations = m_evaluations;
+    m_evaluations = 0;
+    return evaluations;
+  }
 protected:
 
   bool m_value;                ///< current value
   int m_context;               ///< contextual information to go with the condition
   bool m_listItemDependent;    ///< do not cache if a listitem pointer is given
+  unsigned int m_sources;      ///< InfoSource flags, when to re-evaluate
 
 private:
   std::string  m_expression;   ///< original expression
   bool         m_dirty;        ///< whether we need an update
+  unsigned int m_evaluations;  ///< number of updates since TakeEvaluations()
 };
 
 typedef std::shared_ptr<InfoBool> InfoPtr;
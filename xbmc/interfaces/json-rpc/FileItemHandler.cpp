@@ -19,6 +19,7 @@
  */
 
 #include <map>
+#include <memory>
 #include <string.h>
 
 #include "FileItemHandler.h"
@@ -250,6 +251,70 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
   delete thumbLoader;
 }
 
+void CFileItemHandler::StreamFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit /* = true */)
+{
+  if (resultname == NULL || !CJSONRPC::CanDeferResult(result))
+  {
+    HandleFileItemList(ID, allowFile, resultname, items, parameterObject, result, size, sortLimit);
+    return;
+  }
+
+  int start, end;
+  HandleLimits(parameterObject, result, size, start, end);
+
+  if (sortLimit)
+    Sort(items, parameterObject);
+  else
+  {
+    start = 0;
+    end = items.Size();
+  }
+
+  if (end - start <= 0)
+    return;
+
+  // everything is copied, the writer runs after the method returned
+  std::shared_ptr<CFileItemList> list(new CFileItemList);
+  for (int i = start; i < end; i++)
+    list->Add(items.Get(i));
+
+  std::set<std::string> fields;
+  if (parameterObject.isMember("properties") && parameterObject["properties"].isArray())
+  {
+    for (CVariant::const_iterator_array field = parameterObject["properties"].begin_array(); field != parameterObject["properties"].end_array(); field++)
+      fields.insert(field->asString());
+  }
+
+  bool hasID = ID != NULL;
+  std::string id = hasID ? ID : "";
+  std::string name = resultname;
+  CVariant parameters = parameterObject;
+
+  CJSONRPC::DeferResult(name, [list, fields, hasID, id, allowFile, name, parameters](CJSONVariantStreamWriter &writer)
+  {
+    CThumbLoader *thumbLoader = NULL;
+    if (list->Get(0)->HasVideoInfoTag())
+      thumbLoader = new CVideoThumbLoader();
+    else if (list->Get(0)->HasMusicInfoTag())
+      thumbLoader = new CMusicThumbLoader();
+
+    if (thumbLoader != NULL)
+      thumbLoader->OnLoaderStart();
+
+    bool ok = writer.StartArray();
+    for (int i = 0; ok && i < list->Size(); i++)
+    {
+      CVariant object;
+      HandleFileItem(hasID ? id.c_str() : NULL, allowFile, name.c_str(), list->Get(i), parameters, fields, object, false, thumbLoader);
+      ok = writer.Write(object[name]);
+    }
+
+    delete thumbLoader;
+
+    return ok && writer.EndArray();
+  });
+}
+
 void CFileItemHandler::HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const CVariant &validFields, CVariant &result, bool append /* = true */, CThumbLoader *thumbLoader /* = NULL */)
 {
   std::set<std::string> fields;
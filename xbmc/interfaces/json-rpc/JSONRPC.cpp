@@ -29,6 +29,7 @@
 #include "interfaces/AnnouncementManager.h"
 #include "playlists/SmartPlayList.h"
 #include "settings/AdvancedSettings.h"
+#include "threads/ThreadLocal.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
@@ -233,14 +234,39 @@ JSONRPC_STATUS CJSONRPC::NotifyAll(const std::string &method, ITransportLayer *t
   return ACK;
 }
 
+namespace
+{
+  // the method being called on this thread, for deferring its results
+  struct CallContext
+  {
+    const CVariant *result;
+    std::map<std::string, CJSONRPC::ResultWriter> *deferred;
+  };
+
+  XbmcThreads::ThreadLocal<CallContext> callContext;
+}
+
 std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client)
 {
-  CVariant inputroot, outputroot, result;
-  bool hasResponse = false;
+  std::string str;
+  MethodCall(inputString, transport, client, [&str](const char *data, size_t size)
+  {
+    str.append(data, size);
+    return true;
+  });
+
+  return str;
+}
+
+bool CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client, const CJSONVariantStreamWriter::Output &output)
+{
+  CVariant inputroot, outputroot;
 
   if(g_advancedSettings.CanLogComponent(LOGJSONRPC))
     CLog::Log(LOGDEBUG, "JSONRPC: Incoming request: %s", inputString.c_str());
 
+  CJSONVariantStreamWriter writer(output, g_advancedSettings.m_jsonOutputCompact);
+
   if (CJSONVariantParser::Parse(inputString, inputroot) && !inputroot.isNull())
   {
     if (inputroot.isArray())
@@ -249,39 +275,112 @@ std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer
       {
         CLog::Log(LOGERROR, "JSONRPC: Empty batch call\n");
         BuildResponse(inputroot, InvalidRequest, CVariant(), outputroot);
-        hasResponse = true;
+        writer.Write(outputroot);
+        return true;
       }
-      else
+
+      // responses are written as soon as they are ready, the array is only
+      // opened once there is one so notifications alone write nothing
+      bool hasResponse = false;
+      for (CVariant::const_iterator_array itr = inputroot.begin_array(); itr != inputroot.end_array(); itr++)
       {
-        for (CVariant::const_iterator_array itr = inputroot.begin_array(); itr != inputroot.end_array(); itr++)
+        CVariant response;
+        DeferredResults deferred;
+        if (HandleMethodCall(*itr, response, transport, client, deferred))
         {
-          CVariant response;
-          if (HandleMethodCall(*itr, response, transport, client))
-          {
-            outputroot.append(response);
-            hasResponse = true;
-          }
+          if (!hasResponse && !writer.StartArray())
+            return true;
+          hasResponse = true;
+
+          if (!WriteResponse(writer, response, deferred))
+            return true;
         }
       }
+
+      if (hasResponse)
+        writer.EndArray();
+      return hasResponse;
     }
-    else
-      hasResponse = HandleMethodCall(inputroot, outputroot, transport, client);
+
+    DeferredResults deferred;
+    if (!HandleMethodCall(inputroot, outputroot, transport, client, deferred))
+      return false;
+
+    WriteResponse(writer, outputroot, deferred);
+    return true;
   }
-  else
+
+  CLog::Log(LOGERROR, "JSONRPC: Failed to parse '%s'\n", inputString.c_str());
+  BuildResponse(inputroot, ParseError, CVariant(), outputroot);
+  writer.Write(outputroot);
+  return true;
+}
+
+bool CJSONRPC::CanDeferResult(const CVariant &result)
+{
+  CallContext *context = callContext.get();
+  return context != NULL && context->result == &result;
+}
+
+void CJSONRPC::DeferResult(const std::string &key, const ResultWriter &writer)
+{
+  CallContext *context = callContext.get();
+  if (context != NULL)
+    (*context->deferred)[key] = writer;
+}
+
+bool CJSONRPC::WriteResponse(CJSONVariantStreamWriter &writer, const CVariant& response, const DeferredResults &deferred)
+{
+  const CVariant &result = response["result"];
+  if (deferred.empty() || !(result.isObject() || result.isNull()))
+    return writer.Write(response);
+
+  // members are written in the same (sorted) order as CVariant would, the
+  // deferred ones merged into the result, so the output doesn't change
+  if (!writer.StartObject())
+    return false;
+
+  for (CVariant::const_iterator_map member = response.begin_map(); member != response.end_map(); ++member)
   {
-    CLog::Log(LOGERROR, "JSONRPC: Failed to parse '%s'\n", inputString.c_str());
-    BuildResponse(inputroot, ParseError, CVariant(), outputroot);
-    hasResponse = true;
-  }
+    if (!writer.Key(member->first))
+      return false;
 
-  std::string str;
-  if (hasResponse)
-    CJSONVariantWriter::Write(outputroot, str, g_advancedSettings.m_jsonOutputCompact);
+    if (member->first != "result")
+    {
+      if (!writer.Write(member->second))
+        return false;
+      continue;
+    }
 
-  return str;
+    if (!writer.StartObject())
+      return false;
+
+    CVariant::const_iterator_map value = result.begin_map();
+    DeferredResults::const_iterator def = deferred.begin();
+    while (value != result.end_map() || def != deferred.end())
+    {
+      if (def != deferred.end() && (value == result.end_map() || def->first < value->first))
+      {
+        if (!writer.Key(def->first) || !def->second(writer))
+          return false;
+        ++def;
+      }
+      else
+      {
+        if (!writer.Key(value->first) || !writer.Write(value->second))
+          return false;
+        ++value;
+      }
+    }
+
+    if (!writer.EndObject())
+      return false;
+  }
+
+  return writer.EndObject();
 }
 
-bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client)
+bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client, DeferredResults &deferred)
 {
   JSONRPC_STATUS errorCode = OK;
   CVariant result;
@@ -298,7 +397,17 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
     CVariant params;
 
     if ((errorCode = CJSONServiceDescription::CheckCall(methodName.c_str(), request["params"], transport, client, isNotification, method, params)) == OK)
+    {
+      CallContext *previous = callContext.get();
+      CallContext context = { &result, &deferred };
+      callContext.set(&context);
       errorCode = method(methodName, transport, client, params, result);
+      callContext.set(previous);
+
+      // nothing to write them into
+      if (errorCode != OK || isNotification)
+        deferred.clear();
+    }
     else
       result = params;
   }
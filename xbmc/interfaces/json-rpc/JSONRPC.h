@@ -19,6 +19,7 @@
  *
  */
 
+#include <functional>
 #include <iostream>
 #include <map>
 #include <stdio.h>
@@ -26,6 +27,7 @@
 
 #include "JSONRPCUtils.h"
 #include "JSONServiceDescription.h"
+#include "utils/JSONVariantWriter.h"
 
 class CVariant;
 
@@ -64,6 +66,37 @@ namespace JSONRPC
      */
     static std::string MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client);
 
+    /*
+     \brief Handles an incoming JSON-RPC request, streaming the response
+     \param inputString received JSON-RPC request
+     \param transport Transport protocol on which the request arrived
+     \param client Client which sent the request
+     \param output Receives the JSON-RPC response in chunks
+     \return true if there was a response
+
+     Same as MethodCall() above but results deferred by the called method
+     (see DeferResult()) are serialized straight into the output.
+     */
+    static bool MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client, const CJSONVariantStreamWriter::Output &output);
+
+    typedef std::function<bool(CJSONVariantStreamWriter &writer)> ResultWriter;
+
+    /*
+     \brief Whether the given result object is the one of the method being
+     called, i.e. whether members of it can be deferred
+     */
+    static bool CanDeferResult(const CVariant &result);
+
+    /*
+     \brief Defers the member key of the result of the method being called
+     \param key Name of the member in the result object
+     \param writer Writes the value of the member once the response is sent
+
+     The writer is called on the calling thread after the method returned,
+     so it must not reference anything living on the stack of the method.
+     */
+    static void DeferResult(const std::string &key, const ResultWriter &writer);
+
     static JSONRPC_STATUS Introspect(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Version(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Permission(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
@@ -74,7 +107,10 @@ namespace JSONRPC
   
   private:
     static void setup();
-    static bool HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client);
+    typedef std::map<std::string, ResultWriter> DeferredResults;
+
+    static bool HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client, DeferredResults &deferred);
+    static bool WriteResponse(CJSONVariantStreamWriter &writer, const CVariant& response, const DeferredResults &deferred);
     static inline bool IsProperJSONRPC(const CVariant& inputroot);
 
     inline static void BuildResponse(const CVariant& request, JSONRPC_STATUS code, const CVariant& result, CVariant& response);
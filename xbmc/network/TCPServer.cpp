@@ -22,8 +22,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#if defined(TARGET_LINUX) || defined(TARGET_ANDROID)
+#include <sys/epoll.h>
+#define HAS_EPOLL
+#else
+#include <poll.h>
+#endif
 
 #include "settings/AdvancedSettings.h"
 #include "interfaces/json-rpc/JSONRPC.h"
@@ -56,7 +66,222 @@ static const bdaddr_t bt_bdaddr_local = {{0, 0, 0, 0xff, 0xff, 0xff}};
 using namespace JSONRPC;
 using namespace ANNOUNCEMENT;
 
-#define RECEIVEBUFFER 1024
+#define RECEIVEBUFFER 16384
+// jobs executing requests at the same time
+#define JSONRPC_WORKERS 4
+// a connection isn't read from while this many of its requests are pending
+#define JSONRPC_MAX_REQUESTS 16
+// or while more output than this is pending, until it drops below low water
+#define JSONRPC_HIGH_WATER (1024 * 1024)
+#define JSONRPC_LOW_WATER (256 * 1024)
+// a connection not reading its announcements is dropped when this much is pending
+#define JSONRPC_MAX_OUTPUT (16 * 1024 * 1024)
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static bool SetNonBlocking(SOCKET fd)
+{
+  return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0;
+}
+
+/*!
+ \brief Readiness of the server's sockets, edge triggered epoll where
+ available, poll() elsewhere. Interest may be modified from any thread.
+ */
+class CTCPServer::CSocketPoller
+{
+public:
+  struct Event
+  {
+    SOCKET socket;
+    bool   readable;
+    bool   writable;
+    bool   hangup;
+  };
+
+  CSocketPoller();
+  ~CSocketPoller();
+
+  bool Add(SOCKET socket, bool read, bool write);
+  void Modify(SOCKET socket, bool read, bool write);
+  void Remove(SOCKET socket);
+  int  Wait(std::vector<Event> &events, int timeout);
+
+private:
+#if defined(HAS_EPOLL)
+  int m_epoll;
+#else
+  CCriticalSection m_critSection;
+  std::map<SOCKET, short> m_sockets;
+  int m_wake[2];
+#endif
+};
+
+#if defined(HAS_EPOLL)
+CTCPServer::CSocketPoller::CSocketPoller()
+{
+  m_epoll = epoll_create(64);
+  if (m_epoll < 0)
+    CLog::Log(LOGERROR, "JSONRPC Server: Unable to create epoll instance: %d", errno);
+}
+
+CTCPServer::CSocketPoller::~CSocketPoller()
+{
+  if (m_epoll >= 0)
+    close(m_epoll);
+}
+
+bool CTCPServer::CSocketPoller::Add(SOCKET socket, bool read, bool write)
+{
+  struct epoll_event event = {};
+  event.events = EPOLLET | (read ? EPOLLIN : 0) | (write ? EPOLLOUT : 0);
+  event.data.fd = socket;
+  return epoll_ctl(m_epoll, EPOLL_CTL_ADD, socket, &event) == 0;
+}
+
+void CTCPServer::CSocketPoller::Modify(SOCKET socket, bool read, bool write)
+{
+  // re-arming reports the socket again if it is ready, nothing gets lost
+  // when reading resumes after a pause
+  struct epoll_event event = {};
+  event.events = EPOLLET | (read ? EPOLLIN : 0) | (write ? EPOLLOUT : 0);
+  event.data.fd = socket;
+  epoll_ctl(m_epoll, EPOLL_CTL_MOD, socket, &event);
+}
+
+void CTCPServer::CSocketPoller::Remove(SOCKET socket)
+{
+  struct epoll_event event = {};
+  epoll_ctl(m_epoll, EPOLL_CTL_DEL, socket, &event);
+}
+
+int CTCPServer::CSocketPoller::Wait(std::vector<Event> &events, int timeout)
+{
+  struct epoll_event ready[64];
+  events.clear();
+
+  int res = epoll_wait(m_epoll, ready, sizeof(ready) / sizeof(ready[0]), timeout);
+  if (res < 0)
+    return errno == EINTR ? 0 : -1;
+
+  for (int i = 0; i < res; i++)
+  {
+    Event event = { ready[i].data.fd,
+                    (ready[i].events & EPOLLIN) != 0,
+                    (ready[i].events & EPOLLOUT) != 0,
+                    (ready[i].events & (EPOLLHUP | EPOLLERR)) != 0 };
+    events.push_back(event);
+  }
+  return res;
+}
+#else
+CTCPServer::CSocketPoller::CSocketPoller()
+{
+  // changes from other threads interrupt the wait through this pipe
+  if (pipe(m_wake) == 0)
+  {
+    SetNonBlocking(m_wake[0]);
+    SetNonBlocking(m_wake[1]);
+  }
+  else
+  {
+    CLog::Log(LOGERROR, "JSONRPC Server: Unable to create wake up pipe: %d", errno);
+    m_wake[0] = m_wake[1] = -1;
+  }
+}
+
+CTCPServer::CSocketPoller::~CSocketPoller()
+{
+  if (m_wake[0] >= 0)
+    close(m_wake[0]);
+  if (m_wake[1] >= 0)
+    close(m_wake[1]);
+}
+
+bool CTCPServer::CSocketPoller::Add(SOCKET socket, bool read, bool write)
+{
+  Modify(socket, read, write);
+  return true;
+}
+
+void CTCPServer::CSocketPoller::Modify(SOCKET socket, bool read, bool write)
+{
+  CSingleLock lock(m_critSection);
+  m_sockets[socket] = (read ? POLLIN : 0) | (write ? POLLOUT : 0);
+  // a full pipe means a wake up is pending anyway
+  if (m_wake[1] >= 0 && ::write(m_wake[1], "", 1) < 0 && errno != EAGAIN)
+    CLog::Log(LOGERROR, "JSONRPC Server: Unable to wake up: %d", errno);
+}
+
+void CTCPServer::CSocketPoller::Remove(SOCKET socket)
+{
+  CSingleLock lock(m_critSection);
+  m_sockets.erase(socket);
+}
+
+int CTCPServer::CSocketPoller::Wait(std::vector<Event> &events, int timeout)
+{
+  std::vector<struct pollfd> fds;
+  events.clear();
+  {
+    CSingleLock lock(m_critSection);
+    struct pollfd wake = { m_wake[0], POLLIN, 0 };
+    fds.push_back(wake);
+    for (std::map<SOCKET, short>::const_iterator it = m_sockets.begin(); it != m_sockets.end(); ++it)
+    {
+      struct pollfd fd = { it->first, it->second, 0 };
+      fds.push_back(fd);
+    }
+  }
+
+  int res = poll(&fds[0], fds.size(), timeout);
+  if (res < 0)
+    return errno == EINTR ? 0 : -1;
+
+  char buffer[64];
+  if (fds[0].revents & POLLIN)
+    while (::read(m_wake[0], buffer, sizeof(buffer)) > 0);
+
+  for (size_t i = 1; i < fds.size(); i++)
+  {
+    if (fds[i].revents == 0)
+      continue;
+    Event event = { fds[i].fd,
+                    (fds[i].revents & POLLIN) != 0,
+                    (fds[i].revents & POLLOUT) != 0,
+                    (fds[i].revents & (POLLHUP | POLLERR | POLLNVAL)) != 0 };
+    events.push_back(event);
+  }
+  return events.size();
+}
+#endif
+
+/*!
+ \brief Runs the pending requests of a connection
+ */
+class CTCPServer::CRequestJob : public CJob
+{
+public:
+  CRequestJob(CTCPServer *host, const CTCPClientPtr &client)
+   : m_host(host), m_client(client) { }
+  // also when cancelled before running, Deinitialize() waits for all of us
+  virtual ~CRequestJob() { m_host->OnJobDone(); }
+
+  virtual bool DoWork()
+  {
+    m_client->ProcessRequests(m_host);
+    return true;
+  }
+  virtual const char *GetType() const { return "jsonrpc"; }
+  // lets the queue find us when done, a connection has one job at most
+  virtual bool operator==(const CJob *job) const { return this == job; }
+
+private:
+  CTCPServer   *m_host;
+  CTCPClientPtr m_client;
+};
 
 CTCPServer *CTCPServer::ServerInstance = NULL;
 
@@ -96,123 +321,196 @@ bool CTCPServer::IsRunning()
   return ((CThread*)ServerInstance)->IsRunning();
 }
 
-CTCPServer::CTCPServer(int port, bool nonlocal) : CThread("TCPServer")
+CTCPServer::CTCPServer(int port, bool nonlocal)
+ : CThread("TCPServer")
+ , m_jobs(false, JSONRPC_WORKERS, CJob::PRIORITY_NORMAL)
+ , m_activeJobs(0)
+ , m_jobsDone(true, true)
 {
   m_port = port;
   m_nonlocal = nonlocal;
   m_sdpd = NULL;
+  m_poller = new CSocketPoller();
+}
+
+CTCPServer::~CTCPServer()
+{
+  Deinitialize();
+  delete m_poller;
 }
 
 void CTCPServer::Process()
 {
   m_bStop = false;
 
+  std::vector<CSocketPoller::Event> events;
   while (!m_bStop)
   {
-    SOCKET          max_fd = 0;
-    fd_set          rfds;
-    struct timeval  to     = {1, 0};
-    FD_ZERO(&rfds);
+    int res = m_poller->Wait(events, 1000);
+    if (res < 0)
+    {
+      CLog::Log(LOGERROR, "JSONRPC Server: Waiting for sockets failed");
+      Sleep(1000);
+      Initialize();
+      continue;
+    }
 
-    for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+    for (std::vector<CSocketPoller::Event>::const_iterator event = events.begin(); event != events.end() && !m_bStop; ++event)
     {
-      FD_SET(*it, &rfds);
-      if ((intptr_t)*it > (intptr_t)max_fd)
-        max_fd = *it;
+      if (std::find(m_servers.begin(), m_servers.end(), event->socket) != m_servers.end())
+      {
+        AcceptConnections(event->socket);
+        continue;
+      }
+
+      CTCPClientPtr client;
+      {
+        CSingleLock lock(m_critSection);
+        std::map<SOCKET, CTCPClientPtr>::iterator it = m_connections.find(event->socket);
+        if (it == m_connections.end())
+          continue;
+        client = it->second;
+      }
+
+      bool close = event->hangup;
+      if (!close && event->writable)
+        close = !client->Flush();
+      if (!close && event->readable)
+        close = !ReadConnection(client);
+
+      if (close || client->Closing() || client->IsDone())
+      {
+        CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
+        CloseConnection(event->socket, client);
+      }
     }
+  }
+
+  Deinitialize();
+}
 
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+void CTCPServer::AcceptConnections(SOCKET server)
+{
+  // edge triggered, so accept until there's nothing left
+  for (;;)
+  {
+    CTCPClientPtr newconnection(new CTCPClient());
+    newconnection->m_socket = accept(server, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
+
+    if (newconnection->m_socket == INVALID_SOCKET)
     {
-      FD_SET(m_connections[i]->m_socket, &rfds);
-      if ((intptr_t)m_connections[i]->m_socket > (intptr_t)max_fd)
-        max_fd = m_connections[i]->m_socket;
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        return;
+
+      CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", errno);
+      if (EBADF == errno)
+      {
+        Sleep(1000);
+        Initialize();
+      }
+      return;
     }
 
-    int res = select((intptr_t)max_fd+1, &rfds, NULL, NULL, &to);
-    if (res < 0)
+    CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
+    if (!SetNonBlocking(newconnection->m_socket) || !m_poller->Add(newconnection->m_socket, true, false))
     {
-      CLog::Log(LOGERROR, "JSONRPC Server: Select failed");
-      Sleep(1000);
-      Initialize();
+      CLog::Log(LOGERROR, "JSONRPC Server: Unable to watch new connection: %d", errno);
+      closesocket(newconnection->m_socket);
+      continue;
     }
-    else if (res > 0)
+    newconnection->m_poller = m_poller;
+
+    CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
+    CSingleLock lock(m_critSection);
+    m_connections[newconnection->m_socket] = newconnection;
+  }
+}
+
+bool CTCPServer::ReadConnection(CTCPClientPtr &client)
+{
+  // edge triggered, so read until the socket is drained or reading pauses,
+  // the client is notified again when the pause ends
+  while (!client->IsReadPaused())
+  {
+    char buffer[RECEIVEBUFFER];
+    int nread = recv(client->m_socket, buffer, RECEIVEBUFFER, 0);
+    if (nread < 0)
     {
-      for (int i = m_connections.size() - 1; i >= 0; i--)
-      {
-        int socket = m_connections[i]->m_socket;
-        if (FD_ISSET(socket, &rfds))
-        {
-          char buffer[RECEIVEBUFFER] = {};
-          int  nread = 0;
-          nread = recv(socket, (char*)&buffer, RECEIVEBUFFER, 0);
-          bool close = false;
-          if (nread > 0)
-          {
-            std::string response;
-            if (m_connections[i]->IsNew())
-            {
-              CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
-
-              if (response.size() > 0)
-                m_connections[i]->Send(response.c_str(), response.size());
-
-              if (websocket != NULL)
-              {
-                // Replace the CTCPClient with a CWebSocketClient
-                CWebSocketClient *websocketClient = new CWebSocketClient(websocket, *(m_connections[i]));
-                delete m_connections[i];
-                m_connections.erase(m_connections.begin() + i);
-                m_connections.insert(m_connections.begin() + i, websocketClient);
-              }
-            }
-
-            if (response.size() <= 0)
-              m_connections[i]->PushBuffer(this, buffer, nread);
-
-            close = m_connections[i]->Closing();
-          }
-          else
-            close = true;
-
-          if (close)
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
-            m_connections[i]->Disconnect();
-            delete m_connections[i];
-            m_connections.erase(m_connections.begin() + i);
-          }
-        }
-      }
+      if (errno == EINTR)
+        continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    if (nread == 0)
+    {
+      // the requests received so far still get their responses
+      client->SetEndOfInput();
+      break;
+    }
+
+    std::string response;
+    if (client->IsNew())
+    {
+      CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
 
-      for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+      if (response.size() > 0)
+        client->Send(response.c_str(), response.size());
+
+      if (websocket != NULL)
       {
-        if (FD_ISSET(*it, &rfds))
-        {
-          CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
-          CTCPClient *newconnection = new CTCPClient();
-          newconnection->m_socket = accept(*it, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
-
-          if (newconnection->m_socket == INVALID_SOCKET)
-          {
-            CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", errno);
-            if (EBADF == errno)
-            {
-              Sleep(1000);
-              Initialize();
-              break;
-            }
-          }
-          else
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
-            m_connections.push_back(newconnection);
-          }
-        }
+        // Replace the CTCPClient with a CWebSocketClient, announcements
+        // still being sent to the old one are dropped
+        CSingleLock clientLock(client->m_critSection);
+        CTCPClientPtr websocketClient(new CWebSocketClient(websocket, *client));
+        client->m_socket = INVALID_SOCKET;
+        clientLock.Leave();
+
+        CSingleLock lock(m_critSection);
+        m_connections[websocketClient->m_socket] = websocketClient;
+        client = websocketClient;
       }
     }
+
+    if (response.size() <= 0)
+      client->PushBuffer(this, buffer, nread);
+
+    if (client->Closing())
+      break;
   }
 
-  Deinitialize();
+  client->UpdatePoll();
+  return true;
+}
+
+void CTCPServer::CloseConnection(SOCKET socket, const CTCPClientPtr &client)
+{
+  // keyed on the polled socket, the client may have closed its own already
+  {
+    CSingleLock lock(m_critSection);
+    m_connections.erase(socket);
+  }
+
+  // only this thread closes sockets, so their numbers can't be reused
+  // while still being watched
+  m_poller->Remove(socket);
+  client->Disconnect();
+  client->CTCPClient::Disconnect();
+}
+
+void CTCPServer::QueueRequests(const CTCPClientPtr &client)
+{
+  {
+    CSingleLock lock(m_jobsSection);
+    m_activeJobs++;
+    m_jobsDone.Reset();
+  }
+  m_jobs.AddJob(new CRequestJob(this, client));
+}
+
+void CTCPServer::OnJobDone()
+{
+  CSingleLock lock(m_jobsSection);
+  if (--m_activeJobs == 0)
+    m_jobsDone.Set();
 }
 
 bool CTCPServer::PrepareDownload(const char *path, CVariant &details, std::string &protocol)
@@ -232,17 +530,27 @@ int CTCPServer::GetCapabilities()
 
 void CTCPServer::Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
 {
+  std::vector<CTCPClientPtr> connections;
+  {
+    CSingleLock lock (m_critSection);
+    for (std::map<SOCKET, CTCPClientPtr>::const_iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+      connections.push_back(it->second);
+  }
+  if (connections.empty())
+    return;
+
   std::string str = IJSONRPCAnnouncer::AnnouncementToJSONRPC(flag, sender, message, data, g_advancedSettings.m_jsonOutputCompact);
 
-  for (unsigned int i = 0; i < m_connections.size(); i++)
+  for (unsigned int i = 0; i < connections.size(); i++)
   {
     {
-      CSingleLock lock (m_connections[i]->m_critSection);
-      if ((m_connections[i]->GetAnnouncementFlags() & flag) == 0)
+      CSingleLock lock (connections[i]->m_critSection);
+      if ((connections[i]->GetAnnouncementFlags() & flag) == 0)
         continue;
     }
 
-    m_connections[i]->Send(str.c_str(), str.size());
+    // queued, a client not reading doesn't hold up the others
+    connections[i]->SendAnnouncement(str);
   }
 }
 
@@ -255,9 +563,16 @@ bool CTCPServer::Initialize()
   started |= InitializeBlue();
   started |= InitializeTCP();
 
+  for (std::vector<SOCKET>::const_iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+  {
+    if (!SetNonBlocking(*it) || !m_poller->Add(*it, true, false))
+      CLog::Log(LOGERROR, "JSONRPC Server: Unable to watch server socket: %d", errno);
+  }
+
   if (started)
   {
-    CAnnouncementManager::GetInstance().AddAnnouncer(this);
+    // remote clients must not hold up the announcing thread
+    CAnnouncementManager::GetInstance().AddAnnouncer(this, true);
     CLog::Log(LOGINFO, "JSONRPC Server: Successfully initialized");
     return true;
   }
@@ -396,16 +711,29 @@ bool CTCPServer::InitializeTCP()
 
 void CTCPServer::Deinitialize()
 {
-  for (unsigned int i = 0; i < m_connections.size(); i++)
+  std::map<SOCKET, CTCPClientPtr> connections;
+  {
+    CSingleLock lock(m_critSection);
+    connections.swap(m_connections);
+  }
+
+  for (std::map<SOCKET, CTCPClientPtr>::iterator it = connections.begin(); it != connections.end(); ++it)
   {
-    m_connections[i]->Disconnect();
-    delete m_connections[i];
+    m_poller->Remove(it->first);
+    it->second->Disconnect();
+    it->second->CTCPClient::Disconnect();
   }
 
-  m_connections.clear();
+  // requests still running only find closed connections now
+  m_jobs.CancelJobs();
+  m_jobsDone.Wait();
+  CSingleLock lock(m_jobsSection);
 
   for (unsigned int i = 0; i < m_servers.size(); i++)
+  {
+    m_poller->Remove(m_servers[i]);
     closesocket(m_servers[i]);
+  }
 
   m_servers.clear();
 
@@ -423,10 +751,18 @@ CTCPServer::CTCPClient::CTCPClient()
   m_new = true;
   m_announcementflags = ANNOUNCE_ALL;
   m_socket = INVALID_SOCKET;
+  m_poller = NULL;
   m_beginBrackets = 0;
   m_endBrackets = 0;
   m_beginChar = 0;
   m_endChar = 0;
+  m_outputOffset = 0;
+  m_outputSize = 0;
+  m_busy = false;
+  m_eof = false;
+  m_shutdown = false;
+  m_pollRead = true;
+  m_pollWrite = false;
 
   m_addrlen = sizeof(m_cliaddr);
 }
@@ -460,12 +796,144 @@ bool CTCPServer::CTCPClient::SetAnnouncementFlags(int flags)
 
 void CTCPServer::CTCPClient::Send(const char *data, unsigned int size)
 {
-  unsigned int sent = 0;
-  do
+  CSingleLock lock (m_critSection);
+  if (m_socket == INVALID_SOCKET || m_shutdown || size == 0)
+    return;
+
+  // write right away if nothing is queued, only queue what doesn't fit
+  if (m_output.empty())
   {
-    CSingleLock lock (m_critSection);
-    sent += send(m_socket, data + sent, size - sent, 0);
-  } while (sent < size);
+    int sent = send(m_socket, data, size, MSG_NOSIGNAL);
+    if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+      Shutdown();
+      return;
+    }
+    if (sent > 0)
+    {
+      data += sent;
+      size -= sent;
+    }
+  }
+
+  if (size > 0)
+  {
+    m_output.push_back(std::string(data, size));
+    m_outputSize += size;
+    UpdatePoll();
+  }
+}
+
+void CTCPServer::CTCPClient::SendAnnouncement(const std::string &announcement)
+{
+  CSingleLock lock (m_critSection);
+  if (m_socket == INVALID_SOCKET || m_shutdown)
+    return;
+
+  if (m_outputSize > JSONRPC_MAX_OUTPUT)
+  {
+    CLog::Log(LOGWARNING, "JSONRPC Server: Client doesn't read its announcements, disconnecting");
+    Shutdown();
+    return;
+  }
+
+  Send(announcement.c_str(), announcement.size());
+}
+
+bool CTCPServer::CTCPClient::Flush()
+{
+  CSingleLock lock (m_critSection);
+  if (m_socket == INVALID_SOCKET)
+    return false;
+
+  while (!m_output.empty())
+  {
+    const std::string &front = m_output.front();
+    int sent = send(m_socket, front.c_str() + m_outputOffset, front.size() - m_outputOffset, MSG_NOSIGNAL);
+    if (sent < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+      return false;
+    }
+
+    m_outputOffset += sent;
+    m_outputSize -= sent;
+    if (m_outputOffset == front.size())
+    {
+      m_output.pop_front();
+      m_outputOffset = 0;
+    }
+  }
+
+  if (m_outputSize <= JSONRPC_LOW_WATER)
+    m_drained.Set();
+
+  UpdatePoll();
+  return true;
+}
+
+bool CTCPServer::CTCPClient::WaitForSpace()
+{
+  CSingleLock lock (m_critSection);
+  while (m_outputSize > JSONRPC_HIGH_WATER && m_socket != INVALID_SOCKET)
+  {
+    m_drained.Reset();
+    lock.Leave();
+    m_drained.WaitMSec(1000);
+    lock.Enter();
+  }
+  return m_socket != INVALID_SOCKET && !m_shutdown;
+}
+
+bool CTCPServer::CTCPClient::IsReadPaused()
+{
+  CSingleLock lock (m_critSection);
+  return m_eof || m_requests.size() >= JSONRPC_MAX_REQUESTS || m_outputSize > JSONRPC_HIGH_WATER;
+}
+
+bool CTCPServer::CTCPClient::IsDone()
+{
+  CSingleLock lock (m_critSection);
+  return m_eof && !m_busy && m_requests.empty() && m_output.empty();
+}
+
+void CTCPServer::CTCPClient::SetEndOfInput()
+{
+  CSingleLock lock (m_critSection);
+  m_eof = true;
+}
+
+void CTCPServer::CTCPClient::Shutdown()
+{
+  // the polling thread sees the hangup and closes the connection
+  CSingleLock lock (m_critSection);
+  if (m_socket != INVALID_SOCKET && !m_shutdown)
+    shutdown(m_socket, SHUT_RDWR);
+  m_shutdown = true;
+  m_output.clear();
+  m_outputSize = 0;
+  m_drained.Set();
+}
+
+void CTCPServer::CTCPClient::UpdatePoll()
+{
+  CSingleLock lock (m_critSection);
+  if (m_socket == INVALID_SOCKET || !m_poller)
+    return;
+
+  // output below the high water mark has to drop to the low one before
+  // reading resumes, so the pause doesn't flip with every write
+  bool read = !IsReadPaused() && (m_pollRead || m_outputSize <= JSONRPC_LOW_WATER);
+  bool write = !m_output.empty();
+  if (read == m_pollRead && write == m_pollWrite)
+    return;
+
+  m_poller->Modify(m_socket, read, write);
+  m_pollRead = read;
+  m_pollWrite = write;
 }
 
 void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
@@ -496,8 +964,7 @@ void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, in
         m_endBrackets++;
       if (m_beginBrackets > 0 && m_endBrackets > 0 && m_beginBrackets == m_endBrackets)
       {
-        std::string line = CJSONRPC::MethodCall(m_buffer, host, this);
-        Send(line.c_str(), line.size());
+        QueueRequest(host);
         m_beginChar = m_beginBrackets = m_endBrackets = 0;
         m_buffer.clear();
       }
@@ -505,6 +972,56 @@ void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, in
   }
 }
 
+void CTCPServer::CTCPClient::QueueRequest(CTCPServer *host)
+{
+  CSingleLock lock (m_critSection);
+  m_requests.push_back(std::string());
+  m_requests.back().swap(m_buffer);
+
+  if (!m_busy)
+  {
+    m_busy = true;
+    host->QueueRequests(shared_from_this());
+  }
+}
+
+void CTCPServer::CTCPClient::ProcessRequests(CTCPServer *host)
+{
+  for (;;)
+  {
+    std::string request;
+    {
+      CSingleLock lock (m_critSection);
+      if (m_requests.empty() || m_socket == INVALID_SOCKET)
+      {
+        m_requests.clear();
+        m_busy = false;
+        // wake up the polling thread to close the connection
+        if (IsDone())
+          Shutdown();
+        return;
+      }
+
+      request.swap(m_requests.front());
+      m_requests.pop_front();
+      UpdatePoll();
+    }
+
+    SendResponse(host, request);
+    WaitForSpace();
+  }
+}
+
+void CTCPServer::CTCPClient::SendResponse(CTCPServer *host, const std::string &request)
+{
+  // chunks go out while the response is serialized, as fast as the client reads them
+  CJSONRPC::MethodCall(request, host, this, [this](const char *data, size_t size)
+  {
+    Send(data, (unsigned int)size);
+    return WaitForSpace();
+  });
+}
+
 void CTCPServer::CTCPClient::Disconnect()
 {
   if (m_socket > 0)
@@ -513,6 +1030,9 @@ void CTCPServer::CTCPClient::Disconnect()
     shutdown(m_socket, SHUT_RDWR);
     closesocket(m_socket);
     m_socket = INVALID_SOCKET;
+    m_output.clear();
+    m_outputSize = 0;
+    m_drained.Set();
   }
 }
 
@@ -522,12 +1042,22 @@ void CTCPServer::CTCPClient::Copy(const CTCPClient& client)
   m_socket            = client.m_socket;
   m_cliaddr           = client.m_cliaddr;
   m_addrlen           = client.m_addrlen;
+  m_poller            = client.m_poller;
   m_announcementflags = client.m_announcementflags;
   m_beginBrackets     = client.m_beginBrackets;
   m_endBrackets       = client.m_endBrackets;
   m_beginChar         = client.m_beginChar;
   m_endChar           = client.m_endChar;
   m_buffer            = client.m_buffer;
+  m_requests          = client.m_requests;
+  m_output            = client.m_output;
+  m_outputOffset      = client.m_outputOffset;
+  m_outputSize        = client.m_outputSize;
+  m_busy              = client.m_busy;
+  m_eof               = client.m_eof;
+  m_shutdown          = client.m_shutdown;
+  m_pollRead          = client.m_pollRead;
+  m_pollWrite         = client.m_pollWrite;
 }
 
 CTCPServer::CWebSocketClient::CWebSocketClient(CWebSocket *websocket)
@@ -563,6 +1093,8 @@ CTCPServer::CWebSocketClient& CTCPServer::CWebSocketClient::operator=(const CWeb
 
 void CTCPServer::CWebSocketClient::Send(const char *data, unsigned int size)
 {
+  // the frames of a message must not be interleaved with others
+  CSingleLock lock (m_critSection);
   const CWebSocketMessage *msg = m_websocket->Send(WebSocketTextFrame, data, size);
   if (msg == NULL || !msg->IsComplete())
     return;
@@ -598,8 +1130,14 @@ void CTCPServer::CWebSocketClient::PushBuffer(CTCPServer *host, const char *buff
   }
   while (len > 0 && msg != NULL);
 
-  if (m_websocket->GetState() == WebSocketStateClosed)
-    Disconnect();
+  // once closed, Closing() has the polling thread tear the connection down
+}
+
+void CTCPServer::CWebSocketClient::SendResponse(CTCPServer *host, const std::string &request)
+{
+  // every Send() is a message of its own, so the response is sent as a whole
+  std::string line = CJSONRPC::MethodCall(request, host, this);
+  Send(line.c_str(), line.size());
 }
 
 void CTCPServer::CWebSocketClient::Disconnect()
@@ -19,6 +19,9 @@
  *
  */
 
+#include <deque>
+#include <map>
+#include <memory>
 #include <vector>
 #include <sys/socket.h>
 
@@ -27,13 +30,25 @@
 #include "interfaces/json-rpc/IJSONRPCAnnouncer.h"
 #include "interfaces/json-rpc/ITransportLayer.h"
 #include "threads/CriticalSection.h"
+#include "threads/Event.h"
 #include "threads/Thread.h"
+#include "utils/JobManager.h"
 #include "websocket/WebSocket.h"
 
 class CVariant;
 
 namespace JSONRPC
 {
+  /*!
+   \brief JSON-RPC over raw TCP and WebSocket connections
+
+   A single thread waits for socket readiness (epoll where available) and
+   does all reading, accepting and closing. Complete requests are executed
+   by a small pool of jobs, one connection at a time each so responses keep
+   their order. Output is queued per connection and written as the socket
+   takes it. A connection is not read from while too much of its output or
+   too many of its requests are pending.
+   */
   class CTCPServer : public ITransportLayer, public JSONRPC::IJSONRPCAnnouncer, public CThread
   {
   public:
@@ -49,13 +64,25 @@ namespace JSONRPC
   protected:
     void Process();
   private:
+    class CTCPClient;
+    class CSocketPoller;
+    class CRequestJob;
+    typedef std::shared_ptr<CTCPClient> CTCPClientPtr;
+
     CTCPServer(int port, bool nonlocal);
+    ~CTCPServer();
     bool Initialize();
     bool InitializeBlue();
     bool InitializeTCP();
     void Deinitialize();
 
-    class CTCPClient : public IClient
+    void AcceptConnections(SOCKET server);
+    bool ReadConnection(CTCPClientPtr &client);
+    void CloseConnection(SOCKET socket, const CTCPClientPtr &client);
+    void QueueRequests(const CTCPClientPtr &client);
+    void OnJobDone();
+
+    class CTCPClient : public IClient, public std::enable_shared_from_this<CTCPClient>
     {
     public:
       CTCPClient();
@@ -76,19 +103,57 @@ namespace JSONRPC
       virtual bool IsNew() const { return m_new; }
       virtual bool Closing() const { return false; }
 
+      /*!
+       \brief Queues an announcement, drops the connection if it doesn't read them
+       */
+      void SendAnnouncement(const std::string &announcement);
+      /*!
+       \brief Writes queued output until the socket would block, false on errors
+       */
+      bool Flush();
+      /*!
+       \brief Runs the queued requests, called by the jobs of the host
+       */
+      void ProcessRequests(CTCPServer *host);
+      /*!
+       \brief Whether the peer is gone and nothing is left to do for it
+       */
+      bool IsDone();
+      bool IsReadPaused();
+      void SetEndOfInput();
+      /*!
+       \brief Ends the connection from any thread, the polling thread closes it
+       */
+      void Shutdown();
+      void UpdatePoll();
+
       SOCKET           m_socket;
       sockaddr_storage m_cliaddr;
       socklen_t        m_addrlen;
       CCriticalSection m_critSection;
+      CSocketPoller   *m_poller;
 
     protected:
       void Copy(const CTCPClient& client);
+      virtual void SendResponse(CTCPServer *host, const std::string &request);
+      void QueueRequest(CTCPServer *host);
+      bool WaitForSpace();
+
+      std::string m_buffer;
     private:
+      std::deque<std::string> m_requests;
+      std::deque<std::string> m_output;
+      size_t m_outputOffset;     /**< bytes of the first output string already sent */
+      size_t m_outputSize;       /**< bytes waiting to be sent */
+      CEvent m_drained;
+      bool m_busy;               /**< a job is running the requests */
+      bool m_eof;                /**< the peer won't send anymore */
+      bool m_shutdown;           /**< waiting to be closed */
+      bool m_pollRead, m_pollWrite;
       bool m_new;
       int m_announcementflags;
       int m_beginBrackets, m_endBrackets;
       char m_beginChar, m_endChar;
-      std::string m_buffer;
     };
 
     class CWebSocketClient : public CTCPClient
@@ -107,12 +172,21 @@ namespace JSONRPC
       virtual bool IsNew() const { return m_websocket == NULL; }
       virtual bool Closing() const { return m_websocket != NULL && m_websocket->GetState() == WebSocketStateClosed; }
 
+    protected:
+      virtual void SendResponse(CTCPServer *host, const std::string &request);
+
     private:
       CWebSocket *m_websocket;
     };
 
-    std::vector<CTCPClient*> m_connections;
+    CCriticalSection m_critSection;
+    std::map<SOCKET, CTCPClientPtr> m_connections;
     std::vector<SOCKET> m_servers;
+    CSocketPoller *m_poller;
+    CJobQueue m_jobs;
+    CCriticalSection m_jobsSection;
+    unsigned int m_activeJobs;
+    CEvent m_jobsDone;
     int m_port;
     bool m_nonlocal;
     void* m_sdpd;
@@ -26,11 +26,15 @@
 
 #ifdef HAS_WEB_SERVER
 #include <algorithm>
+#include <fcntl.h>
 #include <memory>
 #include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <utility>
 
 #include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
 #include "settings/Settings.h"
 #include "threads/SingleLock.h"
@@ -49,6 +53,12 @@
 //#define WEBSERVER_DEBUG
 
 #define MAX_POST_BUFFER_SIZE 2048
+// bytes read from the VFS per call of ContentReaderCallback
+#define FILE_DOWNLOAD_BLOCK_SIZE (64 * 1024)
+
+#if MHD_VERSION >= 0x00094400
+#define HAS_MHD_FD_RESPONSE
+#endif
 
 #define PAGE_FILE_NOT_FOUND "<html><head><title>File not found</title></head><body>File not found</body></html>"
 #define NOT_SUPPORTED       "<html><head><title>Not Supported</title></head><body>The method you are trying to use is not supported by this server</body></html>"
@@ -749,6 +759,32 @@ int CWebServer::CreateRedirect(struct MHD_Connection *connection, const std::str
   return MHD_YES;
 }
 
+#ifdef HAS_MHD_FD_RESPONSE
+/*!
+ \brief Opens a plain file on the local filesystem, returns its descriptor or -1
+ */
+static int OpenLocalFile(const std::string &filePath, uint64_t &fileLength)
+{
+  std::string path = CSpecialProtocol::TranslatePath(filePath);
+  if (!CURL(path).GetProtocol().empty())
+    return -1;
+
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+  {
+    close(fd);
+    return -1;
+  }
+
+  fileLength = static_cast<uint64_t>(st.st_size);
+  return fd;
+}
+#endif
+
 int CWebServer::CreateFileDownloadResponse(IHTTPRequestHandler *handler, struct MHD_Response *&response)
 {
   if (handler == NULL)
@@ -758,21 +794,40 @@ int CWebServer::CreateFileDownloadResponse(IHTTPRequestHandler *handler, struct
   const HTTPResponseDetails &responseDetails = handler->GetResponseDetails();
   HttpResponseRanges responseRanges = handler->GetResponseData();
 
-  std::shared_ptr<XFILE::CFile> file = std::make_shared<XFILE::CFile>();
+  std::shared_ptr<XFILE::CFile> file;
   std::string filePath = handler->GetResponseFile();
 
   // white/black list access check
   if (!CFileUtils::ZebraListAccessCheck(filePath))
     return SendErrorResponse(request.connection, MHD_HTTP_NOT_FOUND, request.method);
 
-  if (!file->Open(filePath, READ_NO_CACHE))
+  bool ranged = false;
+  uint64_t fileLength = 0;
+
+  // local files are handed to microhttpd as they are, which sends them
+  // without copying them through our buffers (sendfile() where available)
+  int fd = -1;
+#ifdef HAS_MHD_FD_RESPONSE
+  fd = OpenLocalFile(filePath, fileLength);
+#endif
+
+  if (fd < 0)
   {
-    CLog::Log(LOGERROR, "WebServer: Failed to open %s", filePath.c_str());
-    return SendErrorResponse(request.connection, MHD_HTTP_NOT_FOUND, request.method);
-  }
+    file = std::make_shared<XFILE::CFile>();
 
-  bool ranged = false;
-  uint64_t fileLength = static_cast<uint64_t>(file->GetLength());
+    // remote sources are read ahead by the file cache while we send
+    unsigned int flags = READ_NO_CACHE;
+    if (request.method != HEAD && URIUtils::IsRemote(filePath))
+      flags = READ_CHUNKED | READ_CACHED;
+
+    if (!file->Open(filePath, flags))
+    {
+      CLog::Log(LOGERROR, "WebServer: Failed to open %s", filePath.c_str());
+      return SendErrorResponse(request.connection, MHD_HTTP_NOT_FOUND, request.method);
+    }
+
+    fileLength = static_cast<uint64_t>(file->GetLength());
+  }
 
   // get the MIME type for the Content-Type header
   std::string mimeType = responseDetails.contentType;
@@ -850,18 +905,50 @@ int CWebServer::CreateFileDownloadResponse(IHTTPRequestHandler *handler, struct
     // set the initial write position
     context->ranges.GetFirstPosition(context->writePosition);
 
-    // create the response object
-    response = MHD_create_response_from_callback(totalLength, 2048,
-                                                  &CWebServer::ContentReaderCallback,
-                                                  context.get(),
-                                                  &CWebServer::ContentReaderFreeCallback);
-    if (response == NULL)
+#ifdef HAS_MHD_FD_RESPONSE
+    // multipart responses interleave boundaries with the data, so they are
+    // put together by ContentReaderCallback
+    if (fd >= 0 && context->rangeCountTotal > 1)
     {
-      CLog::Log(LOGERROR, "CWebServer: failed to create a HTTP response for %s to be filled from %s", request.pathUrl.c_str(), filePath.c_str());
-      return MHD_NO;
+      close(fd);
+      fd = -1;
+
+      file = std::make_shared<XFILE::CFile>();
+      if (!file->Open(filePath, READ_NO_CACHE))
+      {
+        CLog::Log(LOGERROR, "WebServer: Failed to open %s", filePath.c_str());
+        return SendErrorResponse(request.connection, MHD_HTTP_NOT_FOUND, request.method);
+      }
+      context->file = file;
+    }
+
+    if (fd >= 0)
+    {
+      // microhttpd owns and closes the descriptor from here on
+      response = MHD_create_response_from_fd_at_offset64(totalLength, fd, context->writePosition);
+      if (response == NULL)
+      {
+        CLog::Log(LOGERROR, "CWebServer: failed to create a HTTP response for %s to be sent from %s", request.pathUrl.c_str(), filePath.c_str());
+        close(fd);
+        return MHD_NO;
+      }
     }
+    else
+#endif
+    {
+      // create the response object
+      response = MHD_create_response_from_callback(totalLength, FILE_DOWNLOAD_BLOCK_SIZE,
+                                                    &CWebServer::ContentReaderCallback,
+                                                    context.get(),
+                                                    &CWebServer::ContentReaderFreeCallback);
+      if (response == NULL)
+      {
+        CLog::Log(LOGERROR, "CWebServer: failed to create a HTTP response for %s to be filled from %s", request.pathUrl.c_str(), filePath.c_str());
+        return MHD_NO;
+      }
 
-    context.release(); // ownership was passed to mhd
+      context.release(); // ownership was passed to mhd
+    }
 
     // add Content-Range header
     if (ranged)
@@ -869,6 +956,9 @@ int CWebServer::CreateFileDownloadResponse(IHTTPRequestHandler *handler, struct
   }
   else
   {
+    if (fd >= 0)
+      close(fd);
+
 #if MHD_VERSION >= 0x00090500
     response = MHD_create_response_from_buffer(0, NULL, MHD_RESPMEM_PERSISTENT);
 #else
@@ -81,10 +81,19 @@ int CHTTPJsonRpcHandler::HandleRequest()
 
   if (isRequest)
   {
-    m_responseData = JSONRPC::CJSONRPC::MethodCall(m_requestData, m_request.webserver, &client);
+    // the response is appended chunk by chunk as it is serialized
+    m_responseData.clear();
+    if (!jsonpCallback.empty())
+      m_responseData = jsonpCallback + "(";
+
+    JSONRPC::CJSONRPC::MethodCall(m_requestData, m_request.webserver, &client, [this](const char *data, size_t size)
+    {
+      m_responseData.append(data, size);
+      return true;
+    });
 
     if (!jsonpCallback.empty())
-      m_responseData = jsonpCallback + "(" + m_responseData + ");";
+      m_responseData += ");";
   }
   else if (jsonpCallback.empty())
   {
@@ -114,7 +114,7 @@ CUPnPServer::SetupServices()
     OnScanCompleted(VideoLibrary);
 
     // now safe to start passing on new notifications
-    ANNOUNCEMENT::CAnnouncementManager::GetInstance().AddAnnouncer(this);
+    ANNOUNCEMENT::CAnnouncementManager::GetInstance().AddAnnouncer(this, true);
 
     return result;
 }
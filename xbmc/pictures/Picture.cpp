@@ -26,12 +26,14 @@
 #include <algorithm>
 
 #include "Picture.h"
+#include "PictureKernels.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "FileItem.h"
 #include "filesystem/File.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
+#include "guilib/DDSImage.h"
 #include "guilib/Texture.h"
 #include "guilib/imagefactory.h"
 #include "cores/FFmpeg.h"
@@ -42,6 +44,28 @@ extern "C" {
 
 using namespace XFILE;
 
+/*!
+ \brief Keeps an uncompressed copy of a cached image next to it, which
+ CImageLoader maps and uploads instead of decoding the image again.
+ */
+static void CacheUploadableTexture(const unsigned char *pixels, uint32_t width, uint32_t height, uint32_t pitch, const std::string &dest)
+{
+  std::string ddsFile = URIUtils::ReplaceExtension(dest, ".dds");
+
+  uint32_t maxHeight = g_advancedSettings.m_imageDDSRes;
+  if (maxHeight == 0 || height > maxHeight || width > maxHeight * 16/9)
+  { // don't leave the copy of an earlier version around
+    if (CFile::Exists(ddsFile))
+      CFile::Delete(ddsFile);
+    return;
+  }
+
+  // only images with alpha are cached as png
+  CDDSImage image;
+  if (!image.Create(ddsFile, width, height, pitch, pixels, URIUtils::HasExtension(dest, ".png")))
+    CLog::Log(LOGWARNING, "%s - failed to write %s", __FUNCTION__, ddsFile.c_str());
+}
+
 bool CPicture::GetThumbnailFromSurface(const unsigned char* buffer, int width, int height, int stride, const std::string &thumbFile, uint8_t* &result, size_t& result_size)
 {
   unsigned char *thumb = NULL;
@@ -242,6 +266,8 @@ bool CPicture::CacheTexture(uint8_t *pixels, uint32_t width, uint32_t height, ui
         if (!orientation || OrientateImage(buffer, dest_width, dest_height, orientation))
         {
           success = CreateThumbnailFromSurface((unsigned char*)buffer, dest_width, dest_height, dest_width * 4, dest);
+          if (success)
+            CacheUploadableTexture((unsigned char*)buffer, dest_width, dest_height, dest_width * 4, dest);
         }
       }
       delete[] buffer;
@@ -252,7 +278,10 @@ bool CPicture::CacheTexture(uint8_t *pixels, uint32_t width, uint32_t height, ui
   { // no orientation needed
     dest_width = width;
     dest_height = height;
-    return CreateThumbnailFromSurface(pixels, width, height, pitch, dest);
+    if (!CreateThumbnailFromSurface(pixels, width, height, pitch, dest))
+      return false;
+    CacheUploadableTexture(pixels, width, height, pitch, dest);
+    return true;
   }
   return false;
 }
@@ -330,6 +359,23 @@ bool CPicture::ScaleImage(uint8_t *in_pixels, unsigned int in_width, unsigned in
                           uint8_t *out_pixels, unsigned int out_width, unsigned int out_height, unsigned int out_pitch,
                           CPictureScalingAlgorithm::Algorithm scalingAlgorithm /* = CPictureScalingAlgorithm::NoAlgorithm */)
 {
+  // halve large images with a box filter first, so swscale only filters
+  // down the last factor of 2 to 4 instead of every source pixel
+  uint8_t *reduced = NULL;
+  while (out_width && out_height && in_width >= out_width * 4 && in_height >= out_height * 4)
+  {
+    unsigned int width = in_width / 2;
+    unsigned int height = in_height / 2;
+    uint8_t *buffer = new uint8_t[width * height * 4];
+    CPictureKernels::Halve(in_pixels, in_width, in_height, in_pitch, buffer, width * 4);
+    delete[] reduced;
+    reduced = buffer;
+    in_pixels = buffer;
+    in_width = width;
+    in_height = height;
+    in_pitch = width * 4;
+  }
+
   struct SwsContext *context = sws_getContext(in_width, in_height, AV_PIX_FMT_BGRA,
                                                          out_width, out_height, AV_PIX_FMT_BGRA,
                                                          CPictureScalingAlgorithm::ToSwscale(scalingAlgorithm), NULL, NULL, NULL);
@@ -339,18 +385,19 @@ bool CPicture::ScaleImage(uint8_t *in_pixels, unsigned int in_width, unsigned in
   uint8_t *dst[] = { out_pixels , 0, 0, 0 };
   int     dstStride[] = { (int)out_pitch, 0, 0, 0 };
 
+  bool success = false;
   if (context)
   {
     sws_scale(context, src, srcStride, 0, in_height, dst, dstStride);
     sws_freeContext(context);
-    return true;
+    success = true;
   }
-  return false;
+  delete[] reduced;
+  return success;
 }
 
 bool CPicture::OrientateImage(uint32_t *&pixels, unsigned int &width, unsigned int &height, int orientation)
 {
-  // ideas for speeding these functions up: http://cgit.freedesktop.org/pixman/tree/pixman/pixman-fast-path.c
   bool out = false;
   switch (orientation)
   {
@@ -385,88 +432,31 @@ bool CPicture::OrientateImage(uint32_t *&pixels, unsigned int &width, unsigned i
 bool CPicture::FlipHorizontal(uint32_t *&pixels, unsigned int &width, unsigned int &height)
 {
   // this can be done in-place easily enough
-  for (unsigned int y = 0; y < height; ++y)
-  {
-    uint32_t *line = pixels + y * width;
-    for (unsigned int x = 0; x < width / 2; ++x)
-      std::swap(line[x], line[width - 1 - x]);
-  }
+  CPictureKernels::FlipHorizontal(pixels, width, height);
   return true;
 }
 
 bool CPicture::FlipVertical(uint32_t *&pixels, unsigned int &width, unsigned int &height)
 {
   // this can be done in-place easily enough
-  for (unsigned int y = 0; y < height / 2; ++y)
-  {
-    uint32_t *line1 = pixels + y * width;
-    uint32_t *line2 = pixels + (height - 1 - y) * width;
-    for (unsigned int x = 0; x < width; ++x)
-      std::swap(*line1++, *line2++);
-  }
+  CPictureKernels::FlipVertical(pixels, width, height);
   return true;
 }
 
 bool CPicture::Rotate180CCW(uint32_t *&pixels, unsigned int &width, unsigned int &height)
 {
   // this can be done in-place easily enough
-  for (unsigned int y = 0; y < height / 2; ++y)
-  {
-    uint32_t *line1 = pixels + y * width;
-    uint32_t *line2 = pixels + (height - 1 - y) * width + width - 1;
-    for (unsigned int x = 0; x < width; ++x)
-      std::swap(*line1++, *line2--);
-  }
-  if (height % 2)
-  { // height is odd, so flip the middle row as well
-    uint32_t *line = pixels + (height - 1)/2 * width;
-    for (unsigned int x = 0; x < width / 2; ++x)
-      std::swap(line[x], line[width - 1 - x]);
-  }
+  CPictureKernels::Rotate180(pixels, width, height);
   return true;
 }
 
-bool CPicture::Rotate90CCW(uint32_t *&pixels, unsigned int &width, unsigned int &height)
-{
-  uint32_t *dest = new uint32_t[width * height * 4];
-  if (dest)
-  {
-    unsigned int d_height = width, d_width = height;
-    for (unsigned int y = 0; y < d_height; y++)
-    {
-      const uint32_t *src = pixels + (d_height - 1 - y); // y-th col from right, starting at top
-      uint32_t *dst = dest + d_width * y;                // y-th row from top, starting at left
-      for (unsigned int x = 0; x < d_width; x++)
-      {
-        *dst++ = *src;
-        src += width;
-      }
-    }
-    delete[] pixels;
-    pixels = dest;
-    std::swap(width, height);
-    return true;
-  }
-  return false;
-}
-
-bool CPicture::Rotate270CCW(uint32_t *&pixels, unsigned int &width, unsigned int &height)
+bool CPicture::TransposeImage(uint32_t *&pixels, unsigned int &width, unsigned int &height, bool flipRows, bool flipColumns)
 {
-  uint32_t *dest = new uint32_t[width * height * 4];
+  uint32_t *dest = new uint32_t[width * height];
   if (!dest)
     return false;
 
-  unsigned int d_height = width, d_width = height;
-  for (unsigned int y = 0; y < d_height; y++)
-  {
-    const uint32_t *src = pixels + width * (d_width - 1) + y; // y-th col from left, starting at bottom
-    uint32_t *dst = dest + d_width * y;                       // y-th row from top, starting at left
-    for (unsigned int x = 0; x < d_width; x++)
-    {
-      *dst++ = *src;
-      src -= width;
-    }
-  }
+  CPictureKernels::Transpose(pixels, width, height, dest, flipRows, flipColumns);
 
   delete[] pixels;
   pixels = dest;
@@ -474,50 +464,26 @@ bool CPicture::Rotate270CCW(uint32_t *&pixels, unsigned int &width, unsigned int
   return true;
 }
 
-bool CPicture::Transpose(uint32_t *&pixels, unsigned int &width, unsigned int &height)
+bool CPicture::Rotate90CCW(uint32_t *&pixels, unsigned int &width, unsigned int &height)
 {
-  uint32_t *dest = new uint32_t[width * height * 4];
-  if (!dest)
-    return false;
+  // y-th row from top is the y-th column from right, starting at top
+  return TransposeImage(pixels, width, height, false, true);
+}
 
-  unsigned int d_height = width, d_width = height;
-  for (unsigned int y = 0; y < d_height; y++)
-  {
-    const uint32_t *src = pixels + y;   // y-th col from left, starting at top
-    uint32_t *dst = dest + d_width * y; // y-th row from top, starting at left
-    for (unsigned int x = 0; x < d_width; x++)
-    {
-      *dst++ = *src;
-      src += width;
-    }
-  }
+bool CPicture::Rotate270CCW(uint32_t *&pixels, unsigned int &width, unsigned int &height)
+{
+  // y-th row from top is the y-th column from left, starting at bottom
+  return TransposeImage(pixels, width, height, true, false);
+}
 
-  delete[] pixels;
-  pixels = dest;
-  std::swap(width, height);
-  return true;
+bool CPicture::Transpose(uint32_t *&pixels, unsigned int &width, unsigned int &height)
+{
+  // y-th row from top is the y-th column from left, starting at top
+  return TransposeImage(pixels, width, height, false, false);
 }
 
 bool CPicture::TransposeOffAxis(uint32_t *&pixels, unsigned int &width, unsigned int &height)
 {
-  uint32_t *dest = new uint32_t[width * height * 4];
-  if (!dest)
-    return false;
-
-  unsigned int d_height = width, d_width = height;
-  for (unsigned int y = 0; y < d_height; y++)
-  {
-    const uint32_t *src = pixels + width * (d_width - 1) + (d_height - 1 - y); // y-th col from right, starting at bottom
-    uint32_t *dst = dest + d_width * y;                                        // y-th row, starting at left
-    for (unsigned int x = 0; x < d_width; x++)
-    {
-      *dst++ = *src;
-      src -= width;
-    }
-  }
-
-  delete[] pixels;
-  pixels = dest;
-  std::swap(width, height);
-  return true;
+  // y-th row from top is the y-th column from right, starting at bottom
+  return TransposeImage(pixels, width, height, true, true);
 }
@@ -0,0 +1,362 @@
+/*
+ *      Copyright (C) 2017 Team MrMC
+ *      https://github.com/MrMC
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MrMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "PictureKernels.h"
+#include "threads/Event.h"
+#include "utils/CPUInfo.h"
+#include "utils/JobManager.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAS_KERNEL_SSE2
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#define HAS_KERNEL_NEON
+#endif
+
+// transposes walk the image in square tiles which stay in the cache
+#define KERNEL_TILE 16
+// below this many pixels waking up other workers costs more than it saves
+#define KERNEL_MIN_PARALLEL_PIXELS (512 * 1024)
+
+#if defined(HAS_KERNEL_SSE2)
+typedef __m128i PixelQuad;
+
+static inline PixelQuad LoadQuad(const uint32_t *p)
+{
+  return _mm_loadu_si128((const __m128i*)p);
+}
+
+static inline void StoreQuad(uint32_t *p, PixelQuad v)
+{
+  _mm_storeu_si128((__m128i*)p, v);
+}
+
+static inline PixelQuad ReverseQuad(PixelQuad v)
+{
+  return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+static inline void TransposeQuads(PixelQuad &v0, PixelQuad &v1, PixelQuad &v2, PixelQuad &v3)
+{
+  __m128i t0 = _mm_unpacklo_epi32(v0, v1);
+  __m128i t1 = _mm_unpacklo_epi32(v2, v3);
+  __m128i t2 = _mm_unpackhi_epi32(v0, v1);
+  __m128i t3 = _mm_unpackhi_epi32(v2, v3);
+  v0 = _mm_unpacklo_epi64(t0, t1);
+  v1 = _mm_unpackhi_epi64(t0, t1);
+  v2 = _mm_unpacklo_epi64(t2, t3);
+  v3 = _mm_unpackhi_epi64(t2, t3);
+}
+#elif defined(HAS_KERNEL_NEON)
+typedef uint32x4_t PixelQuad;
+
+static inline PixelQuad LoadQuad(const uint32_t *p)
+{
+  return vld1q_u32(p);
+}
+
+static inline void StoreQuad(uint32_t *p, PixelQuad v)
+{
+  vst1q_u32(p, v);
+}
+
+static inline PixelQuad ReverseQuad(PixelQuad v)
+{
+  v = vrev64q_u32(v);
+  return vcombine_u32(vget_high_u32(v), vget_low_u32(v));
+}
+
+static inline void TransposeQuads(PixelQuad &v0, PixelQuad &v1, PixelQuad &v2, PixelQuad &v3)
+{
+  uint32x4x2_t t01 = vtrnq_u32(v0, v1);
+  uint32x4x2_t t23 = vtrnq_u32(v2, v3);
+  v0 = vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0]));
+  v1 = vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1]));
+  v2 = vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0]));
+  v3 = vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1]));
+}
+#endif
+
+namespace
+{
+/*!
+ \brief Bands of one kernel call, run by whoever gets to them first
+ */
+class CKernelBands
+{
+public:
+  CKernelBands(unsigned int count, const std::function<void(unsigned int)> &fn)
+   : m_count(count)
+   , m_next(0)
+   , m_done(0)
+   , m_fn(fn)
+   , m_finished(true, false)
+  {
+  }
+
+  void Run()
+  {
+    unsigned int band;
+    while ((band = m_next++) < m_count)
+    {
+      m_fn(band);
+      if (++m_done == m_count)
+        m_finished.Set();
+    }
+  }
+
+  void Wait()
+  {
+    m_finished.Wait();
+  }
+
+private:
+  const unsigned int m_count;
+  std::atomic<unsigned int> m_next;
+  std::atomic<unsigned int> m_done;
+  std::function<void(unsigned int)> m_fn;
+  CEvent m_finished;
+};
+}
+
+void CPictureKernels::ParallelRows(unsigned int rows, unsigned int rowPixels,
+                                   const std::function<void(unsigned int, unsigned int)> &fn)
+{
+  unsigned int cpus = std::max(g_cpuInfo.getCPUCount(), 1);
+  if (cpus == 1 || (uint64_t)rows * rowPixels < KERNEL_MIN_PARALLEL_PIXELS)
+  {
+    fn(0, rows);
+    return;
+  }
+
+  // a few bands per cpu even out slow workers, whole tiles keep transposes blocked
+  unsigned int bandRows = (rows + cpus * 2 - 1) / (cpus * 2);
+  bandRows = (bandRows + KERNEL_TILE - 1) / KERNEL_TILE * KERNEL_TILE;
+  unsigned int count = (rows + bandRows - 1) / bandRows;
+
+  // helpers starting after we are done find no band left, so they never
+  // touch anything but the shared bands object
+  std::shared_ptr<CKernelBands> bands(new CKernelBands(count, [&](unsigned int band)
+  {
+    fn(band * bandRows, std::min(rows, (band + 1) * bandRows));
+  }));
+  for (unsigned int i = 1; i < std::min(count, cpus); i++)
+    CJobManager::GetInstance().Submit([bands]() { bands->Run(); });
+
+  bands->Run();
+  bands->Wait();
+}
+
+static inline void HalveRow(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, unsigned int dstWidth)
+{
+  unsigned int x = 0;
+#if defined(HAS_KERNEL_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i two = _mm_set1_epi16(2);
+  for (; x + 4 <= dstWidth; x += 4)
+  {
+    __m128i a0 = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+    __m128i a1 = _mm_loadu_si128((const __m128i*)(row0 + x * 8 + 16));
+    __m128i b0 = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+    __m128i b1 = _mm_loadu_si128((const __m128i*)(row1 + x * 8 + 16));
+    // vertical sums in 16 bit, two pixels per register
+    __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+    __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+    __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+    __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+    // add the neighbours, round and pack
+    __m128i h0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+    __m128i h1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+    h0 = _mm_srli_epi16(_mm_add_epi16(h0, two), 2);
+    h1 = _mm_srli_epi16(_mm_add_epi16(h1, two), 2);
+    _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_packus_epi16(h0, h1));
+  }
+#elif defined(HAS_KERNEL_NEON)
+  for (; x + 4 <= dstWidth; x += 4)
+  {
+    // even pixels in val[0], odd ones in val[1]
+    uint32x4x2_t a = vld2q_u32((const uint32_t*)(row0 + x * 8));
+    uint32x4x2_t b = vld2q_u32((const uint32_t*)(row1 + x * 8));
+    uint8x16_t a0 = vreinterpretq_u8_u32(a.val[0]), a1 = vreinterpretq_u8_u32(a.val[1]);
+    uint8x16_t b0 = vreinterpretq_u8_u32(b.val[0]), b1 = vreinterpretq_u8_u32(b.val[1]);
+    uint16x8_t lo = vaddl_u8(vget_low_u8(a0), vget_low_u8(a1));
+    lo = vaddw_u8(vaddw_u8(lo, vget_low_u8(b0)), vget_low_u8(b1));
+    uint16x8_t hi = vaddl_u8(vget_high_u8(a0), vget_high_u8(a1));
+    hi = vaddw_u8(vaddw_u8(hi, vget_high_u8(b0)), vget_high_u8(b1));
+    vst1q_u8(dst + x * 4, vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+  }
+#endif
+  for (; x < dstWidth; x++)
+  {
+    const uint8_t *p0 = row0 + x * 8;
+    const uint8_t *p1 = row1 + x * 8;
+    for (unsigned int c = 0; c < 4; c++)
+      dst[x * 4 + c] = (p0[c] + p0[c + 4] + p1[c] + p1[c + 4] + 2) >> 2;
+  }
+}
+
+void CPictureKernels::Halve(const uint8_t *src, unsigned int width, unsigned int height, unsigned int pitch,
+                            uint8_t *dst, unsigned int dstPitch)
+{
+  unsigned int dstWidth = width / 2;
+  ParallelRows(height / 2, width, [&](unsigned int begin, unsigned int end)
+  {
+    for (unsigned int y = begin; y < end; y++)
+      HalveRow(src + 2 * y * pitch, src + (2 * y + 1) * pitch, dst + y * dstPitch, dstWidth);
+  });
+}
+
+static inline void MirrorRow(uint32_t *line, unsigned int width)
+{
+  unsigned int x = 0;
+#if defined(HAS_KERNEL_SSE2) || defined(HAS_KERNEL_NEON)
+  for (; 2 * x + 8 <= width; x += 4)
+  {
+    PixelQuad left = LoadQuad(line + x);
+    PixelQuad right = LoadQuad(line + width - 4 - x);
+    StoreQuad(line + x, ReverseQuad(right));
+    StoreQuad(line + width - 4 - x, ReverseQuad(left));
+  }
+#endif
+  for (; x < width / 2; x++)
+    std::swap(line[x], line[width - 1 - x]);
+}
+
+static inline void SwapRowsMirrored(uint32_t *line1, uint32_t *line2, unsigned int width)
+{
+  unsigned int x = 0;
+#if defined(HAS_KERNEL_SSE2) || defined(HAS_KERNEL_NEON)
+  for (; x + 4 <= width; x += 4)
+  {
+    PixelQuad a = LoadQuad(line1 + x);
+    PixelQuad b = LoadQuad(line2 + width - 4 - x);
+    StoreQuad(line1 + x, ReverseQuad(b));
+    StoreQuad(line2 + width - 4 - x, ReverseQuad(a));
+  }
+#endif
+  for (; x < width; x++)
+    std::swap(line1[x], line2[width - 1 - x]);
+}
+
+void CPictureKernels::FlipHorizontal(uint32_t *pixels, unsigned int width, unsigned int height)
+{
+  ParallelRows(height, width, [&](unsigned int begin, unsigned int end)
+  {
+    for (unsigned int y = begin; y < end; y++)
+      MirrorRow(pixels + y * width, width);
+  });
+}
+
+void CPictureKernels::FlipVertical(uint32_t *pixels, unsigned int width, unsigned int height)
+{
+  ParallelRows(height / 2, width * 2, [&](unsigned int begin, unsigned int end)
+  {
+    for (unsigned int y = begin; y < end; y++)
+    {
+      uint32_t *line1 = pixels + y * width;
+      uint32_t *line2 = pixels + (height - 1 - y) * width;
+      std::swap_ranges(line1, line1 + width, line2);
+    }
+  });
+}
+
+void CPictureKernels::Rotate180(uint32_t *pixels, unsigned int width, unsigned int height)
+{
+  ParallelRows(height / 2, width * 2, [&](unsigned int begin, unsigned int end)
+  {
+    for (unsigned int y = begin; y < end; y++)
+      SwapRowsMirrored(pixels + y * width, pixels + (height - 1 - y) * width, width);
+  });
+
+  // height is odd, so flip the middle row as well
+  if (height % 2)
+    MirrorRow(pixels + (height - 1) / 2 * width, width);
+}
+
+static void TransposeTile(const uint32_t *src, unsigned int width, unsigned int height,
+                          uint32_t *dst, bool flipRows, bool flipColumns,
+                          unsigned int x0, unsigned int x1, unsigned int y0, unsigned int y1)
+{
+  const unsigned int dstWidth = height;
+  unsigned int y = y0;
+#if defined(HAS_KERNEL_SSE2) || defined(HAS_KERNEL_NEON)
+  for (; y + 4 <= y1; y += 4)
+  {
+    // four source rows give four destination columns
+    unsigned int column = flipColumns ? width - 4 - y : y;
+    unsigned int x = x0;
+    for (; x + 4 <= x1; x += 4)
+    {
+      const uint32_t *row = src + (size_t)(flipRows ? height - 1 - x : x) * width + column;
+      ptrdiff_t step = flipRows ? -(ptrdiff_t)width : width;
+      PixelQuad v0 = LoadQuad(row);
+      PixelQuad v1 = LoadQuad(row + step);
+      PixelQuad v2 = LoadQuad(row + 2 * step);
+      PixelQuad v3 = LoadQuad(row + 3 * step);
+      if (flipColumns)
+      {
+        v0 = ReverseQuad(v0);
+        v1 = ReverseQuad(v1);
+        v2 = ReverseQuad(v2);
+        v3 = ReverseQuad(v3);
+      }
+      TransposeQuads(v0, v1, v2, v3);
+      uint32_t *out = dst + (size_t)y * dstWidth + x;
+      StoreQuad(out, v0);
+      StoreQuad(out + dstWidth, v1);
+      StoreQuad(out + 2 * dstWidth, v2);
+      StoreQuad(out + 3 * dstWidth, v3);
+    }
+    for (; x < x1; x++)
+    {
+      const uint32_t *row = src + (size_t)(flipRows ? height - 1 - x : x) * width;
+      for (unsigned int i = 0; i < 4; i++)
+        dst[(size_t)(y + i) * dstWidth + x] = row[flipColumns ? width - 1 - y - i : y + i];
+    }
+  }
+#endif
+  for (; y < y1; y++)
+  {
+    uint32_t *out = dst + (size_t)y * dstWidth;
+    const uint32_t *column = src + (flipColumns ? width - 1 - y : y);
+    for (unsigned int x = x0; x < x1; x++)
+      out[x] = column[(size_t)(flipRows ? height - 1 - x : x) * width];
+  }
+}
+
+void CPictureKernels::Transpose(const uint32_t *src, unsigned int width, unsigned int height,
+                                uint32_t *dst, bool flipRows, bool flipColumns)
+{
+  // destination rows are source columns
+  ParallelRows(width, height, [&](unsigned int begin, unsigned int end)
+  {
+    for (unsigned int y = begin; y < end; y += KERNEL_TILE)
+    {
+      unsigned int y1 = std::min(y + KERNEL_TILE, end);
+      for (unsigned int x = 0; x < height; x += KERNEL_TILE)
+        TransposeTile(src, width, height, dst, flipRows, flipColumns, x, std::min(x + KERNEL_TILE, height), y, y1);
+    }
+  });
+}
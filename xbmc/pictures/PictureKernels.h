@@ -0,0 +1,67 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2017 Team MrMC
+ *      https://github.com/MrMC
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MrMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <functional>
+#include <stdint.h>
+
+/*!
+ \brief Pixel kernels for 32 bit images, used by CPicture.
+
+ Images are processed in bands of rows. Large images share the bands between
+ the calling thread and helper jobs, the caller takes whatever bands the
+ helpers haven't started, so it never waits for a job stuck in a queue.
+ SSE2 and NEON versions are used where the compiler provides them.
+ */
+class CPictureKernels
+{
+public:
+  /*!
+   \brief Halves an image with a 2x2 box filter, an odd last row or column is dropped
+   \param dst receives (width / 2) x (height / 2) pixels, must not overlap src
+   */
+  static void Halve(const uint8_t *src, unsigned int width, unsigned int height, unsigned int pitch,
+                    uint8_t *dst, unsigned int dstPitch);
+
+  /*!
+   \brief In place mirroring of contiguous images (pitch is width * 4)
+   */
+  static void FlipHorizontal(uint32_t *pixels, unsigned int width, unsigned int height);
+  static void FlipVertical(uint32_t *pixels, unsigned int width, unsigned int height);
+  static void Rotate180(uint32_t *pixels, unsigned int width, unsigned int height);
+
+  /*!
+   \brief Writes the transposed image to dst, which is height pixels wide.
+
+   Mirroring is folded into the same pass, so every 90 degree orientation
+   takes one pass over the image: dst(x, y) = src(row, column) with
+   row = flipRows ? height - 1 - x : x and column = flipColumns ? width - 1 - y : y.
+   */
+  static void Transpose(const uint32_t *src, unsigned int width, unsigned int height,
+                        uint32_t *dst, bool flipRows, bool flipColumns);
+
+  /*!
+   \brief Runs fn(begin, end) over bands covering [0, rows), in parallel if
+   the image is large enough to be worth it
+   */
+  static void ParallelRows(unsigned int rows, unsigned int rowPixels,
+                           const std::function<void(unsigned int, unsigned int)> &fn);
+};
@@ -829,6 +829,7 @@ void CSlideShowPic::Render(float *x, float *y, CBaseTexture* pTexture, color_t c
   g_graphicsContext.EndPaint();
 #elif defined(HAS_GLES)
   g_graphicsContext.BeginPaint();
+  g_Windowing.GUIQuadBatch().Flush();
   if (pTexture)
   {
     pTexture->LoadToGPU();
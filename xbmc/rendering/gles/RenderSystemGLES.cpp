@@ -156,6 +156,8 @@ bool CRenderSystemGLES::InitRenderSystem()
 
 bool CRenderSystemGLES::ResetRenderSystem(int width, int height, bool fullScreen, float refreshRate)
 {
+  m_quadBatch.Flush();
+
   m_width = width;
   m_height = height;
   
@@ -189,6 +191,8 @@ bool CRenderSystemGLES::ResetRenderSystem(int width, int height, bool fullScreen
 
 bool CRenderSystemGLES::DestroyRenderSystem()
 {
+  m_quadBatch.Destroy();
+
   CLog::Log(LOGDEBUG, "GUI Shader - Destroying Shader : %p", m_pGUIshader);
 
   if (m_pGUIshader)
@@ -233,6 +237,7 @@ bool CRenderSystemGLES::EndRender()
   if (!m_bRenderCreated)
     return false;
 
+  m_quadBatch.Flush();
   return true;
 }
 
@@ -241,6 +246,8 @@ bool CRenderSystemGLES::ClearBuffers(color_t color)
   if (!m_bRenderCreated)
     return false;
 
+  m_quadBatch.Flush();
+
   float r = GET_R(color) / 255.0f;
   float g = GET_G(color) / 255.0f;
   float b = GET_B(color) / 255.0f;
@@ -296,6 +303,9 @@ bool CRenderSystemGLES::PresentRender(const CDirtyRegionList &dirty)
   if (!m_bRenderCreated)
     return false;
 
+  m_quadBatch.Flush();
+  m_quadBatch.EndFrame();
+
   if (m_iVSyncMode != 0 && m_iSwapRate != 0) 
   {
     int64_t curr, diff, freq;
@@ -392,6 +402,7 @@ void CRenderSystemGLES::CaptureStateBlock()
   if (!m_bRenderCreated)
     return;
 
+  m_quadBatch.Flush();
   glMatrixProject.Push();
   glMatrixModview.Push();
   glMatrixTexture.Push();
@@ -407,6 +418,7 @@ void CRenderSystemGLES::ApplyStateBlock()
   if (!m_bRenderCreated)
     return;
 
+  m_quadBatch.Flush();
   glMatrixProject.PopLoad();
   glMatrixModview.PopLoad();
   glMatrixTexture.PopLoad();
@@ -421,6 +433,7 @@ void CRenderSystemGLES::SetCameraPosition(const CPoint &camera, int screenWidth,
   if (!m_bRenderCreated)
     return;
   
+  m_quadBatch.Flush();
   g_graphicsContext.BeginPaint();
   
   CPoint offset = camera - CPoint(screenWidth*0.5f, screenHeight*0.5f);
@@ -501,6 +514,7 @@ void CRenderSystemGLES::ApplyHardwareTransform(const TransformMatrix &finalMatri
   if (!m_bRenderCreated)
     return;
 
+  m_quadBatch.Flush();
   glMatrixModview.Push();
   GLfloat matrix[4][4];
 
@@ -522,6 +536,7 @@ void CRenderSystemGLES::RestoreHardwareTransform()
   if (!m_bRenderCreated)
     return;
 
+  m_quadBatch.Flush();
   glMatrixModview.PopLoad();
 }
 
@@ -548,6 +563,7 @@ void CRenderSystemGLES::SetViewPort(CRect& viewPort)
   if (!m_bRenderCreated)
     return;
 
+  m_quadBatch.Flush();
   glScissor((GLint) viewPort.x1, (GLint) (m_height - viewPort.y1 - viewPort.Height()), (GLsizei) viewPort.Width(), (GLsizei) viewPort.Height());
   glViewport((GLint) viewPort.x1, (GLint) (m_height - viewPort.y1 - viewPort.Height()), (GLsizei) viewPort.Width(), (GLsizei) viewPort.Height());
   m_viewPort[0] = viewPort.x1;
@@ -582,6 +598,7 @@ void CRenderSystemGLES::SetScissors(const CRect &rect)
 {
   if (!m_bRenderCreated)
     return;
+  m_quadBatch.Flush();
   GLint x1 = MathUtils::round_int(rect.x1);
   GLint y1 = MathUtils::round_int(rect.y1);
   GLint x2 = MathUtils::round_int(rect.x2);
@@ -633,6 +650,7 @@ void CRenderSystemGLES::InitialiseGUIShader()
 
 void CRenderSystemGLES::EnableGUIShader(ESHADERMETHOD method)
 {
+  m_quadBatch.Flush();
   m_method = method;
   if (m_pGUIshader[m_method])
   {
@@ -735,6 +753,7 @@ GLint CRenderSystemGLES::GUIShaderGetBrightness()
 
 void CRenderSystemGLES::SetStereoMode(RENDER_STEREO_MODE mode, RENDER_STEREO_VIEW view)
 {
+  m_quadBatch.Flush();
   CRenderSystemBase::SetStereoMode(mode, view);
 
   g_sysinfo.HWSetStereoMode(mode, view);
@@ -27,6 +27,7 @@
 #include "system_gl.h"
 #include "rendering/RenderSystem.h"
 #include "guilib/GUIShader.h"
+#include "guilib/GUIQuadBatchGLES.h"
 
 enum ESHADERMETHOD
 {
@@ -100,6 +101,8 @@ public:
   GLint GUIShaderGetBrightness();
   GLint GUIShaderGetModel();
 
+  CGUIQuadBatchGLES& GUIQuadBatch() { return m_quadBatch; }
+
 protected:
   virtual void SetVSyncImpl(bool enable) = 0;
   virtual bool PresentRenderImpl(const CDirtyRegionList &dirty) = 0;
@@ -123,6 +126,8 @@ protected:
   ESHADERMETHOD m_method;      // Current GUI Shader method
 
   GLint      m_viewPort[4];
+
+  CGUIQuadBatchGLES m_quadBatch; // GUI textures waiting to be drawn
 };
 
 #endif // RENDER_SYSTEM_H
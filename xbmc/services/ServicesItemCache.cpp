@@ -0,0 +1,172 @@
+/*
+ *      Copyright (C) 2017 Team MrMC
+ *      https://github.com/MrMC
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MrMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ServicesItemCache.h"
+
+#include <algorithm>
+
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "utils/JobManager.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/log.h"
+#include "utils/URIUtils.h"
+
+CServicesItemCache::CServicesItemCache(const std::string &itemsMember, const std::string &keyMember)
+: m_itemsMember(itemsMember)
+, m_keyMember(keyMember)
+, m_itemIndexValid(false)
+, m_savePending(false)
+{
+}
+
+CServicesItemCache::~CServicesItemCache()
+{
+}
+
+void CServicesItemCache::SetListing(CVariant &listing)
+{
+  m_listing = std::move(listing);
+  m_itemIndexValid = false;
+}
+
+CVariant &CServicesItemCache::GetListingItems()
+{
+  return m_listing[m_itemsMember];
+}
+
+int CServicesItemCache::FindItem(const std::string &key)
+{
+  const CVariant &items = m_listing[m_itemsMember];
+  if (!m_itemIndexValid)
+  {
+    m_itemIndex.clear();
+    m_itemIndex.reserve(items.size());
+    for (size_t k = 0; k < items.size(); ++k)
+      m_itemIndex.insert(std::make_pair(items[k][m_keyMember].asString(), k));
+    m_itemIndexValid = true;
+  }
+
+  auto it = m_itemIndex.find(key);
+  if (it == m_itemIndex.end())
+    return -1;
+  return (int)it->second;
+}
+
+void CServicesItemCache::AppendItem(const CVariant &item)
+{
+  CVariant &items = m_listing[m_itemsMember];
+  items.push_back(item);
+  if (m_itemIndexValid)
+    m_itemIndex[item[m_keyMember].asString()] = items.size() - 1;
+}
+
+bool CServicesItemCache::EraseItem(const std::string &key)
+{
+  int k = FindItem(key);
+  if (k < 0)
+    return false;
+
+  // the items after it move, the index is rebuilt when next needed
+  m_listing[m_itemsMember].erase(k);
+  m_itemIndexValid = false;
+  return true;
+}
+
+bool CServicesItemCache::ReadListing(std::string &header, CVariant &listing) const
+{
+  std::string file = GetCacheFile();
+  if (file.empty() || !XFILE::CFile::Exists(file))
+    return false;
+
+  XFILE::auto_buffer buffer;
+  if (XFILE::CFile().LoadFile(file, buffer) <= 0)
+    return false;
+
+  // the header is on the first line, the listing follows
+  const char *data = buffer.get();
+  const char *end = data + buffer.size();
+  const char *newline = std::find(data, end, '\n');
+  if (newline == end ||
+      !CJSONVariantParser::Parse(std::string(newline + 1, end), listing) ||
+      !listing.isObject() || !listing[m_itemsMember].isArray())
+  {
+    CLog::Log(LOGERROR, "CServicesItemCache::ReadListing invalid cache %s", file.c_str());
+    return false;
+  }
+
+  header.assign(data, newline);
+  return true;
+}
+
+void CServicesItemCache::SaveListing()
+{
+  if (GetCacheFile().empty())
+    return;
+
+  // changes coming in bursts are written once
+  if (m_savePending.exchange(true))
+    return;
+
+  std::shared_ptr<CServicesItemCache> cache = shared_from_this();
+  CJobManager::GetInstance().Submit([cache]()
+  {
+    cache->m_savePending = false;
+    cache->WriteListing();
+  });
+}
+
+void CServicesItemCache::DeleteListing()
+{
+  std::string file = GetCacheFile();
+  if (!file.empty())
+    XFILE::CFile::Delete(file);
+}
+
+void CServicesItemCache::WriteListing()
+{
+  std::string file;
+  std::string data;
+  {
+    CSingleLock lock(m_lock);
+    file = GetCacheFile();
+    if (file.empty())
+      return;
+
+    std::string header;
+    if (!GetHeader(header))
+    {
+      // nothing to keep, the next run fetches the listing again
+      XFILE::CFile::Delete(file);
+      return;
+    }
+
+    std::string json;
+    if (!CJSONVariantWriter::Write(m_listing, json, true))
+      return;
+    data = header + "\n" + json;
+  }
+
+  XFILE::CDirectory::Create(URIUtils::GetDirectory(file));
+  if (!XFILE::CFile::WriteAtomically(file, data.data(), data.size()))
+    CLog::Log(LOGERROR, "CServicesItemCache::WriteListing unable to write %s", file.c_str());
+}
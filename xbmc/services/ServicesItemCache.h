@@ -0,0 +1,102 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team MrMC
+ *      https://github.com/MrMC
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MrMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "utils/Variant.h"
+#include "threads/CriticalSection.h"
+
+/*!
+ \brief A listing of a media server, kept in memory and on disk.
+
+ The listing is an object with the items in one of its array members. Items
+ are found by their key through an index next to the array. The listing is
+ stored in the background behind a header line, which tells what state of
+ the server it was taken at, and read back from there on the next run.
+
+ Everything protected is called with m_lock held.
+ */
+class CServicesItemCache : public std::enable_shared_from_this<CServicesItemCache>
+{
+public:
+  virtual ~CServicesItemCache();
+
+protected:
+  /*!
+   \param itemsMember member of the listing holding the items
+   \param keyMember member of an item holding its key
+   */
+  CServicesItemCache(const std::string &itemsMember, const std::string &keyMember);
+
+  /*!
+   \brief Take over a listing, it is moved from the given variant
+   */
+  void  SetListing(CVariant &listing);
+  CVariant &GetListingItems();
+
+  /*!
+   \return position of the item in the items of the listing, -1 if it isn't there
+   */
+  int   FindItem(const std::string &key);
+  void  AppendItem(const CVariant &item);
+  bool  EraseItem(const std::string &key);
+
+  /*!
+   \brief Read the stored listing, it is up to the caller to check the header and take it over
+   */
+  bool  ReadListing(std::string &header, CVariant &listing) const;
+
+  /*!
+   \brief Store the listing, done in the background and once for changes coming in bursts
+   */
+  void  SaveListing();
+
+  /*!
+   \brief Remove the stored listing now, a job could be too late for the next read
+   */
+  void  DeleteListing();
+
+  /*!
+   \return path of the stored listing, empty if it isn't stored
+   */
+  virtual const std::string GetCacheFile() const = 0;
+
+  /*!
+   \param header [out] first line of the stored listing
+   \return false if there is nothing to store, the stored listing is removed then
+   */
+  virtual bool  GetHeader(std::string &header) = 0;
+
+  CVariant m_listing;
+  CCriticalSection m_lock;
+
+private:
+  void  WriteListing();
+
+  const std::string m_itemsMember;
+  const std::string m_keyMember;
+  std::unordered_map<std::string, size_t> m_itemIndex;  // position of the items by key
+  bool m_itemIndexValid;
+  std::atomic<bool> m_savePending;
+};
@@ -116,6 +116,74 @@ protected:
   CEvent &m_event;
 };
 
+// items of a view are fetched in pages, a few at the same time
+static const int ViewItemsPageSize = 1000;
+static const int ViewItemsPageFetches = 4;
+
+class CEmbyViewItemsPages
+{
+public:
+  CEmbyViewItemsPages(const CURL &url, int count)
+  : m_url(url)
+  , m_pages(count)
+  , m_next(0)
+  , m_done(0)
+  , m_failed(false)
+  , m_finished(true, false)
+  {
+  }
+
+  // fetch pages until none is left, the caller runs this too and takes
+  // whatever the helper jobs haven't started, so it never waits on a queued job
+  void Run()
+  {
+    unsigned int page;
+    while ((page = m_next++) < m_pages.size())
+    {
+      CURL curl(m_url);
+      curl.SetOption("StartIndex", StringUtils::Format("%u", page * ViewItemsPageSize));
+      curl.SetOption("Limit", StringUtils::Format("%d", ViewItemsPageSize));
+      CVariant variant = CEmbyUtils::GetEmbyCVariant(curl.Get());
+      if (variant.isObject() && variant["Items"].isArray())
+        m_pages[page] = std::move(variant["Items"]);
+      else
+        m_failed = true;
+
+      if (++m_done == m_pages.size())
+        m_finished.Set();
+    }
+  }
+
+  void Wait()
+  {
+    if (!m_pages.empty())
+      m_finished.Wait();
+  }
+
+  bool Failed() const { return m_failed; }
+  std::vector<CVariant> &GetPages() { return m_pages; }
+
+private:
+  const CURL m_url;
+  std::vector<CVariant> m_pages;
+  std::atomic<unsigned int> m_next;
+  std::atomic<unsigned int> m_done;
+  std::atomic<bool> m_failed;
+  CEvent m_finished;
+};
+
+// fetch the pages of a listing of total items, some of them in jobs
+static std::shared_ptr<CEmbyViewItemsPages> FetchViewPages(const CURL &url, int total)
+{
+  int pageCount = (total + ViewItemsPageSize - 1) / ViewItemsPageSize;
+  std::shared_ptr<CEmbyViewItemsPages> pages(new CEmbyViewItemsPages(url, pageCount));
+  for (int i = 1; i < std::min(pageCount, ViewItemsPageFetches); i++)
+    CJobManager::GetInstance().Submit([pages]() { pages->Run(); });
+  pages->Run();
+  pages->Wait();
+  return pages;
+}
+
 CEmbyClient::CEmbyClient()
 {
   m_local = true;
@@ -266,14 +334,13 @@ void CEmbyClient::SetUnWatched(CFileItem &item)
 void CEmbyClient::UpdateLibrary(const std::string &content)
 {
   bool viewHit = false;
-  CVariant nullvariant(CVariant::VariantTypeNull);
   if (content == "movies")
   {
     CSingleLock lock(m_viewMoviesLock);
     for (auto &view : m_viewMovies)
     {
       viewHit = true;
-      view->SetItems(nullvariant);
+      view->ClearItems();
     }
   }
   else if (content == "tvshows")
@@ -282,7 +349,7 @@ void CEmbyClient::UpdateLibrary(const std::string &content)
     for (auto &view : m_viewTVShows)
     {
       viewHit = true;
-      view->SetItems(nullvariant);
+      view->ClearItems();
     }
   }
   if (viewHit)
@@ -682,6 +749,7 @@ bool CEmbyClient::FetchViews()
       libraryView.serverId = view[PropertyViewServerID].asString();
       libraryView.iconId = view["ImageTags"]["Primary"].asString();
       libraryView.mediaType = type;
+      libraryView.userId = m_serverInfo.UserId;
       if (libraryView.id.empty() || libraryView.name.empty())
         continue;
 
@@ -783,7 +851,73 @@ bool CEmbyClient::FetchViewItems(CEmbyViewCachePtr &view, const CURL &url, const
     //return false;
   }
   std::string path = curl.Get();
-  CVariant variant = CEmbyUtils::GetEmbyCVariant(path);
+  CVariant variant;
+  if (type == EmbyTypeMovie || type == EmbyTypeSeries || type == EmbyTypeMusicArtist)
+  {
+    // pages need a stable order
+    curl.SetOption("SortBy", "SortName");
+    curl.SetOption("SortOrder", "Ascending");
+
+    // the count of the items tells how many pages there are and
+    // whether the copy stored for the current etag of the view is still good
+    CURL countUrl(curl);
+    countUrl.SetOption("StartIndex", "0");
+    countUrl.SetOption("Limit", "0");
+    CVariant count = CEmbyUtils::GetEmbyCVariant(countUrl.Get());
+    if (!count.isObject() || !count.isMember("TotalRecordCount"))
+    {
+      CLog::Log(LOGERROR, "CEmbyClient::FetchViewItems: invalid response for views items from %s", CURL::GetRedacted(path).c_str());
+      return false;
+    }
+
+    int total = (int)count["TotalRecordCount"].asInteger();
+    if (view && view->LoadItems())
+    {
+      if (view->ItemsValid() && (int)view->GetItems()["Items"].size() == total)
+      {
+        CLog::Log(LOGDEBUG, "CEmbyClient::FetchViewItems using stored items for view %s", view->GetName().c_str());
+
+        // played state changed by other clients doesn't change the etag of the view,
+        // take it over from a listing that carries nothing else
+        CURL userDataUrl(curl);
+        userDataUrl.SetOption("Fields", "Etag");
+        userDataUrl.SetOption("EnableImages", "false");
+        userDataUrl.SetOption("EnableUserData", "true");
+        std::shared_ptr<CEmbyViewItemsPages> userData = FetchViewPages(userDataUrl, total);
+        if (userData->Failed())
+          CLog::Log(LOGERROR, "CEmbyClient::FetchViewItems: unable to refresh user data from %s", CURL::GetRedacted(path).c_str());
+        for (const auto &page : userData->GetPages())
+          view->UpdateUserData(page);
+        return rtn;
+      }
+      CVariant nullvariant(CVariant::VariantTypeNull);
+      view->SetItems(nullvariant);
+    }
+
+    std::shared_ptr<CEmbyViewItemsPages> pages = FetchViewPages(curl, total);
+
+    if (pages->Failed())
+    {
+      CLog::Log(LOGERROR, "CEmbyClient::FetchViewItems: invalid response for views items from %s", CURL::GetRedacted(path).c_str());
+      return false;
+    }
+
+    variant = CVariant(CVariant::VariantTypeObject);
+    variant["Items"] = CVariant(CVariant::VariantTypeArray);
+    CVariant &items = variant["Items"];
+    for (auto &page : pages->GetPages())
+    {
+      for (auto itemIt = page.begin_array(); itemIt != page.end_array(); ++itemIt)
+        items.push_back(std::move(*itemIt));
+      page.clear();
+    }
+    variant["TotalRecordCount"] = (int)items.size();
+  }
+  else
+  {
+    variant = CEmbyUtils::GetEmbyCVariant(path);
+  }
+
   if (variant.isNull())
   {
     CLog::Log(LOGERROR, "CEmbyClient::FetchViewItems: invalid response for views items from %s", CURL::GetRedacted(path).c_str());
@@ -791,7 +925,10 @@ bool CEmbyClient::FetchViewItems(CEmbyViewCachePtr &view, const CURL &url, const
   }
 
   if (view)
+  {
     view->SetItems(variant);
+    view->SaveItems();
+  }
   return rtn;
 }
 
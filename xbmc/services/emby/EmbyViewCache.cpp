@@ -22,10 +22,15 @@
 
 #include "EmbyUtils.h"
 #include "threads/SingleLock.h"
+#include "utils/Crc32.h"
 #include "utils/log.h"
+#include "utils/StringUtils.h"
 
+#define EMBY_VIEW_CACHE_PATH "special://temp/emby/"
 
 CEmbyViewCache::CEmbyViewCache()
+: CServicesItemCache("Items", "Id")
+, m_loadTried(false)
 {
 }
 
@@ -35,105 +40,89 @@ CEmbyViewCache::~CEmbyViewCache()
 
 void CEmbyViewCache::Init(const EmbyViewContent &content)
 {
-  CSingleLock lock(m_cacheLock);
+  CSingleLock lock(m_lock);
   m_cache = content;
+  SetListing(m_cache.items);
 }
 
 const std::string CEmbyViewCache::GetId() const
 {
-  CSingleLock lock(m_cacheLock);
+  CSingleLock lock(m_lock);
   return m_cache.id;
 }
 
 const std::string CEmbyViewCache::GetName() const
 {
-  CSingleLock lock(m_cacheLock);
+  CSingleLock lock(m_lock);
   return m_cache.name;
 }
 
 void CEmbyViewCache::SetItems(CVariant &variant)
 {
-  CSingleLock lock(m_cacheLock);
-  m_cache.items = std::move(variant);
+  CSingleLock lock(m_lock);
+  SetListing(variant);
 }
 
 CVariant& CEmbyViewCache::GetItems()
 {
-  CSingleLock lock(m_cacheLock);
-  return m_cache.items;
+  CSingleLock lock(m_lock);
+  return m_listing;
 }
 
 bool CEmbyViewCache::ItemsValid()
 {
-  CSingleLock lock(m_cacheLock);
-  if (m_cache.items.isNull())
+  CSingleLock lock(m_lock);
+  if (m_listing.isNull())
     return false;
 
-  if (!m_cache.items.isObject())
+  if (!m_listing.isObject())
     return false;
 
-  if (!m_cache.items.isMember("Items"))
+  if (!m_listing.isMember("Items"))
     return false;
 
-  if (!m_cache.items["Items"].isArray())
+  if (!m_listing["Items"].isArray())
     return false;
 
-  return m_cache.items["Items"].size() > 0;
+  return m_listing["Items"].size() > 0;
 }
 
 bool CEmbyViewCache::AppendItem(const CVariant &variant)
 {
-  bool exists = false;
-  CSingleLock lock(m_cacheLock);
-  const auto& variantItems = m_cache.items["Items"];
-  for (auto variantItemIt = variantItems.begin_array(); variantItemIt != variantItems.end_array(); ++variantItemIt)
-  {
-    if (variant["Id"] == (*variantItemIt)["Id"].asString())
-    {
-      exists = true;
-      break;
-    }
-  }
-  if (!exists)
-  {
-    m_cache.items["Items"].push_back(variant);
-    return true;
-  }
+  CSingleLock lock(m_lock);
+  if (FindItem(variant["Id"].asString()) >= 0)
+    return false;
 
-  return false;
+  CServicesItemCache::AppendItem(variant);
+  SaveListing();
+  return true;
 }
 
 bool CEmbyViewCache::UpdateItem(const CVariant &variant)
 {
-  CSingleLock lock(m_cacheLock);
-  for (size_t k = 0; k < m_cache.items["Items"].size(); ++k)
-  {
-    if (variant["Id"] == m_cache.items["Items"][k]["Id"].asString())
-    {
-      m_cache.items["Items"][k] = variant;
-      return true;
-    }
-  }
-  return false;
+  CSingleLock lock(m_lock);
+  int k = FindItem(variant["Id"].asString());
+  if (k < 0)
+    return false;
+
+  GetListingItems()[k] = variant;
+  SaveListing();
+  return true;
 }
 
 bool CEmbyViewCache::RemoveItem(const std::string &itemId)
 {
-  CSingleLock lock(m_cacheLock);
-  for (size_t k = 0; k < m_cache.items["Items"].size(); ++k)
-  {
-    if (itemId == m_cache.items["Items"][k]["Id"].asString())
-    {
-      m_cache.items["Items"].erase(k);
-      return true;
-    }
-  }
-  return false;
+  CSingleLock lock(m_lock);
+  if (!EraseItem(itemId))
+    return false;
+
+  SaveListing();
+  return true;
 }
 
 const EmbyViewInfo CEmbyViewCache::GetInfo() const
 {
-  CSingleLock lock(m_cacheLock);
+  CSingleLock lock(m_lock);
   EmbyViewInfo info;
   info.id = m_cache.id;
   info.name = m_cache.name;
@@ -144,34 +133,103 @@ const EmbyViewInfo CEmbyViewCache::GetInfo() const
 
 bool CEmbyViewCache::SetWatched(const std::string id, int playcount, double resumetime)
 {
-  CSingleLock lock(m_cacheLock);
-  for (size_t k = 0; k < m_cache.items["Items"].size(); ++k)
-  {
-    if (id == m_cache.items["Items"][k]["Id"].asString())
-    {
-      // do it the long way or the value will not get updated
-      m_cache.items["Items"][k]["UserData"]["Played"] = true;
-      m_cache.items["Items"][k]["UserData"]["PlayCount"] = playcount;
-      m_cache.items["Items"][k]["UserData"]["PlaybackPositionTicks"] = CEmbyUtils::SecondsToTicks(resumetime);
-      return true;
-    }
-  }
-  return false;
+  CSingleLock lock(m_lock);
+  int k = FindItem(id);
+  if (k < 0)
+    return false;
+
+  // do it the long way or the value will not get updated
+  CVariant &items = GetListingItems();
+  items[k]["UserData"]["Played"] = true;
+  items[k]["UserData"]["PlayCount"] = playcount;
+  items[k]["UserData"]["PlaybackPositionTicks"] = CEmbyUtils::SecondsToTicks(resumetime);
+  SaveListing();
+  return true;
 }
 
 bool CEmbyViewCache::SetUnWatched(const std::string id)
 {
-  CSingleLock lock(m_cacheLock);
-  for (size_t k = 0; k < m_cache.items["Items"].size(); ++k)
+  CSingleLock lock(m_lock);
+  int k = FindItem(id);
+  if (k < 0)
+    return false;
+
+  // do it the long way or the value will not get updated
+  CVariant &items = GetListingItems();
+  items[k]["UserData"]["Played"] = false;
+  items[k]["UserData"]["PlayCount"] = 0;
+  items[k]["UserData"]["PlaybackPositionTicks"] = 0;
+  SaveListing();
+  return true;
+}
+
+bool CEmbyViewCache::UpdateUserData(const CVariant &items)
+{
+  CSingleLock lock(m_lock);
+  bool found = false;
+  for (auto variantIt = items.begin_array(); variantIt != items.end_array(); ++variantIt)
   {
-    if (id == m_cache.items["Items"][k]["Id"].asString())
-    {
-      // do it the long way or the value will not get updated
-      m_cache.items["Items"][k]["UserData"]["Played"] = false;
-      m_cache.items["Items"][k]["UserData"]["PlayCount"] = 0;
-      m_cache.items["Items"][k]["UserData"]["PlaybackPositionTicks"] = 0;
-      return true;
-    }
+    const CVariant &item = *variantIt;
+    if (!item.isMember("UserData"))
+      continue;
+
+    int k = FindItem(item["Id"].asString());
+    if (k < 0)
+      continue;
+
+    GetListingItems()[k]["UserData"] = item["UserData"];
+    found = true;
   }
-  return false;
+  if (found)
+    SaveListing();
+  return found;
+}
+
+bool CEmbyViewCache::LoadItems()
+{
+  CSingleLock lock(m_lock);
+  if (m_loadTried)
+    return false;
+  m_loadTried = true;
+
+  std::string etag;
+  CVariant items;
+  if (!ReadListing(etag, items) || etag != m_cache.etag)
+    return false;
+
+  SetListing(items);
+  return true;
+}
+
+void CEmbyViewCache::ClearItems()
+{
+  CSingleLock lock(m_lock);
+  CVariant items(CVariant::VariantTypeNull);
+  SetListing(items);
+  DeleteListing();
+}
+
+void CEmbyViewCache::SaveItems()
+{
+  SaveListing();
+}
+
+bool CEmbyViewCache::GetHeader(std::string &header)
+{
+  if (!ItemsValid())
+    return false;
+
+  header = m_cache.etag;
+  return true;
+}
+
+const std::string CEmbyViewCache::GetCacheFile() const
+{
+  // only library views have an id and an etag to check a stored copy against
+  CSingleLock lock(m_lock);
+  if (m_cache.id.empty() || m_cache.etag.empty())
+    return "";
+
+  std::string key = m_cache.serverId + "/" + m_cache.userId + "/" + m_cache.id;
+  return StringUtils::Format(EMBY_VIEW_CACHE_PATH "%08x.json", (uint32_t)Crc32::Compute(key));
 }
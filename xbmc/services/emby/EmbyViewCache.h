@@ -20,10 +20,9 @@
  */
 
 #include <string>
-#include <vector>
 
+#include "services/ServicesItemCache.h"
 #include "utils/Variant.h"
-#include "threads/CriticalSection.h"
 
 typedef struct EmbyViewInfo
 {
@@ -42,10 +41,18 @@ typedef struct EmbyViewContent
   std::string serverId;
   std::string mediaType;
   std::string iconId;
+  std::string userId;
   CVariant items;
 } EmbyViewContent;
 
-class CEmbyViewCache
+/*!
+ \brief The items of an Emby library view.
+
+ Items are found by id. A copy of the items is kept in special://temp/emby/
+ together with the etag of the view, so the next run can use it as long as
+ the view is unchanged.
+ */
+class CEmbyViewCache : public CServicesItemCache
 {
 public:
   CEmbyViewCache();
@@ -64,9 +71,37 @@ public:
   bool  SetWatched(const std::string id, int playcount, double resumetime);
   bool  SetUnWatched(const std::string id);
 
+  /*!
+   \brief Take the UserData of the given items over to the items with the same id
+   \return true if any item was found
+   */
+  bool  UpdateUserData(const CVariant &items);
+
+  /*!
+   \brief Use the items stored by an earlier run, if they were stored for the current etag of the view.
+   Only the first call does anything, the etag isn't updated while running so it can't tell
+   whether items stored later on are still good.
+   \return true if the items were loaded
+   */
+  bool  LoadItems();
+
+  /*!
+   \brief Drop the items and the stored copy of them, the next fetch gets them from the server
+   */
+  void  ClearItems();
+
+  /*!
+   \brief Store the items for the next run, done in the background
+   */
+  void  SaveItems();
+
   const EmbyViewInfo GetInfo() const;
 
+protected:
+  virtual const std::string GetCacheFile() const;
+  virtual bool  GetHeader(std::string &header);
+
 private:
-  EmbyViewContent m_cache;
-  CCriticalSection m_cacheLock;
+  EmbyViewContent m_cache;  // the items are kept in m_listing
+  bool m_loadTried;
 };
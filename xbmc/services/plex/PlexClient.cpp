@@ -25,17 +25,24 @@
 #include "PlexClient.h"
 #include "PlexUtils.h"
 #include "PlexClientSync.h"
+#include "PlexSectionCache.h"
+#include "PlexServices.h"
 
 #include "Application.h"
+#include "GUIUserMessages.h"
 #include "URL.h"
 #include "filesystem/CurlFile.h"
+#include "filesystem/DirectoryCache.h"
 #include "filesystem/StackDirectory.h"
 #include "network/Network.h"
+#include "guilib/GUIWindowManager.h"
 #include "settings/Settings.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 #include "utils/Base64URL.h"
+#include "utils/Variant.h"
 #include "video/VideoInfoTag.h"
 
 #include <string>
@@ -248,33 +255,16 @@ bool CPlexClient::ParseSections(enum PlexSectionParsing parser)
     if (parser == PlexSectionParsing::newSection)
       CLog::Log(LOGDEBUG, "CPlexClient::ParseSections %d, %s", parser, strResponse.c_str());
 #endif
-    if (parser == PlexSectionParsing::updateSection)
-    {
-      {
-        CSingleLock lock(m_criticalMovies);
-        m_movieSectionsContents.clear();
-      }
-      {
-        CSingleLock lock(m_criticalTVShow);
-        m_showSectionsContents.clear();
-      }
-      {
-        CSingleLock lock(m_criticalArtist);
-        m_artistSectionsContents.clear();
-      }
-      {
-        CSingleLock lock(m_criticalPhoto);
-        m_photoSectionsContents.clear();
-      }
-      m_needUpdate = false;
-    }
-
     TiXmlDocument xml;
     xml.Parse(strResponse.c_str());
 
     TiXmlElement* MediaContainer = xml.RootElement();
     if (MediaContainer)
     {
+      PlexSectionsContentVector movieContents;
+      PlexSectionsContentVector showContents;
+      PlexSectionsContentVector artistContents;
+      PlexSectionsContentVector photoContents;
       const TiXmlElement* DirectoryNode = MediaContainer->FirstChildElement("Directory");
       while (DirectoryNode)
       {
@@ -293,109 +283,13 @@ bool CPlexClient::ParseSections(enum PlexSectionParsing parser)
         else
           content.art = content.section + "/resources/" + URIUtils::GetFileName(art);
         if (content.type == "movie")
-        {
-          if (parser == PlexSectionParsing::checkSection)
-          {
-            CSingleLock lock(m_criticalMovies);
-            for (const auto &contents : m_movieSectionsContents)
-            {
-              if (contents.uuid == content.uuid)
-              {
-                if (contents.updatedAt != content.updatedAt)
-                {
-#if defined(PLEX_DEBUG_VERBOSE)
-                  CLog::Log(LOGDEBUG, "CPlexClient::ParseSections need update on %s:%s",
-                    m_serverName.c_str(), content.title.c_str());
-#endif
-                  m_needUpdate = true;
-                }
-              }
-            }
-          }
-          else
-          {
-            CSingleLock lock(m_criticalMovies);
-            m_movieSectionsContents.push_back(content);
-          }
-        }
+          movieContents.push_back(content);
         else if (content.type == "show")
-        {
-          if (parser == PlexSectionParsing::checkSection)
-          {
-            CSingleLock lock(m_criticalTVShow);
-            for (const auto &contents : m_showSectionsContents)
-            {
-              if (contents.uuid == content.uuid)
-              {
-                if (contents.updatedAt != content.updatedAt)
-                {
-#if defined(PLEX_DEBUG_VERBOSE)
-                  CLog::Log(LOGDEBUG, "CPlexClient::ParseSections need update on %s:%s",
-                    m_serverName.c_str(), content.title.c_str());
-#endif
-                  m_needUpdate = true;
-                }
-              }
-            }
-          }
-          else
-          {
-            CSingleLock lock(m_criticalTVShow);
-            m_showSectionsContents.push_back(content);
-          }
-        }
+          showContents.push_back(content);
         else if (content.type == "artist")
-        {
-          if (parser == PlexSectionParsing::checkSection)
-          {
-            CSingleLock lock(m_criticalArtist);
-            for (const auto &contents : m_artistSectionsContents)
-            {
-              if (contents.uuid == content.uuid)
-              {
-                if (contents.updatedAt != content.updatedAt)
-                {
-#if defined(PLEX_DEBUG_VERBOSE)
-                  CLog::Log(LOGDEBUG, "CPlexClient::ParseSections need update on %s:%s",
-                            m_serverName.c_str(), content.title.c_str());
-#endif
-                  m_needUpdate = true;
-                }
-              }
-            }
-          }
-          else
-          {
-            CSingleLock lock(m_criticalArtist);
-            m_artistSectionsContents.push_back(content);
-          }
-        }
+          artistContents.push_back(content);
         else if (content.type == "photo")
-        {
-          if (parser == PlexSectionParsing::checkSection)
-          {
-            CSingleLock lock(m_criticalPhoto);
-            for (const auto &contents : m_photoSectionsContents)
-            {
-              if (contents.uuid == content.uuid)
-              {
-                if (contents.updatedAt != content.updatedAt)
-                {
-#if defined(PLEX_DEBUG_VERBOSE)
-                  CLog::Log(LOGDEBUG, "CPlexClient::ParseSections need update on %s:%s",
-                            m_serverName.c_str(), content.title.c_str());
-#endif
-                  m_needUpdate = true;
-                }
-              }
-            }
-          }
-          else
-          {
-            CSingleLock lock(m_criticalPhoto);
-            m_photoSectionsContents.push_back(content);
-          }
-        }
+          photoContents.push_back(content);
         else
         {
           CLog::Log(LOGDEBUG, "CPlexClient::ParseSections %s found unhandled content type %s",
@@ -404,6 +298,15 @@ bool CPlexClient::ParseSections(enum PlexSectionParsing parser)
         DirectoryNode = DirectoryNode->NextSiblingElement("Directory");
       }
 
+      bool needUpdate = UpdateSectionsContents(m_criticalMovies, m_movieSectionsContents, movieContents, parser);
+      needUpdate |= UpdateSectionsContents(m_criticalTVShow, m_showSectionsContents, showContents, parser);
+      needUpdate |= UpdateSectionsContents(m_criticalArtist, m_artistSectionsContents, artistContents, parser);
+      needUpdate |= UpdateSectionsContents(m_criticalPhoto, m_photoSectionsContents, photoContents, parser);
+      if (parser == PlexSectionParsing::checkSection && needUpdate)
+        m_needUpdate = true;
+      else if (parser == PlexSectionParsing::updateSection)
+        m_needUpdate = false;
+
       if (parser == PlexSectionParsing::newSection)
       {
         CLog::Log(LOGDEBUG, "CPlexClient::ParseSections %s found %d movie sections",
@@ -441,21 +344,13 @@ bool CPlexClient::ParseSections(enum PlexSectionParsing parser)
     if (parser == PlexSectionParsing::newSection)
       CLog::Log(LOGDEBUG, "CPlexClient::ParseSections %d, %s", parser, strResponse.c_str());
 #endif
-    if (parser == PlexSectionParsing::updateSection)
-    {
-      {
-        CSingleLock lock(m_criticalPlaylist);
-        m_playlistSectionsContents.clear();
-      }
-      m_needUpdate = false;
-    }
-    
     TiXmlDocument xml;
     xml.Parse(strResponse.c_str());
     
     TiXmlElement* MediaContainer = xml.RootElement();
     if (MediaContainer)
     {
+      PlexSectionsContentVector playlistContents;
       const TiXmlElement* PlaylistNode = MediaContainer->FirstChildElement("Playlist");
       while (PlaylistNode)
       {
@@ -475,31 +370,7 @@ bool CPlexClient::ParseSections(enum PlexSectionParsing parser)
         std::string art = XMLUtils::GetAttribute(PlaylistNode, "art");
         content.art = content.thumb;
         if (content.type == "playlist")
-        {
-          if (parser == PlexSectionParsing::checkSection)
-          {
-            CSingleLock lock(m_criticalPlaylist);
-            for (const auto &contents : m_playlistSectionsContents)
-            {
-              if (contents.uuid == content.uuid)
-              {
-                if (contents.updatedAt != content.updatedAt)
-                {
-#if defined(PLEX_DEBUG_VERBOSE)
-                  CLog::Log(LOGDEBUG, "CPlexClient::ParseSections need update on %s:%s",
-                            m_serverName.c_str(), content.title.c_str());
-#endif
-                  m_needUpdate = true;
-                }
-              }
-            }
-          }
-          else
-          {
-            CSingleLock lock(m_criticalPlaylist);
-            m_playlistSectionsContents.push_back(content);
-          }
-        }
+          playlistContents.push_back(content);
         else
         {
           CLog::Log(LOGDEBUG, "CPlexClient::ParseSections Playlists %s found unhandled content type %s",
@@ -507,7 +378,13 @@ bool CPlexClient::ParseSections(enum PlexSectionParsing parser)
         }
         PlaylistNode = PlaylistNode->NextSiblingElement("Playlist");
       }
-      
+
+      bool needUpdate = UpdateSectionsContents(m_criticalPlaylist, m_playlistSectionsContents, playlistContents, parser);
+      if (parser == PlexSectionParsing::checkSection && needUpdate)
+        m_needUpdate = true;
+      else if (parser == PlexSectionParsing::updateSection)
+        m_needUpdate = false;
+
       if (parser == PlexSectionParsing::newSection)
       {
         CLog::Log(LOGDEBUG, "CPlexClient::ParseSections %s found %d playlist sections",
@@ -532,6 +409,196 @@ bool CPlexClient::ParseSections(enum PlexSectionParsing parser)
   return rtn;
 }
 
+bool CPlexClient::UpdateSectionsContents(CCriticalSection &critical, PlexSectionsContentVector &contents,
+  PlexSectionsContentVector &newContents, enum PlexSectionParsing parser)
+{
+  // sections that are new, gone or have another updatedAt
+  bool needUpdate = false;
+  PlexSectionsContentVector changedContents;
+  std::vector<std::string> removedSections;
+  {
+    CSingleLock lock(critical);
+    for (const auto &content : newContents)
+    {
+      auto it = std::find_if(contents.begin(), contents.end(),
+        [&content](const PlexSectionsContent &old) { return old.uuid == content.uuid; });
+      if (it == contents.end())
+        needUpdate = true;
+      else if (it->updatedAt != content.updatedAt)
+      {
+#if defined(PLEX_DEBUG_VERBOSE)
+        CLog::Log(LOGDEBUG, "CPlexClient::ParseSections need update on %s:%s",
+          m_serverName.c_str(), content.title.c_str());
+#endif
+        needUpdate = true;
+        changedContents.push_back(content);
+      }
+    }
+    for (const auto &content : contents)
+    {
+      auto it = std::find_if(newContents.begin(), newContents.end(),
+        [&content](const PlexSectionsContent &now) { return now.uuid == content.uuid; });
+      if (it == newContents.end())
+      {
+        needUpdate = true;
+        removedSections.push_back(content.section);
+      }
+    }
+
+    if (parser == PlexSectionParsing::checkSection)
+      return needUpdate;
+
+    // replaced as a whole, browsing never sees a half filled list
+    contents.swap(newContents);
+  }
+
+  // the snapshots of sections browsed so far take the changes only,
+  // others catch up when they are browsed
+  for (const auto &content : changedContents)
+  {
+    std::shared_ptr<CPlexSectionCache> cache = FindSectionCache(content.section);
+    if (cache)
+      cache->Sync(m_url, content.updatedAt);
+  }
+  for (const auto &removedSection : removedSections)
+  {
+    std::shared_ptr<CPlexSectionCache> cache = FindSectionCache(removedSection);
+    if (cache)
+    {
+      cache->Delete();
+      CSingleLock lock(m_criticalSectionCaches);
+      m_sectionCaches.erase(removedSection);
+    }
+  }
+
+  return needUpdate;
+}
+
+bool CPlexClient::GetSectionContainer(const std::string &url, CVariant &container)
+{
+  CURL curl(url);
+  std::string section = curl.GetFileName();
+  removeLeadingSlash(section);
+  if (!StringUtils::EndsWith(section, "/all"))
+    return false;
+  section.erase(section.size() - 4);
+
+  // filtered or paged listings are fetched as they are
+  std::map<std::string, std::string> options;
+  curl.GetProtocolOptions(options);
+  options.erase("X-Plex-Token");
+  if (!options.empty() || !curl.GetOptions().empty())
+    return false;
+
+  PlexSectionsContent content;
+  if (!FindSectionContent(section, content))
+    return false;
+
+  std::shared_ptr<CPlexSectionCache> cache;
+  {
+    CSingleLock lock(m_criticalSectionCaches);
+    auto it = m_sectionCaches.find(section);
+    if (it == m_sectionCaches.end())
+    {
+      cache.reset(new CPlexSectionCache(m_uuid, section, content.type));
+      m_sectionCaches[section] = cache;
+    }
+    else
+      cache = it->second;
+  }
+
+  if (!cache->Get(m_url, content.updatedAt, container))
+    return false;
+
+  if (cache->NeedSync(content.updatedAt))
+  {
+    // the snapshot of an earlier run is shown right away, the changes follow
+    std::string serverUrl = m_url;
+    std::string updatedAt = content.updatedAt;
+    CJobManager::GetInstance().Submit([cache, serverUrl, updatedAt]()
+    {
+      if (cache->Sync(serverUrl, updatedAt))
+      {
+        g_directoryCache.Clear();
+        if (CPlexServices::GetInstance().GetPlayState() == MediaServicesPlayerState::stopped)
+        {
+          CGUIMessage msg(GUI_MSG_NOTIFY_ALL, 0, 0, GUI_MSG_UPDATE);
+          g_windowManager.SendThreadMessage(msg);
+        }
+      }
+    });
+  }
+
+  return true;
+}
+
+bool CPlexClient::UpdateSectionItem(const std::string &ratingKey)
+{
+  if (ratingKey.empty())
+    return false;
+
+  CURL curl(m_url);
+  curl.SetFileName("library/metadata/" + ratingKey);
+  CVariant variant = CPlexUtils::GetPlexCVariant(curl.Get());
+  if (variant.isNull() || !variant.isObject() || !variant.isMember("MediaContainer"))
+    return false;
+
+  const CVariant &mediaContainer = variant["MediaContainer"];
+  CVariant item = mediaContainer.isMember("Video") ? mediaContainer["Video"] : mediaContainer["Directory"];
+  if (item.isArray())
+    item = item.empty() ? CVariant() : item[0];
+  if (!item.isObject())
+    return false;
+
+  // episodes are not listed, their show is and counts them as watched or not
+  if (item["type"].asString() == "episode")
+    return UpdateSectionItem(item["grandparentRatingKey"].asString());
+
+  std::string sectionId = item["librarySectionID"].asString();
+  if (sectionId.empty())
+    sectionId = mediaContainer["librarySectionID"].asString();
+  std::shared_ptr<CPlexSectionCache> cache = FindSectionCache("library/sections/" + sectionId);
+  return cache && cache->UpdateItem(item);
+}
+
+void CPlexClient::ClearSectionCaches()
+{
+  CSingleLock lock(m_criticalSectionCaches);
+  for (const auto &cache : m_sectionCaches)
+    cache.second->Delete();
+  m_sectionCaches.clear();
+}
+
+bool CPlexClient::FindSectionContent(const std::string &section, PlexSectionsContent &content)
+{
+  auto find = [&section, &content](CCriticalSection &lock, const PlexSectionsContentVector &contents)
+  {
+    CSingleLock contentsLock(lock);
+    for (const auto &sectionContent : contents)
+    {
+      if (sectionContent.section == section)
+      {
+        content = sectionContent;
+        return true;
+      }
+    }
+    return false;
+  };
+
+  return find(m_criticalMovies, m_movieSectionsContents) ||
+         find(m_criticalTVShow, m_showSectionsContents) ||
+         find(m_criticalArtist, m_artistSectionsContents);
+}
+
+std::shared_ptr<CPlexSectionCache> CPlexClient::FindSectionCache(const std::string &section)
+{
+  CSingleLock lock(m_criticalSectionCaches);
+  auto it = m_sectionCaches.find(section);
+  if (it == m_sectionCaches.end())
+    return nullptr;
+  return it->second;
+}
+
 void CPlexClient::SetPresence(bool presence)
 {
   if (m_presence != presence)
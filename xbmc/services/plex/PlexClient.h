@@ -20,6 +20,7 @@
  */
 
 #include <atomic>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -80,6 +81,8 @@ class CFileItem;
 typedef std::shared_ptr<CFileItem> CFileItemPtr;
 typedef std::vector<PlexSectionsContent> PlexSectionsContentVector;
 class CPlexClientSync;
+class CPlexSectionCache;
+class CVariant;
 
 
 class CPlexClient
@@ -118,6 +121,24 @@ public:
   const PlexSectionsContentVector GetPlaylistContent() const;
   const std::string FormatContentTitle(const std::string contentTitle) const;
 
+  /*!
+   \brief Get the listing of a movie, show or artist section from its snapshot, see CPlexSectionCache
+   \param url url of library/sections/<key>/all, filtered or paged listings are not kept
+   \param container [out] the MediaContainer of the listing
+   \return false if the url is not a kept listing or the section can't be listed
+   */
+  bool GetSectionContainer(const std::string &url, CVariant &container);
+
+  /*!
+   \brief Bring an item of the section snapshots up to date, episodes update their show
+   */
+  bool UpdateSectionItem(const std::string &ratingKey);
+
+  /*!
+   \brief Drop the section snapshots, sections are listed from the server again when next browsed
+   */
+  void ClearSectionCaches();
+
   std::string GetHost();
   int         GetPort();
   std::string GetUrl();
@@ -125,9 +146,14 @@ public:
 protected:
   bool        IsSameClientHostName(const CURL& url);
   bool        ParseSections(enum PlexSectionParsing parser);
+  bool        UpdateSectionsContents(CCriticalSection &critical, PlexSectionsContentVector &contents,
+                PlexSectionsContentVector &newContents, enum PlexSectionParsing parser);
   void        SetPresence(bool presence);
 
 private:
+  bool        FindSectionContent(const std::string &section, PlexSectionsContent &content);
+  std::shared_ptr<CPlexSectionCache> FindSectionCache(const std::string &section);
+
   bool        m_local;
   std::string m_contentType;
   std::string m_uuid;
@@ -153,4 +179,6 @@ private:
   std::vector<PlexSectionsContent> m_artistSectionsContents;
   std::vector<PlexSectionsContent> m_photoSectionsContents;
   std::vector<PlexSectionsContent> m_playlistSectionsContents;
+  CCriticalSection  m_criticalSectionCaches;
+  std::map<std::string, std::shared_ptr<CPlexSectionCache>> m_sectionCaches;  // by section path
 };
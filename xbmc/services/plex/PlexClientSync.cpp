@@ -24,6 +24,7 @@
 
 #include "PlexServices.h"
 #include "PlexClient.h"
+#include "PlexSectionCache.h"
 #include "PlexUtils.h"
 
 #include "GUIUserMessages.h"
@@ -32,6 +33,7 @@
 #include "filesystem/DirectoryCache.h"
 #include "guilib/GUIWindowManager.h"
 #include "settings/Settings.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/Stopwatch.h"
@@ -238,6 +240,24 @@ void CPlexClientSync::ProcessSyncByWebSockets()
                   CLog::Log(LOGDEBUG, "CPlexClientSync:ProcessSyncByWebSockets TimelineEntry: "
                     "sectionID(%s), itemID(%s), type(%s), state(%s), title(%s), identifier(%s)",
                     sectionID.c_str(), itemID.c_str(), type.c_str(), state.c_str(), title.c_str(), identifier.c_str());
+
+                  // keep the section snapshots current, by rating key
+                  if (identifier != "com.plexapp.plugins.library" || itemID.empty())
+                    continue;
+                  if (type != "1" && type != "2" && type != "4" && type != "8")
+                    continue;
+                  CPlexClientPtr client = CPlexServices::GetInstance().FindClient(m_address);
+                  if (!client)
+                    continue;
+                  // sections never browsed have nothing to keep current
+                  std::shared_ptr<CPlexSectionCache> cache = client->FindSectionCache("library/sections/" + sectionID);
+                  if (!cache)
+                    continue;
+                  // fetching the item blocks, don't hold up the socket with it
+                  if (state == "5")
+                    CJobManager::GetInstance().Submit([client, itemID]() { client->UpdateSectionItem(itemID); });
+                  else if (state == "9")
+                    CJobManager::GetInstance().Submit([cache, itemID]() { cache->RemoveItem(itemID); });
                 }
               }
             }
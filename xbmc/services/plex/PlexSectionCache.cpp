@@ -0,0 +1,375 @@
+/*
+ *      Copyright (C) 2017 Team MrMC
+ *      https://github.com/MrMC
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MrMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PlexSectionCache.h"
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "PlexUtils.h"
+#include "URL.h"
+#include "threads/SingleLock.h"
+#include "utils/Crc32.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+
+#define PLEX_SECTION_CACHE_PATH "special://temp/plex/"
+
+static CVariant makeVariantArray(const CVariant &variant)
+{
+  // a single item comes as an object, no items as null
+  if (variant.isArray())
+    return variant;
+
+  CVariant array(CVariant::VariantTypeArray);
+  if (variant.isObject())
+    array.push_back(variant);
+  return array;
+}
+
+CPlexSectionCache::CPlexSectionCache(const std::string &serverId, const std::string &section, const std::string &type)
+: CServicesItemCache(type == "movie" ? "Video" : "Directory", "ratingKey")
+, m_serverId(serverId)
+, m_section(section)
+, m_type(type)
+, m_element(type == "movie" ? "Video" : "Directory")
+, m_itemsUpdatedAt(0)
+, m_loaded(false)
+, m_viewStateStale(false)
+, m_syncing(false)
+{
+}
+
+CPlexSectionCache::~CPlexSectionCache()
+{
+}
+
+bool CPlexSectionCache::Get(const std::string &url, const std::string &updatedAt, CVariant &container)
+{
+  bool restored = false;
+  {
+    CSingleLock lock(m_lock);
+    if (!m_loaded)
+      Load();
+    if (!m_listing.isNull())
+    {
+      if (!m_viewStateStale)
+      {
+        container = m_listing;
+        return true;
+      }
+      m_viewStateStale = false;
+      restored = true;
+    }
+  }
+
+  if (restored)
+    RefreshViewState(url);
+  else if (!FetchAll(url, updatedAt))
+    return false;
+
+  CSingleLock lock(m_lock);
+  container = m_listing;
+  return !container.isNull();
+}
+
+bool CPlexSectionCache::NeedSync(const std::string &updatedAt)
+{
+  CSingleLock lock(m_lock);
+  if (!m_loaded)
+    Load();
+  return m_listing.isNull() || m_updatedAt != updatedAt;
+}
+
+bool CPlexSectionCache::Sync(const std::string &url, const std::string &updatedAt)
+{
+  if (m_syncing.exchange(true))
+    return false;
+
+  int64_t since = -1;
+  {
+    CSingleLock lock(m_lock);
+    if (!m_loaded)
+      Load();
+    if (!m_listing.isNull())
+    {
+      if (m_updatedAt == updatedAt)
+      {
+        m_syncing = false;
+        return false;
+      }
+      since = m_itemsUpdatedAt;
+    }
+  }
+
+  if (since < 0)
+  {
+    bool changed = FetchAll(url, updatedAt);
+    m_syncing = false;
+    return changed;
+  }
+
+  // only what was updated since the newest item we have, plex reads
+  // the encoded 'updatedAt>=' as a filter on the listing
+  CURL curl(url);
+  curl.SetFileName(m_section + "/all");
+  curl.SetProtocolOption("updatedAt>", StringUtils::Format("%" PRId64, since));
+  CVariant delta = CPlexUtils::GetPlexCVariant(curl.Get());
+
+  curl.RemoveProtocolOption("updatedAt>");
+  curl.SetProtocolOption("X-Plex-Container-Start", "0");
+  curl.SetProtocolOption("X-Plex-Container-Size", "0");
+  CVariant total = CPlexUtils::GetPlexCVariant(curl.Get());
+
+  if (!delta.isObject() || !delta.isMember("MediaContainer") ||
+      !total.isObject() || !total.isMember("MediaContainer"))
+  {
+    CLog::Log(LOGERROR, "CPlexSectionCache::Sync failed to get changes of %s", m_section.c_str());
+    m_syncing = false;
+    return false;
+  }
+
+  const CVariant items = makeVariantArray(delta["MediaContainer"][m_element]);
+  int64_t totalSize = total["MediaContainer"]["totalSize"].asInteger(-1);
+  bool complete;
+  {
+    CSingleLock lock(m_lock);
+    if (m_listing.isNull())
+    {
+      // deleted meanwhile
+      m_syncing = false;
+      return false;
+    }
+
+    for (auto variantIt = items.begin_array(); variantIt != items.end_array(); ++variantIt)
+    {
+      const CVariant &item = *variantIt;
+      if (!item.isObject())
+        continue;
+
+      int k = FindItem(item["ratingKey"].asString());
+      if (k < 0)
+        AppendItem(item);
+      else
+        GetListingItems()[k] = item;
+      m_itemsUpdatedAt = std::max(m_itemsUpdatedAt, item["updatedAt"].asInteger());
+    }
+
+    complete = (int64_t)GetListingItems().size() == totalSize;
+    if (complete)
+    {
+      m_updatedAt = updatedAt;
+      SaveListing();
+    }
+  }
+  CLog::Log(LOGDEBUG, "CPlexSectionCache::Sync %s, %d changed items", m_section.c_str(), (int)items.size());
+
+  bool changed = !items.empty();
+  if (!complete)
+  {
+    // items were removed, or the server didn't filter
+    CLog::Log(LOGDEBUG, "CPlexSectionCache::Sync %s item count differs, fetching all", m_section.c_str());
+    changed = FetchAll(url, updatedAt);
+  }
+
+  m_syncing = false;
+  return changed;
+}
+
+bool CPlexSectionCache::UpdateItem(const CVariant &item)
+{
+  if (!item.isObject() || item["type"].asString() != m_type)
+    return false;
+
+  std::string ratingKey = item["ratingKey"].asString();
+  if (ratingKey.empty())
+    return false;
+
+  CSingleLock lock(m_lock);
+  if (!m_loaded)
+    Load();
+  // without a snapshot the next Get fetches everything anyway
+  if (m_listing.isNull())
+    return false;
+
+  int k = FindItem(ratingKey);
+  if (k < 0)
+    AppendItem(item);
+  else
+    GetListingItems()[k] = item;
+  SaveListing();
+  return true;
+}
+
+bool CPlexSectionCache::RemoveItem(const std::string &ratingKey)
+{
+  CSingleLock lock(m_lock);
+  if (!m_loaded)
+    Load();
+  if (m_listing.isNull())
+    return false;
+
+  if (!EraseItem(ratingKey))
+    return false;
+
+  SaveListing();
+  return true;
+}
+
+void CPlexSectionCache::Delete()
+{
+  CSingleLock lock(m_lock);
+  m_loaded = true;
+  CVariant container;
+  SetListing(container);
+  m_updatedAt.clear();
+  m_itemsUpdatedAt = 0;
+  m_viewStateStale = false;
+  DeleteListing();
+}
+
+bool CPlexSectionCache::Load()
+{
+  // called with m_lock held
+  m_loaded = true;
+
+  // the updatedAt of the section and of the newest item are the header
+  std::string header;
+  CVariant container;
+  if (!ReadListing(header, container))
+    return false;
+
+  std::vector<std::string> updatedAt = StringUtils::Split(header, " ");
+  if (updatedAt.size() != 2)
+  {
+    CLog::Log(LOGERROR, "CPlexSectionCache::Load invalid cache for %s", m_section.c_str());
+    return false;
+  }
+
+  m_updatedAt = updatedAt[0];
+  m_itemsUpdatedAt = strtoll(updatedAt[1].c_str(), NULL, 10);
+  SetListing(container);
+  m_viewStateStale = true;
+  return true;
+}
+
+bool CPlexSectionCache::FetchAll(const std::string &url, const std::string &updatedAt)
+{
+  CURL curl(url);
+  curl.SetFileName(m_section + "/all");
+  CVariant variant = CPlexUtils::GetPlexCVariant(curl.Get());
+  if (!variant.isObject() || !variant.isMember("MediaContainer"))
+  {
+    CLog::Log(LOGERROR, "CPlexSectionCache::FetchAll failed to list %s", m_section.c_str());
+    return false;
+  }
+
+  CSingleLock lock(m_lock);
+  SetItems(variant["MediaContainer"], updatedAt);
+  return true;
+}
+
+void CPlexSectionCache::SetItems(CVariant &container, const std::string &updatedAt)
+{
+  // called with m_lock held
+  container[m_element] = makeVariantArray(container[m_element]);
+  int64_t itemsUpdatedAt = 0;
+  const CVariant &items = container[m_element];
+  for (auto variantIt = items.begin_array(); variantIt != items.end_array(); ++variantIt)
+    itemsUpdatedAt = std::max(itemsUpdatedAt, (*variantIt)["updatedAt"].asInteger());
+
+  SetListing(container);
+  m_updatedAt = updatedAt;
+  m_itemsUpdatedAt = itemsUpdatedAt;
+  m_viewStateStale = false;
+  SaveListing();
+}
+
+bool CPlexSectionCache::RefreshViewState(const std::string &url)
+{
+  // watching doesn't change the updatedAt of the section or of the item, the
+  // view state of a restored snapshot is taken over from a listing carrying only it
+  static const char *viewStateFields[] = { "viewCount", "viewOffset", "lastViewedAt", "viewedLeafCount" };
+
+  CURL curl(url);
+  curl.SetFileName(m_section + "/all");
+  curl.SetProtocolOption("includeFields", "ratingKey,viewCount,viewOffset,lastViewedAt,viewedLeafCount");
+  CVariant variant = CPlexUtils::GetPlexCVariant(curl.Get());
+  if (!variant.isObject() || !variant.isMember("MediaContainer"))
+  {
+    CLog::Log(LOGERROR, "CPlexSectionCache::RefreshViewState failed to list %s", m_section.c_str());
+    return false;
+  }
+
+  const CVariant items = makeVariantArray(variant["MediaContainer"][m_element]);
+  CSingleLock lock(m_lock);
+  if (m_listing.isNull())
+    return false;
+
+  bool changed = false;
+  for (auto variantIt = items.begin_array(); variantIt != items.end_array(); ++variantIt)
+  {
+    const CVariant &item = *variantIt;
+    int k = FindItem(item["ratingKey"].asString());
+    if (k < 0)
+      continue;
+
+    // plex leaves out the fields of unwatched items
+    CVariant &cachedItem = GetListingItems()[k];
+    for (const char *field : viewStateFields)
+    {
+      if (item.isMember(field))
+      {
+        if (cachedItem[field] != item[field])
+        {
+          cachedItem[field] = item[field];
+          changed = true;
+        }
+      }
+      else if (cachedItem.isMember(field))
+      {
+        cachedItem.erase(field);
+        changed = true;
+      }
+    }
+  }
+  CLog::Log(LOGDEBUG, "CPlexSectionCache::RefreshViewState %s, view state %s", m_section.c_str(), changed ? "changed" : "unchanged");
+
+  if (changed)
+    SaveListing();
+  return changed;
+}
+
+bool CPlexSectionCache::GetHeader(std::string &header)
+{
+  if (m_listing.isNull())
+    return false;
+
+  header = StringUtils::Format("%s %" PRId64, m_updatedAt.c_str(), m_itemsUpdatedAt);
+  return true;
+}
+
+const std::string CPlexSectionCache::GetCacheFile() const
+{
+  std::string key = m_serverId + "/" + m_section;
+  return StringUtils::Format(PLEX_SECTION_CACHE_PATH "%08x.json", (uint32_t)Crc32::Compute(key));
+}
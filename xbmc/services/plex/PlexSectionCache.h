@@ -0,0 +1,106 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team MrMC
+ *      https://github.com/MrMC
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MrMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+#include "services/ServicesItemCache.h"
+#include "utils/Variant.h"
+
+/*!
+ \brief Snapshot of the listing of a Plex library section.
+
+ The MediaContainer of library/sections/<key>/all is kept in memory and in
+ special://temp/plex/ together with the updatedAt of the section it matches,
+ so browsing is served from it right away, also on the next run. When the
+ section has changed, only the items updated since the newest item of the
+ snapshot are fetched and merged by rating key. Deleted items can't be seen
+ that way, the snapshot is fetched in full when the item count disagrees.
+ Watched state doesn't change any updatedAt, it is listed again and merged
+ the first time a snapshot restored from disk is served.
+ */
+class CPlexSectionCache : public CServicesItemCache
+{
+public:
+  /*!
+   \param serverId uuid of the server
+   \param section path of the section, library/sections/<key>
+   \param type plex type of the listed items, movie, show or artist
+   */
+  CPlexSectionCache(const std::string &serverId, const std::string &section, const std::string &type);
+ ~CPlexSectionCache();
+
+  const std::string &GetSection() const { return m_section; }
+
+  /*!
+   \brief Get the listing of the section, from the snapshot if there is one, from the server otherwise
+   \param url url of the server, with its token
+   \param updatedAt current updatedAt of the section
+   \param container [out] the MediaContainer of the listing
+   \return false if there is no snapshot and the section can't be listed
+   */
+  bool  Get(const std::string &url, const std::string &updatedAt, CVariant &container);
+
+  /*!
+   \brief true if there is no snapshot or it was taken at another updatedAt of the section
+   */
+  bool  NeedSync(const std::string &updatedAt);
+
+  /*!
+   \brief Bring the snapshot up to the given updatedAt of the section, returns
+   at once if another sync is running
+   \return true if the listing changed
+   */
+  bool  Sync(const std::string &url, const std::string &updatedAt);
+
+  /*!
+   \brief Replace or add an item fetched from library/metadata/<ratingKey>
+   \return false if the item is not of the type listed by the section
+   */
+  bool  UpdateItem(const CVariant &item);
+  bool  RemoveItem(const std::string &ratingKey);
+
+  /*!
+   \brief Drop the snapshot, also from disk, used when the section is gone
+   */
+  void  Delete();
+
+protected:
+  virtual const std::string GetCacheFile() const;
+  virtual bool  GetHeader(std::string &header);
+
+private:
+  bool  Load();
+  bool  FetchAll(const std::string &url, const std::string &updatedAt);
+  void  SetItems(CVariant &items, const std::string &updatedAt);
+  bool  RefreshViewState(const std::string &url);
+
+  const std::string m_serverId;
+  const std::string m_section;
+  const std::string m_type;
+  const std::string m_element;  // "Video" or "Directory", the member of the MediaContainer holding the items
+  std::string m_updatedAt;      // updatedAt of the section the snapshot was taken at
+  int64_t m_itemsUpdatedAt;     // newest updatedAt of the items, the next delta starts there
+  bool m_loaded;
+  bool m_viewStateStale;        // restored from disk, watched state may have changed since
+  std::atomic<bool> m_syncing;
+};
@@ -448,6 +448,9 @@ void CPlexServices::UpdateLibraries(bool forced)
     if (forced || client->NeedUpdate())
     {
       client->ParseSections(PlexSectionParsing::updateSection);
+      // an update asked for also takes what the snapshots can't see, like watched states set elsewhere
+      if (forced)
+        client->ClearSectionCaches();
       clearDirCache = true;
     }
   }
@@ -27,6 +27,7 @@
 #include "filesystem/StackDirectory.h"
 #include "network/Network.h"
 #include "utils/Base64URL.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/SystemInfo.h"
@@ -224,6 +225,7 @@ void CPlexUtils::SetWatched(CFileItem &item)
 
   std::string filename = StringUtils::Format(":/scrobble?identifier=com.plexapp.plugins.library&key=%s", id.c_str());
   ReportToServer(url, filename);
+  UpdateSectionItem(url, id);
 }
 
 void CPlexUtils::SetUnWatched(CFileItem &item)
@@ -243,6 +245,7 @@ void CPlexUtils::SetUnWatched(CFileItem &item)
 
   std::string filename = StringUtils::Format(":/unscrobble?identifier=com.plexapp.plugins.library&key=%s", id.c_str());
   ReportToServer(url, filename);
+  UpdateSectionItem(url, id);
 }
 
 void CPlexUtils::ReportProgress(CFileItem &item, double currentSeconds)
@@ -289,6 +292,8 @@ void CPlexUtils::ReportProgress(CFileItem &item, double currentSeconds)
           (int)currentSeconds * 1000, totalSeconds * 1000);
 
       ReportToServer(url, filename);
+      if (g_playbackState == MediaServicesPlayerState::stopped)
+        UpdateSectionItem(url, id);
       //CLog::Log(LOGDEBUG, "CPlexUtils::ReportProgress %s", filename.c_str());
     }
     if (g_playbackState == MediaServicesPlayerState::stopped &&
@@ -1099,7 +1104,7 @@ bool CPlexUtils::GetPlexMovies(CFileItemList &items, std::string url, std::strin
 {
   bool rtn = false;
   CURL curl(url);
-  CVariant variant = GetPlexCVariant(url);
+  CVariant variant = filter.empty() ? GetPlexSectionCVariant(url) : GetPlexCVariant(url, filter);
   if (!variant.isNull() && variant.isObject() && variant.isMember("MediaContainer"))
     rtn = ParsePlexVideos(items, curl, variant["MediaContainer"]["Video"], MediaTypeMovie, false);
 
@@ -1110,7 +1115,7 @@ bool CPlexUtils::GetPlexMovies(CFileItemList &items, std::string url, std::strin
 bool CPlexUtils::GetPlexTvshows(CFileItemList &items, std::string url)
 {
   bool rtn = false;
-  CVariant variant = GetPlexCVariant(url);
+  CVariant variant = GetPlexSectionCVariant(url);
   if (!variant.isNull() && variant.isObject() && variant.isMember("MediaContainer"))
   {
     CURL curl(url);
@@ -1425,7 +1430,7 @@ bool CPlexUtils::GetPlexArtistsOrAlbum(CFileItemList &items, std::string url, bo
     if (curl.HasProtocolOption("genre"))
       curl.RemoveProtocolOption("genre");
   }
-  CVariant variant = GetPlexCVariant(curl.Get());
+  CVariant variant = GetPlexSectionCVariant(curl.Get());
   if (!variant.isNull() && variant.isObject() && variant.isMember("MediaContainer"))
   {
     rtn = ParsePlexArtistsAlbum(items, curl, variant["MediaContainer"]["Directory"], album);
@@ -2381,6 +2386,29 @@ CVariant CPlexUtils::GetPlexCVariant(std::string url, std::string filter)
   return CVariant(CVariant::VariantTypeNull);
 }
 
+CVariant CPlexUtils::GetPlexSectionCVariant(const std::string &url)
+{
+  // whole section listings come from the snapshot of the section
+  CPlexClientPtr client = CPlexServices::GetInstance().FindClient(url);
+  CVariant container;
+  if (client && client->GetSectionContainer(url, container))
+  {
+    CVariant variant(CVariant::VariantTypeObject);
+    variant["MediaContainer"] = std::move(container);
+    return variant;
+  }
+
+  return GetPlexCVariant(url);
+}
+
+void CPlexUtils::UpdateSectionItem(const std::string &url, const std::string &ratingKey)
+{
+  // the server has the new state, the section snapshot fetches it in the background
+  CPlexClientPtr client = CPlexServices::GetInstance().FindClient(url);
+  if (client)
+    CJobManager::GetInstance().Submit([client, ratingKey]() { client->UpdateSectionItem(ratingKey); });
+}
+
 TiXmlDocument CPlexUtils::GetPlexXML(std::string url, std::string filter)
 {
 #if defined(PLEX_DEBUG_TIMING)
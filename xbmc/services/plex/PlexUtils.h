@@ -107,12 +107,16 @@ public:
   static bool ParsePlexMoviesFilter(CFileItemList  &items, const CURL url, const TiXmlElement* node, const std::string &filter);
   static bool ParsePlexTVShowsFilter(CFileItemList &items, const CURL url, const TiXmlElement* node, const std::string &filter);
 
+  // Plex server requests
+  static CVariant GetPlexCVariant(std::string url, std::string filter = "");
+
 private:
   static void ReportToServer(std::string url, std::string filename);
   static void GetVideoDetails(CFileItem &item, const CVariant &variant);
   static void GetMusicDetails(CFileItem &item, const CVariant &video);
   static void GetMediaDetals(CFileItem &item, CURL url, const CVariant &media, std::string id = "0");
-  static CVariant GetPlexCVariant(std::string url, std::string filter = "");
+  static CVariant GetPlexSectionCVariant(const std::string &url);
+  static void UpdateSectionItem(const std::string &url, const std::string &ratingKey);
   static TiXmlDocument GetPlexXML(std::string url, std::string filter = "");
   static int ParsePlexCVariant(const CVariant &item);
   static int ParsePlexMediaXML(TiXmlDocument xml);
@@ -213,6 +213,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler, CJob
     int m_songInfoDuration;
     int m_logLevel;
     int m_logLevelHint;
+    bool m_logAsync;             // write the log from a separate thread
+    unsigned int m_logRotateSize; // in MB, 0 to never rotate
     bool m_extraLogEnabled;
     int m_extraLogLevels;
     std::string m_cddbAddress;
@@ -248,6 +250,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler, CJob
 
     unsigned int m_fanartRes; ///< \brief the maximal resolution to cache fanart at (assumes 16x9)
     unsigned int m_imageRes;  ///< \brief the maximal resolution to cache images at (assumes 16x9)
+    unsigned int m_imageDDSRes; ///< \brief the maximal resolution of cached images which also get a copy ready for upload (0, the default, disables)
     CPictureScalingAlgorithm::Algorithm m_imageScalingAlgorithm;
 
     std::string m_sambadoscodepage;
@@ -64,6 +64,7 @@ const std::string& CSkinSettings::GetString(int setting) const
 void CSkinSettings::SetString(int setting, const std::string &label)
 {
   g_SkinInfo->SetString(setting, label);
+  g_infoManager.InvalidateBools(INFO::INFO_SOURCE_SKIN_SETTINGS);
 }
 
 int CSkinSettings::TranslateBool(const std::string &setting)
@@ -79,11 +80,13 @@ bool CSkinSettings::GetBool(int setting) const
 void CSkinSettings::SetBool(int setting, bool set)
 {
   g_SkinInfo->SetBool(setting, set);
+  g_infoManager.InvalidateBools(INFO::INFO_SOURCE_SKIN_SETTINGS);
 }
 
 void CSkinSettings::Reset(const std::string &setting)
 {
   g_SkinInfo->Reset(setting);
+  g_infoManager.InvalidateBools(INFO::INFO_SOURCE_SKIN_SETTINGS);
 }
 
 void CSkinSettings::Reset()
@@ -191,6 +194,8 @@ void CSkinSettings::MigrateSettings(const ADDON::SkinPtr& skin)
 
   if (settingsMigrated)
   {
+    g_infoManager.InvalidateBools(INFO::INFO_SOURCE_SKIN_SETTINGS);
+
     // save the skin's settings
     skin->SaveSettings();
 
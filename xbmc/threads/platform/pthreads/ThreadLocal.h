@@ -26,13 +26,14 @@ namespace XbmcThreads
 {
   /**
    * A thin wrapper around pthreads thread specific storage
-   * functionality.
+   * functionality. The optional destructor is called with the
+   * value of every thread which exits with a value set.
    */
   template <typename T> class ThreadLocal
   {
     pthread_key_t key;
   public:
-    inline ThreadLocal() : key(0) { pthread_key_create(&key,NULL); }
+    inline ThreadLocal(void (*destructor)(void*) = NULL) : key(0) { pthread_key_create(&key,destructor); }
 
     inline ~ThreadLocal() { pthread_key_delete(key); }
 
@@ -20,6 +20,7 @@
 
 #include "CharsetConverter.h"
 
+#include <atomic>
 #include <cerrno>
 #include <algorithm>
 
@@ -33,6 +34,7 @@
 #include "settings/Settings.h"
 #include "system.h"
 #include "threads/SingleLock.h"
+#include "threads/ThreadLocal.h"
 #include "utils/StringUtils.h"
 #include "utils/Utf8Utils.h"
 
@@ -40,6 +42,12 @@
   #include "config.h"
 #endif
 
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+  #include <arm_neon.h>
+#endif
+
 #ifdef WORDS_BIGENDIAN
   #define ENDIAN_SUFFIX "BE"
 #else
@@ -95,7 +103,11 @@ public:
   CConverterType(const CConverterType& other);
   ~CConverterType();
 
-  iconv_t GetConverter(CSingleLock& converterLock);
+  /*! \brief Opens a new converter, owned by the caller
+   \param generation [out] the generation the converter belongs to
+   */
+  iconv_t Open(unsigned int& generation);
+  unsigned int GetGeneration(void) const  { return m_generation; }
 
   void Reset(void);
   void ReinitTo(const std::string& sourceCharset, const std::string& targetCharset, unsigned int targetSingleCharMaxLen = 1);
@@ -110,8 +122,8 @@ private:
   std::string         m_sourceCharset;
   enum SpecialCharset m_targetSpecialCharset;
   std::string         m_targetCharset;
-  iconv_t             m_iconv;
   unsigned int        m_targetSingleCharMaxLen;
+  std::atomic<unsigned int> m_generation; ///< bumped whenever converters opened before have to be reopened
 };
 
 CConverterType::CConverterType(const std::string& sourceCharset, const std::string& targetCharset, unsigned int targetSingleCharMaxLen /*= 1*/) : CCriticalSection(),
@@ -119,8 +131,8 @@ CConverterType::CConverterType(const std::string& sourceCharset, const std::stri
   m_sourceCharset(sourceCharset),
   m_targetSpecialCharset(NotSpecialCharset),
   m_targetCharset(targetCharset),
-  m_iconv(NO_ICONV),
-  m_targetSingleCharMaxLen(targetSingleCharMaxLen)
+  m_targetSingleCharMaxLen(targetSingleCharMaxLen),
+  m_generation(1)
 {
 }
 
@@ -129,8 +141,8 @@ CConverterType::CConverterType(enum SpecialCharset sourceSpecialCharset, const s
   m_sourceCharset(),
   m_targetSpecialCharset(NotSpecialCharset),
   m_targetCharset(targetCharset),
-  m_iconv(NO_ICONV),
-  m_targetSingleCharMaxLen(targetSingleCharMaxLen)
+  m_targetSingleCharMaxLen(targetSingleCharMaxLen),
+  m_generation(1)
 {
 }
 
@@ -139,8 +151,8 @@ CConverterType::CConverterType(const std::string& sourceCharset, enum SpecialCha
   m_sourceCharset(sourceCharset),
   m_targetSpecialCharset(targetSpecialCharset),
   m_targetCharset(),
-  m_iconv(NO_ICONV),
-  m_targetSingleCharMaxLen(targetSingleCharMaxLen)
+  m_targetSingleCharMaxLen(targetSingleCharMaxLen),
+  m_generation(1)
 {
 }
 
@@ -149,8 +161,8 @@ CConverterType::CConverterType(enum SpecialCharset sourceSpecialCharset, enum Sp
   m_sourceCharset(),
   m_targetSpecialCharset(targetSpecialCharset),
   m_targetCharset(),
-  m_iconv(NO_ICONV),
-  m_targetSingleCharMaxLen(targetSingleCharMaxLen)
+  m_targetSingleCharMaxLen(targetSingleCharMaxLen),
+  m_generation(1)
 {
 }
 
@@ -159,53 +171,41 @@ CConverterType::CConverterType(const CConverterType& other) : CCriticalSection()
   m_sourceCharset(other.m_sourceCharset),
   m_targetSpecialCharset(other.m_targetSpecialCharset),
   m_targetCharset(other.m_targetCharset),
-  m_iconv(NO_ICONV),
-  m_targetSingleCharMaxLen(other.m_targetSingleCharMaxLen)
+  m_targetSingleCharMaxLen(other.m_targetSingleCharMaxLen),
+  m_generation(other.m_generation.load())
 {
 }
 
 
 CConverterType::~CConverterType()
 {
-  CSingleLock lock(*this);
-  if (m_iconv != NO_ICONV)
-    iconv_close(m_iconv);
-  lock.Leave(); // ensure unlocking before final destruction
 }
 
 
-iconv_t CConverterType::GetConverter(CSingleLock& converterLock)
+iconv_t CConverterType::Open(unsigned int& generation)
 {
-  // ensure that this unique instance is locked externally
-  if (&converterLock.get_underlying() != this)
-    return NO_ICONV;
+  CSingleLock lock(*this);
+  generation = m_generation;
 
-  if (m_iconv == NO_ICONV)
-  {
-    if (m_sourceSpecialCharset)
-      m_sourceCharset = ResolveSpecialCharset(m_sourceSpecialCharset);
-    if (m_targetSpecialCharset)
-      m_targetCharset = ResolveSpecialCharset(m_targetSpecialCharset);
+  if (m_sourceSpecialCharset)
+    m_sourceCharset = ResolveSpecialCharset(m_sourceSpecialCharset);
+  if (m_targetSpecialCharset)
+    m_targetCharset = ResolveSpecialCharset(m_targetSpecialCharset);
 
-    m_iconv = iconv_open(m_targetCharset.c_str(), m_sourceCharset.c_str());
-    
-    if (m_iconv == NO_ICONV)
-      CLog::Log(LOGERROR, "%s: iconv_open() for \"%s\" -> \"%s\" failed, errno = %d (%s)",
-                __FUNCTION__, m_sourceCharset.c_str(), m_targetCharset.c_str(), errno, strerror(errno));
-  }
+  iconv_t converter = iconv_open(m_targetCharset.c_str(), m_sourceCharset.c_str());
 
-  return m_iconv;
+  if (converter == NO_ICONV)
+    CLog::Log(LOGERROR, "%s: iconv_open() for \"%s\" -> \"%s\" failed, errno = %d (%s)",
+              __FUNCTION__, m_sourceCharset.c_str(), m_targetCharset.c_str(), errno, strerror(errno));
+
+  return converter;
 }
 
 
 void CConverterType::Reset(void)
 {
   CSingleLock lock(*this);
-  if (m_iconv != NO_ICONV)
-  {
-    iconv_close(m_iconv);
-    m_iconv = NO_ICONV;
-  }
+  m_generation++;
 
   if (m_sourceSpecialCharset)
     m_sourceCharset.clear();
@@ -219,11 +219,7 @@ void CConverterType::ReinitTo(const std::string& sourceCharset, const std::strin
   CSingleLock lock(*this);
   if (sourceCharset != m_sourceCharset || targetCharset != m_targetCharset)
   {
-    if (m_iconv != NO_ICONV)
-    {
-      iconv_close(m_iconv);
-      m_iconv = NO_ICONV;
-    }
+    m_generation++;
 
     m_sourceSpecialCharset = NotSpecialCharset;
     m_sourceCharset = sourceCharset;
@@ -282,6 +278,14 @@ public:
   
   template<class INPUT,class OUTPUT>
   static bool stdConvert(StdConversionType convertType, const INPUT& strSource, OUTPUT& strDest, bool failOnInvalidChar = false);
+  template<class INPUT,class OUTPUT>
+  static bool fastConvert(StdConversionType convertType, const INPUT& strSource, OUTPUT& strDest) { return false; }
+  static bool fastConvert(StdConversionType convertType, const std::string& strSource, std::u32string& strDest);
+  static bool fastConvert(StdConversionType convertType, const std::u32string& strSource, std::string& strDest);
+#ifdef WCHAR_IS_UCS_4
+  static bool fastConvert(StdConversionType convertType, const std::string& strSource, std::wstring& strDest);
+  static bool fastConvert(StdConversionType convertType, const std::wstring& strSource, std::string& strDest);
+#endif
   template<class INPUT,class OUTPUT>
   static bool customConvert(const std::string& sourceCharset, const std::string& targetCharset, const INPUT& strSource, OUTPUT& strDest, bool failOnInvalidChar = false);
 
@@ -319,6 +323,65 @@ CConverterType CCharsetConverter::CInnerConverter::m_stdConversion[NumberOfStdCo
 CCriticalSection CCharsetConverter::CInnerConverter::m_critSectionFriBiDi;
 
 
+/* Every thread converts with its own iconv descriptors, so conversions on
+   different threads don't wait for each other. A descriptor is reopened
+   when its CConverterType was reset since it was opened. */
+class CThreadConverters
+{
+public:
+  CThreadConverters()
+  {
+    for (int i = 0; i < NumberOfStdConversionTypes; i++)
+    {
+      m_iconv[i] = NO_ICONV;
+      m_generation[i] = 0;
+    }
+  }
+
+  ~CThreadConverters()
+  {
+    for (int i = 0; i < NumberOfStdConversionTypes; i++)
+    {
+      if (m_iconv[i] != NO_ICONV)
+        iconv_close(m_iconv[i]);
+    }
+  }
+
+  iconv_t Get(StdConversionType convertType, CConverterType& convType)
+  {
+    if (m_iconv[convertType] != NO_ICONV)
+    {
+      if (m_generation[convertType] == convType.GetGeneration())
+        return m_iconv[convertType];
+      iconv_close(m_iconv[convertType]);
+    }
+
+    m_iconv[convertType] = convType.Open(m_generation[convertType]);
+    return m_iconv[convertType];
+  }
+
+  static CThreadConverters& GetForCurrentThread()
+  {
+    static XbmcThreads::ThreadLocal<CThreadConverters> threadConverters(&Delete);
+    CThreadConverters* converters = threadConverters.get();
+    if (!converters)
+    {
+      converters = new CThreadConverters();
+      threadConverters.set(converters);
+    }
+    return *converters;
+  }
+
+private:
+  static void Delete(void* converters)
+  {
+    delete static_cast<CThreadConverters*>(converters);
+  }
+
+  iconv_t      m_iconv[NumberOfStdConversionTypes];
+  unsigned int m_generation[NumberOfStdConversionTypes];
+};
+
 
 template<class INPUT,class OUTPUT>
 bool CCharsetConverter::CInnerConverter::stdConvert(StdConversionType convertType, const INPUT& strSource, OUTPUT& strDest, bool failOnInvalidChar /*= false*/)
@@ -330,12 +393,244 @@ bool CCharsetConverter::CInnerConverter::stdConvert(StdConversionType convertTyp
   if (convertType < 0 || convertType >= NumberOfStdConversionTypes)
     return false;
 
+  // valid unicode strings don't need iconv
+  if (fastConvert(convertType, strSource, strDest))
+    return true;
+
   CConverterType& convType = m_stdConversion[convertType];
-  CSingleLock converterLock(convType);
+  iconv_t converter = CThreadConverters::GetForCurrentThread().Get(convertType, convType);
+
+  return convert(converter, convType.GetTargetSingleCharMaxLen(), strSource, strDest, failOnInvalidChar);
+}
+
+
+/* UTF-8 <-> UTF-32 without iconv. Only valid input is converted, anything
+   else returns false and is left to iconv, which keeps its handling of
+   invalid sequences. Runs of ASCII are converted 16 characters at a time. */
+template<class OUTPUT>
+static bool Utf8ToUtf32Direct(const std::string& strSource, OUTPUT& strDest, bool asciiOnly)
+{
+  typedef typename OUTPUT::value_type CHAR;
+  const unsigned char* src = (const unsigned char*)strSource.data();
+  const size_t length = strSource.length();
+
+  // never more code points than bytes
+  strDest.resize(length);
+  CHAR* dst = &strDest[0];
+  size_t in = 0;
+  size_t out = 0;
+
+  while (in < length)
+  {
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    while (in + 16 <= length)
+    {
+      __m128i chars = _mm_loadu_si128((const __m128i*)(src + in));
+      if (_mm_movemask_epi8(chars))
+        break;
+      __m128i lo = _mm_unpacklo_epi8(chars, zero);
+      __m128i hi = _mm_unpackhi_epi8(chars, zero);
+      _mm_storeu_si128((__m128i*)(dst + out),      _mm_unpacklo_epi16(lo, zero));
+      _mm_storeu_si128((__m128i*)(dst + out + 4),  _mm_unpackhi_epi16(lo, zero));
+      _mm_storeu_si128((__m128i*)(dst + out + 8),  _mm_unpacklo_epi16(hi, zero));
+      _mm_storeu_si128((__m128i*)(dst + out + 12), _mm_unpackhi_epi16(hi, zero));
+      in += 16;
+      out += 16;
+    }
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+    while (in + 16 <= length)
+    {
+      uint8x16_t chars = vld1q_u8(src + in);
+      uint8x8_t any = vorr_u8(vget_low_u8(chars), vget_high_u8(chars));
+      if (vget_lane_u64(vreinterpret_u64_u8(any), 0) & 0x8080808080808080ULL)
+        break;
+      uint16x8_t lo = vmovl_u8(vget_low_u8(chars));
+      uint16x8_t hi = vmovl_u8(vget_high_u8(chars));
+      vst1q_u32((uint32_t*)(dst + out),      vmovl_u16(vget_low_u16(lo)));
+      vst1q_u32((uint32_t*)(dst + out + 4),  vmovl_u16(vget_high_u16(lo)));
+      vst1q_u32((uint32_t*)(dst + out + 8),  vmovl_u16(vget_low_u16(hi)));
+      vst1q_u32((uint32_t*)(dst + out + 12), vmovl_u16(vget_high_u16(hi)));
+      in += 16;
+      out += 16;
+    }
+#endif
+    if (in == length)
+      break;
+
+    const unsigned char lead = src[in];
+    if (lead < 0x80)
+    {
+      dst[out++] = lead;
+      in++;
+      continue;
+    }
+    if (asciiOnly)
+      return false;
+
+    uint32_t codePoint;
+    uint32_t minimum;
+    size_t trail;
+    if ((lead & 0xE0) == 0xC0)
+    {
+      codePoint = lead & 0x1F;
+      minimum = 0x80;
+      trail = 1;
+    }
+    else if ((lead & 0xF0) == 0xE0)
+    {
+      codePoint = lead & 0x0F;
+      minimum = 0x800;
+      trail = 2;
+    }
+    else if ((lead & 0xF8) == 0xF0)
+    {
+      codePoint = lead & 0x07;
+      minimum = 0x10000;
+      trail = 3;
+    }
+    else
+      return false;
+
+    if (length - in <= trail)
+      return false;
+    for (size_t i = 1; i <= trail; i++)
+    {
+      const unsigned char next = src[in + i];
+      if ((next & 0xC0) != 0x80)
+        return false;
+      codePoint = (codePoint << 6) | (next & 0x3F);
+    }
+    // overlong forms, surrogates and values beyond unicode are invalid
+    if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+      return false;
+
+    dst[out++] = (CHAR)codePoint;
+    in += trail + 1;
+  }
+
+  strDest.resize(out);
+  return true;
+}
+
+template<class INPUT>
+static bool Utf32ToUtf8Direct(const INPUT& strSource, std::string& strDest)
+{
+  const uint32_t* src = (const uint32_t*)strSource.data();
+  const size_t length = strSource.length();
+
+  // never more than 4 bytes per code point
+  strDest.resize(length * 4);
+  unsigned char* dst = (unsigned char*)&strDest[0];
+  size_t in = 0;
+  size_t out = 0;
+
+  while (in < length)
+  {
+#if defined(__SSE2__)
+    const __m128i notAscii = _mm_set1_epi32(~0x7F);
+    while (in + 16 <= length)
+    {
+      __m128i c0 = _mm_loadu_si128((const __m128i*)(src + in));
+      __m128i c1 = _mm_loadu_si128((const __m128i*)(src + in + 4));
+      __m128i c2 = _mm_loadu_si128((const __m128i*)(src + in + 8));
+      __m128i c3 = _mm_loadu_si128((const __m128i*)(src + in + 12));
+      __m128i any = _mm_or_si128(_mm_or_si128(c0, c1), _mm_or_si128(c2, c3));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(any, notAscii), _mm_setzero_si128())) != 0xFFFF)
+        break;
+      _mm_storeu_si128((__m128i*)(dst + out), _mm_packus_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3)));
+      in += 16;
+      out += 16;
+    }
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+    while (in + 16 <= length)
+    {
+      uint32x4_t c0 = vld1q_u32(src + in);
+      uint32x4_t c1 = vld1q_u32(src + in + 4);
+      uint32x4_t c2 = vld1q_u32(src + in + 8);
+      uint32x4_t c3 = vld1q_u32(src + in + 12);
+      uint32x4_t any = vorrq_u32(vorrq_u32(c0, c1), vorrq_u32(c2, c3));
+      uint32x2_t folded = vorr_u32(vget_low_u32(any), vget_high_u32(any));
+      if ((vget_lane_u32(folded, 0) | vget_lane_u32(folded, 1)) & ~0x7FU)
+        break;
+      uint16x8_t lo = vcombine_u16(vmovn_u32(c0), vmovn_u32(c1));
+      uint16x8_t hi = vcombine_u16(vmovn_u32(c2), vmovn_u32(c3));
+      vst1q_u8(dst + out, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+      in += 16;
+      out += 16;
+    }
+#endif
+    if (in == length)
+      break;
 
-  return convert(convType.GetConverter(converterLock), convType.GetTargetSingleCharMaxLen(), strSource, strDest, failOnInvalidChar);
+    const uint32_t codePoint = src[in++];
+    if (codePoint < 0x80)
+      dst[out++] = (unsigned char)codePoint;
+    else if (codePoint < 0x800)
+    {
+      dst[out++] = 0xC0 | (codePoint >> 6);
+      dst[out++] = 0x80 | (codePoint & 0x3F);
+    }
+    else if (codePoint < 0x10000)
+    {
+      if (codePoint >= 0xD800 && codePoint <= 0xDFFF)
+        return false;
+      dst[out++] = 0xE0 | (codePoint >> 12);
+      dst[out++] = 0x80 | ((codePoint >> 6) & 0x3F);
+      dst[out++] = 0x80 | (codePoint & 0x3F);
+    }
+    else if (codePoint <= 0x10FFFF)
+    {
+      dst[out++] = 0xF0 | (codePoint >> 18);
+      dst[out++] = 0x80 | ((codePoint >> 12) & 0x3F);
+      dst[out++] = 0x80 | ((codePoint >> 6) & 0x3F);
+      dst[out++] = 0x80 | (codePoint & 0x3F);
+    }
+    else
+      return false;
+  }
+
+  strDest.resize(out);
+  return true;
 }
 
+/* UTF-8-MAC composes decomposed characters, which only plain ASCII is sure not to contain */
+#if defined(TARGET_DARWIN)
+  #define UTF8_SOURCE_ASCII_ONLY true
+#else
+  #define UTF8_SOURCE_ASCII_ONLY false
+#endif
+
+bool CCharsetConverter::CInnerConverter::fastConvert(StdConversionType convertType, const std::string& strSource, std::u32string& strDest)
+{
+  if (convertType != Utf8ToUtf32)
+    return false;
+  return Utf8ToUtf32Direct(strSource, strDest, UTF8_SOURCE_ASCII_ONLY);
+}
+
+bool CCharsetConverter::CInnerConverter::fastConvert(StdConversionType convertType, const std::u32string& strSource, std::string& strDest)
+{
+  if (convertType != Utf32ToUtf8)
+    return false;
+  return Utf32ToUtf8Direct(strSource, strDest);
+}
+
+#ifdef WCHAR_IS_UCS_4
+bool CCharsetConverter::CInnerConverter::fastConvert(StdConversionType convertType, const std::string& strSource, std::wstring& strDest)
+{
+  if (convertType != Utf8toW)
+    return false;
+  return Utf8ToUtf32Direct(strSource, strDest, UTF8_SOURCE_ASCII_ONLY);
+}
+
+bool CCharsetConverter::CInnerConverter::fastConvert(StdConversionType convertType, const std::wstring& strSource, std::string& strDest)
+{
+  if (convertType != WtoUtf8)
+    return false;
+  return Utf32ToUtf8Direct(strSource, strDest);
+}
+#endif
+
 template<class INPUT,class OUTPUT>
 bool CCharsetConverter::CInnerConverter::customConvert(const std::string& sourceCharset, const std::string& targetCharset, const INPUT& strSource, OUTPUT& strDest, bool failOnInvalidChar /*= false*/)
 {
@@ -52,10 +52,12 @@ private:
     return true;
   }
 
-  void PushObject(CVariant variant);
+  // values are moved into their place in the result, nothing is copied
+  void PushObject(CVariant &&variant);
   void PopObject();
 
   CVariant& m_parsedObject;
+  CVariant m_root;
   std::vector<CVariant *> m_parse;
   std::string m_key;
 
@@ -70,6 +72,7 @@ private:
 
 CJSONVariantParserHandler::CJSONVariantParserHandler(CVariant& parsedObject)
   : m_parsedObject(parsedObject),
+    m_root(),
     m_parse(),
     m_key(),
     m_status(PARSE_STATUS::Variable)
@@ -77,7 +80,7 @@ CJSONVariantParserHandler::CJSONVariantParserHandler(CVariant& parsedObject)
 
 bool CJSONVariantParserHandler::Null()
 {
-  PushObject(CVariant::ConstNullVariant);
+  PushObject(CVariant(CVariant::ConstNullVariant));
   PopObject();
 
   return true;
@@ -125,14 +128,14 @@ bool CJSONVariantParserHandler::String(const char* str, rapidjson::SizeType leng
 
 bool CJSONVariantParserHandler::StartObject()
 {
-  PushObject(CVariant::VariantTypeObject);
+  PushObject(CVariant(CVariant::VariantTypeObject));
 
   return true;
 }
 
 bool CJSONVariantParserHandler::Key(const char* str, rapidjson::SizeType length, bool copy)
 {
-  m_key = std::string(str, 0, length);
+  m_key.assign(str, length);
 
   return true;
 }
@@ -146,7 +149,7 @@ bool CJSONVariantParserHandler::EndObject(rapidjson::SizeType memberCount)
 
 bool CJSONVariantParserHandler::StartArray()
 {
-  PushObject(CVariant::VariantTypeArray);
+  PushObject(CVariant(CVariant::VariantTypeArray));
 
   return true;
 }
@@ -158,25 +161,34 @@ bool CJSONVariantParserHandler::EndArray(rapidjson::SizeType elementCount)
   return true;
 }
 
-void CJSONVariantParserHandler::PushObject(CVariant variant)
+void CJSONVariantParserHandler::PushObject(CVariant &&variant)
 {
+  CVariant *target = nullptr;
   if (m_status == PARSE_STATUS::Object)
   {
-    (*m_parse[m_parse.size() - 1])[m_key] = variant;
-    m_parse.push_back(&(*m_parse[m_parse.size() - 1])[m_key]);
+    target = &(*m_parse[m_parse.size() - 1])[m_key];
+    *target = std::move(variant);
   }
   else if (m_status == PARSE_STATUS::Array)
   {
     CVariant *temp = m_parse[m_parse.size() - 1];
-    temp->push_back(variant);
-    m_parse.push_back(&(*temp)[temp->size() - 1]);
+    temp->push_back(std::move(variant));
+    target = &(*temp)[temp->size() - 1];
   }
   else if (m_parse.empty())
-    m_parse.push_back(new CVariant(variant));
+  {
+    target = &m_root;
+    *target = std::move(variant);
+  }
+
+  if (target == nullptr)
+    return;
+
+  m_parse.push_back(target);
 
-  if (variant.isObject())
+  if (target->isObject())
     m_status = PARSE_STATUS::Object;
-  else if (variant.isArray())
+  else if (target->isArray())
     m_status = PARSE_STATUS::Array;
   else
     m_status = PARSE_STATUS::Variable;
@@ -199,8 +211,8 @@ void CJSONVariantParserHandler::PopObject()
   }
   else
   {
-    m_parsedObject = *variant;
-    delete variant;
+    // only hand out the result once it is complete
+    m_parsedObject = std::move(m_root);
 
     m_status = PARSE_STATUS::Variable;
   }
@@ -21,11 +21,26 @@
 #include "JSONVariantWriter.h"
 
 #include <rapidjson/prettywriter.h>
-#include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
 #include "utils/Variant.h"
 
+// rapidjson output stream appending straight to the caller's string,
+// saves copying the whole document out of a rapidjson::StringBuffer
+class CJSONStringStream
+{
+public:
+  typedef char Ch;
+
+  explicit CJSONStringStream(std::string &output) : m_output(output) { }
+
+  void Put(Ch c) { m_output.push_back(c); }
+  void Flush() { }
+
+private:
+  std::string &m_output;
+};
+
 template<class TWriter>
 bool InternalWrite(TWriter& writer, const CVariant &value)
 {
@@ -64,7 +79,7 @@ bool InternalWrite(TWriter& writer, const CVariant &value)
 
     for (CVariant::const_iterator_map itr = value.begin_map(); itr != value.end_map(); ++itr)
     {
-      if (!writer.Key(itr->first.c_str()) ||
+      if (!writer.Key(itr->first.c_str(), itr->first.size()) ||
         !InternalWrite(writer, itr->second))
         return false;
     }
@@ -82,23 +97,157 @@ bool InternalWrite(TWriter& writer, const CVariant &value)
 
 bool CJSONVariantWriter::Write(const CVariant &value, std::string& output, bool compact)
 {
-  rapidjson::StringBuffer stringBuffer;
+  std::string result;
+  CJSONStringStream stream(result);
   if (compact)
   {
-    rapidjson::Writer<rapidjson::StringBuffer> writer(stringBuffer);
+    rapidjson::Writer<CJSONStringStream> writer(stream);
 
     if (!InternalWrite(writer, value) || !writer.IsComplete())
       return false;
   }
   else
   {
-    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(stringBuffer);
+    rapidjson::PrettyWriter<CJSONStringStream> writer(stream);
     writer.SetIndent('\t', 1);
 
     if (!InternalWrite(writer, value) || !writer.IsComplete())
       return false;
   }
 
-  output = stringBuffer.GetString();
+  output.swap(result);
   return true;
 }
+
+// rapidjson output stream collecting chunks for a CJSONVariantStreamWriter
+class CJSONChunkStream
+{
+public:
+  typedef char Ch;
+
+  CJSONChunkStream(const CJSONVariantStreamWriter::Output &output, size_t chunkSize)
+    : m_output(output), m_chunkSize(chunkSize), m_failed(false)
+  {
+    m_buffer.reserve(chunkSize + 64);
+  }
+
+  void Put(Ch c)
+  {
+    m_buffer.push_back(c);
+    if (m_buffer.size() >= m_chunkSize)
+      Flush();
+  }
+
+  void Flush()
+  {
+    if (m_buffer.empty())
+      return;
+    if (!m_failed && !m_output(m_buffer.c_str(), m_buffer.size()))
+      m_failed = true;
+    m_buffer.clear();
+  }
+
+  bool Failed() const { return m_failed; }
+
+private:
+  CJSONVariantStreamWriter::Output m_output;
+  size_t m_chunkSize;
+  bool m_failed;
+  std::string m_buffer;
+};
+
+class CJSONVariantStreamWriter::IWriter
+{
+public:
+  virtual ~IWriter() { }
+
+  virtual bool StartObject() = 0;
+  virtual bool EndObject() = 0;
+  virtual bool StartArray() = 0;
+  virtual bool EndArray() = 0;
+  virtual bool Key(const std::string &key) = 0;
+  virtual bool Write(const CVariant &value) = 0;
+  virtual bool Flush() = 0;
+};
+
+template<class TWriter>
+class CJSONStreamWriterImpl : public CJSONVariantStreamWriter::IWriter
+{
+public:
+  CJSONStreamWriterImpl(const CJSONVariantStreamWriter::Output &output, size_t chunkSize)
+    : m_stream(output, chunkSize), m_writer(m_stream)
+  { }
+
+  virtual bool StartObject() { return m_writer.StartObject() && !m_stream.Failed(); }
+  virtual bool EndObject() { return m_writer.EndObject() && Done(); }
+  virtual bool StartArray() { return m_writer.StartArray() && !m_stream.Failed(); }
+  virtual bool EndArray() { return m_writer.EndArray() && Done(); }
+  virtual bool Key(const std::string &key) { return m_writer.Key(key.c_str(), key.size()) && !m_stream.Failed(); }
+  virtual bool Write(const CVariant &value) { return InternalWrite(m_writer, value) && Done(); }
+  virtual bool Flush() { m_stream.Flush(); return !m_stream.Failed(); }
+
+  TWriter &GetWriter() { return m_writer; }
+
+private:
+  // the last bit of a document is handed out right away
+  bool Done()
+  {
+    if (m_writer.IsComplete())
+      m_stream.Flush();
+    return !m_stream.Failed();
+  }
+
+  CJSONChunkStream m_stream;
+  TWriter m_writer;
+};
+
+CJSONVariantStreamWriter::CJSONVariantStreamWriter(const Output &output, bool compact, size_t chunkSize /* = 16 * 1024 */)
+{
+  if (compact)
+    m_writer.reset(new CJSONStreamWriterImpl<rapidjson::Writer<CJSONChunkStream> >(output, chunkSize));
+  else
+  {
+    CJSONStreamWriterImpl<rapidjson::PrettyWriter<CJSONChunkStream> > *writer = new CJSONStreamWriterImpl<rapidjson::PrettyWriter<CJSONChunkStream> >(output, chunkSize);
+    writer->GetWriter().SetIndent('\t', 1);
+    m_writer.reset(writer);
+  }
+}
+
+CJSONVariantStreamWriter::~CJSONVariantStreamWriter()
+{
+}
+
+bool CJSONVariantStreamWriter::StartObject()
+{
+  return m_writer->StartObject();
+}
+
+bool CJSONVariantStreamWriter::EndObject()
+{
+  return m_writer->EndObject();
+}
+
+bool CJSONVariantStreamWriter::StartArray()
+{
+  return m_writer->StartArray();
+}
+
+bool CJSONVariantStreamWriter::EndArray()
+{
+  return m_writer->EndArray();
+}
+
+bool CJSONVariantStreamWriter::Key(const std::string &key)
+{
+  return m_writer->Key(key);
+}
+
+bool CJSONVariantStreamWriter::Write(const CVariant &value)
+{
+  return m_writer->Write(value);
+}
+
+bool CJSONVariantStreamWriter::Flush()
+{
+  return m_writer->Flush();
+}
@@ -19,6 +19,8 @@
  *
  */
 
+#include <functional>
+#include <memory>
 #include <string>
 
 class CVariant;
@@ -30,3 +32,40 @@ public:
 
   static bool Write(const CVariant &value, std::string& output, bool compact);
 };
+
+/*!
+ \brief Writes a JSON document piece by piece.
+
+ Values are serialized as soon as they are written and the output is handed
+ out in chunks, so large documents (e.g. library listings) never need to be
+ held as a CVariant or a string as a whole.
+ */
+class CJSONVariantStreamWriter
+{
+public:
+  /*!
+   \brief Receives the serialized output.
+   \return false to stop writing, e.g. when the client went away
+   */
+  typedef std::function<bool(const char *data, size_t size)> Output;
+
+  CJSONVariantStreamWriter(const Output &output, bool compact, size_t chunkSize = 16 * 1024);
+  ~CJSONVariantStreamWriter();
+
+  bool StartObject();
+  bool EndObject();
+  bool StartArray();
+  bool EndArray();
+  bool Key(const std::string &key);
+  bool Write(const CVariant &value);
+
+  /*!
+   \brief Hands out what is buffered, called automatically for every chunk
+   and once the document is complete.
+   */
+  bool Flush();
+
+  class IWriter;
+private:
+  std::unique_ptr<IWriter> m_writer;
+};
@@ -23,6 +23,8 @@
 #include <functional>
 #include <stdexcept>
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/CPUInfo.h"
 #include "utils/log.h"
 
 #include "system.h"
@@ -34,31 +36,30 @@ bool CJob::ShouldCancel(unsigned int progress, unsigned int total) const
   return false;
 }
 
-CJobWorker::CJobWorker(CJobManager *manager) : CThread("JobWorker")
+// a lower priority job is run ahead of higher ones after being passed over this often
+#define JOB_STARVATION_LIMIT 16
+
+CJobWorker::CJobWorker(CJobManager *manager, unsigned int index) : CThread("JobWorker")
 {
   m_jobManager = manager;
-  Create(true); // start work immediately, and kill ourselves when we're done
+  m_index = index;
+  Create(); // start work immediately, we live until the manager stops us
 }
 
 CJobWorker::~CJobWorker()
 {
-  // while we should already be removed from the job manager, if an exception
-  // occurs during processing that we haven't caught, we may skip over that step.
-  // Thus, before we go out of scope, ensure the job manager knows we're gone.
-  m_jobManager->RemoveWorker(this);
-  if(!IsAutoDelete())
-    StopThread();
+  StopThread();
 }
 
 void CJobWorker::Process()
 {
   SetPriority( GetMinPriority() );
-  while (true)
+  while (!m_bStop)
   {
     // request an item from our manager (this call is blocking)
-    CJob *job = m_jobManager->GetNextJob(this);
+    CJob *job = m_jobManager->GetNextJob(m_index);
     if (!job)
-      break;
+      continue;
 
     bool success = false;
     try
@@ -69,7 +70,7 @@ void CJobWorker::Process()
     {
       CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, job->GetType());
     }
-    m_jobManager->OnJobComplete(success, job);
+    m_jobManager->OnJobComplete(m_index, success);
   }
 }
 
@@ -179,8 +180,22 @@ CJobManager &CJobManager::GetInstance()
 CJobManager::CJobManager()
 {
   m_jobCounter = 0;
+  m_nextWorker = 0;
   m_running = true;
   m_pauseJobs = false;
+  m_numWorkers = 0;
+  m_workersStarted = false;
+  m_processingTotal = 0;
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+  {
+    m_queued[priority] = 0;
+    m_processing[priority] = 0;
+    m_skipped[priority] = 0;
+    m_completed[priority] = 0;
+    m_waitTime[priority] = 0;
+    m_maxWaitTime[priority] = 0;
+    m_runTime[priority] = 0;
+  }
 }
 
 void CJobManager::Restart()
@@ -194,243 +209,448 @@ void CJobManager::Restart()
 
 void CJobManager::CancelJobs()
 {
-  CSingleLock lock(m_section);
-  m_running = false;
-
-  // clear any pending jobs
-  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
   {
-    for_each(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), std::mem_fun_ref(&CWorkItem::FreeJob));
-    m_jobQueue[priority].clear();
+    CSingleLock lock(m_section);
+    m_running = false;
   }
 
-  // cancel any callbacks on jobs still processing
-  for_each(m_processing.begin(), m_processing.end(), std::mem_fun_ref(&CWorkItem::Cancel));
+  unsigned int numWorkers = m_numWorkers;
+  for (unsigned int i = 0; i < numWorkers; ++i)
+  {
+    CWorkerQueue *worker = m_workers[i];
+    CSingleLock lock(worker->m_section);
 
-  // tell our workers to finish
-  while (m_workers.size())
+    // clear any pending jobs
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+    {
+      m_queued[priority] -= worker->m_jobQueue[priority].size();
+      for_each(worker->m_jobQueue[priority].begin(), worker->m_jobQueue[priority].end(), std::mem_fun_ref(&CWorkItem::FreeJob));
+      worker->m_jobQueue[priority].clear();
+    }
+
+    // cancel any callbacks on jobs still processing
+    if (worker->m_processing)
+      worker->m_current.Cancel();
+  }
+
+  PriorityStats stats[CJob::PRIORITY_HIGH+1];
+  GetStats(stats);
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
   {
-    lock.Leave();
-    m_jobEvent.Set();
-    Sleep(0); // yield after setting the event to give the workers some time to die
-    lock.Enter();
+    uint64_t completed = stats[priority].completed;
+    if (completed)
+      CLog::Log(LOGDEBUG, "%s - priority %u: %llu jobs, average wait %llu ms, max wait %u ms, average run %llu ms", __FUNCTION__, priority,
+                (unsigned long long)completed, (unsigned long long)(stats[priority].waitTime / completed),
+                stats[priority].maxWaitTime, (unsigned long long)(stats[priority].runTime / completed));
   }
+
+  // tell our workers to finish
+  StopWorkers();
 }
 
 CJobManager::~CJobManager()
 {
 }
 
-unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORITY priority)
+void CJobManager::StartWorkers()
+{
+  if (m_workersStarted)
+    return;
+
+  CSingleLock lock(m_section);
+  if (m_workersStarted || !m_running)
+    return;
+
+  // one worker per core, but not less than we used to allow for the (mostly I/O bound) jobs
+  if (m_workers.empty())
+  {
+    unsigned int numWorkers = std::min(std::max((unsigned int)g_cpuInfo.getCPUCount(), 5U), 16U);
+    for (unsigned int i = 0; i < numWorkers; ++i)
+      m_workers.push_back(new CWorkerQueue);
+    m_numWorkers = numWorkers;
+  }
+
+  for (unsigned int i = 0; i < m_workers.size(); ++i)
+    m_workers[i]->m_worker = new CJobWorker(this, i);
+
+  m_workersStarted = true;
+}
+
+void CJobManager::StopWorkers()
 {
   CSingleLock lock(m_section);
 
+  for (Workers::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+  {
+    if ((*it)->m_worker)
+      (*it)->m_worker->StopThread(false);
+    (*it)->m_jobEvent.Set();
+  }
+
+  // waits for the threads to finish their current job
+  for (Workers::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+  {
+    delete (*it)->m_worker;
+    (*it)->m_worker = NULL;
+  }
+
+  m_workersStarted = false;
+}
+
+unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORITY priority)
+{
   if (!m_running)
     return 0;
 
+  StartWorkers();
+  unsigned int numWorkers = m_numWorkers;
+  if (numWorkers == 0)
+    return 0;
+
   // increment the job counter, ensuring 0 (invalid job) is never hit
-  m_jobCounter++;
-  if (m_jobCounter == 0)
-    m_jobCounter++;
+  unsigned int id = ++m_jobCounter;
+  if (id == 0)
+    id = ++m_jobCounter;
 
   // create a work item for this job
-  CWorkItem work(job, m_jobCounter, priority, callback);
-  m_jobQueue[priority].push_back(work);
+  CWorkItem work(job, id, priority, callback);
+  work.m_queued = XbmcThreads::SystemClockMillis();
 
-  StartWorkers(priority);
-  return work.m_id;
+  // queue at an idle worker if there is one, else spread the jobs
+  unsigned int first = m_nextWorker++ % numWorkers;
+  unsigned int target = first;
+  for (unsigned int i = 0; i < numWorkers; ++i)
+  {
+    unsigned int index = (first + i) % numWorkers;
+    if (m_workers[index]->m_idle)
+    {
+      target = index;
+      break;
+    }
+  }
+
+  {
+    CSingleLock lock(m_workers[target]->m_section);
+    m_workers[target]->m_jobQueue[priority].push_back(work);
+    m_queued[priority]++;
+  }
+  m_workers[target]->m_jobEvent.Set();
+
+  // the target may be busy, let anyone idle steal it
+  if (!m_workers[target]->m_idle)
+  {
+    for (unsigned int i = 0; i < numWorkers; ++i)
+    {
+      if (m_workers[i]->m_idle)
+      {
+        m_workers[i]->m_jobEvent.Set();
+        break;
+      }
+    }
+  }
+
+  return id;
 }
 
 void CJobManager::CancelJob(unsigned int jobID)
 {
-  CSingleLock lock(m_section);
+  // jobs may move between workers, so hold all of them (in order) while looking
+  unsigned int numWorkers = m_numWorkers;
+  for (unsigned int i = 0; i < numWorkers; ++i)
+    m_workers[i]->m_section.lock();
 
-  // check whether we have this job in the queue
-  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+  bool found = false;
+  for (unsigned int i = 0; i < numWorkers && !found; ++i)
   {
-    JobQueue::iterator i = find(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), jobID);
-    if (i != m_jobQueue[priority].end())
+    CWorkerQueue *worker = m_workers[i];
+
+    // check whether we have this job in the queue
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH && !found; ++priority)
     {
-      delete i->m_job;
-      m_jobQueue[priority].erase(i);
-      return;
+      JobQueue::iterator it = find(worker->m_jobQueue[priority].begin(), worker->m_jobQueue[priority].end(), jobID);
+      if (it != worker->m_jobQueue[priority].end())
+      {
+        delete it->m_job;
+        worker->m_jobQueue[priority].erase(it);
+        m_queued[priority]--;
+        found = true;
+      }
+    }
+
+    // or if we're processing it
+    if (!found && worker->m_processing && worker->m_current == jobID)
+    {
+      worker->m_current.m_callback = NULL; // job is in progress, so only thing to do is to remove callback
+      found = true;
     }
   }
-  // or if we're processing it
-  Processing::iterator it = find(m_processing.begin(), m_processing.end(), jobID);
-  if (it != m_processing.end())
-    it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
+
+  for (unsigned int i = numWorkers; i > 0; --i)
+    m_workers[i - 1]->m_section.unlock();
 }
 
-void CJobManager::StartWorkers(CJob::PRIORITY priority)
+unsigned int CJobManager::GetMaxWorkers(CJob::PRIORITY priority) const
 {
-  CSingleLock lock(m_section);
-
-  // check how many free threads we have
-  if (m_processing.size() >= GetMaxWorkers(priority))
-    return;
+  // keep workers free for higher priority jobs that may arise
+  unsigned int reserved = CJob::PRIORITY_HIGH - priority;
+  unsigned int numWorkers = m_numWorkers;
+  return numWorkers > reserved ? numWorkers - reserved : 1;
+}
 
-  // do we have any sleeping threads?
-  if (m_processing.size() < m_workers.size())
+bool CJobManager::ReserveWorker(CJob::PRIORITY priority)
+{
+  // counted before popping, so idle workers can't pass the limit all together
+  unsigned int maxWorkers = GetMaxWorkers(priority);
+  unsigned int total = m_processingTotal;
+  do
   {
-    m_jobEvent.Set();
-    return;
-  }
+    if (total >= maxWorkers)
+      return false;
+  } while (!m_processingTotal.compare_exchange_weak(total, total + 1));
+  return true;
+}
+
+bool CJobManager::PopJob(unsigned int index, unsigned int victim, CJob::PRIORITY priority)
+{
+  CWorkerQueue *me = m_workers[index];
+  CWorkerQueue *other = m_workers[victim];
+
+  // lock in index order, the job has to be in a queue or current at all times
+  CCriticalSection &first = index < victim ? me->m_section : other->m_section;
+  CCriticalSection &second = index < victim ? other->m_section : me->m_section;
+  CSingleLock lock1(first);
+  CSingleLock lock2(second);
+
+  JobQueue &queue = other->m_jobQueue[priority];
+  if (queue.empty())
+    return false;
+
+  me->m_current = queue.front();
+  queue.pop_front();
+  me->m_processing = true;
+  me->m_started = XbmcThreads::SystemClockMillis();
+  me->m_current.m_job->m_callback = this;
 
-  // everyone is busy - we need more workers
-  m_workers.push_back(new CJobWorker(this));
+  m_queued[priority]--;
+  m_processing[priority]++;
+  return true;
 }
 
-CJob *CJobManager::PopJob()
+CJob *CJobManager::PopJob(unsigned int index)
 {
-  CSingleLock lock(m_section);
+  if (!m_running)
+    return NULL;
+
+  // serve lanes by priority, but lanes passed over too often go first
+  int order[CJob::PRIORITY_HIGH + 2];
+  int count = 0;
+  for (int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+  {
+    if (m_skipped[priority] >= JOB_STARVATION_LIMIT)
+    {
+      order[count++] = priority;
+      break;
+    }
+  }
   for (int priority = CJob::PRIORITY_HIGH; priority >= CJob::PRIORITY_LOW_PAUSABLE; --priority)
+    order[count++] = priority;
+
+  unsigned int numWorkers = m_numWorkers;
+  for (int i = 0; i < count; ++i)
   {
+    CJob::PRIORITY priority = CJob::PRIORITY(order[i]);
+
     // Check whether we're pausing pausable jobs
     if (priority == CJob::PRIORITY_LOW_PAUSABLE && m_pauseJobs)
       continue;
 
-    if (m_jobQueue[priority].size() && m_processing.size() < GetMaxWorkers(CJob::PRIORITY(priority)))
+    if (m_queued[priority] == 0 || !ReserveWorker(priority))
+      continue;
+
+    // our own queue first, then steal from the others
+    for (unsigned int j = 0; j < numWorkers; ++j)
     {
-      // pop the job off the queue
-      CWorkItem job = m_jobQueue[priority].front();
-      m_jobQueue[priority].pop_front();
-
-      // add to the processing vector
-      m_processing.push_back(job);
-      job.m_job->m_callback = this;
-      return job.m_job;
+      if (PopJob(index, (index + j) % numWorkers, priority))
+      {
+        m_skipped[priority] = 0;
+        for (int lower = CJob::PRIORITY_LOW_PAUSABLE; lower < priority; ++lower)
+        {
+          if (m_queued[lower] > 0)
+            m_skipped[lower]++;
+        }
+
+        unsigned int wait = m_workers[index]->m_started - m_workers[index]->m_current.m_queued;
+        m_waitTime[priority] += wait;
+        unsigned int maxWait = m_maxWaitTime[priority];
+        while (wait > maxWait && !m_maxWaitTime[priority].compare_exchange_weak(maxWait, wait))
+          ;
+
+        return m_workers[index]->m_current.m_job;
+      }
     }
+
+    // someone else got the job, give the worker back. others may have
+    // gone idle on the limit meanwhile
+    m_processingTotal--;
+    WakeIdleWorker();
   }
   return NULL;
 }
 
 void CJobManager::PauseJobs()
 {
-  CSingleLock lock(m_section);
   m_pauseJobs = true;
 }
 
 void CJobManager::UnPauseJobs()
 {
-  CSingleLock lock(m_section);
   m_pauseJobs = false;
+
+  unsigned int numWorkers = m_numWorkers;
+  for (unsigned int i = 0; i < numWorkers; ++i)
+    m_workers[i]->m_jobEvent.Set();
 }
 
 bool CJobManager::IsProcessing(const CJob::PRIORITY &priority) const
 {
-  CSingleLock lock(m_section);
-
   if (m_pauseJobs)
     return false;
 
-  for(Processing::const_iterator it = m_processing.begin(); it < m_processing.end(); ++it)
-  {
-    if (priority == it->m_priority)
-      return true;
-  }
-  return false;
+  return m_processing[priority] > 0;
 }
 
 int CJobManager::IsProcessing(const std::string &type) const
 {
   int jobsMatched = 0;
-  CSingleLock lock(m_section);
 
   if (m_pauseJobs)
     return 0;
 
-  for(Processing::const_iterator it = m_processing.begin(); it < m_processing.end(); ++it)
+  unsigned int numWorkers = m_numWorkers;
+  for (unsigned int i = 0; i < numWorkers; ++i)
   {
-    if (type == std::string(it->m_job->GetType()))
+    CWorkerQueue *worker = m_workers[i];
+    CSingleLock lock(worker->m_section);
+    if (worker->m_processing && type == std::string(worker->m_current.m_job->GetType()))
       jobsMatched++;
   }
   return jobsMatched;
 }
 
-CJob *CJobManager::GetNextJob(const CJobWorker *worker)
+CJob *CJobManager::GetNextJob(unsigned int index)
 {
-  CSingleLock lock(m_section);
-  while (m_running)
-  {
-    // grab a job off the queue if we have one
-    CJob *job = PopJob();
-    if (job)
-      return job;
-    // no jobs are left - sleep for 30 seconds to allow new jobs to come in
-    lock.Leave();
-    bool newJob = m_jobEvent.WaitMSec(30000);
-    lock.Enter();
-    if (!newJob)
-      break;
-  }
-  // ensure no jobs have come in during the period after
-  // timeout and before we held the lock
-  CJob *job = PopJob();
+  CWorkerQueue *me = m_workers[index];
+
+  // grab a job off the queues if we have one
+  CJob *job = PopJob(index);
   if (job)
     return job;
-  // have no jobs
-  RemoveWorker(worker);
-  return NULL;
+
+  // announce we're idle before looking again, so AddJob either sees
+  // us idle and wakes us or we see its job
+  me->m_idle = true;
+  job = PopJob(index);
+  if (!job)
+  {
+    // sleep until there's a job for us, or one held back by the worker
+    // limits can start (see WakeIdleWorker)
+    me->m_jobEvent.Wait();
+    me->m_idle = false;
+    job = PopJob(index);
+  }
+  me->m_idle = false;
+  return job;
 }
 
-bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const CJob *job) const
+void CJobManager::WakeIdleWorker()
 {
-  CSingleLock lock(m_section);
-  // find the job in the processing queue, and check whether it's cancelled (no callback)
-  Processing::const_iterator i = find(m_processing.begin(), m_processing.end(), job);
-  if (i != m_processing.end())
+  bool queued = false;
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+    queued |= m_queued[priority] > 0;
+  if (!queued)
+    return;
+
+  unsigned int numWorkers = m_numWorkers;
+  for (unsigned int i = 0; i < numWorkers; ++i)
   {
-    CWorkItem item(*i);
-    lock.Leave(); // leave section prior to call
-    if (item.m_callback)
+    if (m_workers[i]->m_idle)
     {
-      item.m_callback->OnJobProgress(item.m_id, progress, total, job);
-      return false;
+      m_workers[i]->m_jobEvent.Set();
+      break;
     }
   }
-  return true; // couldn't find the job, or it's been cancelled
 }
 
-void CJobManager::OnJobComplete(bool success, CJob *job)
+bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const CJob *job) const
 {
-  CSingleLock lock(m_section);
-  // remove the job from the processing queue
-  Processing::iterator i = find(m_processing.begin(), m_processing.end(), job);
-  if (i != m_processing.end())
+  // find the job in the processing workers, and check whether it's cancelled (no callback)
+  unsigned int numWorkers = m_numWorkers;
+  for (unsigned int i = 0; i < numWorkers; ++i)
   {
-    // tell any listeners we're done with the job, then delete it
-    CWorkItem item(*i);
-    lock.Leave();
-    try
+    CWorkerQueue *worker = m_workers[i];
+    CSingleLock lock(worker->m_section);
+    if (worker->m_processing && worker->m_current == job)
     {
+      CWorkItem item(worker->m_current);
+      lock.Leave(); // leave section prior to call
       if (item.m_callback)
-        item.m_callback->OnJobComplete(item.m_id, success, item.m_job);
-    }
-    catch (...)
-    {
-      CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, item.m_job->GetType());
+      {
+        item.m_callback->OnJobProgress(item.m_id, progress, total, job);
+        return false;
+      }
+      break;
     }
-    lock.Enter();
-    Processing::iterator j = find(m_processing.begin(), m_processing.end(), job);
-    if (j != m_processing.end())
-      m_processing.erase(j);
-    lock.Leave();
-    item.FreeJob();
   }
+  return true; // couldn't find the job, or it's been cancelled
 }
 
-void CJobManager::RemoveWorker(const CJobWorker *worker)
+void CJobManager::OnJobComplete(unsigned int index, bool success)
 {
-  CSingleLock lock(m_section);
-  // remove our worker
-  Workers::iterator i = find(m_workers.begin(), m_workers.end(), worker);
-  if (i != m_workers.end())
-    m_workers.erase(i); // workers auto-delete
+  CWorkerQueue *me = m_workers[index];
+  CSingleLock lock(me->m_section);
+  if (!me->m_processing)
+    return;
+
+  // tell any listeners we're done with the job, then delete it
+  CWorkItem item(me->m_current);
+  unsigned int runTime = XbmcThreads::SystemClockMillis() - me->m_started;
+  lock.Leave();
+  try
+  {
+    if (item.m_callback)
+      item.m_callback->OnJobComplete(item.m_id, success, item.m_job);
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, item.m_job->GetType());
+  }
+  lock.Enter();
+  me->m_processing = false;
+  me->m_current = CWorkItem();
+  lock.Leave();
+
+  m_processing[item.m_priority]--;
+  m_processingTotal--;
+  m_completed[item.m_priority]++;
+  m_runTime[item.m_priority] += runTime;
+
+  // this worker looks for a job right away, but a job of another worker may
+  // have been held back by the limit we just released
+  WakeIdleWorker();
+
+  item.FreeJob();
 }
 
-unsigned int CJobManager::GetMaxWorkers(CJob::PRIORITY priority)
+unsigned int CJobManager::GetStats(PriorityStats (&stats)[CJob::PRIORITY_HIGH+1]) const
 {
-  static const unsigned int max_workers = 5;
-  return max_workers - (CJob::PRIORITY_HIGH - priority);
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+  {
+    stats[priority].queued = m_queued[priority];
+    stats[priority].processing = m_processing[priority];
+    stats[priority].completed = m_completed[priority];
+    stats[priority].waitTime = m_waitTime[priority];
+    stats[priority].maxWaitTime = m_maxWaitTime[priority];
+    stats[priority].runTime = m_runTime[priority];
+  }
+  return m_numWorkers;
 }
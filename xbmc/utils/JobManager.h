@@ -19,9 +19,11 @@
  *
  */
 
+#include <atomic>
 #include <queue>
 #include <vector>
 #include <string>
+#include <stdint.h>
 #include "threads/CriticalSection.h"
 #include "threads/Thread.h"
 #include "Job.h"
@@ -31,12 +33,13 @@ class CJobManager;
 class CJobWorker : public CThread
 {
 public:
-  CJobWorker(CJobManager *manager);
+  CJobWorker(CJobManager *manager, unsigned int index);
   virtual ~CJobWorker();
 
   void Process();
 private:
   CJobManager  *m_jobManager;
+  unsigned int  m_index;
 };
 
 /*!
@@ -177,12 +180,21 @@ class CJobManager
   class CWorkItem
   {
   public:
+    CWorkItem()
+    {
+      m_job = NULL;
+      m_id = 0;
+      m_callback = NULL;
+      m_priority = CJob::PRIORITY_LOW;
+      m_queued = 0;
+    }
     CWorkItem(CJob *job, unsigned int id, CJob::PRIORITY priority, IJobCallback *callback)
     {
       m_job = job;
       m_id = id;
       m_callback = callback;
       m_priority = priority;
+      m_queued = 0;
     }
     bool operator==(unsigned int jobID) const
     {
@@ -205,6 +217,29 @@ class CJobManager
     unsigned int  m_id;
     IJobCallback *m_callback;
     CJob::PRIORITY m_priority;
+    unsigned int  m_queued; // time the job was queued, for statistics
+  };
+
+  typedef std::deque<CWorkItem> JobQueue;
+
+  /*!
+   \brief Queues and current job of one worker.
+   Jobs are queued at a worker, idle workers take (steal) jobs queued at
+   other workers, so there is no single lock all workers contend for.
+   */
+  class CWorkerQueue
+  {
+  public:
+    CWorkerQueue() : m_worker(NULL), m_processing(false), m_idle(false) {}
+
+    CJobWorker      *m_worker;
+    CCriticalSection m_section;
+    JobQueue         m_jobQueue[CJob::PRIORITY_HIGH+1];
+    CWorkItem        m_current;
+    bool             m_processing;
+    unsigned int     m_started;
+    CEvent           m_jobEvent;
+    std::atomic<bool> m_idle;
   };
   
   template<typename F>
@@ -296,25 +331,42 @@ public:
    */
   bool IsProcessing(const CJob::PRIORITY &priority) const;
 
+  struct PriorityStats
+  {
+    unsigned int queued;     //!< jobs currently waiting
+    unsigned int processing; //!< jobs currently running
+    uint64_t     completed;  //!< jobs run since startup
+    uint64_t     waitTime;   //!< total time jobs waited before running, in ms
+    unsigned int maxWaitTime;
+    uint64_t     runTime;    //!< total time spent running jobs, in ms
+  };
+
+  /*!
+   \brief Get queue depth and latency figures of each priority.
+   \param stats array receiving the figures, indexed by CJob::PRIORITY
+   \return number of worker threads
+   */
+  unsigned int GetStats(PriorityStats (&stats)[CJob::PRIORITY_HIGH+1]) const;
+
 protected:
   friend class CJobWorker;
   friend class CJob;
 
   /*!
-   \brief Get a new job to process. Blocks until a new job is available, or a timeout has occurred.
-   \param worker a pointer to the current CJobWorker instance requesting a job.
+   \brief Get a new job to process. Blocks until a new job is available, or the worker is stopped.
+   \param index index of the CJobWorker instance requesting a job.
    \sa CJob
    */
-  CJob *GetNextJob(const CJobWorker *worker);
+  CJob *GetNextJob(unsigned int index);
 
   /*!
    \brief Callback from CJobWorker after a job has completed.
    Calls IJobCallback::OnJobComplete(), and then destroys job.
-   \param job a pointer to the calling subclassed CJob instance.
+   \param index index of the CJobWorker instance that processed the job.
    \param success the result from the DoWork call
    \sa IJobCallback, CJob
    */
-  void  OnJobComplete(bool success, CJob *job);
+  void  OnJobComplete(unsigned int index, bool success);
 
   /*!
    \brief Callback from CJob to report progress and check for cancellation.
@@ -334,27 +386,45 @@ private:
   CJobManager const& operator=(CJobManager const&);
   virtual ~CJobManager();
 
-  /*! \brief Pop a job off the job queue and add to the processing queue ready to process
+  /*! \brief Pop a job off the job queues and make it the current job of the worker
    \return the job to process, NULL if no jobs are available
    */
-  CJob *PopJob();
+  CJob *PopJob(unsigned int index);
+  bool PopJob(unsigned int index, unsigned int victim, CJob::PRIORITY priority);
 
-  void StartWorkers(CJob::PRIORITY priority);
-  void RemoveWorker(const CJobWorker *worker);
-  static unsigned int GetMaxWorkers(CJob::PRIORITY priority);
+  void StartWorkers();
+  void StopWorkers();
+  unsigned int GetMaxWorkers(CJob::PRIORITY priority) const;
+  /*!
+   \brief Take one of the workers allowed for the given priority
+   \return false if they are all busy
+   */
+  bool ReserveWorker(CJob::PRIORITY priority);
+  /*!
+   \brief Wake an idle worker if jobs are waiting, they may be able to start now
+   */
+  void WakeIdleWorker();
 
-  unsigned int m_jobCounter;
+  std::atomic<unsigned int> m_jobCounter;
+  std::atomic<unsigned int> m_nextWorker;
 
-  typedef std::deque<CWorkItem>    JobQueue;
-  typedef std::vector<CWorkItem>   Processing;
-  typedef std::vector<CJobWorker*> Workers;
+  typedef std::vector<CWorkerQueue*> Workers;
 
-  JobQueue   m_jobQueue[CJob::PRIORITY_HIGH+1];
-  bool       m_pauseJobs;
-  Processing m_processing;
-  Workers    m_workers;
+  std::atomic<bool> m_pauseJobs;
+  Workers    m_workers;           // only grows, entries live as long as the manager
+  std::atomic<unsigned int> m_numWorkers;
+  std::atomic<bool> m_workersStarted;
+
+  // statistics, queue depth and processing count also drive scheduling
+  std::atomic<unsigned int> m_queued[CJob::PRIORITY_HIGH+1];
+  std::atomic<unsigned int> m_processing[CJob::PRIORITY_HIGH+1];
+  std::atomic<unsigned int> m_processingTotal;
+  std::atomic<unsigned int> m_skipped[CJob::PRIORITY_HIGH+1];
+  std::atomic<uint64_t>     m_completed[CJob::PRIORITY_HIGH+1];
+  std::atomic<uint64_t>     m_waitTime[CJob::PRIORITY_HIGH+1];
+  std::atomic<unsigned int> m_maxWaitTime[CJob::PRIORITY_HIGH+1];
+  std::atomic<uint64_t>     m_runTime[CJob::PRIORITY_HIGH+1];
 
   CCriticalSection m_section;
-  CEvent           m_jobEvent;
-  bool             m_running;
+  std::atomic<bool> m_running;
 };
@@ -23,11 +23,21 @@
 #include "URL.h"
 #include "Util.h"
 #include "XBDateTime.h"
+#include "threads/Thread.h"
 #include "utils/CharsetConverter.h"
+#include "utils/CPUInfo.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
 #include <algorithm>
+#include <locale>
+#include <math.h>
+#include <unordered_map>
+#include <unordered_set>
+
+// lists smaller than this are not worth the thread start-up
+#define PARALLEL_SORT_MIN_ITEMS   10000
+#define PARALLEL_SORT_MAX_THREADS 4U
 
 std::string ArrayToString(SortAttribute attributes, const CVariant &variant, const std::string &seperator = " / ")
 {
@@ -80,9 +90,10 @@ std::string ByLastPlayed(SortAttribute attributes, const SortItem &values)
   return StringUtils::Format("%s %s", values.at(FieldLastPlayed).asString().c_str(), ByLabel(attributes, values).c_str());
 }
 
-std::string ByPlaycount(SortAttribute attributes, const SortItem &values)
+std::string ByPlaycount(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%i %s", (int)values.at(FieldPlaycount).asInteger(), ByLabel(attributes, values).c_str());
+  key.AddNumber(values.at(FieldPlaycount).asInteger());
+  return ByLabel(attributes, values);
 }
 
 std::string ByDate(SortAttribute attributes, const SortItem &values)
@@ -95,14 +106,16 @@ std::string ByDateAdded(SortAttribute attributes, const SortItem &values)
   return StringUtils::Format("%s %d", values.at(FieldDateAdded).asString().c_str(), (int)values.at(FieldId).asInteger());
 }
 
-std::string BySize(SortAttribute attributes, const SortItem &values)
+std::string BySize(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%" PRId64, values.at(FieldSize).asInteger());
+  key.AddNumber(values.at(FieldSize).asInteger());
+  return "";
 }
 
-std::string ByDriveType(SortAttribute attributes, const SortItem &values)
+std::string ByDriveType(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%d %s", (int)values.at(FieldDriveType).asInteger(), ByLabel(attributes, values).c_str());
+  key.AddNumber(values.at(FieldDriveType).asInteger());
+  return ByLabel(attributes, values);
 }
 
 std::string ByTitle(SortAttribute attributes, const SortItem &values)
@@ -167,31 +180,33 @@ std::string ByArtistThenYear(SortAttribute attributes, const SortItem &values)
   return label;
 }
 
-std::string ByTrackNumber(SortAttribute attributes, const SortItem &values)
+std::string ByTrackNumber(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%i", (int)values.at(FieldTrackNumber).asInteger());
+  key.AddNumber(values.at(FieldTrackNumber).asInteger());
+  return "";
 }
 
-std::string ByTime(SortAttribute attributes, const SortItem &values)
+std::string ByTime(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  std::string label;
   const CVariant &time = values.at(FieldTime);
   if (time.isInteger())
-    label = StringUtils::Format("%i", (int)time.asInteger());
-  else
-    label = StringUtils::Format("%s", time.asString().c_str());
-  return label;
+  {
+    key.AddNumber(time.asInteger());
+    return "";
+  }
+  return time.asString();
 }
 
-std::string ByProgramCount(SortAttribute attributes, const SortItem &values)
+std::string ByProgramCount(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%i", (int)values.at(FieldProgramCount).asInteger());
+  key.AddNumber(values.at(FieldProgramCount).asInteger());
+  return "";
 }
 
-std::string ByPlaylistOrder(SortAttribute attributes, const SortItem &values)
+std::string ByPlaylistOrder(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
   // TODO: Playlist order is hacked into program count variable (not nice, but ok until 2.0)
-  return ByProgramCount(attributes, values);
+  return ByProgramCount(attributes, values, key);
 }
 
 std::string ByGenre(SortAttribute attributes, const SortItem &values)
@@ -238,24 +253,28 @@ std::string BySortTitle(SortAttribute attributes, const SortItem &values)
   return title;
 }
 
-std::string ByRating(SortAttribute attributes, const SortItem &values)
+std::string ByRating(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%f %s", values.at(FieldRating).asFloat(), ByLabel(attributes, values).c_str());
+  key.AddNumber(values.at(FieldRating).asDouble());
+  return ByLabel(attributes, values);
 }
 
-std::string ByUserRating(SortAttribute attributes, const SortItem &values)
+std::string ByUserRating(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%d %s", static_cast<int>(values.at(FieldUserRating).asInteger()), ByLabel(attributes, values).c_str());
+  key.AddNumber(values.at(FieldUserRating).asInteger());
+  return ByLabel(attributes, values);
 }
 
-std::string ByVotes(SortAttribute attributes, const SortItem &values)
+std::string ByVotes(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%d %s", (int)values.at(FieldVotes).asInteger(), ByLabel(attributes, values).c_str());
+  key.AddNumber(values.at(FieldVotes).asInteger());
+  return ByLabel(attributes, values);
 }
 
-std::string ByTop250(SortAttribute attributes, const SortItem &values)
+std::string ByTop250(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%d %s", (int)values.at(FieldTop250).asInteger(), ByLabel(attributes, values).c_str());
+  key.AddNumber(values.at(FieldTop250).asInteger());
+  return ByLabel(attributes, values);
 }
 
 std::string ByMPAA(SortAttribute attributes, const SortItem &values)
@@ -268,7 +287,7 @@ std::string ByStudio(SortAttribute attributes, const SortItem &values)
   return ArrayToString(attributes, values.at(FieldStudio));
 }
 
-std::string ByEpisodeNumber(SortAttribute attributes, const SortItem &values)
+std::string ByEpisodeNumber(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
   // we calculate an offset number based on the episode's
   // sort season and episode values. in addition
@@ -293,27 +312,31 @@ std::string ByEpisodeNumber(SortAttribute attributes, const SortItem &values)
   if (title.empty())
     title = ByLabel(attributes, values);
 
-  return StringUtils::Format("%" PRIu64" %s", num, title.c_str());
+  key.AddNumber(num);
+  return title;
 }
 
-std::string BySeason(SortAttribute attributes, const SortItem &values)
+std::string BySeason(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
   int season = (int)values.at(FieldSeason).asInteger();
   const CVariant &specialSeason = values.at(FieldSeasonSpecialSort);
   if (!specialSeason.isNull())
     season = (int)specialSeason.asInteger();
 
-  return StringUtils::Format("%i %s", season, ByLabel(attributes, values).c_str());
+  key.AddNumber(season);
+  return ByLabel(attributes, values);
 }
 
-std::string ByNumberOfEpisodes(SortAttribute attributes, const SortItem &values)
+std::string ByNumberOfEpisodes(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%i %s", (int)values.at(FieldNumberOfEpisodes).asInteger(), ByLabel(attributes, values).c_str());
+  key.AddNumber(values.at(FieldNumberOfEpisodes).asInteger());
+  return ByLabel(attributes, values);
 }
 
-std::string ByNumberOfWatchedEpisodes(SortAttribute attributes, const SortItem &values)
+std::string ByNumberOfWatchedEpisodes(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%i %s", (int)values.at(FieldNumberOfWatchedEpisodes).asInteger(), ByLabel(attributes, values).c_str());
+  key.AddNumber(values.at(FieldNumberOfWatchedEpisodes).asInteger());
+  return ByLabel(attributes, values);
 }
 
 std::string ByTvShowStatus(SortAttribute attributes, const SortItem &values)
@@ -331,9 +354,10 @@ std::string ByProductionCode(SortAttribute attributes, const SortItem &values)
   return values.at(FieldProductionCode).asString();
 }
 
-std::string ByVideoResolution(SortAttribute attributes, const SortItem &values)
+std::string ByVideoResolution(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%i %s", (int)values.at(FieldVideoResolution).asInteger(), ByLabel(attributes, values).c_str());
+  key.AddNumber(values.at(FieldVideoResolution).asInteger());
+  return ByLabel(attributes, values);
 }
 
 std::string ByVideoCodec(SortAttribute attributes, const SortItem &values)
@@ -341,14 +365,17 @@ std::string ByVideoCodec(SortAttribute attributes, const SortItem &values)
   return StringUtils::Format("%s %s", values.at(FieldVideoCodec).asString().c_str(), ByLabel(attributes, values).c_str());
 }
 
-std::string ByVideoAspectRatio(SortAttribute attributes, const SortItem &values)
+std::string ByVideoAspectRatio(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%.03f %s", values.at(FieldVideoAspectRatio).asFloat(), ByLabel(attributes, values).c_str());
+  // aspect ratios only differ from the third decimal on
+  key.AddNumber(floor(values.at(FieldVideoAspectRatio).asDouble() * 1000.0 + 0.5));
+  return ByLabel(attributes, values);
 }
 
-std::string ByAudioChannels(SortAttribute attributes, const SortItem &values)
+std::string ByAudioChannels(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%i %s", (int)values.at(FieldAudioChannels).asInteger(), ByLabel(attributes, values).c_str());
+  key.AddNumber(values.at(FieldAudioChannels).asInteger());
+  return ByLabel(attributes, values);
 }
 
 std::string ByAudioCodec(SortAttribute attributes, const SortItem &values)
@@ -366,19 +393,22 @@ std::string BySubtitleLanguage(SortAttribute attributes, const SortItem &values)
   return StringUtils::Format("%s %s", values.at(FieldSubtitleLanguage).asString().c_str(), ByLabel(attributes, values).c_str());
 }
 
-std::string ByBitrate(SortAttribute attributes, const SortItem &values)
+std::string ByBitrate(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%" PRId64, values.at(FieldBitrate).asInteger());
+  key.AddNumber(values.at(FieldBitrate).asInteger());
+  return "";
 }
 
-std::string ByListeners(SortAttribute attributes, const SortItem &values)
+std::string ByListeners(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%" PRId64, values.at(FieldListeners).asInteger());
+  key.AddNumber(values.at(FieldListeners).asInteger());
+  return "";
 }
 
-std::string ByRandom(SortAttribute attributes, const SortItem &values)
+std::string ByRandom(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%i", CUtil::GetRandomNumber());
+  key.AddNumber(CUtil::GetRandomNumber());
+  return "";
 }
 
 std::string ByChannel(SortAttribute attributes, const SortItem &values)
@@ -386,9 +416,10 @@ std::string ByChannel(SortAttribute attributes, const SortItem &values)
   return values.at(FieldChannelName).asString();
 }
 
-std::string ByChannelNumber(SortAttribute attributes, const SortItem &values)
+std::string ByChannelNumber(SortAttribute attributes, const SortItem &values, SortKey &key)
 {
-  return StringUtils::Format("%i", (int)values.at(FieldChannelNumber).asInteger());
+  key.AddNumber(values.at(FieldChannelNumber).asInteger());
+  return "";
 }
 
 std::string ByDateTaken(SortAttribute attributes, const SortItem &values)
@@ -396,130 +427,264 @@ std::string ByDateTaken(SortAttribute attributes, const SortItem &values)
   return values.at(FieldDateTaken).asString();
 }
 
-bool preliminarySort(const SortItem &left, const SortItem &right, bool handleFolder, bool &result, std::wstring &labelLeft, std::wstring &labelRight)
+SortKey::SortKey()
+  : count(0),
+    index(0),
+    special(SortSpecialNone),
+    hasFolder(false),
+    folder(false)
+{ }
+
+void SortKey::AddNumber(double value)
 {
-  // make sure both items have the necessary data to do the sorting
-  SortItem::const_iterator itLeftSort, itRightSort;
-  if ((itLeftSort = left.find(FieldSort)) == left.end())
-  {
-    result = false;
-    return true;
-  }
-  if ((itRightSort = right.find(FieldSort)) == right.end())
-  {
-    result = true;
-    return true;
-  }
+  if (count < MAX_NUMBERS)
+    numbers[count++] = value;
+}
 
-  // look at special sorting behaviour
-  SortItem::const_iterator itLeft, itRight;
-  SortSpecial leftSortSpecial = SortSpecialNone;
-  SortSpecial rightSortSpecial = SortSpecialNone;
-  if ((itLeft = left.find(FieldSortSpecial)) != left.end() && itLeft->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    leftSortSpecial = (SortSpecial)itLeft->second.asInteger();
-  if ((itRight = right.find(FieldSortSpecial)) != right.end() && itRight->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    rightSortSpecial = (SortSpecial)itRight->second.asInteger();
-  
-  // one has a special sort
-  if (leftSortSpecial != rightSortSpecial)
+class CSortKeyComparator
+{
+public:
+  CSortKeyComparator(SortOrder sortOrder, SortAttribute attributes)
+    : m_descending(sortOrder == SortOrderDescending),
+      m_handleFolders((attributes & SortAttributeIgnoreFolders) == 0)
+  { }
+
+  bool operator()(const SortKey *left, const SortKey *right) const
   {
-    // left should be sorted on top
-    // or right should be sorted on bottom
-    // => left is sorted above right
-    if (leftSortSpecial == SortSpecialOnTop ||
-        rightSortSpecial == SortSpecialOnBottom)
+    // one has a special sort
+    if (left->special != right->special)
+    {
+      // left should be sorted on top
+      // or right should be sorted on bottom
+      // => left is sorted above right
+      return left->special == SortSpecialOnTop || right->special == SortSpecialOnBottom;
+    }
+
+    // both have either sort on top or sort on bottom -> leave as-is
+    if (left->special == SortSpecialNone)
     {
-      result = true;
-      return true;
+      if (m_handleFolders && left->hasFolder && right->hasFolder && left->folder != right->folder)
+        return left->folder;
+
+      int64_t result = Compare(*left, *right);
+      if (result != 0)
+        return m_descending ? result > 0 : result < 0;
     }
-    
-    // otherwise right is sorted above left
-    result = false;
-    return true;
+
+    // keep the original order of equal items
+    return left->index < right->index;
   }
-  // both have either sort on top or sort on bottom -> leave as-is
-  else if (leftSortSpecial != SortSpecialNone && leftSortSpecial == rightSortSpecial)
+
+private:
+  static int64_t Compare(const SortKey &left, const SortKey &right)
   {
-    result = false;
-    return true;
+    unsigned int count = std::min(left.count, right.count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+      if (left.numbers[i] != right.numbers[i])
+        return left.numbers[i] < right.numbers[i] ? -1 : 1;
+    }
+    if (left.count != right.count)
+      return left.count < right.count ? -1 : 1;
+
+    return CompareLabels(left, right);
   }
 
-  if (handleFolder)
+  /*! StringUtils::AlphaNumericCompare, with the collation weights of the keys
+   in place of collating the characters */
+  static int64_t CompareLabels(const SortKey &left, const SortKey &right)
   {
-    itLeft = left.find(FieldFolder);
-    itRight = right.find(FieldFolder);
-    if (itLeft != left.end() && itRight != right.end() &&
-        itLeft->second.asBoolean() != itRight->second.asBoolean())
+    const std::vector<uint32_t> &lweights = left.weights;
+    const std::vector<uint32_t> &rweights = right.weights;
+    return StringUtils::AlphaNumericCompare(left.label.c_str(), right.label.c_str(), [&lweights, &rweights](size_t lpos, size_t rpos)
     {
-      result = itLeft->second.asBoolean();
-      return true;
-    }
+      uint32_t lw = lweights[lpos];
+      uint32_t rw = rweights[rpos];
+      return lw == rw ? 0 : (lw < rw ? -1 : 1);
+    });
   }
 
-  labelLeft = itLeftSort->second.asWideString();
-  labelRight = itRightSort->second.asWideString();
+  bool m_descending;
+  bool m_handleFolders;
+};
 
-  return false;
-}
+typedef std::vector<SortKey*> SortKeyList;
 
-bool SorterAscending(const SortItem &left, const SortItem &right)
+class CSortKeyRunner : public IRunnable
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
-
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
-}
+public:
+  CSortKeyRunner(SortKeyList::iterator begin, SortKeyList::iterator end, const CSortKeyComparator &comparator)
+    : m_begin(begin), m_end(end), m_comparator(comparator)
+  { }
 
-bool SorterDescending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
+  virtual void Run()
+  {
+    std::sort(m_begin, m_end, m_comparator);
+  }
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
-}
+private:
+  SortKeyList::iterator m_begin;
+  SortKeyList::iterator m_end;
+  CSortKeyComparator m_comparator;
+};
 
-bool SorterIgnoreFoldersAscending(const SortItem &left, const SortItem &right)
+void SortKeys(SortKeyList &keys, const CSortKeyComparator &comparator)
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
+  unsigned int chunks = std::min((unsigned int)std::max(g_cpuInfo.getCPUCount(), 1), PARALLEL_SORT_MAX_THREADS);
+  if (keys.size() < PARALLEL_SORT_MIN_ITEMS || chunks < 2)
+  {
+    std::sort(keys.begin(), keys.end(), comparator);
+    return;
+  }
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
-}
+  // sort equally sized runs on worker threads and merge them afterwards
+  const size_t width = (keys.size() + chunks - 1) / chunks;
+  std::vector<CSortKeyRunner*> runners;
+  std::vector<CThread*> threads;
+  for (size_t begin = width; begin < keys.size(); begin += width)
+  {
+    CSortKeyRunner *runner = new CSortKeyRunner(keys.begin() + begin, keys.begin() + std::min(begin + width, keys.size()), comparator);
+    CThread *thread = new CThread(runner, "SortKeys");
+    thread->Create();
+    runners.push_back(runner);
+    threads.push_back(thread);
+  }
+  std::sort(keys.begin(), keys.begin() + width, comparator);
 
-bool SorterIgnoreFoldersDescending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
+  for (size_t i = 0; i < threads.size(); i++)
+  {
+    threads[i]->WaitForThreadExit(0xFFFFFFFF);
+    delete threads[i];
+    delete runners[i];
+  }
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
+  for (size_t run = width; run < keys.size(); run *= 2)
+  {
+    for (size_t begin = 0; begin + run < keys.size(); begin += 2 * run)
+      std::inplace_merge(keys.begin() + begin, keys.begin() + begin + run, keys.begin() + std::min(begin + 2 * run, keys.size()), comparator);
+  }
 }
 
-bool SorterIndirectAscending(const SortItemPtr &left, const SortItemPtr &right)
+inline wchar_t CollationChar(wchar_t c)
 {
-  return SorterAscending(*left, *right);
+  // case less, like StringUtils::AlphaNumericCompare
+  return (c >= L'A' && c <= L'Z') ? c + (L'a' - L'A') : c;
 }
 
-bool SorterIndirectDescending(const SortItemPtr &left, const SortItemPtr &right)
+/*! Collation only ever compares single characters, so every distinct
+ character of the labels is ranked in the current locale once and the
+ labels are compared by these ranks during the sort */
+void SetCollationWeights(std::vector<SortKey> &keys)
 {
-  return SorterDescending(*left, *right);
+  std::unordered_set<wchar_t> distinct;
+  for (std::vector<SortKey>::const_iterator key = keys.begin(); key != keys.end(); ++key)
+  {
+    for (std::wstring::const_iterator c = key->label.begin(); c != key->label.end(); ++c)
+      distinct.insert(CollationChar(*c));
+  }
+  if (distinct.empty())
+    return;
+
+  const std::collate<wchar_t>& coll = std::use_facet<std::collate<wchar_t> >(g_langInfo.GetSystemLocale());
+  std::vector<wchar_t> chars(distinct.begin(), distinct.end());
+  std::sort(chars.begin(), chars.end(), [&coll](const wchar_t &a, const wchar_t &b)
+  {
+    return coll.compare(&a, &a + 1, &b, &b + 1) < 0;
+  });
+
+  // characters collating equal share their rank
+  std::unordered_map<wchar_t, uint32_t> ranks;
+  ranks.reserve(chars.size());
+  uint32_t rank = 0;
+  for (size_t i = 0; i < chars.size(); i++)
+  {
+    if (i > 0 && coll.compare(&chars[i - 1], &chars[i - 1] + 1, &chars[i], &chars[i] + 1) != 0)
+      rank++;
+    ranks[chars[i]] = rank;
+  }
+
+  for (std::vector<SortKey>::iterator key = keys.begin(); key != keys.end(); ++key)
+  {
+    key->weights.resize(key->label.size());
+    for (size_t i = 0; i < key->label.size(); i++)
+      key->weights[i] = ranks[CollationChar(key->label[i])];
+  }
 }
 
-bool SorterIndirectIgnoreFoldersAscending(const SortItemPtr &left, const SortItemPtr &right)
+std::wstring SortLabel(SortKey &key)
 {
-  return SorterIgnoreFoldersAscending(*left, *right);
+  if (key.count == 0)
+    return std::move(key.label);
+
+  // keep the leading number in the label so that scrolling by letter still
+  // groups the items the way they are sorted
+  wchar_t number[32];
+  if (key.numbers[0] == floor(key.numbers[0]))
+    swprintf(number, sizeof(number) / sizeof(wchar_t), L"%.0f", key.numbers[0]);
+  else
+    swprintf(number, sizeof(number) / sizeof(wchar_t), L"%f", key.numbers[0]);
+
+  std::wstring label(number);
+  if (!key.label.empty())
+    label += L" " + key.label;
+  return label;
 }
 
-bool SorterIndirectIgnoreFoldersDescending(const SortItemPtr &left, const SortItemPtr &right)
+inline SortItem& GetSortItem(DatabaseResult &item) { return item; }
+inline SortItem& GetSortItem(SortItemPtr &item) { return *item; }
+
+template<typename ItemType>
+void SortWithKeys(SortUtils::SortPreparator preparator, SortUtils::SortKeyPreparator keyPreparator, const Fields &sortingFields,
+                  SortOrder sortOrder, SortAttribute attributes, std::vector<ItemType> &items)
 {
-  return SorterIgnoreFoldersDescending(*left, *right);
+  std::vector<SortKey> keys(items.size());
+  SortKeyList sortedKeys(items.size());
+
+  // Prepare the key used for sorting once per item
+  for (size_t index = 0; index < items.size(); index++)
+  {
+    SortItem &item = GetSortItem(items[index]);
+
+    // add all fields to the item that are required for sorting if they are currently missing
+    for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
+    {
+      if (item.find(*field) == item.end())
+        item.insert(std::pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
+    }
+
+    SortKey &key = keys[index];
+    key.index = index;
+    std::string label = keyPreparator != NULL ? keyPreparator(attributes, item, key) : preparator(attributes, item);
+    if (!label.empty())
+      g_charsetConverter.utf8ToW(label, key.label, false);
+
+    SortItem::const_iterator it;
+    if ((it = item.find(FieldSortSpecial)) != item.end() && it->second.asInteger() <= (int64_t)SortSpecialOnBottom)
+      key.special = (SortSpecial)it->second.asInteger();
+    if ((it = item.find(FieldFolder)) != item.end())
+    {
+      key.hasFolder = true;
+      key.folder = it->second.asBoolean();
+    }
+
+    sortedKeys[index] = &key;
+  }
+
+  SetCollationWeights(keys);
+
+  // Do the sorting
+  SortKeys(sortedKeys, CSortKeyComparator(sortOrder, attributes));
+
+  // Move the items into their new order and store the label used for sorting under FieldSort
+  std::vector<ItemType> sortedItems;
+  sortedItems.reserve(items.size());
+  for (SortKeyList::iterator key = sortedKeys.begin(); key != sortedKeys.end(); ++key)
+  {
+    ItemType &item = items[(*key)->index];
+    GetSortItem(item)[FieldSort] = CVariant(SortLabel(**key));
+    sortedItems.push_back(std::move(item));
+  }
+  items.swap(sortedItems);
 }
 
 std::map<SortBy, SortUtils::SortPreparator> fillPreparators()
@@ -529,13 +694,9 @@ std::map<SortBy, SortUtils::SortPreparator> fillPreparators()
   preparators[SortByNone]                     = NULL;
   preparators[SortByLabel]                    = ByLabel;
   preparators[SortByDate]                     = ByDate;
-  preparators[SortBySize]                     = BySize;
   preparators[SortByFile]                     = ByFile;
   preparators[SortByPath]                     = ByPath;
-  preparators[SortByDriveType]                = ByDriveType;
   preparators[SortByTitle]                    = ByTitle;
-  preparators[SortByTrackNumber]              = ByTrackNumber;
-  preparators[SortByTime]                     = ByTime;
   preparators[SortByArtist]                   = ByArtist;
   preparators[SortByArtistThenYear]           = ByArtistThenYear;
   preparators[SortByAlbum]                    = ByAlbum;
@@ -543,42 +704,54 @@ std::map<SortBy, SortUtils::SortPreparator> fillPreparators()
   preparators[SortByGenre]                    = ByGenre;
   preparators[SortByCountry]                  = ByCountry;
   preparators[SortByYear]                     = ByYear;
-  preparators[SortByRating]                   = ByRating;
-  preparators[SortByUserRating]               = ByUserRating;
-  preparators[SortByVotes]                    = ByVotes;
-  preparators[SortByTop250]                   = ByTop250;
-  preparators[SortByProgramCount]             = ByProgramCount;
-  preparators[SortByPlaylistOrder]            = ByPlaylistOrder;
-  preparators[SortByEpisodeNumber]            = ByEpisodeNumber;
-  preparators[SortBySeason]                   = BySeason;
-  preparators[SortByNumberOfEpisodes]         = ByNumberOfEpisodes;
-  preparators[SortByNumberOfWatchedEpisodes]  = ByNumberOfWatchedEpisodes;
   preparators[SortByTvShowStatus]             = ByTvShowStatus;
   preparators[SortByTvShowTitle]              = ByTvShowTitle;
   preparators[SortBySortTitle]                = BySortTitle;
   preparators[SortByProductionCode]           = ByProductionCode;
   preparators[SortByMPAA]                     = ByMPAA;
-  preparators[SortByVideoResolution]          = ByVideoResolution;
   preparators[SortByVideoCodec]               = ByVideoCodec;
-  preparators[SortByVideoAspectRatio]         = ByVideoAspectRatio;
-  preparators[SortByAudioChannels]            = ByAudioChannels;
   preparators[SortByAudioCodec]               = ByAudioCodec;
   preparators[SortByAudioLanguage]            = ByAudioLanguage;
   preparators[SortBySubtitleLanguage]         = BySubtitleLanguage;
   preparators[SortByStudio]                   = ByStudio;
   preparators[SortByDateAdded]                = ByDateAdded;
   preparators[SortByLastPlayed]               = ByLastPlayed;
-  preparators[SortByPlaycount]                = ByPlaycount;
-  preparators[SortByListeners]                = ByListeners;
-  preparators[SortByBitrate]                  = ByBitrate;
-  preparators[SortByRandom]                   = ByRandom;
   preparators[SortByChannel]                  = ByChannel;
-  preparators[SortByChannelNumber]            = ByChannelNumber;
   preparators[SortByDateTaken]                = ByDateTaken;
 
   return preparators;
 }
 
+std::map<SortBy, SortUtils::SortKeyPreparator> fillKeyPreparators()
+{
+  std::map<SortBy, SortUtils::SortKeyPreparator> keyPreparators;
+
+  keyPreparators[SortBySize]                     = BySize;
+  keyPreparators[SortByDriveType]                = ByDriveType;
+  keyPreparators[SortByTrackNumber]              = ByTrackNumber;
+  keyPreparators[SortByTime]                     = ByTime;
+  keyPreparators[SortByRating]                   = ByRating;
+  keyPreparators[SortByUserRating]               = ByUserRating;
+  keyPreparators[SortByVotes]                    = ByVotes;
+  keyPreparators[SortByTop250]                   = ByTop250;
+  keyPreparators[SortByProgramCount]             = ByProgramCount;
+  keyPreparators[SortByPlaylistOrder]            = ByPlaylistOrder;
+  keyPreparators[SortByEpisodeNumber]            = ByEpisodeNumber;
+  keyPreparators[SortBySeason]                   = BySeason;
+  keyPreparators[SortByNumberOfEpisodes]         = ByNumberOfEpisodes;
+  keyPreparators[SortByNumberOfWatchedEpisodes]  = ByNumberOfWatchedEpisodes;
+  keyPreparators[SortByVideoResolution]          = ByVideoResolution;
+  keyPreparators[SortByVideoAspectRatio]         = ByVideoAspectRatio;
+  keyPreparators[SortByAudioChannels]            = ByAudioChannels;
+  keyPreparators[SortByPlaycount]                = ByPlaycount;
+  keyPreparators[SortByListeners]                = ByListeners;
+  keyPreparators[SortByBitrate]                  = ByBitrate;
+  keyPreparators[SortByRandom]                   = ByRandom;
+  keyPreparators[SortByChannelNumber]            = ByChannelNumber;
+
+  return keyPreparators;
+}
+
 std::map<SortBy, Fields> fillSortingFields()
 {
   std::map<SortBy, Fields> sortingFields;
@@ -659,6 +832,7 @@ std::map<SortBy, Fields> fillSortingFields()
 }
 
 std::map<SortBy, SortUtils::SortPreparator> SortUtils::m_preparators = fillPreparators();
+std::map<SortBy, SortUtils::SortKeyPreparator> SortUtils::m_keyPreparators = fillKeyPreparators();
 std::map<SortBy, Fields> SortUtils::m_sortingFields = fillSortingFields();
 
 void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, DatabaseResults& items, int limitEnd /* = -1 */, int limitStart /* = 0 */)
@@ -666,29 +840,10 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
   if (sortBy != SortByNone)
   {
     // get the matching SortPreparator
+    SortKeyPreparator keyPreparator = getKeyPreparator(sortBy);
     SortPreparator preparator = getPreparator(sortBy);
-    if (preparator != NULL)
-    {
-      Fields sortingFields = GetFieldsForSorting(sortBy);
-
-      // Prepare the string used for sorting and store it under FieldSort
-      for (DatabaseResults::iterator item = items.begin(); item != items.end(); ++item)
-      {
-        // add all fields to the item that are required for sorting if they are currently missing
-        for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
-        {
-          if (item->find(*field) == item->end())
-            item->insert(std::pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
-        }
-
-        std::wstring sortLabel;
-        g_charsetConverter.utf8ToW(preparator(attributes, *item), sortLabel, false);
-        item->insert(std::pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
-      }
-
-      // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorter(sortOrder, attributes));
-    }
+    if (keyPreparator != NULL || preparator != NULL)
+      SortWithKeys(preparator, keyPreparator, GetFieldsForSorting(sortBy), sortOrder, attributes, items);
   }
 
   if (limitStart > 0 && (size_t)limitStart < items.size())
@@ -705,29 +860,10 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
   if (sortBy != SortByNone)
   {
     // get the matching SortPreparator
+    SortKeyPreparator keyPreparator = getKeyPreparator(sortBy);
     SortPreparator preparator = getPreparator(sortBy);
-    if (preparator != NULL)
-    {
-      Fields sortingFields = GetFieldsForSorting(sortBy);
-
-      // Prepare the string used for sorting and store it under FieldSort
-      for (SortItems::iterator item = items.begin(); item != items.end(); ++item)
-      {
-        // add all fields to the item that are required for sorting if they are currently missing
-        for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
-        {
-          if ((*item)->find(*field) == (*item)->end())
-            (*item)->insert(std::pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
-        }
-
-        std::wstring sortLabel;
-        g_charsetConverter.utf8ToW(preparator(attributes, **item), sortLabel, false);
-        (*item)->insert(std::pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
-      }
-
-      // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorterIndirect(sortOrder, attributes));
-    }
+    if (keyPreparator != NULL || preparator != NULL)
+      SortWithKeys(preparator, keyPreparator, GetFieldsForSorting(sortBy), sortOrder, attributes, items);
   }
 
   if (limitStart > 0 && (size_t)limitStart < items.size())
@@ -779,20 +915,13 @@ const SortUtils::SortPreparator& SortUtils::getPreparator(SortBy sortBy)
   return m_preparators[SortByNone];
 }
 
-SortUtils::Sorter SortUtils::getSorter(SortOrder sortOrder, SortAttribute attributes)
+SortUtils::SortKeyPreparator SortUtils::getKeyPreparator(SortBy sortBy)
 {
-  if (attributes & SortAttributeIgnoreFolders)
-    return sortOrder == SortOrderDescending ? SorterIgnoreFoldersDescending : SorterIgnoreFoldersAscending;
-
-  return sortOrder == SortOrderDescending ? SorterDescending : SorterAscending;
-}
-
-SortUtils::SorterIndirect SortUtils::getSorterIndirect(SortOrder sortOrder, SortAttribute attributes)
-{
-  if (attributes & SortAttributeIgnoreFolders)
-    return sortOrder == SortOrderDescending ? SorterIndirectIgnoreFoldersDescending : SorterIndirectIgnoreFoldersAscending;
+  std::map<SortBy, SortKeyPreparator>::const_iterator it = m_keyPreparators.find(sortBy);
+  if (it != m_keyPreparators.end())
+    return it->second;
 
-  return sortOrder == SortOrderDescending ? SorterIndirectDescending : SorterIndirectAscending;
+  return NULL;
 }
 
 const Fields& SortUtils::GetFieldsForSorting(SortBy sortBy)
@@ -20,8 +20,10 @@
  */
 
 #include <map>
+#include <stdint.h>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "DatabaseUtils.h"
 #include "SortFileItem.h"
@@ -121,6 +123,27 @@ typedef DatabaseResult SortItem;
 typedef std::shared_ptr<SortItem> SortItemPtr;
 typedef std::vector<SortItemPtr> SortItems;
 
+/*! \brief Sort key precomputed once per item.
+ Numeric parts are compared first in the order they were added, followed by
+ an alphanumeric comparison of the label, which compares the collation
+ weights of its characters instead of collating them again.
+ */
+struct SortKey
+{
+  SortKey();
+  void AddNumber(double value);
+
+  static const unsigned int MAX_NUMBERS = 2;
+  unsigned int count;
+  double numbers[MAX_NUMBERS];
+  std::wstring label;
+  std::vector<uint32_t> weights;  ///< rank of every character of the label in the current locale
+  size_t index;
+  SortSpecial special;
+  bool hasFolder;
+  bool folder;
+};
+
 class SortUtils
 {
 public:
@@ -148,14 +171,14 @@ public:
   static std::string RemoveArticles(const std::string &label);
   
   typedef std::string (*SortPreparator) (SortAttribute, const SortItem&);
-  typedef bool (*Sorter) (const DatabaseResult &, const DatabaseResult &);
-  typedef bool (*SorterIndirect) (const SortItemPtr &, const SortItemPtr &);
+  /*! \brief Fills the numeric parts of the sort key and returns its label */
+  typedef std::string (*SortKeyPreparator) (SortAttribute, const SortItem&, SortKey&);
   
 private:
   static const SortPreparator& getPreparator(SortBy sortBy);
-  static Sorter getSorter(SortOrder sortOrder, SortAttribute attributes);
-  static SorterIndirect getSorterIndirect(SortOrder sortOrder, SortAttribute attributes);
+  static SortKeyPreparator getKeyPreparator(SortBy sortBy);
 
   static std::map<SortBy, SortPreparator> m_preparators;
+  static std::map<SortBy, SortKeyPreparator> m_keyPreparators;
   static std::map<SortBy, Fields> m_sortingFields;
 };
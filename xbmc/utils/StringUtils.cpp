@@ -762,82 +762,22 @@ int StringUtils::FindNumber(const std::string& strInput, const std::string &strF
   return numfound;
 }
 
-// Compares separately the numeric and alphabetic parts of a string.
-// returns negative if left < right, positive if left > right
-// and 0 if they are identical (essentially calculates left - right)
 int64_t StringUtils::AlphaNumericCompare(const wchar_t *left, const wchar_t *right)
 {
-  bool isNumeric = true;
-  wchar_t *l = (wchar_t *)left;
-  wchar_t *r = (wchar_t *)right;
-  wchar_t *ld = nullptr, *rd = nullptr;
-  wchar_t lc, rc;
-  int64_t lnum, rnum;
   const std::collate<wchar_t>& coll = std::use_facet<std::collate<wchar_t> >(g_langInfo.GetSystemLocale());
-  int cmp_res = 0;
-
-  while (*l != 0 && *r != 0)
+  return AlphaNumericCompare(left, right, [left, right, &coll](size_t lpos, size_t rpos)
   {
-    // check if we have a numerical value
-    if (isNumeric && *l >= L'0' && *l <= L'9' && *r >= L'0' && *r <= L'9')
-    {
-      ld = l;
-      lnum = 0;
-      while (*ld >= L'0' && *ld <= L'9' && ld < l + 15)
-      { // compare only up to 15 digits
-        lnum *= 10;
-        lnum += *ld++ - '0';
-      }
-      rd = r;
-      rnum = 0;
-      while (*rd >= L'0' && *rd <= L'9' && rd < r + 15)
-      { // compare only up to 15 digits
-        rnum *= 10;
-        rnum += *rd++ - L'0';
-      }
-      // do we have numbers?
-      if ((*ld == 0 || *ld == L' ') && (*rd == 0 || *rd == L' '))
-      {
-        if (lnum != rnum)
-          return lnum - rnum;
-      }
-      else
-      {
-        // Restart
-        isNumeric = false;
-        ld = rd = nullptr;
-        l = (wchar_t *)left;
-        r = (wchar_t *)right;
-        continue;
-      }
-      l = ld;
-      r = rd;
-      continue;
-    }
     // do case less comparison
-    lc = *l;
+    wchar_t lc = left[lpos];
     if (lc >= L'A' && lc <= L'Z')
       lc += L'a' - L'A';
-    rc = *r;
+    wchar_t rc = right[rpos];
     if (rc >= L'A' && rc <= L'Z')
       rc += L'a' - L'A';
 
     // ok, do a normal comparison, taking current locale into account. Add special case stuff (eg '(' characters)) in here later
-    if ((cmp_res = coll.compare(&lc, &lc + 1, &rc, &rc + 1)) != 0)
-    {
-      return cmp_res;
-    }
-    l++; r++;
-  }
-  if (*r)
-  { // r is longer
-    return -1;
-  }
-  else if (*l)
-  { // l is longer
-    return 1;
-  }
-  return 0; // files are the same
+    return coll.compare(&lc, &lc + 1, &rc, &rc + 1);
+  });
 }
 
 int StringUtils::DateStringToYYYYMMDD(const std::string &dateString)
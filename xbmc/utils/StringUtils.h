@@ -106,6 +106,12 @@ public:
   static std::vector<std::string> Split(const std::string& input, const char delimiter, size_t iMaxStrings = 0);
   static int FindNumber(const std::string& strInput, const std::string &strFind);
   static int64_t AlphaNumericCompare(const wchar_t *left, const wchar_t *right);
+  /*! \brief AlphaNumericCompare with the comparison of single characters done by the caller.
+   \param compareChars called as compareChars(leftPos, rightPos) with the positions of the characters
+   in left and right, returns negative, 0 or positive like AlphaNumericCompare
+   */
+  template<typename CompareChars>
+  static int64_t AlphaNumericCompare(const wchar_t *left, const wchar_t *right, CompareChars compareChars);
   static long TimeStringToSeconds(const std::string &timeString);
   static void RemoveCRLF(std::string& strLine);
 
@@ -204,3 +210,70 @@ struct sortstringbyname
     return StringUtils::CompareNoCase(strItem1, strItem2) < 0;
   }
 };
+
+// Compares separately the numeric and alphabetic parts of a string.
+// returns negative if left < right, positive if left > right
+// and 0 if they are identical (essentially calculates left - right)
+template<typename CompareChars>
+int64_t StringUtils::AlphaNumericCompare(const wchar_t *left, const wchar_t *right, CompareChars compareChars)
+{
+  bool isNumeric = true;
+  const wchar_t *l = left;
+  const wchar_t *r = right;
+  const wchar_t *ld, *rd;
+  int64_t lnum, rnum;
+  int64_t cmp_res = 0;
+
+  while (*l != 0 && *r != 0)
+  {
+    // check if we have a numerical value
+    if (isNumeric && *l >= L'0' && *l <= L'9' && *r >= L'0' && *r <= L'9')
+    {
+      ld = l;
+      lnum = 0;
+      while (*ld >= L'0' && *ld <= L'9' && ld < l + 15)
+      { // compare only up to 15 digits
+        lnum *= 10;
+        lnum += *ld++ - L'0';
+      }
+      rd = r;
+      rnum = 0;
+      while (*rd >= L'0' && *rd <= L'9' && rd < r + 15)
+      { // compare only up to 15 digits
+        rnum *= 10;
+        rnum += *rd++ - L'0';
+      }
+      // do we have numbers?
+      if ((*ld == 0 || *ld == L' ') && (*rd == 0 || *rd == L' '))
+      {
+        if (lnum != rnum)
+          return lnum - rnum;
+      }
+      else
+      {
+        // Restart
+        isNumeric = false;
+        l = left;
+        r = right;
+        continue;
+      }
+      l = ld;
+      r = rd;
+      continue;
+    }
+
+    if ((cmp_res = compareChars(l - left, r - right)) != 0)
+      return cmp_res;
+    l++; r++;
+  }
+  if (*r)
+  { // r is longer
+    return -1;
+  }
+  else if (*l)
+  { // l is longer
+    return 1;
+  }
+  return 0; // files are the same
+}
+
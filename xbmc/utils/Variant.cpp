@@ -151,7 +151,7 @@ CVariant::CVariant(VariantType type)
       m_data.dvalue = 0.0;
       break;
     case VariantTypeString:
-      m_data.string = new std::string();
+      setString("", 0);
       break;
     case VariantTypeWideString:
       m_data.wstring = new std::wstring();
@@ -213,25 +213,25 @@ CVariant::CVariant(bool boolean)
 CVariant::CVariant(const char *str)
 {
   m_type = VariantTypeString;
-  m_data.string = new std::string(str);
+  setString(str, strlen(str));
 }
 
 CVariant::CVariant(const char *str, unsigned int length)
 {
   m_type = VariantTypeString;
-  m_data.string = new std::string(str, length);
+  setString(str, length);
 }
 
 CVariant::CVariant(const std::string &str)
 {
   m_type = VariantTypeString;
-  m_data.string = new std::string(str);
+  setString(str.c_str(), str.size());
 }
 
 CVariant::CVariant(std::string &&str)
 {
   m_type = VariantTypeString;
-  m_data.string = new std::string(std::move(str));
+  setString(std::move(str));
 }
 
 CVariant::CVariant(const wchar_t *str)
@@ -301,13 +301,57 @@ CVariant::~CVariant()
   cleanup();
 }
 
+void CVariant::setString(const char *str, size_t length)
+{
+  if (length < SHORT_STRING_SIZE)
+  {
+    memcpy(m_data.shortstring, str, length);
+    m_data.shortstring[length] = '\0';
+    m_shortLength = (uint8_t)length;
+    m_shortString = true;
+  }
+  else
+  {
+    m_data.string = new std::string(str, length);
+    m_shortString = false;
+  }
+}
+
+void CVariant::setString(std::string &&str)
+{
+  if (str.size() < SHORT_STRING_SIZE)
+    setString(str.c_str(), str.size());
+  else
+  {
+    m_data.string = new std::string(std::move(str));
+    m_shortString = false;
+  }
+}
+
+const char *CVariant::stringData() const
+{
+  return m_shortString ? m_data.shortstring : m_data.string->c_str();
+}
+
+size_t CVariant::stringLength() const
+{
+  return m_shortString ? m_shortLength : m_data.string->size();
+}
+
+std::string CVariant::stringValue() const
+{
+  return m_shortString ? std::string(m_data.shortstring, m_shortLength) : *m_data.string;
+}
+
 void CVariant::cleanup()
 {
   switch (m_type)
   {
   case VariantTypeString:
-    delete m_data.string;
+    if (!m_shortString)
+      delete m_data.string;
     m_data.string = nullptr;
+    m_shortString = false;
     break;
 
   case VariantTypeWideString:
@@ -396,7 +440,7 @@ int64_t CVariant::asInteger(int64_t fallback) const
     case VariantTypeDouble:
       return (int64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2int64(*m_data.string, fallback);
+      return str2int64(stringValue(), fallback);
     case VariantTypeWideString:
       return str2int64(*m_data.wstring, fallback);
     default:
@@ -417,7 +461,7 @@ uint64_t CVariant::asUnsignedInteger(uint64_t fallback) const
     case VariantTypeDouble:
       return (uint64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2uint64(*m_data.string, fallback);
+      return str2uint64(stringValue(), fallback);
     case VariantTypeWideString:
       return str2uint64(*m_data.wstring, fallback);
     default:
@@ -438,7 +482,7 @@ double CVariant::asDouble(double fallback) const
     case VariantTypeUnsignedInteger:
       return (double)m_data.unsignedinteger;
     case VariantTypeString:
-      return str2double(*m_data.string, fallback);
+      return str2double(stringValue(), fallback);
     case VariantTypeWideString:
       return str2double(*m_data.wstring, fallback);
     default:
@@ -459,7 +503,7 @@ float CVariant::asFloat(float fallback) const
     case VariantTypeUnsignedInteger:
       return (float)m_data.unsignedinteger;
     case VariantTypeString:
-      return (float)str2double(*m_data.string, fallback);
+      return (float)str2double(stringValue(), fallback);
     case VariantTypeWideString:
       return (float)str2double(*m_data.wstring, fallback);
     default:
@@ -482,9 +526,13 @@ bool CVariant::asBoolean(bool fallback) const
     case VariantTypeDouble:
       return (m_data.dvalue != 0);
     case VariantTypeString:
-      if (m_data.string->empty() || m_data.string->compare("0") == 0 || m_data.string->compare("false") == 0)
+    {
+      const char *str = stringData();
+      size_t length = stringLength();
+      if (length == 0 || (length == 1 && str[0] == '0') || (length == 5 && memcmp(str, "false", 5) == 0))
         return false;
       return true;
+    }
     case VariantTypeWideString:
       if (m_data.wstring->empty() || m_data.wstring->compare(L"0") == 0 || m_data.wstring->compare(L"false") == 0)
         return false;
@@ -501,7 +549,7 @@ std::string CVariant::asString(const std::string &fallback /* = "" */) const
   switch (m_type)
   {
     case VariantTypeString:
-      return *m_data.string;
+      return stringValue();
     case VariantTypeBoolean:
       return m_data.boolean ? "true" : "false";
     case VariantTypeInteger:
@@ -615,7 +663,7 @@ CVariant &CVariant::operator=(const CVariant &rhs)
     m_data.dvalue = rhs.m_data.dvalue;
     break;
   case VariantTypeString:
-    m_data.string = new std::string(*rhs.m_data.string);
+    setString(rhs.stringData(), rhs.stringLength());
     break;
   case VariantTypeWideString:
     m_data.wstring = new std::wstring(*rhs.m_data.wstring);
@@ -644,11 +692,16 @@ CVariant& CVariant::operator=(CVariant&& rhs)
 
   m_type = rhs.m_type;
   m_data = std::move(rhs.m_data);
+  m_shortString = rhs.m_shortString;
+  m_shortLength = rhs.m_shortLength;
 
   //Should be enough to just set m_type here
   //but better safe than sorry, could probably lead to coverity warnings
   if (rhs.m_type == VariantTypeString)
+  {
     rhs.m_data.string = nullptr;
+    rhs.m_shortString = false;
+  }
   else if (rhs.m_type == VariantTypeWideString)
     rhs.m_data.wstring = nullptr;
   else if (rhs.m_type == VariantTypeArray)
@@ -676,7 +729,8 @@ bool CVariant::operator==(const CVariant &rhs) const
     case VariantTypeDouble:
       return m_data.dvalue == rhs.m_data.dvalue;
     case VariantTypeString:
-      return *m_data.string == *rhs.m_data.string;
+      return stringLength() == rhs.stringLength() &&
+             memcmp(stringData(), rhs.stringData(), stringLength()) == 0;
     case VariantTypeWideString:
       return *m_data.wstring == *rhs.m_data.wstring;
     case VariantTypeArray:
@@ -728,7 +782,7 @@ void CVariant::append(CVariant&& variant)
 const char *CVariant::c_str() const
 {
   if (m_type == VariantTypeString)
-    return m_data.string->c_str();
+    return stringData();
   else
     return NULL;
 }
@@ -737,12 +791,18 @@ void CVariant::swap(CVariant &rhs)
 {
   VariantType  temp_type = m_type;
   VariantUnion temp_data = m_data;
+  bool         temp_short = m_shortString;
+  uint8_t      temp_length = m_shortLength;
 
   m_type = rhs.m_type;
   m_data = rhs.m_data;
+  m_shortString = rhs.m_shortString;
+  m_shortLength = rhs.m_shortLength;
 
   rhs.m_type = temp_type;
   rhs.m_data = temp_data;
+  rhs.m_shortString = temp_short;
+  rhs.m_shortLength = temp_length;
 }
 
 CVariant::iterator_array CVariant::begin_array()
@@ -816,7 +876,7 @@ unsigned int CVariant::size() const
   else if (m_type == VariantTypeArray)
     return m_data.array->size();
   else if (m_type == VariantTypeString)
-    return m_data.string->size();
+    return stringLength();
   else if (m_type == VariantTypeWideString)
     return m_data.wstring->size();
   else
@@ -830,7 +890,7 @@ bool CVariant::empty() const
   else if (m_type == VariantTypeArray)
     return m_data.array->empty();
   else if (m_type == VariantTypeString)
-    return m_data.string->empty();
+    return stringLength() == 0;
   else if (m_type == VariantTypeWideString)
     return m_data.wstring->empty();
   else if (m_type == VariantTypeNull)
@@ -846,7 +906,11 @@ void CVariant::clear()
   else if (m_type == VariantTypeArray)
     m_data.array->clear();
   else if (m_type == VariantTypeString)
-    m_data.string->clear();
+  {
+    cleanup();
+    m_type = VariantTypeString;
+    setString("", 0);
+  }
   else if (m_type == VariantTypeWideString)
     m_data.wstring->clear();
 }
@@ -146,13 +146,25 @@ public:
   static CVariant ConstNullVariant;
 
 private:
+  /*! Strings shorter than this are stored inline, which saves the two heap
+      allocations of a std::string for the many short values (ids, labels,
+      dates, ...) of JSON-RPC payloads. */
+  static const unsigned int SHORT_STRING_SIZE = 16;
+
   void cleanup();
+  void setString(const char *str, size_t length);
+  void setString(std::string &&str);
+  const char *stringData() const;
+  size_t stringLength() const;
+  std::string stringValue() const;
+
   union VariantUnion
   {
     int64_t integer;
     uint64_t unsignedinteger;
     bool boolean;
     double dvalue;
+    char shortstring[SHORT_STRING_SIZE];
     std::string *string;
     std::wstring *wstring;
     VariantArray *array;
@@ -160,6 +172,8 @@ private:
   };
 
   VariantType m_type;
+  bool m_shortString = false; ///< string is stored in m_data.shortstring
+  uint8_t m_shortLength = 0;
   VariantUnion m_data;
 
   static VariantArray EMPTY_ARRAY;
@@ -20,11 +20,23 @@
 
 #include "log.h"
 #include "system.h"
+#include "threads/Event.h"
 #include "threads/SingleLock.h"
 #include "threads/Thread.h"
 #include "utils/StringUtils.h"
 #include "CompileInfo.h"
 
+#include <memory>
+
+// lines the writer thread can be behind, must be a power of 2
+#define LOG_QUEUE_SIZE     8192
+// the writer thread collects lines for this many ms before writing them
+#define LOG_WRITE_INTERVAL 50
+// bytes the writer thread buffers before writing
+#define LOG_BATCH_SIZE     (64 * 1024)
+// how many ms errors wait for room in a full queue before being dropped
+#define LOG_QUEUE_RETRIES  50
+
 static const char* const levelNames[] =
 {"DEBUG", "INFO", "NOTICE", "WARNING", "ERROR", "SEVERE", "FATAL", "NONE"};
 
@@ -35,6 +47,201 @@ static const char* const logLevelNames[] =
 // s_globals is used as static global with CLog global variables
 #define s_globals XBMC_GLOBAL_USE(CLog).m_globalInstance
 
+/*!
+ \brief Thread writing the lines queued by CLog in asynchronous mode.
+
+ Logging threads put their lines in a bounded multi producer, single consumer
+ ring which has a sequence number in each cell, so queueing never takes a
+ lock. The writer wakes up every LOG_WRITE_INTERVAL ms, or earlier for
+ errors and a filling queue, and writes everything queued at once.
+ */
+class CLogWriter : public CThread
+{
+public:
+  CLogWriter();
+  virtual ~CLogWriter();
+
+  void Queue(CLog::LogEntry &entry);
+  void Start();
+  void Stop();
+  uint64_t GetDropped() const { return m_droppedTotal.load(std::memory_order_relaxed); }
+
+protected:
+  virtual void Process();
+
+private:
+  bool Push(CLog::LogEntry &entry);
+  bool Pop(CLog::LogEntry &entry);
+  void Drain();
+
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    CLog::LogEntry entry;
+  };
+
+  std::unique_ptr<Cell[]> m_cells;
+  size_t m_mask;
+  std::atomic<size_t> m_enqueuePos;
+  std::atomic<size_t> m_dequeuePos;
+  std::atomic<unsigned int> m_dropped;  // since the writer last reported it
+  std::atomic<uint64_t> m_droppedTotal;
+  std::atomic<bool> m_stopping;  // lines queued from now on are written by the thread queueing them
+  CEvent m_wake;
+  std::string m_buffer;
+};
+
+CLogWriter::CLogWriter()
+  : CThread("LogWriter")
+  , m_cells(new Cell[LOG_QUEUE_SIZE])
+  , m_mask(LOG_QUEUE_SIZE - 1)
+  , m_enqueuePos(0)
+  , m_dequeuePos(0)
+  , m_dropped(0)
+  , m_droppedTotal(0)
+  , m_stopping(false)
+{
+  for (size_t i = 0; i < LOG_QUEUE_SIZE; i++)
+    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+CLogWriter::~CLogWriter()
+{
+  Stop();
+}
+
+void CLogWriter::Start()
+{
+  m_stopping = false;
+  if (!IsRunning())
+    Create();
+}
+
+void CLogWriter::Stop()
+{
+  m_stopping = true;
+  m_bStop = true;
+  m_wake.Set();
+  StopThread(true);
+
+  // nobody else is reading anymore, write whatever was queued meanwhile
+  Drain();
+}
+
+bool CLogWriter::Push(CLog::LogEntry &entry)
+{
+  Cell *cell;
+  size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    cell = &m_cells[pos & m_mask];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0)
+    {
+      if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+      return false; // full
+    else
+      pos = m_enqueuePos.load(std::memory_order_relaxed);
+  }
+
+  cell->entry = std::move(entry);
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool CLogWriter::Pop(CLog::LogEntry &entry)
+{
+  size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+  Cell &cell = m_cells[pos & m_mask];
+  if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+    return false;
+
+  entry = std::move(cell.entry);
+  m_dequeuePos.store(pos + 1, std::memory_order_relaxed);
+  cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+  return true;
+}
+
+void CLogWriter::Queue(CLog::LogEntry &entry)
+{
+  int level = entry.level & LOGMASK;
+  for (int retry = 0; !Push(entry); retry++)
+  {
+    // errors are worth waiting for a little, anything else would only
+    // slow down the thread logging it
+    if (level < LOGERROR || retry == LOG_QUEUE_RETRIES)
+    {
+      m_dropped++;
+      m_droppedTotal++;
+      return;
+    }
+    m_wake.Set();
+    Sleep(1);
+  }
+
+  // a thread which looked the writer up before SetAsync(false) may get here
+  // after Stop() drained the queue, the line would stay queued otherwise
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_stopping.load())
+  {
+    Drain();
+    return;
+  }
+
+  if (level >= LOGERROR ||
+      m_enqueuePos.load(std::memory_order_relaxed) - m_dequeuePos.load(std::memory_order_relaxed) > LOG_QUEUE_SIZE / 4)
+    m_wake.Set();
+}
+
+void CLogWriter::Drain()
+{
+  CSingleLock lock(s_globals.critSec);
+
+  CLog::LogEntry entry;
+  for (;;)
+  {
+    unsigned int dropped = m_dropped.exchange(0);
+    if (dropped > 0)
+    {
+      CLog::LogEntry warning;
+      CLog::InitEntry(warning, LOGWARNING);
+      warning.line = StringUtils::Format("%u lines were dropped, the log writer could not keep up", dropped);
+      CLog::FormatEntry(warning, m_buffer);
+    }
+
+    if (!Pop(entry))
+      break;
+
+    CLog::FormatEntry(entry, m_buffer);
+    if (m_buffer.size() >= LOG_BATCH_SIZE)
+      CLog::WriteBuffer(m_buffer);
+  }
+
+  CLog::WriteBuffer(m_buffer);
+}
+
+void CLogWriter::Process()
+{
+  while (!m_bStop)
+  {
+    m_wake.WaitMSec(LOG_WRITE_INTERVAL);
+    Drain();
+  }
+}
+
+CLog::CLogGlobals::~CLogGlobals()
+{
+  if (m_writer)
+  {
+    m_queue = NULL;
+    delete m_writer;
+  }
+}
+
 CLog::CLog()
 {}
 
@@ -43,6 +250,8 @@ CLog::~CLog()
 
 void CLog::Close()
 {
+  SetAsync(false);
+
   CSingleLock waitLock(s_globals.critSec);
   s_globals.m_platform.CloseLogFile();
   s_globals.m_repeatLine.clear();
@@ -75,34 +284,56 @@ void CLog::LogFunction(int loglevel, const char* functionName, const char* forma
 
 void CLog::LogString(int logLevel, const std::string& logString)
 {
-  CSingleLock waitLock(s_globals.critSec);
-  std::string strData(logString);
-  StringUtils::TrimRight(strData);
-  if (!strData.empty())
+  LogEntry entry;
+  entry.line = logString;
+  StringUtils::TrimRight(entry.line);
+  if (entry.line.empty())
+    return;
+
+  InitEntry(entry, logLevel);
+
+  CLogWriter *writer = s_globals.m_queue.load(std::memory_order_acquire);
+  if (writer)
   {
-    if (s_globals.m_repeatLogLevel == logLevel && s_globals.m_repeatLine == strData)
-    {
-      s_globals.m_repeatCount++;
-      return;
-    }
-    else if (s_globals.m_repeatCount)
-    {
-      std::string strData2 = StringUtils::Format("Previous line repeats %d times.",
-                                                s_globals.m_repeatCount);
-      PrintDebugString(strData2);
-      WriteLogString(s_globals.m_repeatLogLevel, strData2);
-      s_globals.m_repeatCount = 0;
-    }
+    writer->Queue(entry);
+    return;
+  }
 
-    s_globals.m_repeatLine = strData;
-    s_globals.m_repeatLogLevel = logLevel;
+  CSingleLock waitLock(s_globals.critSec);
+  std::string buffer;
+  FormatEntry(entry, buffer);
+  WriteBuffer(buffer);
+}
 
-    PrintDebugString(strData);
+void CLog::SetAsync(bool async, size_t rotateSize /* = 0 */)
+{
+  CSingleLock asyncLock(s_globals.asyncSec);
+  {
+    CSingleLock waitLock(s_globals.critSec);
+    s_globals.m_rotateSize = rotateSize;
+  }
 
-    WriteLogString(logLevel, strData);
+  if (async)
+  {
+    if (!s_globals.m_writer)
+      s_globals.m_writer = new CLogWriter();
+    s_globals.m_writer->Start();
+    s_globals.m_queue = s_globals.m_writer;
+  }
+  else if (s_globals.m_queue.load())
+  {
+    // the writer is kept, threads which just looked it up may still queue lines
+    s_globals.m_queue = NULL;
+    s_globals.m_writer->Stop();
   }
 }
 
+uint64_t CLog::GetDroppedLines()
+{
+  CSingleLock asyncLock(s_globals.asyncSec);
+  return s_globals.m_writer ? s_globals.m_writer->GetDropped() : 0;
+}
+
 bool CLog::Init(const std::string& path)
 {
   CSingleLock waitLock(s_globals.critSec);
@@ -112,7 +343,10 @@ bool CLog::Init(const std::string& path)
 
   std::string appName = CCompileInfo::GetAppName();
   StringUtils::ToLower(appName);
-  return s_globals.m_platform.OpenLogFile(path + appName + ".log", path + appName + ".old.log");
+  s_globals.m_logFile = path + appName + ".log";
+  s_globals.m_rotatedLogFile = path + appName + ".1.log";
+  s_globals.m_fileSize = 3; // BOM
+  return s_globals.m_platform.OpenLogFile(s_globals.m_logFile, path + appName + ".old.log");
 }
 
 void CLog::MemDump(char *pData, int length)
@@ -196,25 +430,85 @@ void CLog::PrintDebugString(const std::string& line)
 #endif // defined(_DEBUG) || defined(PROFILE)
 }
 
-bool CLog::WriteLogString(int logLevel, const std::string& logString)
+void CLog::InitEntry(LogEntry &entry, int logLevel)
+{
+  double millisecond;
+  PlatformInterfaceForCLog::GetCurrentLocalTime(entry.hour, entry.minute, entry.second, millisecond);
+  entry.millisecond = static_cast<int>(millisecond);
+  entry.level = logLevel;
+  entry.threadId = (uint64_t)CThread::GetCurrentThreadId();
+}
+
+/*!
+ \brief Appends the line of an entry with its prefix to buffer, collapsing repeated lines.
+ Must be called with critSec held.
+ */
+void CLog::FormatEntry(const LogEntry &entry, std::string &buffer)
 {
   static const char* prefixFormat = "%02d:%02d:%02d.%03d T:%" PRIu64" %7s: ";
 
-  std::string strData(logString);
-  /* fixup newline alignment, number of spaces should equal prefix length */
-  StringUtils::Replace(strData, "\n", "\n                                            ");
+  if (s_globals.m_repeatLogLevel == entry.level && s_globals.m_repeatLine == entry.line)
+  {
+    s_globals.m_repeatCount++;
+    return;
+  }
 
-  int hour, minute, second;
-  double millisecond;
-  s_globals.m_platform.GetCurrentLocalTime(hour, minute, second, millisecond);
+  auto append = [&](int logLevel, const std::string &line)
+  {
+    PrintDebugString(line);
+
+    if (!buffer.empty())
+      buffer += '\n';
+    buffer += StringUtils::Format(prefixFormat,
+                                  entry.hour,
+                                  entry.minute,
+                                  entry.second,
+                                  entry.millisecond,
+                                  entry.threadId,
+                                  levelNames[logLevel & LOGMASK]);
+
+    if (line.find('\n') == std::string::npos)
+      buffer += line;
+    else
+    {
+      /* fixup newline alignment, number of spaces should equal prefix length */
+      std::string strData(line);
+      StringUtils::Replace(strData, "\n", "\n                                            ");
+      buffer += strData;
+    }
+  };
+
+  if (s_globals.m_repeatCount)
+  {
+    append(s_globals.m_repeatLogLevel, StringUtils::Format("Previous line repeats %d times.", s_globals.m_repeatCount));
+    s_globals.m_repeatCount = 0;
+  }
+
+  s_globals.m_repeatLine = entry.line;
+  s_globals.m_repeatLogLevel = entry.level;
+
+  append(entry.level, entry.line);
+}
 
-  strData = StringUtils::Format(prefixFormat,
-                                  hour,
-                                  minute,
-                                  second,
-                                  static_cast<int>(millisecond),
-                                  (uint64_t)CThread::GetCurrentThreadId(),
-                                  levelNames[logLevel]) + strData;
+/*!
+ \brief Writes out and clears buffer, starting a new log file once it grew too large.
+ Must be called with critSec held.
+ */
+bool CLog::WriteBuffer(std::string &buffer)
+{
+  if (buffer.empty())
+    return true;
+
+  bool ret = s_globals.m_platform.WriteStringToLog(buffer);
+  s_globals.m_fileSize += buffer.size() + 1;
+  buffer.clear();
+
+  if (s_globals.m_rotateSize > 0 && s_globals.m_fileSize >= s_globals.m_rotateSize && !s_globals.m_logFile.empty())
+  {
+    s_globals.m_platform.CloseLogFile();
+    s_globals.m_platform.OpenLogFile(s_globals.m_logFile, s_globals.m_rotatedLogFile);
+    s_globals.m_fileSize = 3; // BOM
+  }
 
-  return s_globals.m_platform.WriteStringToLog(strData);
+  return ret;
 }
@@ -20,6 +20,8 @@
  *
  */
 
+#include <atomic>
+#include <stdint.h>
 #include <string>
 
 #if defined(TARGET_POSIX)
@@ -33,6 +35,8 @@ typedef class CPosixInterfaceForCLog PlatformInterfaceForCLog;
 
 #include "utils/params_check_macros.h"
 
+class CLogWriter;
+
 class CLog
 {
 public:
@@ -49,24 +53,54 @@ public:
   static int  GetLogLevel();
   static void SetExtraLogLevels(int level);
   static bool IsLogLevelLogged(int loglevel);
+  /*! \brief Hand log lines to a writer thread instead of writing them from the logging thread
+   Lines are queued without taking a lock and written in batches. When the
+   queue is full, lines below LOGERROR are dropped and counted.
+   \param async true to queue lines, false to write them synchronously
+   \param rotateSize size in bytes at which the log is moved to <app>.1.log and started anew, 0 to never rotate
+   */
+  static void SetAsync(bool async, size_t rotateSize = 0);
+  static uint64_t GetDroppedLines();
 
 protected:
+  struct LogEntry
+  {
+    int         level;
+    int         hour;
+    int         minute;
+    int         second;
+    int         millisecond;
+    uint64_t    threadId;
+    std::string line;
+  };
+
   class CLogGlobals
   {
   public:
-    CLogGlobals(void) : m_repeatCount(0), m_repeatLogLevel(-1), m_logLevel(LOG_LEVEL_DEBUG), m_extraLogLevels(0) {}
-    ~CLogGlobals() {}
+    CLogGlobals(void) : m_repeatCount(0), m_repeatLogLevel(-1), m_logLevel(LOG_LEVEL_DEBUG), m_extraLogLevels(0),
+                        m_fileSize(0), m_rotateSize(0), m_queue(NULL), m_writer(NULL) {}
+    ~CLogGlobals();
     PlatformInterfaceForCLog m_platform;
     int         m_repeatCount;
     int         m_repeatLogLevel;
     std::string m_repeatLine;
     int         m_logLevel;
     int         m_extraLogLevels;
+    std::string m_logFile;
+    std::string m_rotatedLogFile;
+    size_t      m_fileSize;
+    size_t      m_rotateSize;
+    std::atomic<CLogWriter*> m_queue;  // writer taking lines, NULL when logging synchronously
+    CLogWriter *m_writer;
+    CCriticalSection asyncSec;
     CCriticalSection critSec;
   };
   class CLogGlobals m_globalInstance; // used as static global variable
+  friend class CLogWriter;
   static void LogString(int logLevel, const std::string& logString);
-  static bool WriteLogString(int logLevel, const std::string& logString);
+  static void InitEntry(LogEntry &entry, int logLevel);
+  static void FormatEntry(const LogEntry &entry, std::string &buffer);
+  static bool WriteBuffer(std::string &buffer);
 };
 
 
@@ -505,6 +505,10 @@ namespace VIDEO
     if(pDlgProgress)
       pDlgProgress->ShowProgressBar(false);
 
+    // the items scraped so far are written even if it stopped early
+    if (!WriteQueuedVideos())
+      FoundSomeInfo = false;
+
     m_database.Close();
     return FoundSomeInfo;
   }
@@ -610,8 +614,7 @@ namespace VIDEO
       pItem->GetVideoInfoTag()->Reset();
       m_nfoReader.GetDetails(*pItem->GetVideoInfoTag());
 
-      if (AddVideo(pItem, info2->Content(), bDirNames, true) < 0)
-        return INFO_ERROR;
+      QueueVideo(pItem, info2->Content(), bDirNames, true);
       return INFO_ADDED;
     }
     if (result == CNfoFile::URL_NFO || result == CNfoFile::COMBINED_NFO)
@@ -629,8 +632,7 @@ namespace VIDEO
       {
         pItem->GetVideoInfoTag()->m_strTitle = CURL(pItem->GetPath()).GetFileNameWithoutPath();
         CURL::Decode(pItem->GetVideoInfoTag()->m_strTitle);
-        if (AddVideo(pItem, CONTENT_MOVIES, bDirNames, useLocal) < 0)
-          return INFO_ERROR;
+        QueueVideo(pItem, CONTENT_MOVIES, bDirNames, useLocal);
         return INFO_ADDED;
       }
       else
@@ -639,8 +641,7 @@ namespace VIDEO
 
     if (GetDetails(pItem, url, info2, result == CNfoFile::COMBINED_NFO ? &m_nfoReader : NULL, pDlgProgress) || CSettings::GetInstance().GetBool(CSettings::SETTING_VIDEOLIBRARY_IMPORTALL))
     {
-      if (AddVideo(pItem, info2->Content(), bDirNames, useLocal) < 0)
-        return INFO_ERROR;
+      QueueVideo(pItem, info2->Content(), bDirNames, useLocal);
       return INFO_ADDED;
     }
 
@@ -673,8 +674,7 @@ namespace VIDEO
       pItem->GetVideoInfoTag()->Reset();
       m_nfoReader.GetDetails(*pItem->GetVideoInfoTag());
 
-      if (AddVideo(pItem, info2->Content(), bDirNames, true) < 0)
-        return INFO_ERROR;
+      QueueVideo(pItem, info2->Content(), bDirNames, true);
       return INFO_ADDED;
     }
     if (result == CNfoFile::URL_NFO || result == CNfoFile::COMBINED_NFO)
@@ -689,8 +689,7 @@ namespace VIDEO
 
     if (GetDetails(pItem, url, info2, result == CNfoFile::COMBINED_NFO ? &m_nfoReader : NULL, pDlgProgress))
     {
-      if (AddVideo(pItem, info2->Content(), bDirNames, useLocal) < 0)
-        return INFO_ERROR;
+      QueueVideo(pItem, info2->Content(), bDirNames, useLocal);
       return INFO_ADDED;
     }
     // TODO: This is not strictly correct as we could fail to download information here or error, or be cancelled
@@ -712,6 +711,9 @@ namespace VIDEO
     CVideoInfoTag showInfo;
     m_database.GetTvShowInfo("", showInfo, showID);
     INFO_RET ret = OnProcessSeriesFolder(files, scraper, useLocal, showInfo, progress);
+    // the episodes scraped so far are written even if it stopped early
+    if (!WriteQueuedVideos() && ret == INFO_ADDED)
+      ret = INFO_ERROR;
 
     if (ret == INFO_ADDED)
     {
@@ -733,11 +735,13 @@ namespace VIDEO
         CVideoInfoDownloader loader(scraper);
         loader.GetArtwork(showInfo);
         GetSeasonThumbs(showInfo, seasonArt, CVideoThumbLoader::GetArtTypes(MediaTypeSeason), useLocal);
+        m_database.BeginBatch();
         for (std::map<int, std::map<std::string, std::string> >::const_iterator i = seasonArt.begin(); i != seasonArt.end(); ++i)
         {
           int seasonID = m_database.AddSeason(showID, i->first);
           m_database.SetArtForItem(seasonID, MediaTypeSeason, i->second);
         }
+        m_database.CommitBatch();
       }
     }
     return ret;
@@ -1193,17 +1197,49 @@ namespace VIDEO
     if (!m_database.Open())
       return -1;
 
+    std::map<int, std::map<std::string, std::string> > seasonArt;
+    PrepareVideo(pItem, content, videoFolder, useLocal, showInfo, libraryImport, seasonArt);
+
+    // the writes of the item are committed together
+    m_database.BeginBatch();
+    long lResult = WriteVideo(pItem, content, showInfo, libraryImport, seasonArt);
+    m_database.CommitBatch();
+    m_database.Close();
+
+    if (!m_bRunning)
+      g_infoManager.ResetLibraryBools();
+    AnnounceVideo(pItem);
+    return lResult;
+  }
+
+  void CVideoInfoScanner::PrepareVideo(CFileItem *pItem, const CONTENT_TYPE &content, bool videoFolder, bool useLocal, const CVideoInfoTag *showInfo, bool libraryImport, std::map<int, std::map<std::string, std::string> > &seasonArt)
+  {
     if (!libraryImport)
       GetArtwork(pItem, content, videoFolder, useLocal, showInfo ? showInfo->m_strPath : "");
 
+    CVideoInfoTag &movieDetails = *pItem->GetVideoInfoTag();
+    if (movieDetails.m_basePath.empty())
+      movieDetails.m_basePath = pItem->GetBaseMoviePath(videoFolder);
+
+    if (content == CONTENT_MOVIES)
+    {
+      // find local trailer first
+      std::string strTrailer = pItem->FindTrailer();
+      if (!strTrailer.empty())
+        movieDetails.m_strTrailer = strTrailer;
+    }
+    else if (content == CONTENT_TVSHOWS && pItem->m_bIsFolder && !libraryImport)
+      GetSeasonThumbs(movieDetails, seasonArt, CVideoThumbLoader::GetArtTypes(MediaTypeSeason), useLocal);
+  }
+
+  long CVideoInfoScanner::WriteVideo(CFileItem *pItem, const CONTENT_TYPE &content, const CVideoInfoTag *showInfo, bool libraryImport, const std::map<int, std::map<std::string, std::string> > &seasonArt)
+  {
     // ensure the art map isn't completely empty by specifying an empty thumb
     std::map<std::string, std::string> art = pItem->GetArt();
     if (art.empty())
       art["thumb"] = "";
 
     CVideoInfoTag &movieDetails = *pItem->GetVideoInfoTag();
-    if (movieDetails.m_basePath.empty())
-      movieDetails.m_basePath = pItem->GetBaseMoviePath(videoFolder);
     movieDetails.m_parentPathID = m_database.AddPath(URIUtils::GetParentPath(movieDetails.m_basePath));
 
     movieDetails.m_strFileNameAndPath = pItem->GetPath();
@@ -1225,11 +1261,6 @@ namespace VIDEO
 
     if (content == CONTENT_MOVIES)
     {
-      // find local trailer first
-      std::string strTrailer = pItem->FindTrailer();
-      if (!strTrailer.empty())
-        movieDetails.m_strTrailer = strTrailer;
-
       lResult = m_database.SetDetailsForMovie(pItem->GetPath(), movieDetails, art);
       movieDetails.m_iDbId = lResult;
       movieDetails.m_type = MediaTypeMovie;
@@ -1260,11 +1291,6 @@ namespace VIDEO
         for (std::vector<std::string>::const_iterator i = multipath.begin(); i != multipath.end(); ++i)
           paths.push_back(std::make_pair(*i, URIUtils::GetParentPath(*i)));
 
-        std::map<int, std::map<std::string, std::string> > seasonArt;
-
-        if (!libraryImport)
-          GetSeasonThumbs(movieDetails, seasonArt, CVideoThumbLoader::GetArtTypes(MediaTypeSeason), useLocal);
-
         lResult = m_database.SetDetailsForTvShow(paths, movieDetails, art, seasonArt);
         movieDetails.m_iDbId = lResult;
         movieDetails.m_type = MediaTypeTvShow;
@@ -1302,16 +1328,62 @@ namespace VIDEO
         movieDetails.m_resumePoint.IsSet())
       m_database.AddBookMarkToFile(pItem->GetPath(), movieDetails.m_resumePoint, CBookmark::RESUME);
 
-    m_database.Close();
+    return lResult;
+  }
 
+  void CVideoInfoScanner::AnnounceVideo(const CFileItem *pItem)
+  {
     CFileItemPtr itemCopy = CFileItemPtr(new CFileItem(*pItem));
     CVariant data;
     if (m_bRunning)
       data["transaction"] = true;
     ANNOUNCEMENT::CAnnouncementManager::GetInstance().Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnUpdate", itemCopy, data);
-    return lResult;
   }
 
+  void CVideoInfoScanner::QueueVideo(CFileItem *pItem, const CONTENT_TYPE &content, bool videoFolder, bool useLocal, const CVideoInfoTag *showInfo /* = NULL */)
+  {
+    // the lookups on disk are done now, only the writes wait
+    std::map<int, std::map<std::string, std::string> > seasonArt;
+    PrepareVideo(pItem, content, videoFolder, useLocal, showInfo, false, seasonArt);
+
+    QueuedVideo video;
+    video.item = CFileItemPtr(new CFileItem(*pItem));
+    video.content = content;
+    video.showInfo = showInfo;
+    m_queuedVideos.push_back(video);
+  }
+
+  bool CVideoInfoScanner::WriteQueuedVideos()
+  {
+    if (m_queuedVideos.empty())
+      return true;
+
+    std::vector<QueuedVideo> videos;
+    videos.swap(m_queuedVideos);
+
+    // one transaction for all of them, the scraping is done so other
+    // writers only wait for the writes
+    bool success = true;
+    const std::map<int, std::map<std::string, std::string> > seasonArt;
+    m_database.Open();
+    m_database.BeginBatch();
+    for (std::vector<QueuedVideo>::const_iterator video = videos.begin(); video != videos.end(); ++video)
+    {
+      if (WriteVideo(video->item.get(), video->content, video->showInfo, false, seasonArt) < 0)
+      {
+        CLog::Log(LOGERROR, "VideoInfoScanner: Failed to add %s", CURL::GetRedacted(video->item->GetPath()).c_str());
+        success = false;
+      }
+    }
+    m_database.CommitBatch();
+    m_database.Close();
+
+    for (std::vector<QueuedVideo>::const_iterator video = videos.begin(); video != videos.end(); ++video)
+      AnnounceVideo(video->item.get());
+    return success;
+  }
+
+
   std::string ContentToMediaType(CONTENT_TYPE content, bool folder)
   {
     switch (content)
@@ -1514,8 +1586,7 @@ namespace VIDEO
           item.GetVideoInfoTag()->m_iSeason = file->iSeason;
         }
         if (m_database.GetEpisodeId(file->strPath, item.GetVideoInfoTag()->m_iEpisode, item.GetVideoInfoTag()->m_iSeason) < 0)
-          if (AddVideo(&item, CONTENT_TVSHOWS, file->isFolder, true, &showInfo) < 0)
-            return INFO_ERROR;
+          QueueVideo(&item, CONTENT_TVSHOWS, file->isFolder, true, &showInfo);
         continue;
       }
 
@@ -1658,8 +1729,7 @@ namespace VIDEO
         if (item.GetVideoInfoTag()->m_iEpisode == -1)
           item.GetVideoInfoTag()->m_iEpisode = guide->iEpisode;
           
-        if (AddVideo(&item, CONTENT_TVSHOWS, file->isFolder, useLocal, &showInfo) < 0)
-          return INFO_ERROR;
+        QueueVideo(&item, CONTENT_TVSHOWS, file->isFolder, useLocal, &showInfo);
       }
       else
       {
@@ -1713,8 +1783,7 @@ namespace VIDEO
           }
 
           item.GetVideoInfoTag()->m_firstAired = dateAdded;
-          if (AddVideo(&item, CONTENT_TVSHOWS, file->isFolder, useLocal, &showInfo) < 0)
-            return INFO_ERROR;
+          QueueVideo(&item, CONTENT_TVSHOWS, file->isFolder, useLocal, &showInfo);
         }
       }
     }
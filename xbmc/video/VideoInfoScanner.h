@@ -18,6 +18,11 @@
  *  <http://www.gnu.org/licenses/>.
  *
  */
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "VideoDatabase.h"
 #include "addons/Scraper.h"
 #include "NfoFile.h"
@@ -130,6 +135,22 @@ namespace VIDEO
     INFO_RET RetrieveInfoForMusicVideo(CFileItem *pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, CGUIDialogProgress* pDlgProgress);
     INFO_RET RetrieveInfoForEpisodes(CFileItem *item, long showID, const ADDON::ScraperPtr &scraper, bool useLocal, CGUIDialogProgress *progress = NULL);
 
+    /*! \brief Look up the artwork of an item and queue it to be added by WriteQueuedVideos().
+     The items scraped for a directory are written in one transaction, which isn't held while scraping.
+     \param showInfo details of the show of an episode, must stay valid until WriteQueuedVideos().
+     \sa AddVideo
+     */
+    void QueueVideo(CFileItem *pItem, const CONTENT_TYPE &content, bool videoFolder, bool useLocal, const CVideoInfoTag *showInfo = NULL);
+
+    /*! \brief Add the items queued by QueueVideo() to the database in one transaction.
+     \return false if any of them failed to be added.
+     */
+    bool WriteQueuedVideos();
+
+    void PrepareVideo(CFileItem *pItem, const CONTENT_TYPE &content, bool videoFolder, bool useLocal, const CVideoInfoTag *showInfo, bool libraryImport, std::map<int, std::map<std::string, std::string> > &seasonArt);
+    long WriteVideo(CFileItem *pItem, const CONTENT_TYPE &content, const CVideoInfoTag *showInfo, bool libraryImport, const std::map<int, std::map<std::string, std::string> > &seasonArt);
+    void AnnounceVideo(const CFileItem *pItem);
+
     /*! \brief Update the progress bar with the heading and line and check for cancellation
      \param progress CGUIDialogProgress bar
      \param heading string id of heading
@@ -249,6 +270,14 @@ namespace VIDEO
     std::set<std::string> m_pathsToCount;
     std::set<int> m_pathsToClean;
     CNfoFile m_nfoReader;
+
+    struct QueuedVideo
+    {
+      std::shared_ptr<CFileItem> item;
+      CONTENT_TYPE content;
+      const CVideoInfoTag *showInfo;
+    };
+    std::vector<QueuedVideo> m_queuedVideos;
   };
 }
 
@@ -22,6 +22,7 @@
 #include "settings/AdvancedSettings.h"
 #include "addons/Skin.h"
 #include "utils/CPUInfo.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "CompileInfo.h"
 #include "input/ButtonTranslator.h"
@@ -31,8 +32,12 @@
 #include "guilib/GUIWindowManager.h"
 #include "guilib/GUIControlProfiler.h"
 #include "GUIInfoManager.h"
+#include "interfaces/AnnouncementManager.h"
 #include "utils/Variant.h"
 #include "utils/StringUtils.h"
+#if defined(HAS_GLES)
+#include "windowing/WindowingFactory.h"
+#endif
 
 CGUIWindowDebugInfo::CGUIWindowDebugInfo(void)
   : CGUIDialog(WINDOW_DEBUG_INFO, "", DialogModalityType::MODELESS)
@@ -114,6 +119,30 @@ void CGUIWindowDebugInfo::Process(unsigned int currentTime, CDirtyRegionList &di
     info = StringUtils::Format("LOG: %s%s.log\nMEM: %" PRIu64"/%" PRIu64" KB - FPS: %2.1f fps\nCPU: %s (CPU-%s %4.2f%%%s)", g_advancedSettings.m_logFolder.c_str(), lcAppName.c_str(),
                                stat.ullAvailPhys/1024, stat.ullTotalPhys/1024, g_infoManager.GetFPS(), strCores.c_str(), ucAppName.c_str(), dCPU, profiling.c_str());
 #endif
+#if defined(HAS_GLES)
+    const CGUIQuadBatchGLES::Stats &batch = g_Windowing.GUIQuadBatch().GetFrameStats();
+    info += StringUtils::Format("\nGUI: %u draw calls, %u quads, %u flushes", batch.drawCalls, batch.quads, batch.flushes);
+#endif
+    const CGUIInfoManager::InfoBoolStats &bools = g_infoManager.GetBoolStats();
+    info += StringUtils::Format("\nINFO: %u conditions evaluated, %u of %u reset", bools.evaluations, bools.invalidated, bools.bools);
+    std::vector<ANNOUNCEMENT::AnnouncerStats> announcers;
+    ANNOUNCEMENT::CAnnouncementManager::GetInstance().GetStats(announcers);
+    unsigned int queued = 0, lag = 0;
+    for (std::vector<ANNOUNCEMENT::AnnouncerStats>::const_iterator it = announcers.begin(); it != announcers.end(); ++it)
+    {
+      queued += it->queued;
+      lag = std::max(lag, it->lastLag);
+    }
+    info += StringUtils::Format("\nANN: %u queued for %u listeners, lag %u ms", queued, (unsigned int)announcers.size(), lag);
+    CJobManager::PriorityStats jobs[CJob::PRIORITY_HIGH+1];
+    unsigned int workers = CJobManager::GetInstance().GetStats(jobs);
+    info += StringUtils::Format("\nJOBS: %u workers", workers);
+    for (int priority = CJob::PRIORITY_HIGH; priority >= CJob::PRIORITY_LOW_PAUSABLE; --priority)
+    {
+      const CJobManager::PriorityStats &lane = jobs[priority];
+      info += StringUtils::Format(" - P%d %u/%u, wait %u/%u ms", priority, lane.processing, lane.queued,
+                                  lane.completed ? (unsigned int)(lane.waitTime / lane.completed) : 0, lane.maxWaitTime);
+    }
   }
 
   // render the skin debug info